@@ -1,42 +1,57 @@
 #version 460 core
+#pragma qrk_include < depth.frag>
 #pragma qrk_include < normals.frag>
 in vec2 texCoords;
 
 out vec4 fragColor;
 
-uniform sampler2D screenTexture;
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoMetallic;
+uniform sampler2D gRoughnessAO;
+uniform sampler2D gEmission;
+uniform mat4 inverseProjection;
+// Fraction of the G-Buffer that was rendered to, see
+// Framebuffer::setViewportSize().
+uniform vec2 qrk_renderScale;
 // Which component of the G-Buffer to visualize.
 uniform int gBufferVis;
 
 void main() {
-  vec4 color = texture(screenTexture, texCoords);
+  vec2 gBufferCoords = texCoords * qrk_renderScale;
+  float depth = texture(gDepth, gBufferCoords).r;
+  if (depth == 1.0) {
+    // Fragment has no G-Buffer info.
+    fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    return;
+  }
 
   if (gBufferVis == 1) {
-    // Positions.
-    fragColor = vec4(color.rgb, 1.0);
+    // Positions, reconstructed from depth.
+    vec3 position = qrk_viewPosFromDepth(depth, texCoords, inverseProjection);
+    fragColor = vec4(position, 1.0);
   } else if (gBufferVis == 2) {
     // AO.
-    fragColor = vec4(color.a, color.a, color.a, 1.0);
+    float ao = texture(gRoughnessAO, gBufferCoords).g;
+    fragColor = vec4(ao, ao, ao, 1.0);
   } else if (gBufferVis == 3) {
     // Normals.
-    if (color.rgb == vec3(0.0)) {
-      // Fragment has no normal info.
-      fragColor = vec4(0.0, 0.0, 0.0, 1.0);
-    } else {
-      fragColor = qrk_normalColor(color.rgb);
-    }
+    fragColor =
+        qrk_normalColor(qrk_decodeNormalOctahedral(texture(gNormal, gBufferCoords).rg));
   } else if (gBufferVis == 4) {
     // Roughness.
-    fragColor = vec4(color.a, color.a, color.a, 1.0);
+    float roughness = texture(gRoughnessAO, gBufferCoords).r;
+    fragColor = vec4(roughness, roughness, roughness, 1.0);
   } else if (gBufferVis == 5) {
     // Albedo.
-    fragColor = vec4(color.rgb, 1.0);
+    fragColor = vec4(texture(gAlbedoMetallic, gBufferCoords).rgb, 1.0);
   } else if (gBufferVis == 6) {
     // Metallic.
-    fragColor = vec4(color.a, color.a, color.a, 1.0);
+    float metallic = texture(gAlbedoMetallic, gBufferCoords).a;
+    fragColor = vec4(metallic, metallic, metallic, 1.0);
   } else if (gBufferVis == 7) {
     // Emission.
-    fragColor = vec4(color.rgb, 1.0);
+    fragColor = vec4(texture(gEmission, gBufferCoords).rgb, 1.0);
   } else {
     fragColor = vec4(1.0, 0.0, 0.0, 1.0);
   }
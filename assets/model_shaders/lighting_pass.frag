@@ -4,6 +4,8 @@
 #pragma qrk_include < standard_lights_pbr.frag>
 #pragma qrk_include < depth.frag>
 #pragma qrk_include < tone_mapping.frag>
+#pragma qrk_include < normals.frag>
+#pragma qrk_include < cascaded_shadows.glsl>
 
 // A fragment shader for rendering models.
 
@@ -11,12 +13,18 @@ in vec2 texCoords;
 
 out vec4 fragColor;
 
-uniform sampler2D gPositionAO;
-uniform sampler2D gNormalRoughness;
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
 uniform sampler2D gAlbedoMetallic;
+uniform sampler2D gRoughnessAO;
 uniform sampler2D gEmission;
+// Fraction of the G-Buffer that was rendered to, see
+// Framebuffer::setViewportSize().
+uniform vec2 qrk_renderScale;
 
 uniform bool shadowMapping;
+// Tints each shadow cascade to show the splits.
+uniform bool shadowCascadeVis;
 uniform bool ssao;
 uniform sampler2D qrk_ssao;
 
@@ -30,8 +38,7 @@ uniform int lightingModel;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 lightViewProjection;
-uniform sampler2D shadowMap;
+uniform mat4 inverseProjection;
 uniform float shadowBiasMin;
 uniform float shadowBiasMax;
 uniform samplerCube qrk_irradianceMap;
@@ -41,14 +48,25 @@ uniform float qrk_ggxPrefilteredEnvMapMaxLOD;
 uniform sampler2D qrk_ggxIntegrationMap;
 
 void main() {
+  vec2 gBufferCoords = texCoords * qrk_renderScale;
   // Extract G-Buffer for PBR rendering.
-  vec3 fragPos_viewSpace = texture(gPositionAO, texCoords).rgb;
-  float fragAO = texture(gPositionAO, texCoords).a;
-  vec3 fragNormal_viewSpace = texture(gNormalRoughness, texCoords).rgb;
-  float fragRoughness = texture(gNormalRoughness, texCoords).a;
-  vec3 fragAlbedo = texture(gAlbedoMetallic, texCoords).rgb;
-  float fragMetallic = texture(gAlbedoMetallic, texCoords).a;
-  vec3 fragEmission = texture(gEmission, texCoords).rgb;
+  float fragDepth = texture(gDepth, gBufferCoords).r;
+  if (fragDepth == 1.0) {
+    // Nothing was drawn here; the skybox fills it in the forward pass.
+    fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    return;
+  }
+  vec3 fragPos_viewSpace =
+      qrk_viewPosFromDepth(fragDepth, texCoords, inverseProjection);
+  vec3 fragNormal_viewSpace =
+      qrk_decodeNormalOctahedral(texture(gNormal, gBufferCoords).rg);
+  vec4 albedoMetallic = texture(gAlbedoMetallic, gBufferCoords);
+  vec3 fragAlbedo = albedoMetallic.rgb;
+  float fragMetallic = albedoMetallic.a;
+  vec2 roughnessAO = texture(gRoughnessAO, gBufferCoords).rg;
+  float fragRoughness = roughnessAO.r;
+  float fragAO = roughnessAO.g;
+  vec3 fragEmission = texture(gEmission, gBufferCoords).rgb;
 
   vec3 color;
 
@@ -57,12 +75,14 @@ void main() {
   if (shadowMapping) {
     float shadowBias =
         qrk_shadowBias(shadowBiasMin, shadowBiasMax, fragNormal_viewSpace,
-                       qrk_directionalLights[0].direction);
+                       qrk_directionalLightData[0].direction.xyz);
     // Since we're in view space, we have to un-project to world space in order
     // to get to the light's view.
-    vec4 fragPos_worldSpace = inverse(view) * vec4(fragPos_viewSpace, 1.0);
-    vec4 fragPos_lightSpace = lightViewProjection * fragPos_worldSpace;
-    shadow = qrk_shadow(shadowMap, fragPos_lightSpace, shadowBias);
+    mat4 inverseView = inverse(view);
+    vec3 fragPos_worldSpace = vec3(inverseView * vec4(fragPos_viewSpace, 1.0));
+    vec3 fragNormal_worldSpace = mat3(inverseView) * fragNormal_viewSpace;
+    shadow = qrk_cascadedShadow(fragPos_worldSpace, fragNormal_worldSpace,
+                                -fragPos_viewSpace.z, shadowBias);
   }
 
   // Ambient occlusion.
@@ -120,5 +140,15 @@ void main() {
                                                          fragPos_viewSpace,
                                                          emissionAttenuation);
 
+  if (shadowMapping && shadowCascadeVis) {
+    const vec3 cascadeColors[QRK_MAX_SHADOW_CASCADES] =
+        vec3[](vec3(1.0, 0.25, 0.25), vec3(0.25, 1.0, 0.25),
+               vec3(0.25, 0.25, 1.0), vec3(1.0, 1.0, 0.25));
+    int cascade = qrk_shadowCascade(-fragPos_viewSpace.z);
+    if (cascade >= 0) {
+      color *= cascadeColors[cascade];
+    }
+  }
+
   fragColor = vec4(color, 1.0);
 }
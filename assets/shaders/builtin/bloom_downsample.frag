@@ -10,13 +10,21 @@ in vec2 texCoords;
 out vec4 fragColor;
 
 uniform sampler2D qrk_bloomMipChain;
+// Set for the first downsample from the HDR image.
+uniform bool qrk_karisAverage;
+
+// Weighs a region by the inverse of its luma, which keeps single very bright
+// texels (fireflies) from dominating the average and flickering as they move.
+float qrk_karisWeight(vec4 color) {
+  float luma = dot(color.rgb, vec3(0.2126, 0.7152, 0.0722));
+  return 1.0 / (1.0 + luma);
+}
 
 void main() {
   // Determine texel size.
   // When rendering from one mip level to another mip of the same texture,
-  // calling code should use GL_TEXTURE_BASE_LEVEL and GL_TEXTURE_MAX_LEVEL to
-  // limit the textures that can be sampled from. When doing this,
-  // textureSize(..., 0) will correctly use the BASE mip level.
+  // calling code samples the source mip through a single level texture view,
+  // so textureSize(..., 0) is the size of that mip.
   vec2 srcTexelSize = 1.0 / vec2(textureSize(qrk_bloomMipChain, 0));
   float offsetX = srcTexelSize.x;
   float offsetY = srcTexelSize.y;
@@ -67,6 +75,27 @@ void main() {
   //       sum((region_weight / 5) for each region that sample is in)
   //
   // This yields the following distribution. The weights all add up to 1.
+  if (qrk_karisAverage) {
+    // The Karis average weighs the regions separately, so they are averaged
+    // on their own before being combined.
+    vec4 center = (itl + itr + ibl + ibr) * 0.25;
+    vec4 topLeft = (etl + ett + ell + ccc) * 0.25;
+    vec4 topRight = (ett + etr + ccc + err) * 0.25;
+    vec4 bottomLeft = (ell + ccc + ebl + ebb) * 0.25;
+    vec4 bottomRight = (ccc + err + ebb + ebr) * 0.25;
+
+    float wc = 0.5 * qrk_karisWeight(center);
+    float wtl = 0.125 * qrk_karisWeight(topLeft);
+    float wtr = 0.125 * qrk_karisWeight(topRight);
+    float wbl = 0.125 * qrk_karisWeight(bottomLeft);
+    float wbr = 0.125 * qrk_karisWeight(bottomRight);
+
+    fragColor = center * wc + topLeft * wtl + topRight * wtr +
+                bottomLeft * wbl + bottomRight * wbr;
+    fragColor /= wc + wtl + wtr + wbl + wbr;
+    return;
+  }
+
   fragColor = ccc * 0.2;
   fragColor += (itl + itr + ibl + ibr) * 0.125;
   fragColor += (ett + ell + err + ebb) * 0.05;
@@ -13,9 +13,11 @@ in VS_OUT {
 }
 fs_in;
 
-layout(location = 0) out vec4 gPositionAO;
-layout(location = 1) out vec4 gNormalRoughness;
-layout(location = 2) out vec4 gAlbedoMetallic;
+// Depth is written by the depth attachment and used to reconstruct positions,
+// so positions are not stored.
+layout(location = 0) out vec2 gNormal;
+layout(location = 1) out vec4 gAlbedoMetallic;
+layout(location = 2) out vec2 gRoughnessAO;
 layout(location = 3) out vec3 gEmission;
 
 uniform QrkMaterial material;
@@ -23,19 +25,18 @@ uniform QrkMaterial material;
 void main() {
   // Fill the G-Buffer.
 
-  // Map the fragment position and AO.
-  gPositionAO.rgb = fs_in.fragPos_viewSpace;
-  gPositionAO.a = qrk_extractAmbientOcclusion(material, fs_in.texCoords);
   // Lookup normal and map from tangent space to view space. Falls back to
   // vertex normal otherwise.
-  gNormalRoughness.rgb =
+  vec3 normal_viewSpace =
       qrk_getNormal(material, fs_in.texCoords, fs_in.fragTBN_viewSpace,
                     fs_in.fragNormal_viewSpace);
-  gNormalRoughness.a = qrk_extractRoughness(material, fs_in.texCoords);
+  gNormal = qrk_encodeNormalOctahedral(normal_viewSpace);
 
   gAlbedoMetallic.rgb = qrk_extractAlbedo(material, fs_in.texCoords);
   gAlbedoMetallic.a = qrk_extractMetallic(material, fs_in.texCoords);
 
-  // We currently don't store anything in the alpha channel.
+  gRoughnessAO.r = qrk_extractRoughness(material, fs_in.texCoords);
+  gRoughnessAO.g = qrk_extractAmbientOcclusion(material, fs_in.texCoords);
+
   gEmission = qrk_extractEmission(material, fs_in.texCoords);
 }
@@ -0,0 +1,62 @@
+#pragma once
+
+// Cascaded shadow maps of the directional light, see CascadedShadowMap in
+// shadows.h.
+
+// Must match MAX_SHADOW_CASCADES.
+#define QRK_MAX_SHADOW_CASCADES 4
+
+uniform sampler2DArrayShadow qrk_shadowMap;
+uniform mat4 qrk_cascadeViewProjections[QRK_MAX_SHADOW_CASCADES];
+// View space distance at which each cascade ends.
+uniform float qrk_cascadeSplits[QRK_MAX_SHADOW_CASCADES];
+// World space size of a shadow map texel in each cascade.
+uniform float qrk_cascadeTexelSizes[QRK_MAX_SHADOW_CASCADES];
+uniform int qrk_shadowCascadeCount;
+
+/** Returns the cascade covering the given view depth, or -1 if none does. */
+int qrk_shadowCascade(float viewDepth) {
+  for (int i = 0; i < qrk_shadowCascadeCount; i++) {
+    if (viewDepth < qrk_cascadeSplits[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Calculate whether the given fragment is in shadow, using the cascade that
+ * covers its view depth. The position is offset along the normal by a texel of
+ * that cascade, so the bias scales with the cascade resolution.
+ * Returns 1.0 if in shadow, 0.0 if not.
+ */
+float qrk_cascadedShadow(vec3 fragPos_worldSpace, vec3 normal_worldSpace,
+                         float viewDepth, float bias) {
+  int cascade = qrk_shadowCascade(viewDepth);
+  if (cascade < 0) {
+    // Beyond the shadow distance.
+    return 0.0;
+  }
+  vec3 offsetPos =
+      fragPos_worldSpace + normal_worldSpace * qrk_cascadeTexelSizes[cascade];
+  vec4 fragPos_lightSpace =
+      qrk_cascadeViewProjections[cascade] * vec4(offsetPos, 1.0);
+  vec3 projectedPos = fragPos_lightSpace.xyz / fragPos_lightSpace.w;
+  projectedPos = projectedPos * 0.5 + 0.5;
+  if (projectedPos.z > 1.0) {
+    // Assume not in shadow.
+    return 0.0;
+  }
+
+  // 3x3 taps, each a bilinear 2x2 hardware comparison.
+  vec2 texelOffset = 1.0 / vec2(textureSize(qrk_shadowMap, /*mip=*/0).xy);
+  float lit = 0.0;
+  for (int x = -1; x <= 1; x++) {
+    for (int y = -1; y <= 1; y++) {
+      lit += texture(qrk_shadowMap,
+                     vec4(projectedPos.xy + vec2(x, y) * texelOffset,
+                          float(cascade), projectedPos.z - bias));
+    }
+  }
+  return 1.0 - lit / 9.0;
+}
@@ -0,0 +1,24 @@
+#version 460 core
+in vec2 gTextureCoord;
+in vec4 gColor;
+
+uniform sampler2D sprite;
+// 没有贴图时画柔和的圆点
+uniform bool useSprite;
+
+out vec4 color;
+
+void main()
+{
+    float alpha;
+    if (useSprite)
+    {
+        alpha = texture(sprite, gTextureCoord).r;
+    }
+    else
+    {
+        float r = length(gTextureCoord * 2.0 - 1.0);
+        alpha = 1.0 - smoothstep(0.5, 1.0, r);
+    }
+    color = vec4(gColor.rgb, gColor.a * alpha);
+}
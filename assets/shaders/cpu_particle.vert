@@ -0,0 +1,23 @@
+#version 460 core
+#pragma qrk_include < particle_billboard.glsl>
+
+// 每个实例一个粒子 数据由CPU每帧写入映射的缓冲 四个角在这里算出
+layout(location = 0) in vec4 positionSize;
+layout(location = 1) in vec4 color;
+
+out vec2 gTextureCoord;
+out vec4 gColor;
+
+uniform mat4 view;
+uniform mat4 proj;
+
+void main()
+{
+    vec3 right_vec = vec3(view[0][0], view[1][0], view[2][0]) * positionSize.w;
+    vec3 up_vec = vec3(view[0][1], view[1][1], view[2][1]) * positionSize.w;
+    vec2 corner = qrk_particleCorner(gl_VertexID);
+    gTextureCoord = corner;
+    gColor = color;
+    gl_Position = proj * view * vec4(positionSize.xyz
+            + (corner.x * 2.f - 1.f) * right_vec + (corner.y * 2.f - 1.f) * up_vec, 1.f);
+}
@@ -12,6 +12,7 @@ uniform float materialShininess;        // material specular shininess
 // varyings (input)
 in vec3 esVertex;
 in vec3 esNormal;
+in vec4 esColor;
 // output
 out vec4 fragColor;
 void main()
@@ -21,8 +22,8 @@ void main()
 	vec3 v = normalize(-p);                       // eye vector
 	float vdn = 1.0 - max(dot(v, n), 0.0);        // the rim contribution
 	 
-	fragColor.a = 1.0;
-	fragColor.rgb = vec3(smoothstep(0.8, 1.0, vdn));
+	fragColor.a = esColor.a;
+	fragColor.rgb = vec3(smoothstep(0.8, 1.0, vdn)) * esColor.rgb;
 	
     // vec3 normal = normalize(esNormal);
     // vec3 light;
@@ -1,16 +1,21 @@
 #version 430 core
-uniform mat4 matrixModelView;
-uniform mat4 matrixNormal;
-uniform mat4 matrixModelViewProjection;
+uniform mat4 view;
+uniform mat4 projection;
 // vertex attribs (input)
 layout(location=0) in vec3 vertexPosition;
 layout(location=1) in vec3 vertexNormal;
+// per-instance attribs (input)
+layout(location=4) in mat4 instanceModel;
+layout(location=8) in vec4 instanceColor;
 // varyings (output)
 out vec3 esVertex;
 out vec3 esNormal;
+out vec4 esColor;
 void main()
 {
+    mat4 matrixModelView = view * instanceModel;
     esVertex = vec3(matrixModelView * vec4(vertexPosition, 1.0));
-    esNormal = vec3(matrixNormal * vec4(vertexNormal, 1.0));
-    gl_Position = matrixModelViewProjection * vec4(vertexPosition, 1.0);
+    esNormal = vec3(matrixModelView * vec4(vertexNormal, 1.0));
+    esColor = instanceColor;
+    gl_Position = projection * matrixModelView * vec4(vertexPosition, 1.0);
 }
@@ -20,4 +20,14 @@ vec4 qrk_depthColor(float near, float far) {
   // Convert depth to 0.0-1.0 range.
   float depthColor = depth / far;
   return vec4(vec3(depthColor), 1.0);
-}
\ No newline at end of file
+}
+
+/**
+ * Un-projects a depth buffer value back to a view space position. `texCoords`
+ * are the screen space coordinates the depth was sampled at.
+ */
+vec3 qrk_viewPosFromDepth(float depth, vec2 texCoords, mat4 inverseProjection) {
+  vec4 pos_clipSpace = vec4(vec3(texCoords, depth) * 2.0 - 1.0, 1.0);
+  vec4 pos_viewSpace = inverseProjection * pos_clipSpace;
+  return pos_viewSpace.xyz / pos_viewSpace.w;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+// Light storage, shared by the lighting shaders and the light cluster
+// binning. Layouts match GpuLightBlock / GpuPointLight / GpuSpotLight in
+// light_control.h.
+
+// Fixed by the size of the light block, must match MAX_DIRECTIONAL_LIGHTS.
+#define QRK_MAX_DIRECTIONAL_LIGHTS 10
+
+struct QrkDirectionalLightData {
+  vec4 direction;
+  vec4 diffuse;
+  vec4 specular;
+};
+
+layout(std140, binding = 0) uniform QrkLightBlock {
+  QrkDirectionalLightData qrk_directionalLightData[QRK_MAX_DIRECTIONAL_LIGHTS];
+  int qrk_directionalLightCount;
+  int qrk_pointLightCount;
+  int qrk_spotLightCount;
+};
+
+struct QrkPointLightData {
+  // xyz: position, w: range of influence.
+  vec4 positionRange;
+  vec4 diffuse;
+  vec4 specular;
+  // xyz: constant, linear, quadratic.
+  vec4 attenuation;
+};
+
+struct QrkSpotLightData {
+  vec4 positionRange;
+  vec4 direction;
+  vec4 diffuse;
+  vec4 specular;
+  vec4 attenuation;
+  // x: inner angle, y: outer angle.
+  vec4 angles;
+};
+
+layout(std430, binding = 1) readonly buffer QrkPointLightBuffer {
+  QrkPointLightData qrk_pointLightData[];
+};
+
+layout(std430, binding = 2) readonly buffer QrkSpotLightBuffer {
+  QrkSpotLightData qrk_spotLightData[];
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+// Cluster grid helpers shared by the binning compute shader and the lighting
+// pass. Mirrored on the CPU in light_clusters.cpp.
+
+uniform ivec3 qrk_clusterGridSize;
+uniform int qrk_maxLightsPerCluster;
+uniform float qrk_clusterNear;
+uniform float qrk_clusterFar;
+
+int qrk_clusterIndex(ivec3 cluster) {
+  return cluster.x +
+         qrk_clusterGridSize.x * (cluster.y + qrk_clusterGridSize.y * cluster.z);
+}
+
+ivec3 qrk_clusterCoords(int clusterIndex) {
+  int sliceSize = qrk_clusterGridSize.x * qrk_clusterGridSize.y;
+  return ivec3(clusterIndex % qrk_clusterGridSize.x,
+               (clusterIndex % sliceSize) / qrk_clusterGridSize.x,
+               clusterIndex / sliceSize);
+}
+
+/**
+ * Returns the depth slice of a (positive) view space depth. Slices are spaced
+ * exponentially between the near and far planes.
+ */
+int qrk_clusterSlice(float viewDepth) {
+  float slice = log(max(viewDepth, qrk_clusterNear) / qrk_clusterNear) *
+                float(qrk_clusterGridSize.z) /
+                log(qrk_clusterFar / qrk_clusterNear);
+  return clamp(int(slice), 0, qrk_clusterGridSize.z - 1);
+}
+
+/** Calculates the view space AABB of a cluster. */
+void qrk_clusterBounds(ivec3 cluster, mat4 inverseProjection,
+                       out vec3 minBounds, out vec3 maxBounds) {
+  float sliceNear =
+      qrk_clusterNear * pow(qrk_clusterFar / qrk_clusterNear,
+                            float(cluster.z) / float(qrk_clusterGridSize.z));
+  float sliceFar =
+      qrk_clusterNear * pow(qrk_clusterFar / qrk_clusterNear,
+                            float(cluster.z + 1) / float(qrk_clusterGridSize.z));
+  vec2 ndcMin = vec2(cluster.xy) / vec2(qrk_clusterGridSize.xy) * 2.0 - 1.0;
+  vec2 ndcMax = vec2(cluster.xy + 1) / vec2(qrk_clusterGridSize.xy) * 2.0 - 1.0;
+
+  minBounds = vec3(3.402823466e+38);
+  maxBounds = vec3(-3.402823466e+38);
+  for (int i = 0; i < 4; i++) {
+    vec2 ndc = vec2((i & 1) != 0 ? ndcMax.x : ndcMin.x,
+                    (i & 2) != 0 ? ndcMax.y : ndcMin.y);
+    // A point on the near plane, which is the direction of the ray through
+    // the corner.
+    vec4 corner = inverseProjection * vec4(ndc, -1.0, 1.0);
+    vec3 ray = corner.xyz / corner.w;
+    vec3 nearPoint = ray * (sliceNear / -ray.z);
+    vec3 farPoint = ray * (sliceFar / -ray.z);
+    minBounds = min(minBounds, min(nearPoint, farPoint));
+    maxBounds = max(maxBounds, max(nearPoint, farPoint));
+  }
+}
+
+bool qrk_sphereIntersectsAabb(vec4 sphere, vec3 minBounds, vec3 maxBounds) {
+  vec3 offset = clamp(sphere.xyz, minBounds, maxBounds) - sphere.xyz;
+  return dot(offset, offset) <= sphere.w * sphere.w;
+}
@@ -9,4 +9,28 @@ vec3 qrk_sampleNormalMap(sampler2D normalMap, vec2 texCoords) {
 }
 
 /** Converts a normal to a color representation, with 100% opacity. */
-vec4 qrk_normalColor(vec3 normal) { return vec4((normal + 1.0) / 2.0, 1.0); }
\ No newline at end of file
+vec4 qrk_normalColor(vec3 normal) { return vec4((normal + 1.0) / 2.0, 1.0); }
+
+/** Folds the lower hemisphere of an octahedral mapping over the diagonals. */
+vec2 qrk_octahedralWrap(vec2 v) {
+  vec2 signs = vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+  return (1.0 - abs(v.yx)) * signs;
+}
+
+/**
+ * Encodes a normalized vector into two [-1..1] components using an octahedral
+ * mapping. Suited for RG16_SNORM targets.
+ */
+vec2 qrk_encodeNormalOctahedral(vec3 normal) {
+  normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+  return normal.z >= 0.0 ? normal.xy : qrk_octahedralWrap(normal.xy);
+}
+
+/** Decodes a normal encoded with qrk_encodeNormalOctahedral(). */
+vec3 qrk_decodeNormalOctahedral(vec2 encoded) {
+  vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+  float t = clamp(-normal.z, 0.0, 1.0);
+  normal.x += normal.x >= 0.0 ? -t : t;
+  normal.y += normal.y >= 0.0 ? -t : t;
+  return normalize(normal);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Sprite expansion of the fountain particles, shared by the geometry shader
+// and the instanced quad path.
+
+// Half width of a sprite, stretched sprites are twice as long.
+const float QRK_PARTICLE_HALF_WIDTH = .025f;
+
+/**
+ * Returns the half extents of a sprite in world space. With `stretch` the
+ * sprite is long along the on-screen direction of `deltaPosition`, the last
+ * movement of the particle, otherwise it is a square facing the camera.
+ */
+void qrk_particleBillboard(mat4 view, vec3 deltaPosition, bool stretch,
+                           out vec3 right, out vec3 up) {
+  float w = QRK_PARTICLE_HALF_WIDTH;
+  if (!stretch) {
+    right = vec3(view[0][0], view[1][0], view[2][0]) * w;
+    up = vec3(view[0][1], view[1][1], view[2][1]) * w;
+    return;
+  }
+
+  vec3 u = mat3(view) * deltaPosition;  // movement in view
+  float h = w * 2.f;                    // half height
+  float t = 0;
+  float nz = abs(normalize(u).z);
+  // the more the delta position aligns with Z axis
+  // the more t will close to 1 such that h will close to w
+  if (nz > 1.f - 1e-7f)
+    t = (nz - (1.f - 1e-7f)) / 1e-7f;
+  else if (dot(u, u) < 1e-7f)
+    t = (1e-7f - dot(u, u)) / 1e-7f;
+  u.z = 0.f;
+  u = normalize(mix(normalize(u), vec3(1.f, 0.f, 0.f), t));
+  h = mix(h, w, t);
+
+  vec3 v = vec3(-u.y, u.x, 0.f);
+  vec3 a = u * mat3(view);
+  vec3 b = v * mat3(view);
+  right = b * w;
+  up = a * h;
+}
+
+/** Corner of vertex `vertex` of a 4 vertex triangle strip, in [0, 1]^2. */
+vec2 qrk_particleCorner(int vertex) {
+  return vec2(vertex & 1, vertex >> 1);
+}
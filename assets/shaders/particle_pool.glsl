@@ -0,0 +1,68 @@
+#pragma once
+
+// Particle storage of GpuParticlePool, see gpu_particle_pool.h. Attributes are
+// separate std430 arrays, indexed by particle.
+
+#define QRK_PARTICLE_LOCAL_SIZE 256
+
+layout(std430, binding = 9) buffer QrkParticlePositions {
+  // xyz: position, w: alpha.
+  vec4 qrk_particlePositions[];
+};
+
+layout(std430, binding = 10) buffer QrkParticleVelocities {
+  // xyz: velocity, w: remaining life in seconds.
+  vec4 qrk_particleVelocities[];
+};
+
+layout(std430, binding = 11) buffer QrkParticleDeltas {
+  // xyz: movement over the last update.
+  vec4 qrk_particleDeltas[];
+};
+
+struct QrkParticleEmitter {
+  // xyz: position, w: initial speed.
+  vec4 positionSpeed;
+  // x: lifetime, y: lifetime variance.
+  vec4 lifetime;
+  // x: births this frame, y: first emission thread.
+  uvec4 births;
+};
+
+layout(std430, binding = 12) readonly buffer QrkParticleEmitters {
+  QrkParticleEmitter qrk_particleEmitters[];
+};
+
+// Also bound as the indirect dispatch and draw buffer, see
+// GpuParticlePool::Simulate().
+layout(std430, binding = 13) buffer QrkParticleCounters {
+  uint qrk_particleEmitArgs[3];
+  uint qrk_particleSimulateArgs[3];
+  // count, instanceCount, first, baseInstance.
+  uint qrk_particleDrawArgs[4];
+  int qrk_particleDeadCount;
+  uint qrk_particleAliveCount[2];
+  uint qrk_particleEmitCount;
+  // Instanced quads, see GpuParticlePool::DrawQuads().
+  uint qrk_particleQuadDrawArgs[4];
+};
+
+// Two lists of qrk_particleCapacity entries each.
+layout(std430, binding = 14) buffer QrkParticleAliveList {
+  uint qrk_particleAliveList[];
+};
+
+layout(std430, binding = 15) buffer QrkParticleDeadList {
+  uint qrk_particleDeadList[];
+};
+
+uniform uint qrk_particleCapacity;
+// Alive list that holds the current particles, the other one receives the
+// survivors.
+uniform uint qrk_particleCurrentList;
+
+/** Returns the particle of entry `i` of the current alive list. */
+uint qrk_particleAlive(uint i) {
+  return qrk_particleAliveList[qrk_particleCurrentList * qrk_particleCapacity +
+                               i];
+}
@@ -0,0 +1,73 @@
+#pragma once
+#pragma qrk_include < particle_pool.glsl>
+
+// Compute side of GpuParticlePool, see gpu_particle_pool.h. A simulation
+// shader is dispatched once to emit and once to update.
+
+uniform uint qrk_numParticleEmitters;
+// Set for the dispatch that spawns this frame's births.
+uniform bool qrk_particleEmit;
+
+/** Linear index of this thread, across dispatches larger than one dimension. */
+uint qrk_particleThread() {
+  return gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x +
+         gl_GlobalInvocationID.x;
+}
+
+/**
+ * Pops a dead particle for this emission thread, and returns it with its
+ * emitter. Returns false for threads past this frame's births.
+ */
+bool qrk_particleEmitIndex(out uint particle, out uint emitter) {
+  uint thread = qrk_particleThread();
+  if (thread >= qrk_particleEmitCount) {
+    return false;
+  }
+  // Last emitter whose first thread is at or before `thread`. Emitters without
+  // births share their first thread with the next one, and lose.
+  uint lo = 0;
+  uint hi = qrk_numParticleEmitters - 1;
+  while (lo < hi) {
+    uint mid = (lo + hi + 1) / 2;
+    if (qrk_particleEmitters[mid].births.y <= thread) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  emitter = lo;
+
+  // The emission count is capped to the dead count, so this never underflows.
+  int dead = atomicAdd(qrk_particleDeadCount, -1) - 1;
+  particle = qrk_particleDeadList[dead];
+  uint alive = atomicAdd(qrk_particleAliveCount[qrk_particleCurrentList], 1);
+  qrk_particleAliveList[qrk_particleCurrentList * qrk_particleCapacity + alive] =
+      particle;
+  return true;
+}
+
+/**
+ * Returns the live particle of this simulation thread. Returns false for
+ * threads past the alive count.
+ */
+bool qrk_particleSimulateIndex(out uint particle) {
+  uint thread = qrk_particleThread();
+  if (thread >= qrk_particleAliveCount[qrk_particleCurrentList]) {
+    return false;
+  }
+  particle = qrk_particleAlive(thread);
+  return true;
+}
+
+/** Keeps `particle` for the next frame. */
+void qrk_particleSurvive(uint particle) {
+  uint next = 1 - qrk_particleCurrentList;
+  uint alive = atomicAdd(qrk_particleAliveCount[next], 1);
+  qrk_particleAliveList[next * qrk_particleCapacity + alive] = particle;
+}
+
+/** Frees `particle` for emission. */
+void qrk_particleDie(uint particle) {
+  int dead = atomicAdd(qrk_particleDeadCount, 1);
+  qrk_particleDeadList[dead] = particle;
+}
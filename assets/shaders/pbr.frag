@@ -199,7 +199,8 @@ vec3 qrk_shadeDirectionalLightCookTorranceGGX(QrkMaterial material,
 vec3 qrk_shadePointLightCookTorranceGGXDeferred(vec3 albedo, float roughness,
                                                 float metallic,
                                                 QrkPointLight light,
-                                                vec3 fragPos, vec3 normal) {
+                                                vec3 fragPos, vec3 normal,
+                                                float shadow) {
   vec3 lightDir = normalize(light.position - fragPos);
   vec3 viewDir = normalize(-fragPos);
 
@@ -210,8 +211,8 @@ vec3 qrk_shadePointLightCookTorranceGGXDeferred(vec3 albedo, float roughness,
   vec3 result = qrk_shadeCookTorranceGGXDeferred(albedo, roughness, metallic,
                                                  light.diffuse, light.specular,
                                                  lightDir, viewDir, normal);
-  // Apply attenuation.
-  return result * attenuation;
+  // Apply attenuation and shadowing.
+  return result * attenuation * (1.0 - shadow);
 }
 
 /** Calculate shading for a point light source. */
@@ -221,15 +222,15 @@ vec3 qrk_shadePointLightCookTorranceGGX(QrkMaterial material,
   vec3 albedo = qrk_extractAlbedo(material, texCoords);
   float roughness = qrk_extractRoughness(material, texCoords);
   float metallic = qrk_extractMetallic(material, texCoords);
-  return qrk_shadePointLightCookTorranceGGXDeferred(albedo, roughness, metallic,
-                                                    light, fragPos, normal);
+  return qrk_shadePointLightCookTorranceGGXDeferred(
+      albedo, roughness, metallic, light, fragPos, normal, /*shadow=*/0.0);
 }
 
 /** Calculate shading for a spot light source using deferred data. */
 vec3 qrk_shadeSpotLightCookTorranceGGXDeferred(vec3 albedo, float roughness,
                                                float metallic,
                                                QrkSpotLight light, vec3 fragPos,
-                                               vec3 normal) {
+                                               vec3 normal, float shadow) {
   vec3 lightDir = normalize(light.position - fragPos);
   vec3 viewDir = normalize(-fragPos);
 
@@ -242,8 +243,8 @@ vec3 qrk_shadeSpotLightCookTorranceGGXDeferred(vec3 albedo, float roughness,
   vec3 result = qrk_shadeCookTorranceGGXDeferred(albedo, roughness, metallic,
                                                  light.diffuse, light.specular,
                                                  lightDir, viewDir, normal);
-  // Apply attenuation and intensity.
-  return result * attenuation * spotlightIntensity;
+  // Apply attenuation, intensity and shadowing.
+  return result * attenuation * spotlightIntensity * (1.0 - shadow);
 }
 
 /** Calculate shading for a spot light source. */
@@ -253,6 +254,6 @@ vec3 qrk_shadeSpotLightCookTorranceGGX(QrkMaterial material, QrkSpotLight light,
   vec3 albedo = qrk_extractAlbedo(material, texCoords);
   float roughness = qrk_extractRoughness(material, texCoords);
   float metallic = qrk_extractMetallic(material, texCoords);
-  return qrk_shadeSpotLightCookTorranceGGXDeferred(albedo, roughness, metallic,
-                                                   light, fragPos, normal);
+  return qrk_shadeSpotLightCookTorranceGGXDeferred(
+      albedo, roughness, metallic, light, fragPos, normal, /*shadow=*/0.0);
 }
\ No newline at end of file
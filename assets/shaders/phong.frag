@@ -86,7 +86,7 @@ vec3 qrk_shadeDirectionalLightBlinnPhong(QrkMaterial material,
 vec3 qrk_shadePointLightBlinnPhongDeferred(vec3 albedo, vec3 specular,
                                            vec3 ambient, float shininess,
                                            QrkPointLight light, vec3 fragPos,
-                                           vec3 normal, float ao) {
+                                           vec3 normal, float shadow, float ao) {
   vec3 lightDir = normalize(light.position - fragPos);
   vec3 viewDir = normalize(-fragPos);
 
@@ -96,7 +96,7 @@ vec3 qrk_shadePointLightBlinnPhongDeferred(vec3 albedo, vec3 specular,
 
   vec3 result = qrk_shadeBlinnPhongDeferred(
       albedo, specular, ambient, shininess, light.diffuse, light.specular,
-      lightDir, viewDir, normal, /*intensity=*/1.0, /*shadow=*/0.0, ao);
+      lightDir, viewDir, normal, /*intensity=*/1.0, shadow, ao);
   // Apply attenuation.
   return result * attenuation;
 }
@@ -109,14 +109,14 @@ vec3 qrk_shadePointLightBlinnPhong(QrkMaterial material, QrkPointLight light,
   vec3 specular = qrk_extractSpecular(material, texCoords);
   return qrk_shadePointLightBlinnPhongDeferred(
       albedo, specular, material.ambient, material.shininess, light, fragPos,
-      normal, ao);
+      normal, /*shadow=*/0.0, ao);
 }
 
 /** Calculate shading for a spot light source using deferred data. */
 vec3 qrk_shadeSpotLightBlinnPhongDeferred(vec3 albedo, vec3 specular,
                                           vec3 ambient, float shininess,
                                           QrkSpotLight light, vec3 fragPos,
-                                          vec3 normal, float ao) {
+                                          vec3 normal, float shadow, float ao) {
   vec3 lightDir = normalize(light.position - fragPos);
   vec3 viewDir = normalize(-fragPos);
 
@@ -128,7 +128,7 @@ vec3 qrk_shadeSpotLightBlinnPhongDeferred(vec3 albedo, vec3 specular,
 
   vec3 result = qrk_shadeBlinnPhongDeferred(
       albedo, specular, ambient, shininess, light.diffuse, light.specular,
-      lightDir, viewDir, normal, intensity, /*shadow=*/0.0, ao);
+      lightDir, viewDir, normal, intensity, shadow, ao);
   // Apply attenuation.
   return result * attenuation;
 }
@@ -141,5 +141,5 @@ vec3 qrk_shadeSpotLightBlinnPhong(QrkMaterial material, QrkSpotLight light,
   vec3 specular = qrk_extractSpecular(material, texCoords);
   return qrk_shadeSpotLightBlinnPhongDeferred(
       albedo, specular, material.ambient, material.shininess, light, fragPos,
-      normal, ao);
+      normal, /*shadow=*/0.0, ao);
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#pragma qrk_include < light_buffers.glsl>
+
+// Shadows of point and spot lights, packed into the tiles of one depth texture.
+// See ShadowAtlas in shadow_atlas.h.
+
+struct QrkShadowTile {
+  // From view space to the tile's clip space.
+  mat4 viewProjection;
+  // xy: offset, zw: size, in atlas texture coordinates. Zero size for faces
+  // that got no tile.
+  vec4 atlasRect;
+};
+
+layout(std430, binding = 5) readonly buffer QrkShadowTileBuffer {
+  QrkShadowTile qrk_shadowTiles[];
+};
+// First tile of each light, or -1 if it has none. Point lights come first,
+// followed by the spot lights.
+layout(std430, binding = 6) readonly buffer QrkLightShadowBuffer {
+  int qrk_lightShadowTiles[];
+};
+
+uniform sampler2DShadow qrk_shadowAtlas;
+uniform mat4 qrk_shadowViewToWorld;
+uniform bool qrk_localShadows;
+
+/**
+ * Returns the cube face a world space direction points into, in the order
+ * +X, -X, +Y, -Y, +Z, -Z.
+ */
+int qrk_cubeFace(vec3 dir) {
+  vec3 absDir = abs(dir);
+  if (absDir.x >= absDir.y && absDir.x >= absDir.z) {
+    return dir.x > 0.0 ? 0 : 1;
+  }
+  if (absDir.y >= absDir.z) {
+    return dir.y > 0.0 ? 2 : 3;
+  }
+  return dir.z > 0.0 ? 4 : 5;
+}
+
+/**
+ * Calculate whether a view space position is in shadow in the given tile.
+ * Returns 1.0 if in shadow, 0.0 if not.
+ */
+float qrk_sampleShadowTile(int tileIdx, vec3 fragPos) {
+  QrkShadowTile tile = qrk_shadowTiles[tileIdx];
+  if (tile.atlasRect.z == 0.0) {
+    return 0.0;
+  }
+  vec4 fragPos_lightSpace = tile.viewProjection * vec4(fragPos, 1.0);
+  vec3 projectedPos = fragPos_lightSpace.xyz / fragPos_lightSpace.w;
+  projectedPos = projectedPos * 0.5 + 0.5;
+  if (projectedPos.z > 1.0) {
+    return 0.0;
+  }
+
+  // 3x3 taps, each a bilinear 2x2 hardware comparison. Clamped so the filter
+  // never reads a neighboring tile.
+  vec2 texelOffset = 1.0 / vec2(textureSize(qrk_shadowAtlas, /*mip=*/0));
+  vec2 minUV = tile.atlasRect.xy + texelOffset * 0.5;
+  vec2 maxUV = tile.atlasRect.xy + tile.atlasRect.zw - texelOffset * 0.5;
+  vec2 uv = tile.atlasRect.xy + projectedPos.xy * tile.atlasRect.zw;
+  float lit = 0.0;
+  for (int x = -1; x <= 1; x++) {
+    for (int y = -1; y <= 1; y++) {
+      vec2 tapUV = clamp(uv + vec2(x, y) * texelOffset, minUV, maxUV);
+      lit += texture(qrk_shadowAtlas, vec3(tapUV, projectedPos.z));
+    }
+  }
+  return 1.0 - lit / 9.0;
+}
+
+/** Shadow of a point light at a view space position. */
+float qrk_pointLightShadow(int lightIdx, vec3 lightPos, vec3 fragPos) {
+  if (!qrk_localShadows) {
+    return 0.0;
+  }
+  int firstTile = qrk_lightShadowTiles[lightIdx];
+  if (firstTile < 0) {
+    return 0.0;
+  }
+  // The cube faces are aligned to the world axes.
+  vec3 lightToFrag_worldSpace = mat3(qrk_shadowViewToWorld) * (fragPos - lightPos);
+  return qrk_sampleShadowTile(firstTile + qrk_cubeFace(lightToFrag_worldSpace),
+                              fragPos);
+}
+
+/** Shadow of a spot light at a view space position. */
+float qrk_spotLightShadow(int lightIdx, vec3 fragPos) {
+  if (!qrk_localShadows) {
+    return 0.0;
+  }
+  int firstTile = qrk_lightShadowTiles[qrk_pointLightCount + lightIdx];
+  if (firstTile < 0) {
+    return 0.0;
+  }
+  return qrk_sampleShadowTile(firstTile, fragPos);
+}
@@ -0,0 +1,15 @@
+#version 460 core
+
+in vec3 fragPos_viewSpace;
+in vec3 fragNormal_viewSpace;
+in vec4 fragInstanceColor;
+
+out vec4 fragColor;
+
+void main() {
+  // Simple headlight shading, enough to read the shape of a marker.
+  vec3 normal = normalize(fragNormal_viewSpace);
+  vec3 viewDir = normalize(-fragPos_viewSpace);
+  float diffuse = max(dot(normal, viewDir), 0.0);
+  fragColor = vec4(fragInstanceColor.rgb * (0.2 + 0.8 * diffuse), fragInstanceColor.a);
+}
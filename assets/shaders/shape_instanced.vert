@@ -0,0 +1,25 @@
+#version 460 core
+layout(location = 0) in vec3 vertexPos;
+layout(location = 1) in vec3 vertexNormal;
+// Per-instance attributes, see shape_cache.h.
+layout(location = 4) in mat4 instanceModel;
+layout(location = 8) in vec4 instanceColor;
+
+// Instanced primitive markers (spheres, cubes).
+
+out vec3 fragPos_viewSpace;
+out vec3 fragNormal_viewSpace;
+out vec4 fragInstanceColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+  mat4 modelView = view * instanceModel;
+  vec4 pos_viewSpace = modelView * vec4(vertexPos, 1.0);
+  gl_Position = projection * pos_viewSpace;
+
+  fragPos_viewSpace = pos_viewSpace.xyz;
+  fragNormal_viewSpace = mat3(transpose(inverse(modelView))) * vertexNormal;
+  fragInstanceColor = instanceColor;
+}
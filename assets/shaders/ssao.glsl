@@ -0,0 +1,18 @@
+#pragma once
+
+// Helpers shared by the SSAO passes, see SsaoPass in lighting/ssao.h. The
+// passes work on linear view depth, the positive distance along -z.
+
+/** Linear view depth of a depth buffer value. */
+float qrk_ssaoViewDepth(float depth, vec2 texCoords, mat4 inverseProjection) {
+  vec4 pos_viewSpace =
+      inverseProjection * vec4(vec3(texCoords, depth) * 2.0 - 1.0, 1.0);
+  return -pos_viewSpace.z / pos_viewSpace.w;
+}
+
+/** View space position at the given screen coordinates and linear depth. */
+vec3 qrk_ssaoViewPos(vec2 texCoords, float viewDepth, mat4 inverseProjection) {
+  vec4 ray = inverseProjection * vec4(texCoords * 2.0 - 1.0, -1.0, 1.0);
+  ray.xyz /= ray.w;
+  return ray.xyz * (viewDepth / -ray.z);
+}
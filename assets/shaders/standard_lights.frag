@@ -2,21 +2,69 @@
 
 #pragma qrk_include < lighting.frag>
 #pragma qrk_include < pbr.frag>
+#pragma qrk_include < light_buffers.glsl>
+#pragma qrk_include < light_clusters.glsl>
+#pragma qrk_include < shadow_atlas.glsl>
 
-#ifndef QRK_MAX_DIRECTIONAL_LIGHTS
-#define QRK_MAX_DIRECTIONAL_LIGHTS 10
-#endif
-uniform QrkDirectionalLight qrk_directionalLights[QRK_MAX_DIRECTIONAL_LIGHTS];
-uniform int qrk_directionalLightCount;
-
-#ifndef QRK_MAX_POINT_LIGHTS
-#define QRK_MAX_POINT_LIGHTS 10
-#endif
-uniform QrkPointLight qrk_pointLights[QRK_MAX_POINT_LIGHTS];
-uniform int qrk_pointLightCount;
-
-#ifndef QRK_MAX_SPOT_LIGHTS
-#define QRK_MAX_SPOT_LIGHTS 10
-#endif
-uniform QrkSpotLight qrk_spotLights[QRK_MAX_SPOT_LIGHTS];
-uniform int qrk_spotLightCount;
\ No newline at end of file
+// Point and spot lights live in storage buffers (see light_buffers.glsl), so
+// their count is unbounded. Deferred shading only visits the lights binned
+// into the cluster of the fragment.
+
+// x: point light count, y: spot light count.
+layout(std430, binding = 3) readonly buffer QrkLightClusterBuffer {
+  uvec2 qrk_lightClusters[];
+};
+layout(std430, binding = 4) readonly buffer QrkLightIndexBuffer {
+  uint qrk_lightIndices[];
+};
+// Size of the target the lighting pass renders to.
+uniform vec2 qrk_clusterScreenSize;
+
+QrkDirectionalLight qrk_getDirectionalLight(int i) {
+  QrkDirectionalLightData data = qrk_directionalLightData[i];
+  QrkDirectionalLight light;
+  light.direction = data.direction.xyz;
+  light.diffuse = data.diffuse.rgb;
+  light.specular = data.specular.rgb;
+  return light;
+}
+
+QrkPointLight qrk_getPointLight(int i) {
+  QrkPointLightData data = qrk_pointLightData[i];
+  QrkPointLight light;
+  light.position = data.positionRange.xyz;
+  light.diffuse = data.diffuse.rgb;
+  light.specular = data.specular.rgb;
+  light.attenuation.constant = data.attenuation.x;
+  light.attenuation.linear = data.attenuation.y;
+  light.attenuation.quadratic = data.attenuation.z;
+  return light;
+}
+
+QrkSpotLight qrk_getSpotLight(int i) {
+  QrkSpotLightData data = qrk_spotLightData[i];
+  QrkSpotLight light;
+  light.position = data.positionRange.xyz;
+  light.direction = data.direction.xyz;
+  light.innerAngle = data.angles.x;
+  light.outerAngle = data.angles.y;
+  light.diffuse = data.diffuse.rgb;
+  light.specular = data.specular.rgb;
+  light.attenuation.constant = data.attenuation.x;
+  light.attenuation.linear = data.attenuation.y;
+  light.attenuation.quadratic = data.attenuation.z;
+  return light;
+}
+
+/** Returns the cluster of the current fragment at a view space position. */
+int qrk_getFragmentCluster(vec3 fragPos) {
+  ivec2 tile = ivec2(gl_FragCoord.xy / qrk_clusterScreenSize *
+                     vec2(qrk_clusterGridSize.xy));
+  tile = clamp(tile, ivec2(0), qrk_clusterGridSize.xy - 1);
+  return qrk_clusterIndex(ivec3(tile, qrk_clusterSlice(-fragPos.z)));
+}
+
+/** Offset of the cluster's lights in qrk_lightIndices. */
+int qrk_clusterLightOffset(int cluster) {
+  return cluster * qrk_maxLightsPerCluster;
+}
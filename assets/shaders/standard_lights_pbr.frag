@@ -19,7 +19,7 @@ vec3 qrk_shadeAllDirectionalLightsCookTorranceGGX(QrkMaterial material,
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_directionalLightCount; i++) {
     result += qrk_shadeDirectionalLightCookTorranceGGX(
-        material, qrk_directionalLights[i], fragPos, normal, texCoords, shadow);
+        material, qrk_getDirectionalLight(i), fragPos, normal, texCoords, shadow);
   }
   return result;
 }
@@ -31,7 +31,7 @@ vec3 qrk_shadeAllDirectionalLightsCookTorranceGGXDeferred(
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_directionalLightCount; i++) {
     result += qrk_shadeDirectionalLightCookTorranceGGXDeferred(
-        albedo, roughness, metallic, qrk_directionalLights[i], fragPos, normal,
+        albedo, roughness, metallic, qrk_getDirectionalLight(i), fragPos, normal,
         shadow);
   }
   return result;
@@ -42,21 +42,30 @@ vec3 qrk_shadeAllPointLightsCookTorranceGGX(QrkMaterial material, vec3 fragPos,
                                             vec3 normal, vec2 texCoords) {
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_pointLightCount; i++) {
-    result += qrk_shadePointLightCookTorranceGGX(material, qrk_pointLights[i],
+    result += qrk_shadePointLightCookTorranceGGX(material, qrk_getPointLight(i),
                                                  fragPos, normal, texCoords);
   }
   return result;
 }
 
-/** Calculate shading from all active point lights using deferred data. */
+/**
+ * Calculate shading from the point lights in the fragment's cluster using
+ * deferred data.
+ */
 vec3 qrk_shadeAllPointLightsCookTorranceGGXDeferred(vec3 albedo,
                                                     float roughness,
                                                     float metallic,
                                                     vec3 fragPos, vec3 normal) {
+  int cluster = qrk_getFragmentCluster(fragPos);
+  int offset = qrk_clusterLightOffset(cluster);
+  int count = int(qrk_lightClusters[cluster].x);
   vec3 result = vec3(0.0);
-  for (int i = 0; i < qrk_pointLightCount; i++) {
+  for (int i = 0; i < count; i++) {
+    int lightIdx = int(qrk_lightIndices[offset + i]);
+    QrkPointLight light = qrk_getPointLight(lightIdx);
     result += qrk_shadePointLightCookTorranceGGXDeferred(
-        albedo, roughness, metallic, qrk_pointLights[i], fragPos, normal);
+        albedo, roughness, metallic, light, fragPos, normal,
+        qrk_pointLightShadow(lightIdx, light.position, fragPos));
   }
   return result;
 }
@@ -66,20 +75,30 @@ vec3 qrk_shadeAllSpotLightsCookTorranceGGX(QrkMaterial material, vec3 fragPos,
                                            vec3 normal, vec2 texCoords) {
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_spotLightCount; i++) {
-    result += qrk_shadeSpotLightCookTorranceGGX(material, qrk_spotLights[i],
+    result += qrk_shadeSpotLightCookTorranceGGX(material, qrk_getSpotLight(i),
                                                 fragPos, normal, texCoords);
   }
   return result;
 }
 
-/** Calculate shading from all active spot lights using deferred data. */
+/**
+ * Calculate shading from the spot lights in the fragment's cluster using
+ * deferred data.
+ */
 vec3 qrk_shadeAllSpotLightsCookTorranceGGXDeferred(vec3 albedo, float roughness,
                                                    float metallic, vec3 fragPos,
                                                    vec3 normal) {
+  int cluster = qrk_getFragmentCluster(fragPos);
+  // Spot lights follow the point lights in the cluster's list.
+  int offset =
+      qrk_clusterLightOffset(cluster) + int(qrk_lightClusters[cluster].x);
+  int count = int(qrk_lightClusters[cluster].y);
   vec3 result = vec3(0.0);
-  for (int i = 0; i < qrk_spotLightCount; i++) {
+  for (int i = 0; i < count; i++) {
+    int lightIdx = int(qrk_lightIndices[offset + i]);
     result += qrk_shadeSpotLightCookTorranceGGXDeferred(
-        albedo, roughness, metallic, qrk_spotLights[i], fragPos, normal);
+        albedo, roughness, metallic, qrk_getSpotLight(lightIdx), fragPos, normal,
+        qrk_spotLightShadow(lightIdx, fragPos));
   }
   return result;
 }
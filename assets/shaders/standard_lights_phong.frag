@@ -11,7 +11,7 @@ vec3 qrk_shadeAllDirectionalLightsBlinnPhong(QrkMaterial material, vec3 fragPos,
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_directionalLightCount; i++) {
     result += qrk_shadeDirectionalLightBlinnPhong(
-        material, qrk_directionalLights[i], fragPos, normal, texCoords, shadow,
+        material, qrk_getDirectionalLight(i), fragPos, normal, texCoords, shadow,
         ao);
   }
   return result;
@@ -26,7 +26,7 @@ vec3 qrk_shadeAllDirectionalLightsBlinnPhongDeferred(vec3 albedo, vec3 specular,
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_directionalLightCount; i++) {
     result += qrk_shadeDirectionalLightBlinnPhongDeferred(
-        albedo, specular, ambient, shininess, qrk_directionalLights[i], fragPos,
+        albedo, specular, ambient, shininess, qrk_getDirectionalLight(i), fragPos,
         normal, shadow, ao);
   }
   return result;
@@ -37,22 +37,30 @@ vec3 qrk_shadeAllPointLightsBlinnPhong(QrkMaterial material, vec3 fragPos,
                                        vec3 normal, vec2 texCoords, float ao) {
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_pointLightCount; i++) {
-    result += qrk_shadePointLightBlinnPhong(material, qrk_pointLights[i],
+    result += qrk_shadePointLightBlinnPhong(material, qrk_getPointLight(i),
                                             fragPos, normal, texCoords, ao);
   }
   return result;
 }
 
-/** Calculate shading from all active point lights using deferred data. */
+/**
+ * Calculate shading from the point lights in the fragment's cluster using
+ * deferred data.
+ */
 vec3 qrk_shadeAllPointLightsBlinnPhongDeferred(vec3 albedo, vec3 specular,
                                                vec3 ambient, float shininess,
                                                vec3 fragPos, vec3 normal,
                                                float ao) {
+  int cluster = qrk_getFragmentCluster(fragPos);
+  int offset = qrk_clusterLightOffset(cluster);
+  int count = int(qrk_lightClusters[cluster].x);
   vec3 result = vec3(0.0);
-  for (int i = 0; i < qrk_pointLightCount; i++) {
+  for (int i = 0; i < count; i++) {
+    int lightIdx = int(qrk_lightIndices[offset + i]);
+    QrkPointLight light = qrk_getPointLight(lightIdx);
     result += qrk_shadePointLightBlinnPhongDeferred(
-        albedo, specular, ambient, shininess, qrk_pointLights[i], fragPos,
-        normal, ao);
+        albedo, specular, ambient, shininess, light, fragPos, normal,
+        qrk_pointLightShadow(lightIdx, light.position, fragPos), ao);
   }
   return result;
 }
@@ -62,22 +70,31 @@ vec3 qrk_shadeAllSpotLightsBlinnPhong(QrkMaterial material, vec3 fragPos,
                                       vec3 normal, vec2 texCoords, float ao) {
   vec3 result = vec3(0.0);
   for (int i = 0; i < qrk_spotLightCount; i++) {
-    result += qrk_shadeSpotLightBlinnPhong(material, qrk_spotLights[i], fragPos,
+    result += qrk_shadeSpotLightBlinnPhong(material, qrk_getSpotLight(i), fragPos,
                                            normal, texCoords, ao);
   }
   return result;
 }
 
-/** Calculate shading from all active spot lights using deferred data. */
+/**
+ * Calculate shading from the spot lights in the fragment's cluster using
+ * deferred data.
+ */
 vec3 qrk_shadeAllSpotLightsDeferredBlinnPhong(vec3 albedo, vec3 specular,
                                               vec3 ambient, float shininess,
                                               vec3 fragPos, vec3 normal,
                                               float ao) {
+  int cluster = qrk_getFragmentCluster(fragPos);
+  // Spot lights follow the point lights in the cluster's list.
+  int offset =
+      qrk_clusterLightOffset(cluster) + int(qrk_lightClusters[cluster].x);
+  int count = int(qrk_lightClusters[cluster].y);
   vec3 result = vec3(0.0);
-  for (int i = 0; i < qrk_spotLightCount; i++) {
-    result += qrk_shadeSpotLightBlinnPhongDeferred(albedo, specular, ambient,
-                                                   shininess, qrk_spotLights[i],
-                                                   fragPos, normal, ao);
+  for (int i = 0; i < count; i++) {
+    int lightIdx = int(qrk_lightIndices[offset + i]);
+    result += qrk_shadeSpotLightBlinnPhongDeferred(
+        albedo, specular, ambient, shininess, qrk_getSpotLight(lightIdx), fragPos,
+        normal, qrk_spotLightShadow(lightIdx, fragPos), ao);
   }
   return result;
 }
@@ -1,23 +1,47 @@
-#version 430 core
-            
-layout(location = 0) in vec3 pos;
-layout(location = 1) in float life;
-layout(location = 2) in vec3 delta_position;
+#version 460 core
+#pragma qrk_include < particle_pool.glsl>
+#pragma qrk_include < particle_billboard.glsl>
 
+// 粒子从存活列表中取 不再使用顶点属性
+// 两种绘制方式:
+// 1. 点 每个顶点一个粒子 由几何着色器扩展成四边形
+// 2. 实例化四边形 每个实例一个粒子 在这里直接算出四个角 不需要几何着色器
 out VS_OUT
 {
     float alpha;
     vec3 delta_position;
 } primitive;
 
+out vec2 gTextureCoord;
+out float gAlpha;
+
 uniform mat4 modelMatrix;
+uniform mat4 view;
+uniform mat4 proj;
+uniform bool stretch;
+uniform bool quads;
 
 void main()
 {
-    gl_Position = modelMatrix * vec4(pos, 1.0f);
-
-    primitive.alpha = life;
-    primitive.delta_position = delta_position;
-}
+    uint particle = qrk_particleAlive(quads ? gl_InstanceID : gl_VertexID);
+    vec4 position = qrk_particlePositions[particle];
+    vec3 delta_position = qrk_particleDeltas[particle].xyz;
+    vec4 worldPosition = modelMatrix * vec4(position.xyz, 1.0f);
 
+    if (!quads)
+    {
+        gl_Position = worldPosition;
+        primitive.alpha = position.w;
+        primitive.delta_position = delta_position;
+        return;
+    }
 
+    vec3 right_vec;
+    vec3 up_vec;
+    qrk_particleBillboard(view, delta_position, stretch, right_vec, up_vec);
+    vec2 corner = qrk_particleCorner(gl_VertexID);
+    gTextureCoord = corner;
+    gAlpha = position.w;
+    gl_Position = proj * view * vec4(worldPosition.xyz
+            + (corner.x * 2.f - 1.f) * right_vec + (corner.y * 2.f - 1.f) * up_vec, 1.f);
+}
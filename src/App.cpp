@@ -1,7 +1,11 @@
 #include "App.h"
+#include "profiler.h"
+#include "core/frame_clock.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 
@@ -38,7 +42,22 @@ namespace Cme
 
     void App::Init(bool bFullScreen)
     {
-        m_pWindow = new Cme::Window(1920, 1080, "Model Render", false, 0);
+        int width = 1920;
+        int height = 1080;
+        if (m_spBenchmark)
+        {
+            const BenchmarkScript& script = m_spBenchmark->GetScript();
+            width = script.iWidth;
+            height = script.iHeight;
+            Cme::Window::setHeadless(script.eContextApi);
+            m_ModelSceneObj.SetModelPath(script.sModelPath);
+            FrameClock::GetInstance().SetFixedTimestep(script.fTimestep);
+        }
+        if (m_spReplayer)
+        {
+            m_spReplayer->Attach();
+        }
+        m_pWindow = new Cme::Window(width, height, "Model Render", false, 0);
         m_pWindow->setClearColor(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
         m_pWindow->setEscBehavior(Cme::EscBehavior::UNCAPTURE_MOUSE_OR_CLOSE);
 
@@ -60,31 +79,26 @@ namespace Cme
         m_spLightControl = std::make_shared<Cme::LightControl>(m_spCamera->getViewTransform());
         m_spDirectionalLight = std::make_shared<Cme::DirectionalLight>();
         m_spLightControl->AddLight(m_spDirectionalLight);
-
-        TextureParams params;
-        params.filtering = TextureFiltering::BILINEAR;
-        params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
-        m_spMainFb = std::make_shared<Cme::Framebuffer>(m_pWindow->getSize(), Cme::BufferType::COLOR_HDR_ALPHA, params);
-        m_spMainFb->attachRenderbuffer(Cme::BufferType::DEPTH_AND_STENCIL);
+        m_upShadowMap = std::make_unique<Cme::CascadedShadowMap>(m_spDirectionalLight);
+        m_spShadowMapShader = std::make_shared<Cme::ShadowMapShader>();
+        tm.AddTexture("shadowmap", std::vector<std::shared_ptr<Texture>>{m_upShadowMap->getDepthTexture()});
+        m_upShadowAtlas = std::make_unique<Cme::ShadowAtlas>();
+        m_spShadowAtlasShader = std::make_shared<Cme::ShadowAtlasShader>();
+        tm.AddTexture("shadowatlas", std::vector<std::shared_ptr<Texture>>{m_upShadowAtlas->getDepthTexture()});
+        m_upLightClusters = std::make_unique<Cme::LightClusters>();
 
         // Build the G-Buffer and prepare deferred shading.
         m_spGeometryPassShader = std::make_shared<Cme::DeferredGeometryPassShader>();           
 
-        // GBuffer
-        m_spGBuffer = std::make_shared<Cme::GBuffer>(m_pWindow->getSize());
-        tm.AddTexture("gbuffer", m_spGBuffer->GetAllTexture());
-
         // Screen
         m_spScreenQuad = std::make_shared<Cme::ScreenQuadMesh>();
         m_spGBufferVisualShader = std::make_shared<Cme::ScreenShader>(Cme::ShaderPath("assets//model_shaders//gbuffer_visual.frag"));
         m_spLightingPassShader = std::make_shared<Cme::ScreenShader>(Cme::ShaderPath("assets//model_shaders//lighting_pass.frag"));
 
-        // ֻShaderܸUniform 
-        // shaderԶĶ ֻͨglBindTexture߽һ ʵʱǶ
-        m_spPostprocessShader = std::make_shared<Cme::ScreenShader>(Cme::ShaderPath("assets//model_shaders//post_processing.frag"));
+        m_upAutoExposure = std::make_unique<Cme::AutoExposure>();
 
-        // FXAA
-        m_spFxaaShader = std::make_shared<Cme::FXAAShader>();
+        // ֡ GBuffer͸ĻߴĺĿ
+        CreateScreenTargets(m_pWindow->getSize());
 
         // IBL
         constexpr int CUBEMAP_SIZE = 1024;
@@ -112,6 +126,29 @@ namespace Cme
         m_pWaterFountainPS->max_particles = WATER_FOUNTAIN_MAX_PARTICLES;
         m_pWaterFountainPS->birth_rate = m_pWaterFountainPS->max_particles * 1000;
         m_pWaterFountainPS->InitPS(nullptr, 0);
+        // ӳؿԱ ĿǰֻһȪ
+        // Զӳ ÿ֡·ȥ
+        Cme::ParticleEmitter fountain;
+        fountain.birthRate = m_pWaterFountainPS->birth_rate;
+        m_iFountainEmitter = m_pWaterFountainPS->AddEmitter(fountain);
+
+        // CPU ̷ֿ߳ģдӳĻ
+        // 䵽ȪĻͨupdate_fnCPUϷ
+        m_upCpuParticles = std::make_unique<Cme::CpuParticleSystem>();
+        m_upCpuParticles->max_particles = CPU_PARTICLE_MAX_PARTICLES;
+        m_upCpuParticles->birth_rate = CPU_PARTICLE_MAX_PARTICLES / m_upCpuParticles->lifetime;
+        m_upCpuParticles->update_fn = [](Cme::ParticleProperty& particle, float&, float, int)
+        {
+            const float groundHeight = -2.5f;
+            if (particle.position.y < groundHeight && particle.velocity.y < 0.0f)
+            {
+                particle.position.y = groundHeight;
+                particle.velocity *= glm::vec3(0.6f, -0.4f, 0.6f);
+            }
+            return true;
+        };
+        m_upCpuParticles->InitPS(nullptr, 0,
+            Cme::TextureManager::GetInstance().GetTexture(WaterFountainParticleSystem::WATERFOUNTAIN_KEY)[0]->getId());
 
         // ĿǰδϺ ʼȾ ݲ֪ԭ
         // m_pWindow->enableFaceCull();
@@ -123,6 +160,22 @@ namespace Cme
         m_spPipeFirst = std::make_shared<Pipe>(0.0f, glm::vec3(0.0, 1.0, 0.0));
         m_spPipeSecond = std::make_shared<Pipe>(3.4f, glm::vec3(0.0, 0.0, 1.0));
 
+        // ӰͶ ģǾ̬ ܵÿ֡ڶ
+        m_upShadowMap->AddCaster(Cme::ShadowCasterType::STATIC,
+            [this](Cme::Shader& shader) { m_ModelSceneObj.RenderDepth(m_OptsObj, shader); });
+        m_upShadowMap->AddCaster(Cme::ShadowCasterType::DYNAMIC,
+            [this](Cme::Shader& shader) { m_spPipeFirst->RenderDepth(shader); });
+        m_upShadowMap->AddCaster(Cme::ShadowCasterType::DYNAMIC,
+            [this](Cme::Shader& shader) { m_spPipeSecond->RenderDepth(shader); });
+        // Ӱͼÿ֡Ⱦ ־̬Ͷ̬
+        m_upShadowAtlas->AddCaster([this](Cme::Shader& shader) { m_ModelSceneObj.RenderDepth(m_OptsObj, shader); });
+        m_upShadowAtlas->AddCaster([this](Cme::Shader& shader) { m_spPipeFirst->RenderDepth(shader); });
+        m_upShadowAtlas->AddCaster([this](Cme::Shader& shader) { m_spPipeSecond->RenderDepth(shader); });
+
+        // ͼ
+        m_upFrameCapture = std::make_unique<FrameCapture>();
+        m_pWindow->addKeyPressHandler(GLFW_KEY_F12, [this](int) { m_OptsObj.captureScreenshot = true; });
+
         // 
         m_spText = std::make_shared<Text>();
         m_spText->setFontHeight(static_cast<std::size_t>(40));
@@ -130,12 +183,72 @@ namespace Cme
         m_spText->addFont("assets//font//Just_My_Type.otf", 10);
 	}
 
+    void App::CreateScreenTargets(Cme::ImageSize size)
+    {
+        Cme::TextureManager& tm = Cme::TextureManager::GetInstance();
+        m_TargetSize = size;
+
+        // پɵĿ 黹RenderTargetPool ֡ûбþͻᱻͷ
+        // ֡干GBuffer ҪGBuffer
+        m_spMainFb.reset();
+        m_spGBuffer.reset();
+        m_upSsao.reset();
+        m_upBloom.reset();
+        m_upPostProcess.reset();
+        m_upTaa.reset();
+        m_upUpscale.reset();
+
+        TextureParams params;
+        params.filtering = TextureFiltering::BILINEAR;
+        params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+        m_spMainFb = std::make_shared<Cme::Framebuffer>(size, Cme::BufferType::COLOR_HDR_ALPHA, params);
+
+        // GBuffer
+        m_spGBuffer = std::make_shared<Cme::GBuffer>(size);
+        // ´ʱ滻ɵ GLᱻRenderTargetPoolͷ
+        //  ԷԪȻЧ
+        tm.ReplaceTexture("gbuffer", m_spGBuffer->GetAllTexture());
+        // ֱ֡ʹGBuffer ȾǰҪ
+        m_spMainFb->attachSharedTexture(m_spGBuffer->getTexture(Cme::BufferType::DEPTH_AND_STENCIL));
+
+        // SSAO GBuffer֮ ԪҲTextureManager
+        m_upSsao = std::make_unique<Cme::SsaoPass>(size);
+        tm.ReplaceTexture("ssao", m_upSsao->getTextures());
+
+        // ͺ TextureManagerԪ ĻıĬϵ0ŵԪͻ
+        m_upBloom = std::make_unique<Cme::BloomPass>(size);
+        m_upPostProcess = std::make_unique<Cme::PostProcessPass>(size);
+        tm.ReplaceTexture("postprocess", std::vector<std::shared_ptr<Texture>>{m_upBloom->getBloomTexture(), m_spMainFb->GetTexture()});
+        m_upTaa = std::make_unique<Cme::TaaPass>(size);
+        tm.ReplaceTexture("taa", m_upTaa->getTextures());
+        // ֱ̬ Ŀ갴ڳߴ ֻСӿ ·
+        // ´ʱǰű
+        float renderScale = m_upDynamicResolution ? m_upDynamicResolution->getScale() : 1.0f;
+        m_upDynamicResolution = std::make_unique<Cme::DynamicResolution>(size);
+        m_upDynamicResolution->setScale(renderScale);
+        m_upUpscale = std::make_unique<Cme::UpscalePass>(size);
+        tm.ReplaceTexture("upscale", std::vector<std::shared_ptr<Texture>>{m_upUpscale->getTexture()});
+    }
+
 	bool App::Run()
 	{
         ImGuiIO& io = ImGui::GetIO();
         m_pWindow->loop([&](float deltaTime)
         {
+            // ͷż֡ûбõȾĿ
+            Cme::RenderTargetPool::GetInstance().NextFrame();
+
             // ImGui logic.
+            if (m_spBenchmark && m_spBenchmark->Advance(m_pWindow->getRealFrameDelta()))
+            {
+                m_pWindow->requestClose();
+            }
+            if (m_spReplayer && m_spReplayer->IsFinished())
+            {
+                m_pWindow->requestClose();
+            }
+            m_upFrameCapture->Update();
+
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
@@ -143,8 +256,6 @@ namespace Cme
             m_pWindow->setMouseInputPaused(io.WantCaptureMouse);
             m_pWindow->setKeyInputPaused(io.WantCaptureKeyboard);
 
-            m_pWaterFountainPS->Upload();
-
             ModelRenderOptions prevOpts = m_OptsObj;
 
             // ʼ༭
@@ -158,10 +269,29 @@ namespace Cme
             m_OptsObj.numFrameDeltas = m_pWindow->getNumFrameDeltas();
             m_OptsObj.frameDeltasOffset = m_pWindow->getFrameDeltasOffset();
             m_OptsObj.avgFPS = m_pWindow->getAvgFPS();
+            m_OptsObj.shadowAtlasLights = m_upShadowAtlas->getShadowedLightCount();
+            m_OptsObj.shadowAtlasTiles = m_upShadowAtlas->getTileCount();
+            m_OptsObj.renderScale = m_upDynamicResolution->getScale();
 
             // Ⱦ༭
             UI::RenderUI(m_OptsObj, *m_spCamera);
 
+            // ׼ԸǱ༭ѡ
+            if (m_spBenchmark)
+            {
+                m_spBenchmark->ApplyFrame(*m_spCamera, m_OptsObj);
+            }
+
+            // ¼ƻطͱ༭ѡ
+            if (m_spReplayer)
+            {
+                m_spReplayer->Apply(*m_spCamera, m_OptsObj);
+            }
+            if (m_spRecorder)
+            {
+                m_spRecorder->RecordFrame(deltaTime, *m_spCamera, m_OptsObj);
+            }
+
             auto& tm = TextureManager::GetInstance();
 
             // Ⱦ ͹ǿԱ༭
@@ -169,6 +299,42 @@ namespace Cme
             m_spDirectionalLight->setSpecular(m_OptsObj.directionalSpecular * m_OptsObj.directionalIntensity);
             m_spDirectionalLight->setDirection(m_OptsObj.directionalDirection);
 
+            // Դ Ա༭ Χģ˶
+            while ((int)m_vecPointLights.size() > m_OptsObj.numPointLights)
+            {
+                m_spLightControl->RemoveLight(m_vecPointLights.back());
+                m_vecPointLights.pop_back();
+            }
+            while ((int)m_vecPointLights.size() < m_OptsObj.numPointLights)
+            {
+                m_vecPointLights.push_back(std::make_shared<Cme::PointLight>());
+                m_spLightControl->AddLight(m_vecPointLights.back());
+            }
+            {
+                // Attenuation that fades the light out at the configured range.
+                float quadratic = (m_OptsObj.pointLightIntensity / Cme::LIGHT_CUTOFF_INTENSITY - 1.0f) /
+                    (m_OptsObj.pointLightRange * m_OptsObj.pointLightRange);
+                float time = static_cast<float>(FrameClock::GetInstance().GetTime());
+                for (size_t i = 0; i < m_vecPointLights.size(); ++i)
+                {
+                    // Spread the lights over rings with the golden angle, and
+                    // give each a distinct hue.
+                    float fi = static_cast<float>(i);
+                    float radius = 1.0f + 0.25f * static_cast<float>(i % 16);
+                    float angle = fi * 2.39996f + time * (0.2f + 0.05f * static_cast<float>(i % 5));
+                    float height = std::fmod(fi * 0.618034f, 1.0f) * 4.0f - 2.0f;
+                    float hue = std::fmod(fi * 0.618034f + 0.3f, 1.0f);
+                    glm::vec3 color = 0.5f + 0.5f * glm::cos(6.28318f * (hue + glm::vec3(0.0f, 1.0f / 3.0f, 2.0f / 3.0f)));
+
+                    auto& light = m_vecPointLights[i];
+                    light->setPosition(glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle)));
+                    light->setDiffuse(color * m_OptsObj.pointLightIntensity);
+                    light->setSpecular(color * m_OptsObj.pointLightIntensity);
+                    light->setAttenuation({ 1.0f, 0.0f, std::max(quadratic, 0.0f) });
+                    light->setCastShadows(static_cast<int>(i) < m_OptsObj.numShadowedPointLights);
+                }
+            }
+
             m_spCameraControls->setSpeed(m_OptsObj.speed);
             m_spCameraControls->setSensitivity(m_OptsObj.sensitivity);
             m_spCamera->setFov(m_OptsObj.fov);
@@ -198,22 +364,47 @@ namespace Cme
                 m_pWindow->bindCameraControls(m_spCameraControls);
             }
 
-            // Ӹ
-            m_pWaterFountainPS->Update(deltaTime, static_cast<float>(glfwGetTime()));
+            {
+                Cme::ProfileScope profileScope("Scene update");
+
+                // ӳشС仯· ʸųصĴС
+                unsigned int particleCount = static_cast<unsigned int>(std::max(m_OptsObj.particleCount, 1));
+                if (particleCount != m_pWaterFountainPS->total())
+                {
+                    m_pWaterFountainPS->SetMaxParticles(particleCount);
+                    m_pWaterFountainPS->GetEmitter(m_iFountainEmitter).birthRate = particleCount * 1000.0f;
+                }
 
-            // ܵ1
-            m_spPipeFirst->SetThickness(m_OptsObj.fFirstLoveThickness);
-            //m_spPipeFirst->UpdateMaterial(m_OptsObj.vec3FirstLoveMaterialAmbient, m_OptsObj.vec3FirstLoveMaterialDiffuse, m_OptsObj.vec3FirstLoveMaterialSpecular, m_OptsObj.fFirstShininess);
-            m_spPipeFirst->UpdateLight(m_spCamera->getPosition(), m_OptsObj.vec3FirstLoveLightAmbient, m_OptsObj.vec3FirstLoveLightDiffuse, m_OptsObj.vec3FirstLoveLightSpecular);
-            m_spPipeFirst->UpdateRim(m_OptsObj.vec3FirstLoveRimColor, m_OptsObj.fFirstLoveRimWidth, m_OptsObj.fFirstLoveRimStrength);
-            m_spPipeFirst->Update(static_cast<float>(glfwGetTime()));
+                // Ӹ
+                m_pWaterFountainPS->Update(deltaTime, static_cast<float>(FrameClock::GetInstance().GetTime()));
+                if (m_OptsObj.cpuParticles)
+                {
+                    unsigned int cpuParticleCount = static_cast<unsigned int>(std::max(m_OptsObj.cpuParticleCount, 1));
+                    if (cpuParticleCount != m_upCpuParticles->total())
+                    {
+                        m_upCpuParticles->max_particles = cpuParticleCount;
+                        m_upCpuParticles->birth_rate = cpuParticleCount / m_upCpuParticles->lifetime;
+                        m_upCpuParticles->InitPS(nullptr, 0,
+                            Cme::TextureManager::GetInstance().GetTexture(WaterFountainParticleSystem::WATERFOUNTAIN_KEY)[0]->getId());
+                    }
+                    m_upCpuParticles->emitter_position = m_OptsObj.vec3ParticleLocation + glm::vec3(0.0f, -2.5f, 0.0f);
+                    m_upCpuParticles->Update(deltaTime, static_cast<float>(FrameClock::GetInstance().GetTime()));
+                }
 
-            // ܵ2
-            m_spPipeSecond->SetThickness(m_OptsObj.fSecLoveThickness);
-            //m_spPipeSecond->UpdateMaterial(m_OptsObj.vec3SecLoveMaterialAmbient, m_OptsObj.vec3SecLoveMaterialDiffuse, m_OptsObj.vec3SecLoveMaterialSpecular, m_OptsObj.fSecShininess);
-            m_spPipeSecond->UpdateLight(m_spCamera->getPosition(), m_OptsObj.vec3SecLoveLightAmbient, m_OptsObj.vec3SecLoveLightDiffuse, m_OptsObj.vec3SecLoveLightSpecular);
-            m_spPipeSecond->UpdateRim(m_OptsObj.vec3SecLoveRimColor, m_OptsObj.fSecLoveRimWidth, m_OptsObj.fSecLoveRimStrength);
-            m_spPipeSecond->Update(static_cast<float>(glfwGetTime()));
+                // ܵ1
+                m_spPipeFirst->SetThickness(m_OptsObj.fFirstLoveThickness);
+                //m_spPipeFirst->UpdateMaterial(m_OptsObj.vec3FirstLoveMaterialAmbient, m_OptsObj.vec3FirstLoveMaterialDiffuse, m_OptsObj.vec3FirstLoveMaterialSpecular, m_OptsObj.fFirstShininess);
+                m_spPipeFirst->UpdateLight(m_spCamera->getPosition(), m_OptsObj.vec3FirstLoveLightAmbient, m_OptsObj.vec3FirstLoveLightDiffuse, m_OptsObj.vec3FirstLoveLightSpecular);
+                m_spPipeFirst->UpdateRim(m_OptsObj.vec3FirstLoveRimColor, m_OptsObj.fFirstLoveRimWidth, m_OptsObj.fFirstLoveRimStrength);
+                m_spPipeFirst->Update(static_cast<float>(FrameClock::GetInstance().GetTime()));
+
+                // ܵ2
+                m_spPipeSecond->SetThickness(m_OptsObj.fSecLoveThickness);
+                //m_spPipeSecond->UpdateMaterial(m_OptsObj.vec3SecLoveMaterialAmbient, m_OptsObj.vec3SecLoveMaterialDiffuse, m_OptsObj.vec3SecLoveMaterialSpecular, m_OptsObj.fSecShininess);
+                m_spPipeSecond->UpdateLight(m_spCamera->getPosition(), m_OptsObj.vec3SecLoveLightAmbient, m_OptsObj.vec3SecLoveLightDiffuse, m_OptsObj.vec3SecLoveLightSpecular);
+                m_spPipeSecond->UpdateRim(m_OptsObj.vec3SecLoveRimColor, m_OptsObj.fSecLoveRimWidth, m_OptsObj.fSecLoveRimStrength);
+                m_spPipeSecond->Update(static_cast<float>(FrameClock::GetInstance().GetTime()));
+            }
 
             // 
             m_spText->UpdateFont(m_OptsObj.iFontX, m_OptsObj.iFontY, m_OptsObj.iScale, m_OptsObj.vec3FontColor);
@@ -236,6 +427,59 @@ namespace Cme
                 m_spSkybox->LoadSkyboxImage(m_OptsObj.skyboxImage);
             }
 
+            // ڳߴ仯´ĻߴĿ СʱߴΪ0 ԭĿ
+            Cme::ImageSize windowSize = m_pWindow->getSize();
+            if (windowSize != m_TargetSize && windowSize.width > 0 && windowSize.height > 0)
+            {
+                CreateScreenTargets(windowSize);
+            }
+
+            // ֱ̬ ݴڼ¼֡ʱ֡Ⱦߴ
+            m_upDynamicResolution->setMinScale(m_OptsObj.minRenderScale);
+            if (m_OptsObj.dynamicResolution)
+            {
+                m_upDynamicResolution->setTargetFrameTime(1.0f / m_OptsObj.targetFrameRate);
+                m_upDynamicResolution->Update(*m_pWindow);
+            }
+            else
+            {
+                m_upDynamicResolution->setScale(1.0f);
+            }
+            Cme::ImageSize renderSize = m_upDynamicResolution->getRenderSize();
+            Cme::ImageSize screenSize = m_upDynamicResolution->getMaxSize();
+            glm::vec2 renderScale = glm::vec2(renderSize.width, renderSize.height) / glm::vec2(screenSize.width, screenSize.height);
+            m_spGBuffer->setViewportSize(renderSize);
+            m_spMainFb->setViewportSize(renderSize);
+
+            // ʱ俹 ֡ͶӰض TAA֮
+            if (m_OptsObj.taa)
+            {
+                m_upTaa->BeginFrame(*m_spCamera, renderSize);
+            }
+            else
+            {
+                m_spCamera->setJitter(glm::vec2(0.0f));
+                m_upTaa->ResetHistory();
+            }
+
+            // Ӱ ÿ׶һ ̬Ȼᱻ
+            if (m_OptsObj.modelRotation != prevOpts.modelRotation || m_OptsObj.modelScale != prevOpts.modelScale)
+            {
+                m_upShadowMap->InvalidateStaticCasters();
+            }
+            if (m_OptsObj.shadowMapping)
+            {
+                Cme::DebugGroup debugGroup("Shadow pass");
+                m_upShadowMap->setNumCascades(m_OptsObj.shadowCascades);
+                m_upShadowMap->setSplitLambda(m_OptsObj.shadowSplitLambda);
+                m_upShadowMap->setShadowDistance(m_OptsObj.shadowDistance);
+                m_upShadowMap->setStableFit(m_OptsObj.shadowStableFit);
+                m_upShadowMap->setCaching(m_OptsObj.shadowCaching);
+                m_upShadowMap->setRefreshBudgetMs(m_OptsObj.shadowRefreshBudgetMs);
+                m_upShadowMap->Update(*m_spCamera);
+                m_upShadowMap->Render(*m_spShadowMapShader);
+            }
+
             // G-Buffer1 Geometry Pass. Opengl̵̳߼
             {
                 Cme::DebugGroup debugGroup("Geometry pass");
@@ -269,28 +513,11 @@ namespace Cme
             {
                 {
                     Cme::DebugGroup debugGroup("G-Buffer vis");
-                    switch (m_OptsObj.gBufferVis)
-                    {
-                    case GBufferVis::POSITIONS:
-                    case GBufferVis::AO:
-                        m_spScreenQuad->setTexture(m_spGBuffer->getPositionAOTexture());
-                        break;
-                    case GBufferVis::NORMALS:
-                    case GBufferVis::ROUGHNESS:
-                        m_spScreenQuad->setTexture(m_spGBuffer->getNormalRoughnessTexture());
-                        break;
-                    case GBufferVis::ALBEDO:
-                    case GBufferVis::METALLIC:
-                        m_spScreenQuad->setTexture(m_spGBuffer->getAlbedoMetallicTexture());
-                        break;
-                    case GBufferVis::EMISSION:
-                        m_spScreenQuad->setTexture(m_spGBuffer->getEmissionTexture());
-                        break;
-                    case GBufferVis::DISABLED:
-                        break;
-                    };
+                    m_spGBuffer->bindTexture(tm.GetTextureUnit("gbuffer"), *m_spGBufferVisualShader);
+                    m_spGBufferVisualShader->setMat4("inverseProjection", glm::inverse(m_spCamera->getProjectionTransform()));
                     m_spGBufferVisualShader->setInt("gBufferVis", static_cast<int>(m_OptsObj.gBufferVis));
-                    // GBuffer
+                    m_spGBufferVisualShader->setVec2("qrk_renderScale", renderScale);
+                    m_spScreenQuad->unsetTexture();
                     m_spScreenQuad->draw(*m_spGBufferVisualShader);
                 }
 
@@ -302,24 +529,87 @@ namespace Cme
                 return;
             }
 
+            // ڱ ֱʼ ʱۻ ٰϲȫֱ
+            if (m_OptsObj.ssao)
+            {
+                Cme::DebugGroup debugGroup("SSAO pass");
+                m_upSsao->setResolution(m_OptsObj.ssaoQuarterResolution ? Cme::SsaoResolution::QUARTER
+                    : Cme::SsaoResolution::HALF);
+                m_upSsao->getKernel().setRadius(m_OptsObj.ssaoRadius);
+                m_upSsao->getKernel().setBias(m_OptsObj.ssaoBias);
+                m_upSsao->getKernel().setSize(m_OptsObj.ssaoSamples);
+                m_upSsao->setTemporal(m_OptsObj.ssaoTemporal);
+                m_upSsao->setTemporalBlend(m_OptsObj.ssaoTemporalBlend);
+                m_upSsao->Render(*m_spGBuffer, *m_spCamera, tm.GetTextureUnit("ssao"));
+            }
+            else
+            {
+                // Stale history must not be blended in when SSAO comes back.
+                m_upSsao->ResetHistory();
+            }
+
+            // Դִ ֻиǵصĹԴŲôصĹռ
+            {
+                Cme::DebugGroup debugGroup("Light binning");
+                m_spLightControl->setViewTransform(m_spCamera->getViewTransform());
+                m_spLightControl->updateLightBuffers();
+                m_upLightClusters->Build(*m_spLightControl, m_spCamera->getProjectionTransform(),
+                    m_spCamera->getNearPlane(), m_spCamera->getFarPlane());
+
+                if (m_OptsObj.validateLightClusters)
+                {
+                    int mismatches = m_upLightClusters->Validate(*m_spLightControl, m_spCamera->getProjectionTransform(),
+                        m_spCamera->getNearPlane(), m_spCamera->getFarPlane());
+                    // ׼ÿ֡ ֻһµ֡ ʹʧ ޽
+                    if (!m_spBenchmark || mismatches > 0)
+                    {
+                        std::cout << "Light clusters: " << mismatches << " of " << m_upLightClusters->GetGrid().GetClusterCount()
+                            << " clusters differ from the CPU reference" << std::endl;
+                    }
+                    if (m_spBenchmark && mismatches > 0)
+                    {
+                        m_spBenchmark->AddFailure("validateLightClusters");
+                    }
+                    m_OptsObj.validateLightClusters = false;
+                }
+            }
+
+            // Դ;۹Ӱ ĻǷͼеĿ һλƸпɼ
+            if (m_OptsObj.localShadows)
+            {
+                Cme::DebugGroup debugGroup("Shadow atlas pass");
+                m_upShadowAtlas->setCoverageScale(m_OptsObj.shadowAtlasCoverageScale);
+                m_upShadowAtlas->Update(*m_spLightControl, *m_spCamera, renderSize);
+                m_upShadowAtlas->Render(*m_spShadowAtlasShader);
+            }
+
             // G-Buffer2 Lighting Pass. Draw to the main framebuffer.
             {
                 Cme::DebugGroup debugGroup("Deferred lighting pass");
                 // m_spMainFbidΪ1
                 m_spMainFb->activate();
-                m_spMainFb->clear();
+                // GBuffer ֻɫ
+                m_spMainFb->clear(GL_COLOR_BUFFER_BIT);
 
                 // TODO: Set up environment mapping with the skybox.
                 // ʱд ڸm_spLightingPassShaderһЩ Ų˳ Ϊ˰texture_uniform_sourceɵ
                 // ʹm_spGBuffer->bindTexture ôm_spScreenQuad->drawҲҪ仯 ʱҪŪһmanager רŹTextureUniformSource
                 m_spGBuffer->bindTexture(tm.GetTextureUnit("gbuffer"), *m_spLightingPassShader);              // ShaderõGBuffer
                 m_spBrdfMap->bindTexture(tm.GetTextureUnit("brdf"), *m_spLightingPassShader);                 // Shaderõbrdf
-                m_spLightControl->updateUniforms(*m_spLightingPassShader);                                    // Shader
-
+                m_spLightControl->bindLightBuffers();                                                         // Դ
+                m_upLightClusters->updateUniforms(*m_spLightingPassShader, renderSize);
+                m_spLightingPassShader->setVec2("qrk_renderScale", renderScale);
+
+                // ӰʹرӰҲҪ ͳͻ
+                m_upShadowMap->bindTexture(tm.GetTextureUnit("shadowmap"), *m_spLightingPassShader);
+                m_upShadowAtlas->bindTexture(tm.GetTextureUnit("shadowatlas"), *m_spLightingPassShader);
+                m_spLightingPassShader->setBool("qrk_localShadows", m_OptsObj.localShadows);
                 m_spLightingPassShader->setBool("shadowMapping", m_OptsObj.shadowMapping);
+                m_spLightingPassShader->setBool("shadowCascadeVis", m_OptsObj.shadowCascadeVis);
                 m_spLightingPassShader->setFloat("shadowBiasMin", m_OptsObj.shadowBiasMin);
                 m_spLightingPassShader->setFloat("shadowBiasMax", m_OptsObj.shadowBiasMax);
                 m_spLightingPassShader->setBool("useIBL", m_OptsObj.useIBL);
+                m_upSsao->bindTexture(tm.GetTextureUnit("ssao"), *m_spLightingPassShader);
                 m_spLightingPassShader->setBool("ssao", m_OptsObj.ssao);
                 m_spLightingPassShader->setInt("lightingModel", static_cast<int>(m_OptsObj.lightingModel));
                 // TODO: Pull this out into a material class.
@@ -332,9 +622,13 @@ namespace Cme
 
                 m_spLightingPassShader->setMat4("view", m_spCamera->getViewTransform());
                 m_spLightingPassShader->setMat4("projection", m_spCamera->getProjectionTransform());
+                m_spLightingPassShader->setMat4("inverseProjection", glm::inverse(m_spCamera->getProjectionTransform()));
 
                 m_spScreenQuad->unsetTexture();
+                // ĻıβͨȲ Ҳд빲GBuffer
+                m_pWindow->disableDepthTest();
                 m_spScreenQuad->draw(*m_spLightingPassShader);
+                m_pWindow->enableDepthTest();
 
                 m_spMainFb->deactivate();
             }
@@ -344,9 +638,8 @@ namespace Cme
             {
                 Cme::DebugGroup debugGroup("Forward pass");
 
-                // Before we do so, we have to blit the depth buffer.
-                m_spGBuffer->blit(*m_spMainFb, GL_DEPTH_BUFFER_BIT);
-
+                // The main framebuffer shares the G-Buffer's depth, so no blit
+                // is needed before drawing.
                 m_spMainFb->activate();
 
                 if (m_OptsObj.drawNormals)
@@ -359,75 +652,143 @@ namespace Cme
                 //m_spLampShader->updateUniforms();
                 // պ պȾ
                 m_spSkybox->Render(*m_spSkyboxShader, m_spCamera);
+
+                // Ⱦ Ⱦ
+                // Opengl̳ӳɫ½е----ӳȾȾ
+                // ӻ֡ GBuffer ܱڵ
+                // Һͳһ𾭹TAAͺ
+                // оҪעInitеenableFaceCull()
+                m_pWaterFountainPS->SetCamera(m_spCamera);
+                m_pWaterFountainPS->SetRendering(m_OptsObj.particleRendering);
+                m_pWaterFountainPS->SetStretch(m_OptsObj.particleStretch);
+                m_pWaterFountainPS->SetBlending(m_OptsObj.particleBlending);
+                if (!m_OptsObj.bChangeParticleColorByTime)
+                {
+                    m_pWaterFountainPS->SetParticleColor(m_OptsObj.vec3ParticleColor);
+                }
+                else
+                {
+                    // ʱ仯ɫ
+                    auto fT = FrameClock::GetInstance().GetTime();
+                    float r = (sin(fT) / 2.0f + 0.5f);
+                    float g = (cos(fT) / 2.0f + 0.5f);
+                    float b = (sin(fT / 2.0) / 2.0f + 0.5f);
+                    m_pWaterFountainPS->SetParticleColor(glm::vec3(r, g, b));
+                }
+
+                // Ȫ
+                {
+                    Cme::DebugGroup debugGroup("Particles");
+                    m_pWaterFountainPS->Render();
+                    if (m_OptsObj.cpuParticles)
+                    {
+                        m_upCpuParticles->SetCamera(m_spCamera);
+                        m_upCpuParticles->Render();
+                    }
+                }
                 m_spMainFb->deactivate();
             }
 
-            // 
+            // ͷֱȾʱ ֡ӿϲߴ ֮Ĳ趼ߴϽ
+            if (renderSize != screenSize)
             {
-                Cme::DebugGroup debugGroup("Tonemap & gamma");
-                m_spMainFb->activate();
-
-                // Draw to the final FB using the post process shader.
-                m_spPostprocessShader->setBool("bloom", m_OptsObj.bloom);
-                m_spPostprocessShader->setFloat("bloomMix", m_OptsObj.bloomMix);
-                m_spPostprocessShader->setInt("toneMapping", static_cast<int>(m_OptsObj.toneMapping));
-                m_spPostprocessShader->setBool("gammaCorrect", m_OptsObj.gammaCorrect);
-                m_spPostprocessShader->setFloat("gamma", static_cast<int>(m_OptsObj.gamma));
-                m_spScreenQuad->setTexture(m_spMainFb->GetTexture());
-
-                //  
-                m_spScreenQuad->draw(*m_spPostprocessShader);
+                Cme::DebugGroup debugGroup("Upscale pass");
+                m_upUpscale->setSharpness(m_OptsObj.upscaleSharpness);
+                m_upUpscale->Render(*m_spMainFb->GetTexture(), renderSize, tm.GetTextureUnit("upscale"));
+            }
+            m_spMainFb->setViewportSize(screenSize);
 
-                m_spMainFb->deactivate();
+            // ʱ俹 HDRͼͶӰʷ д֡
+            if (m_OptsObj.taa)
+            {
+                Cme::DebugGroup debugGroup("TAA pass");
+                m_upTaa->setBlend(m_OptsObj.taaBlend);
+                m_upTaa->Render(*m_spMainFb->GetTexture(), *m_spGBuffer, *m_spCamera, tm.GetTextureUnit("taa"));
             }
 
-            m_pWindow->setViewport();
+            //  HDR֡彵mipϲ
+            if (m_OptsObj.bloom)
+            {
+                Cme::DebugGroup debugGroup("Bloom pass");
+                m_upBloom->setFilterRadius(m_OptsObj.bloomFilterRadius);
+                m_upBloom->Render(*m_spMainFb->GetTexture(), *m_spScreenQuad, tm.GetTextureUnit("postprocess"));
+            }
 
-            //// Finally draw to the screen via the FXAA shader.
-            //if (m_OptsObj.fxaa)
-            //{
-            //    Cme::DebugGroup debugGroup("FXAA");
-            //    m_spScreenQuad->setTexture(m_FinalColorAttachmentObj);
-            //    // fxaa
-            //    m_spScreenQuad->draw(*m_spFxaaShader);
-            //}
-            //else
-            //{
-            m_spMainFb->blitToDefault(GL_COLOR_BUFFER_BIT);
-
-            //}
-
-            // Ⱦ Ⱦ
-            // Opengl̳ӳɫ½е----ӳȾȾ
-            // ֪ȾһҪglBlitFramebuffer֮
-            // оҪעInitеenableFaceCull()
-            m_pWaterFountainPS->SetCamera(m_spCamera);
-            if (!m_OptsObj.bChangeParticleColorByTime)
-            {
-                m_pWaterFountainPS->SetParticleColor(m_OptsObj.vec3ParticleColor);
+            // 
+            // Զع ͳHDRͼĶֱͼ عֵضCPU
+            if (m_OptsObj.autoExposure)
+            {
+                Cme::DebugGroup debugGroup("Auto exposure");
+                m_upAutoExposure->setAdaptationSpeed(m_OptsObj.exposureAdaptationSpeed);
+                m_upAutoExposure->Update(*m_spMainFb->GetTexture(), deltaTime, tm.GetTextureUnit("postprocess"));
             }
             else
             {
-                // ʱ仯ɫ
-                auto fT = glfwGetTime();
-                float r = (sin(fT) / 2.0f + 0.5f);
-                float g = (cos(fT) / 2.0f + 0.5f);
-                float b = (sin(fT / 2.0) / 2.0f + 0.5f);
-                m_pWaterFountainPS->SetParticleColor(glm::vec3(r, g, b));
+                // ¿ʱֱʹòõع Ӿֵ
+                m_upAutoExposure->ResetHistory();
+            }
+
+            {
+                Cme::DebugGroup debugGroup("Post-process pass");
+                m_upPostProcess->setBloom(m_OptsObj.bloom);
+                m_upPostProcess->setBloomMix(m_OptsObj.bloomMix);
+                m_upPostProcess->setExposure(m_OptsObj.exposure);
+                m_upPostProcess->setAutoExposure(m_OptsObj.autoExposure);
+                m_upAutoExposure->bindExposureBuffer();
+                m_upPostProcess->setToneMapping(static_cast<int>(m_OptsObj.toneMapping));
+                m_upPostProcess->setGammaCorrect(m_OptsObj.gammaCorrect);
+                m_upPostProcess->setGamma(m_OptsObj.gamma);
+                m_upPostProcess->setFxaa(m_OptsObj.fxaa);
+                // ֡ͷʹTextureManagerԪ
+                m_upPostProcess->Render(*m_spMainFb->GetTexture(), *m_upBloom->getBloomTexture(),
+                    tm.GetTextureUnit("postprocess"));
+            }
+
+            // ͼ 첽ض Ⱦ߳
+            if (m_OptsObj.captureScreenshot || m_OptsObj.captureSequence)
+            {
+                CaptureFormat eFormat = m_OptsObj.captureExr ? CaptureFormat::EXR : CaptureFormat::PNG;
+                const char* extension = m_OptsObj.captureExr ? ".exr" : ".png";
+                std::string sPath;
+                if (m_OptsObj.captureSequence)
+                {
+                    std::filesystem::create_directories("capture");
+                    char name[32];
+                    snprintf(name, sizeof(name), "frame_%06u", m_uiSequenceFrame++);
+                    sPath = std::string("capture/") + name + extension;
+                }
+                else
+                {
+                    sPath = "screenshot_" + std::to_string(m_pWindow->getFrameCount()) + extension;
+                }
+                // EXRɫӳǰHDRͼ PNGʾͼ
+                std::shared_ptr<Texture> spCaptured = m_OptsObj.captureExr ? m_spMainFb->GetTexture() : m_upPostProcess->getTexture();
+                m_upFrameCapture->Capture(*spCaptured, sPath, eFormat);
+                m_OptsObj.captureScreenshot = false;
             }
-            
-            // Ȫ
-            m_pWaterFountainPS->Render();
+
+            m_pWindow->setViewport();
+
+            m_upPostProcess->Present();
 
             // Բ
-            m_spCylinder->Render(m_spCamera);
+            {
+                Cme::DebugGroup debugGroup("Cylinder");
+                m_spCylinder->Render(m_spCamera);
+            }
 
             // ܵ
-            m_spPipeFirst->Render(m_spCamera);
-            m_spPipeSecond->Render(m_spCamera);
+            {
+                Cme::DebugGroup debugGroup("Pipes");
+                m_spPipeFirst->Render(m_spCamera);
+                m_spPipeSecond->Render(m_spCamera);
+            }
 
             // 
-            m_spText->Render("DWR:  CMQ", Anchor::LeftTop, m_spCamera);
+            {
+                Cme::DebugGroup debugGroup("Text");
+                m_spText->Render("DWR:  CMQ", Anchor::LeftTop, m_spCamera);
+            }
 
             // Finally, draw ImGui data.
             {
@@ -438,10 +799,16 @@ namespace Cme
         });
 
         // Cleanup.
+        // Pending captures are written while the context is still current.
+        m_upFrameCapture.reset();
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
 
+        if (m_spBenchmark)
+        {
+            return m_spBenchmark->Finish();
+        }
         return true;
 	}
 
@@ -1,8 +1,12 @@
 #pragma once
 
 // ͷļ
-#include "fxaa.h"
 #include "blur.h"
+#include "bloom.h"
+#include "taa.h"
+#include "dynamic_resolution.h"
+#include "post_process.h"
+#include "auto_exposure.h"
 #include "camera.h"
 #include "cubemap.h"
 #include "debug.h"
@@ -16,6 +20,7 @@
 
 #include "lighting/light.h"
 #include "lighting/light_control.h"
+#include "lighting/light_clusters.h"
 
 #include "shape/mesh.h"
 #include "shape/screenquad_mesh.h"
@@ -31,6 +36,7 @@
 #include "shader/shader_loader.h"
 #include "shader/shader_primitives.h"
 #include "shadows.h"
+#include "shadow_atlas.h"
 #include "lighting/ssao.h"
 #include "lighting/ssao_kernel.h"
 #include "core/texture.h"
@@ -40,10 +46,15 @@
 #include "window.h"
 #include "cme_defs.h"
 #include "core/texture_manager.h"
+#include "core/render_target_pool.h"
 #include "UI/ui.h"
 #include "font/text.h"
+#include "benchmark.h"
+#include "session_log.h"
+#include "capture/frame_capture.h"
 
 #include "particle/water_fountain_particle_system.h"
+#include "particle/cpu_particle_system.h"
 
 #include <memory>
 #include <iostream>
@@ -56,8 +67,8 @@ namespace Cme
     struct UIContext
     {
         Cme::Camera& camera;
-        Cme::ShadowMap& shadowMap;
-        Cme::SsaoBuffer& ssaoBuffer;
+        Cme::CascadedShadowMap& shadowMap;
+        Cme::SsaoPass& ssao;
     };
 
 	class App
@@ -66,7 +77,16 @@ namespace Cme
 		//static App* Instance();     
 
 		void Init(bool bFullScreen = true);
+		// Returns false if a benchmark run regressed against its baseline.
 		bool Run();
+		// Must be called before Init. The app then runs the benchmark script
+		// offscreen and exits when it is done.
+		void SetBenchmark(std::shared_ptr<Benchmark> spBenchmark) { m_spBenchmark = spBenchmark; }
+		// Records every frame's delta, camera and options to a session log.
+		void SetRecorder(std::shared_ptr<SessionRecorder> spRecorder) { m_spRecorder = spRecorder; }
+		// Must be called before Init. Replays a session log with its recorded
+		// deltas and exits at its end.
+		void SetReplayer(std::shared_ptr<SessionReplayer> spReplayer) { m_spReplayer = spReplayer; }
 		void Restart();
 		void Close();
 
@@ -75,7 +95,13 @@ namespace Cme
         ~App();
 
 	private:
+		// (Re)creates the render targets that follow the window size. Called
+		// from Init, and from the frame loop once the window has been resized.
+		void CreateScreenTargets(Cme::ImageSize size);
+
 		Cme::Window* m_pWindow;
+		// Size the screen targets were created for.
+		Cme::ImageSize m_TargetSize;
 
         // AppпƱ༭
         ModelRenderOptions m_OptsObj;
@@ -94,6 +120,11 @@ namespace Cme
         std::shared_ptr<Cme::BrdfMap> m_spBrdfMap;
 
         std::shared_ptr<Cme::DirectionalLight> m_spDirectionalLight;
+        // ƽйļӰ мһPassȾ
+        std::unique_ptr<Cme::CascadedShadowMap> m_upShadowMap;
+        std::shared_ptr<Cme::ShadowMapShader> m_spShadowMapShader;
+        std::unique_ptr<Cme::ShadowAtlas> m_upShadowAtlas;                          // Դ;۹ƵӰͼ
+        std::shared_ptr<Cme::ShadowAtlasShader> m_spShadowAtlasShader;
         // GBuffer 
         // ӳȾ׶(pass) 
         // һδ׶(GeometryPass) Ⱦһ ȡĸּϢ 洢ڽGBuffer
@@ -113,19 +144,26 @@ namespace Cme
         // m_spFinalFbͨBlitܷȾȥ
         // std::shared_ptr<Cme::Framebuffer> m_spFinalFb;
 
-        // FXAA
-        std::shared_ptr<Cme::FXAAShader> m_spFxaaShader;
-        // FXAA
-
         // PostProcess
-        std::shared_ptr<Cme::ScreenShader> m_spPostprocessShader;
+        std::unique_ptr<Cme::AutoExposure> m_upAutoExposure;                        // ֱͼԶع GPU
+        std::unique_ptr<Cme::PostProcessPass> m_upPostProcess;                      // ϳ ع ɫӳ ٤FXAAϲΪһμ
+        std::unique_ptr<Cme::BloomPass> m_upBloom;                                  // mip
+        std::unique_ptr<Cme::TaaPass> m_upTaa;                                      // ʱ俹 ͶӰʷͶӰ
+        std::unique_ptr<Cme::DynamicResolution> m_upDynamicResolution;              // ֱ̬ ֡ʱȾߴ
+        std::unique_ptr<Cme::UpscalePass> m_upUpscale;                              // ԵӦϲ
         // PostProcess
 
         // տ
         std::shared_ptr<Cme::LightControl> m_spLightControl;
+        // ִع Դ;۹ư׶ִ
+        std::unique_ptr<Cme::LightClusters> m_upLightClusters;
+        std::unique_ptr<Cme::SsaoPass> m_upSsao;                                    // ͷֱSSAO ʱۻ˫ϲ
+        std::vector<std::shared_ptr<Cme::PointLight>> m_vecPointLights;
 
         // ϵͳ
         WaterFountainParticleSystem* m_pWaterFountainPS;
+        int m_iFountainEmitter = 0;
+        std::unique_ptr<Cme::CpuParticleSystem> m_upCpuParticles;                  // CPUģĻ Ҫɫ
 
         // Բ
         std::shared_ptr<Cylinder> m_spCylinder;
@@ -136,6 +174,17 @@ namespace Cme
 
         // 
         std::shared_ptr<Text> m_spText;
+
+        // Benchmark
+        std::shared_ptr<Benchmark> m_spBenchmark;
+
+        // ¼ط
+        std::shared_ptr<SessionRecorder> m_spRecorder;
+        std::shared_ptr<SessionReplayer> m_spReplayer;
+
+        // ͼ
+        std::unique_ptr<FrameCapture> m_upFrameCapture;
+        unsigned int m_uiSequenceFrame = 0;
 	};
 }
 
@@ -1,7 +1,43 @@
 #include "ui.h"
+#include "../profiler.h"
+#include "../shadows.h"
+#include "../lighting/ssao_kernel.h"
 
 namespace Cme
 {
+    namespace
+    {
+        // Draws the records at `depth` starting at `index` as tree nodes, with
+        // their children nested below. Advances `index` past the subtree.
+        void renderProfileRecords(const std::vector<ProfileRecord>& records, size_t& index, int depth)
+        {
+            while (index < records.size() && records[index].depth == depth)
+            {
+                const ProfileRecord& record = records[index];
+                bool hasChildren = index + 1 < records.size() && records[index + 1].depth > depth;
+                ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen;
+                if (!hasChildren)
+                {
+                    flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+                }
+                bool open = ImGui::TreeNodeEx((void*)(intptr_t)index, flags,
+                    "%-28s cpu %6.3f ms  gpu %6.3f ms", record.name,
+                    record.GetCpuMs(), record.GetGpuMs());
+                ++index;
+                if (open && hasChildren)
+                {
+                    renderProfileRecords(records, index, depth + 1);
+                    ImGui::TreePop();
+                }
+                // Skip children of a collapsed node.
+                while (index < records.size() && records[index].depth > depth)
+                {
+                    ++index;
+                }
+            }
+        }
+    }
+
 	void UI::SetupUI(GLFWwindow* window)
 	{
 		IMGUI_CHECKVERSION();
@@ -80,6 +116,50 @@ namespace Cme
                 }
                 CommonHelper::imguiFloatSlider("Intensity", &opts.directionalIntensity, 0.0f, 50.0f, nullptr, Scale::LINEAR);
 
+                ImGui::Checkbox("Shadow mapping", &opts.shadowMapping);
+                ImGui::BeginDisabled(!opts.shadowMapping);
+                ImGui::SliderInt("Cascades", &opts.shadowCascades, 1, MAX_SHADOW_CASCADES);
+                CommonHelper::imguiFloatSlider("Split lambda", &opts.shadowSplitLambda, 0.0f, 1.0f, nullptr, Scale::LINEAR);
+                ImGui::SameLine();
+                CommonHelper::imguiHelpMarker("Blend between uniform (0) and logarithmic (1) cascade splits.");
+                CommonHelper::imguiFloatSlider("Shadow distance", &opts.shadowDistance, 1.0f, 500.0f, nullptr, Scale::LOG);
+                ImGui::Checkbox("Stable fit", &opts.shadowStableFit);
+                ImGui::SameLine();
+                CommonHelper::imguiHelpMarker("Fits cascades to spheres so they don't shimmer when the camera "
+                    "rotates, at the cost of some resolution.");
+                CommonHelper::imguiFloatSlider("Bias min", &opts.shadowBiasMin, 0.00001f, 0.01f, nullptr, Scale::LOG);
+                CommonHelper::imguiFloatSlider("Bias max", &opts.shadowBiasMax, 0.00001f, 0.01f, nullptr, Scale::LOG);
+                ImGui::Checkbox("Cache static casters", &opts.shadowCaching);
+                ImGui::SameLine();
+                CommonHelper::imguiHelpMarker("Keeps the depth of static casters until the light, a cascade or "
+                    "the casters change. Far cascades refresh over several frames within the budget.");
+                ImGui::BeginDisabled(!opts.shadowCaching);
+                CommonHelper::imguiFloatSlider("Refresh budget (ms)", &opts.shadowRefreshBudgetMs, 0.0f, 4.0f, nullptr, Scale::LINEAR);
+                ImGui::EndDisabled();
+                ImGui::Checkbox("Visualize cascades", &opts.shadowCascadeVis);
+                ImGui::EndDisabled();
+
+                ImGui::TreePop();
+            }
+
+            if (ImGui::TreeNode("Point lights"))
+            {
+                ImGui::SliderInt("Count", &opts.numPointLights, 0, 4096);
+                ImGui::SameLine();
+                CommonHelper::imguiHelpMarker("Animated point lights around the model. Shaded with clustered "
+                    "lighting, so each pixel only pays for the lights that reach it.");
+                CommonHelper::imguiFloatSlider("Intensity", &opts.pointLightIntensity, 0.0f, 50.0f, nullptr, Scale::LINEAR);
+                CommonHelper::imguiFloatSlider("Range", &opts.pointLightRange, 0.05f, 20.0f, nullptr, Scale::LOG);
+                ImGui::Checkbox("Shadows", &opts.localShadows);
+                ImGui::SameLine();
+                CommonHelper::imguiHelpMarker("Shadows of the first point lights, rendered into tiles of a "
+                    "shared atlas sized by how much of the screen each light covers.");
+                ImGui::BeginDisabled(!opts.localShadows);
+                ImGui::SliderInt("Shadowed lights", &opts.numShadowedPointLights, 0, 64);
+                CommonHelper::imguiFloatSlider("Tile resolution scale", &opts.shadowAtlasCoverageScale, 0.125f, 4.0f, nullptr, Scale::LOG);
+                ImGui::Text("Atlas: %d lights, %d tiles", opts.shadowAtlasLights, opts.shadowAtlasTiles);
+                ImGui::EndDisabled();
+
                 ImGui::TreePop();
             }
 
@@ -121,11 +201,31 @@ namespace Cme
                 CommonHelper::imguiHelpMarker("Shininess of specular highlights. Only applies to Phong.");
                 ImGui::EndDisabled();
 
+                ImGui::Checkbox("SSAO", &opts.ssao);
+                ImGui::BeginDisabled(!opts.ssao);
+                CommonHelper::imguiFloatSlider("SSAO radius", &opts.ssaoRadius, 0.01f, 5.0f, nullptr, Scale::LOG);
+                CommonHelper::imguiFloatSlider("SSAO bias", &opts.ssaoBias, 0.0001f, 0.5f, nullptr, Scale::LOG);
+                ImGui::SliderInt("SSAO samples", &opts.ssaoSamples, 1, Cme::MAX_SSAO_KERNEL_SIZE);
+                ImGui::Checkbox("Quarter resolution", &opts.ssaoQuarterResolution);
+                ImGui::Checkbox("Temporal accumulation", &opts.ssaoTemporal);
+                ImGui::SameLine();
+                CommonHelper::imguiHelpMarker("Rotates the sample kernel every frame and blends the result into "
+                    "the reprojected history, so a few samples per frame add up over time.");
+                ImGui::BeginDisabled(!opts.ssaoTemporal);
+                CommonHelper::imguiFloatSlider("Current frame weight", &opts.ssaoTemporalBlend, 0.01f, 1.0f, nullptr, Scale::LOG);
+                ImGui::EndDisabled();
+                ImGui::EndDisabled();
+
                 ImGui::TreePop();
             }
 
             if (ImGui::TreeNode("Post-processing"))
             {
+                ImGui::Checkbox("Auto exposure", &opts.autoExposure);
+                ImGui::BeginDisabled(!opts.autoExposure);
+                CommonHelper::imguiFloatSlider("Adaptation speed", &opts.exposureAdaptationSpeed, 0.1f, 10.0f, "%.02f", Scale::LOG);
+                ImGui::EndDisabled();
+                CommonHelper::imguiFloatSlider(opts.autoExposure ? "Exposure compensation" : "Exposure", &opts.exposure, 0.01f, 100.0f, "%.02f", Scale::LOG);
                 ImGui::Combo(
                     "Tone mapping", reinterpret_cast<int*>(&opts.toneMapping),
                     "None\0Reinhard\0Reinhard luminance\0ACES (approx)\0AMD\0\0");
@@ -135,7 +235,17 @@ namespace Cme
 
                 ImGui::EndDisabled();
 
+                ImGui::Checkbox("Bloom", &opts.bloom);
+                ImGui::BeginDisabled(!opts.bloom);
+                CommonHelper::imguiFloatSlider("Bloom mix", &opts.bloomMix, 0.001f, 1.0f, "%.03f", Scale::LOG);
+                CommonHelper::imguiFloatSlider("Bloom radius", &opts.bloomFilterRadius, 0.001f, 0.1f, "%.04f", Scale::LOG);
+                ImGui::EndDisabled();
+
                 ImGui::Checkbox("FXAA", &opts.fxaa);
+                ImGui::Checkbox("TAA", &opts.taa);
+                ImGui::BeginDisabled(!opts.taa);
+                CommonHelper::imguiFloatSlider("TAA blend", &opts.taaBlend, 0.01f, 1.0f, "%.02f", Scale::LOG);
+                ImGui::EndDisabled();
 
                 ImGui::TreePop();
             }
@@ -184,6 +294,22 @@ namespace Cme
 
             ImGui::Checkbox("Wireframe", &opts.wireframe);
             ImGui::Checkbox("Draw vertex normals", &opts.drawNormals);
+            if (ImGui::Button("Validate light clusters"))
+            {
+                opts.validateLightClusters = true;
+            }
+            ImGui::SameLine();
+            CommonHelper::imguiHelpMarker("Compares the GPU light lists of the next frame against the CPU "
+                "reference binner and prints the result.");
+
+            if (ImGui::Button("Screenshot (F12)"))
+            {
+                opts.captureScreenshot = true;
+            }
+            ImGui::SameLine();
+            ImGui::Checkbox("Record sequence", &opts.captureSequence);
+            ImGui::SameLine();
+            ImGui::Checkbox("EXR", &opts.captureExr);
         }
 
         if (ImGui::CollapsingHeader("Performance"))
@@ -195,6 +321,61 @@ namespace Cme
                 ImVec2(0, 80.0f));
 
             ImGui::Checkbox("Enable VSync", &opts.enableVsync);
+
+            ImGui::Checkbox("Dynamic resolution", &opts.dynamicResolution);
+            ImGui::SameLine();
+            CommonHelper::imguiHelpMarker("Renders the scene at a lower resolution when frames take longer than "
+                "the target, then upscales and sharpens. With VSync on, the resolution only recovers while "
+                "frames fit in one refresh interval.");
+            ImGui::BeginDisabled(!opts.dynamicResolution);
+            CommonHelper::imguiFloatSlider("Target FPS", &opts.targetFrameRate, 24.0f, 240.0f, "%.0f", Scale::LINEAR);
+            CommonHelper::imguiFloatSlider("Min render scale", &opts.minRenderScale, 0.25f, 1.0f, "%.02f", Scale::LINEAR);
+            CommonHelper::imguiFloatSlider("Sharpness", &opts.upscaleSharpness, 0.0f, 1.0f, "%.02f", Scale::LINEAR);
+            ImGui::EndDisabled();
+            ImGui::Text("Render scale %.0f%%", opts.renderScale * 100.0f);
+
+            if (ImGui::TreeNode("Profiler"))
+            {
+                Profiler& profiler = Profiler::GetInstance();
+                bool enabled = profiler.IsEnabled();
+                if (ImGui::Checkbox("Enabled", &enabled))
+                {
+                    profiler.SetEnabled(enabled);
+                }
+                ImGui::Text("Avg frame: cpu %.3f ms, gpu %.3f ms",
+                    profiler.GetAvgCpuFrameMs(), profiler.GetAvgGpuFrameMs());
+                ImGui::Text("Draw calls %u, primitives %llu", profiler.GetLastFrame().drawCalls,
+                    (unsigned long long)profiler.GetLastFrame().primitives);
+
+                if (!profiler.IsCapturing())
+                {
+                    if (ImGui::Button("Start capture"))
+                    {
+                        profiler.StartCapture();
+                    }
+                }
+                else if (ImGui::Button("Stop capture"))
+                {
+                    profiler.StopCapture();
+                }
+                ImGui::SameLine();
+                static bool s_bExported = false;
+                if (ImGui::Button("Export trace"))
+                {
+                    s_bExported = profiler.ExportChromeTrace("profile_trace.json");
+                }
+                ImGui::SameLine();
+                ImGui::Text("%zu frames%s", profiler.GetCapturedFrameCount(),
+                    s_bExported ? ", saved to profile_trace.json" : "");
+
+                const ProfileFrame& frame = profiler.GetLastFrame();
+                size_t index = 0;
+                while (index < frame.records.size())
+                {
+                    renderProfileRecords(frame.records, index, frame.records[index].depth);
+                }
+                ImGui::TreePop();
+            }
         }
 
         // ӱ༭ λ ٶ ״
@@ -207,6 +388,24 @@ namespace Cme
             ImGui::EndDisabled();
             ImGui::Checkbox("ChangeParticleColorByTime", &bTemp);
             opts.bChangeParticleColorByTime = bTemp;
+
+            CommonHelper::imguiIntSlider("Particle count", &opts.particleCount, 1000, 4000000, nullptr, Scale::LOG);
+            ImGui::Combo("Particle rendering", reinterpret_cast<int*>(&opts.particleRendering),
+                "Geometry shader\0Instanced quads\0\0");
+            ImGui::SameLine();
+            CommonHelper::imguiHelpMarker("Instanced quads are expanded in the vertex shader, which avoids the geometry shader.");
+            ImGui::Checkbox("Stretch along velocity", &opts.particleStretch);
+            ImGui::Combo("Particle blending", reinterpret_cast<int*>(&opts.particleBlending),
+                "Additive\0Alpha, sorted\0\0");
+            ImGui::SameLine();
+            CommonHelper::imguiHelpMarker("Alpha blending sorts the particles back to front on the GPU every frame, for smoke like sprites.");
+
+            ImGui::Checkbox("CPU particles", &opts.cpuParticles);
+            ImGui::SameLine();
+            CommonHelper::imguiHelpMarker("Sparks simulated on worker threads and streamed to the GPU every frame.");
+            ImGui::BeginDisabled(!opts.cpuParticles);
+            CommonHelper::imguiIntSlider("CPU particle count", &opts.cpuParticleCount, 1000, 1000000, nullptr, Scale::LOG);
+            ImGui::EndDisabled();
         }
 
         // ɫ
@@ -0,0 +1,73 @@
+#include "auto_exposure.h"
+
+#include <cmath>
+
+namespace Cme
+{
+    namespace
+    {
+        // Matches luminance_histogram.comp and luminance_average.comp.
+        constexpr int HISTOGRAM_LOCAL_SIZE = 16;
+        constexpr int HISTOGRAM_BINS = 256;
+    }
+
+    AutoExposure::AutoExposure()
+        : m_HistogramShaderObj(ShaderPath("assets//shaders//builtin//luminance_histogram.comp")),
+        m_AverageShaderObj(ShaderPath("assets//shaders//builtin//luminance_average.comp"))
+    {
+        // The average pass clears the histogram after reading it, so it only
+        // needs to start out empty.
+        glCreateBuffers(1, &m_uiHistogramBuffer);
+        glNamedBufferStorage(m_uiHistogramBuffer, HISTOGRAM_BINS * sizeof(GLuint), nullptr, 0);
+        glClearNamedBufferData(m_uiHistogramBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+        // Average luminance and exposure.
+        const float initial[2] = { 1.0f, 1.0f };
+        glCreateBuffers(1, &m_uiExposureBuffer);
+        glNamedBufferStorage(m_uiExposureBuffer, sizeof(initial), initial, 0);
+    }
+
+    AutoExposure::~AutoExposure()
+    {
+        glDeleteBuffers(1, &m_uiHistogramBuffer);
+        glDeleteBuffers(1, &m_uiExposureBuffer);
+    }
+
+    void AutoExposure::Update(Texture& source, float deltaTime, unsigned int textureUnit)
+    {
+        float logRange = m_fMaxLogLuminance - m_fMinLogLuminance;
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LUMINANCE_HISTOGRAM_BUFFER_BINDING, m_uiHistogramBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, EXPOSURE_BUFFER_BINDING, m_uiExposureBuffer);
+
+        source.BindToUnit(textureUnit);
+        m_HistogramShaderObj.setInt("qrk_exposureSource", textureUnit);
+        m_HistogramShaderObj.setFloat("qrk_minLogLuminance", m_fMinLogLuminance);
+        m_HistogramShaderObj.setFloat("qrk_inverseLogLuminanceRange", 1.0f / logRange);
+        m_HistogramShaderObj.activate();
+        glDispatchCompute((source.getWidth() + HISTOGRAM_LOCAL_SIZE - 1) / HISTOGRAM_LOCAL_SIZE,
+                          (source.getHeight() + HISTOGRAM_LOCAL_SIZE - 1) / HISTOGRAM_LOCAL_SIZE, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        m_HistogramShaderObj.deactivate();
+
+        // Exponential decay towards the measurement, independent of the frame
+        // rate.
+        float adaptation = 1.0f - std::exp(-deltaTime * m_fAdaptationSpeed);
+        m_AverageShaderObj.setFloat("qrk_minLogLuminance", m_fMinLogLuminance);
+        m_AverageShaderObj.setFloat("qrk_logLuminanceRange", logRange);
+        m_AverageShaderObj.setUInt("qrk_numPixels", static_cast<unsigned int>(source.getWidth() * source.getHeight()));
+        m_AverageShaderObj.setFloat("qrk_adaptation", adaptation);
+        m_AverageShaderObj.setFloat("qrk_exposureKey", m_fKey);
+        m_AverageShaderObj.setBool("qrk_exposureReset", m_bReset);
+        m_AverageShaderObj.activate();
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        m_AverageShaderObj.deactivate();
+        m_bReset = false;
+    }
+
+    void AutoExposure::bindExposureBuffer() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, EXPOSURE_BUFFER_BINDING, m_uiExposureBuffer);
+    }
+
+}  // namespace Cme
@@ -0,0 +1,69 @@
+#ifndef QUARKGL_AUTO_EXPOSURE_H_
+#define QUARKGL_AUTO_EXPOSURE_H_
+
+#include "screen.h"
+#include "shader/shader.h"
+#include "core/texture.h"
+
+#include <glad/glad.h>
+
+namespace Cme
+{
+    // SSBO binding points of the histogram and of the resulting exposure,
+    // see luminance_histogram.comp and post_process.comp.
+    constexpr GLuint LUMINANCE_HISTOGRAM_BUFFER_BINDING = 7;
+    constexpr GLuint EXPOSURE_BUFFER_BINDING = 8;
+
+    // Exposure from the average scene luminance, in two compute dispatches:
+    //  1. A histogram of log luminance over the HDR image, counted per work
+    //     group with shared memory atomics.
+    //  2. One work group that averages the histogram, ignoring black texels,
+    //     and adapts the previous average towards it over time.
+    // The exposure stays in a GPU buffer that the post-process pass reads, so
+    // there is no readback and no full resolution reduction chain.
+    class AutoExposure
+    {
+    public:
+        AutoExposure();
+        ~AutoExposure();
+
+        AutoExposure(const AutoExposure&) = delete;
+        AutoExposure& operator=(const AutoExposure&) = delete;
+
+        // Measures `source` and updates the exposure for a frame of
+        // `deltaTime` seconds. Samples from `textureUnit`.
+        void Update(Texture& source, float deltaTime, unsigned int textureUnit);
+        // Binds the exposure buffer for the passes that apply it.
+        void bindExposureBuffer() const;
+        // Jumps straight to the measured exposure on the next update instead of
+        // adapting, e.g. after a scene change.
+        void ResetHistory() { m_bReset = true; }
+
+        // Log2 luminance range covered by the histogram.
+        float getMinLogLuminance() const { return m_fMinLogLuminance; }
+        void setMinLogLuminance(float value) { m_fMinLogLuminance = value; }
+        float getMaxLogLuminance() const { return m_fMaxLogLuminance; }
+        void setMaxLogLuminance(float value) { m_fMaxLogLuminance = value; }
+        // Rate of adaptation, in 1 / seconds.
+        float getAdaptationSpeed() const { return m_fAdaptationSpeed; }
+        void setAdaptationSpeed(float speed) { m_fAdaptationSpeed = speed; }
+        // Luminance the average is mapped to, 0.18 for middle gray.
+        float getKey() const { return m_fKey; }
+        void setKey(float key) { m_fKey = key; }
+
+    private:
+        float m_fMinLogLuminance = -10.0f;
+        float m_fMaxLogLuminance = 4.0f;
+        float m_fAdaptationSpeed = 1.5f;
+        float m_fKey = 0.18f;
+        bool m_bReset = true;
+
+        Shader m_HistogramShaderObj;
+        Shader m_AverageShaderObj;
+        GLuint m_uiHistogramBuffer = 0;
+        GLuint m_uiExposureBuffer = 0;
+    };
+
+}  // namespace Cme
+
+#endif
@@ -0,0 +1,526 @@
+#include "benchmark.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+namespace Cme
+{
+    // Frames rendered after the last measured one while waiting for the
+    // Profiler readback, before giving up on the missing frames.
+    const int MAX_DRAIN_FRAMES = 4 * Profiler::NUM_FRAMES_IN_FLIGHT;
+
+    namespace
+    {
+        using OptionSetter = std::function<void(ModelRenderOptions&, float)>;
+
+        // Options that can be overridden from a script. Booleans are set from
+        // non-zero values and enums from their underlying index.
+        const std::map<std::string, OptionSetter>& getOptionSetters()
+        {
+            static const std::map<std::string, OptionSetter> setters = {
+                { "modelScale", [](ModelRenderOptions& o, float v) { o.modelScale = v; } },
+                { "lightingModel", [](ModelRenderOptions& o, float v) { o.lightingModel = static_cast<LightingModel>((int)v); } },
+                { "directionalIntensity", [](ModelRenderOptions& o, float v) { o.directionalIntensity = v; } },
+                { "pointLights", [](ModelRenderOptions& o, float v) { o.numPointLights = (int)v; } },
+                { "pointLightRange", [](ModelRenderOptions& o, float v) { o.pointLightRange = v; } },
+                { "shadowMapping", [](ModelRenderOptions& o, float v) { o.shadowMapping = v != 0.0f; } },
+                { "shadowCascades", [](ModelRenderOptions& o, float v) { o.shadowCascades = (int)v; } },
+                { "shadowDistance", [](ModelRenderOptions& o, float v) { o.shadowDistance = v; } },
+                { "shadowCaching", [](ModelRenderOptions& o, float v) { o.shadowCaching = v != 0.0f; } },
+                { "localShadows", [](ModelRenderOptions& o, float v) { o.localShadows = v != 0.0f; } },
+                { "shadowedPointLights", [](ModelRenderOptions& o, float v) { o.numShadowedPointLights = (int)v; } },
+                { "useIBL", [](ModelRenderOptions& o, float v) { o.useIBL = v != 0.0f; } },
+                { "ssao", [](ModelRenderOptions& o, float v) { o.ssao = v != 0.0f; } },
+                { "ssaoRadius", [](ModelRenderOptions& o, float v) { o.ssaoRadius = v; } },
+                { "ssaoBias", [](ModelRenderOptions& o, float v) { o.ssaoBias = v; } },
+                { "ssaoSamples", [](ModelRenderOptions& o, float v) { o.ssaoSamples = (int)v; } },
+                { "ssaoQuarterResolution", [](ModelRenderOptions& o, float v) { o.ssaoQuarterResolution = v != 0.0f; } },
+                { "ssaoTemporal", [](ModelRenderOptions& o, float v) { o.ssaoTemporal = v != 0.0f; } },
+                { "bloom", [](ModelRenderOptions& o, float v) { o.bloom = v != 0.0f; } },
+                { "bloomMix", [](ModelRenderOptions& o, float v) { o.bloomMix = v; } },
+                { "bloomFilterRadius", [](ModelRenderOptions& o, float v) { o.bloomFilterRadius = v; } },
+                { "taa", [](ModelRenderOptions& o, float v) { o.taa = v != 0.0f; } },
+                { "taaBlend", [](ModelRenderOptions& o, float v) { o.taaBlend = v; } },
+                { "dynamicResolution", [](ModelRenderOptions& o, float v) { o.dynamicResolution = v != 0.0f; } },
+                { "targetFrameRate", [](ModelRenderOptions& o, float v) { o.targetFrameRate = v; } },
+                { "minRenderScale", [](ModelRenderOptions& o, float v) { o.minRenderScale = v; } },
+                { "upscaleSharpness", [](ModelRenderOptions& o, float v) { o.upscaleSharpness = v; } },
+                { "exposure", [](ModelRenderOptions& o, float v) { o.exposure = v; } },
+                { "autoExposure", [](ModelRenderOptions& o, float v) { o.autoExposure = v != 0.0f; } },
+                { "exposureAdaptationSpeed", [](ModelRenderOptions& o, float v) { o.exposureAdaptationSpeed = v; } },
+                { "toneMapping", [](ModelRenderOptions& o, float v) { o.toneMapping = static_cast<ToneMapping>((int)v); } },
+                { "gammaCorrect", [](ModelRenderOptions& o, float v) { o.gammaCorrect = v != 0.0f; } },
+                { "fxaa", [](ModelRenderOptions& o, float v) { o.fxaa = v != 0.0f; } },
+                { "fov", [](ModelRenderOptions& o, float v) { o.fov = v; } },
+                { "near", [](ModelRenderOptions& o, float v) { o.near = v; } },
+                { "far", [](ModelRenderOptions& o, float v) { o.far = v; } },
+                { "wireframe", [](ModelRenderOptions& o, float v) { o.wireframe = v != 0.0f; } },
+                { "drawNormals", [](ModelRenderOptions& o, float v) { o.drawNormals = v != 0.0f; } },
+                { "particleColorByTime", [](ModelRenderOptions& o, float v) { o.bChangeParticleColorByTime = v != 0.0f; } },
+                { "particleCount", [](ModelRenderOptions& o, float v) { o.particleCount = (int)v; } },
+                { "particleRendering", [](ModelRenderOptions& o, float v) { o.particleRendering = static_cast<ParticleRendering>((int)v); } },
+                { "particleStretch", [](ModelRenderOptions& o, float v) { o.particleStretch = v != 0.0f; } },
+                { "particleBlending", [](ModelRenderOptions& o, float v) { o.particleBlending = static_cast<ParticleBlending>((int)v); } },
+                { "cpuParticles", [](ModelRenderOptions& o, float v) { o.cpuParticles = v != 0.0f; } },
+                { "cpuParticleCount", [](ModelRenderOptions& o, float v) { o.cpuParticleCount = (int)v; } },
+                // Checks the light clusters against the CPU reference every
+                // frame. Stalls on the GPU, so timings of such runs are off.
+                { "validateLightClusters", [](ModelRenderOptions& o, float v) { o.validateLightClusters = v != 0.0f; } },
+            };
+            return setters;
+        }
+
+        double percentile(std::vector<double> values, double p)
+        {
+            if (values.empty())
+            {
+                return 0.0;
+            }
+            std::sort(values.begin(), values.end());
+            size_t rank = (size_t)(p * (values.size() - 1) + 0.5);
+            return values[std::min(rank, values.size() - 1)];
+        }
+
+        double mean(const std::vector<double>& values)
+        {
+            if (values.empty())
+            {
+                return 0.0;
+            }
+            double sum = 0.0;
+            for (double v : values)
+            {
+                sum += v;
+            }
+            return sum / values.size();
+        }
+
+        // Quotes `s` as a JSON string, escaping quotes, backslashes and
+        // control characters.
+        std::string jsonString(const std::string& s)
+        {
+            std::string sOut = "\"";
+            for (char c : s)
+            {
+                switch (c)
+                {
+                case '"': sOut += "\\\""; break;
+                case '\\': sOut += "\\\\"; break;
+                case '\n': sOut += "\\n"; break;
+                case '\r': sOut += "\\r"; break;
+                case '\t': sOut += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+                        sOut += buf;
+                    }
+                    else
+                    {
+                        sOut += c;
+                    }
+                }
+            }
+            return sOut + "\"";
+        }
+
+        void addDistribution(std::map<std::string, double>& metrics, const std::string& sPrefix,
+            const std::vector<double>& values)
+        {
+            metrics[sPrefix + ".mean"] = mean(values);
+            metrics[sPrefix + ".p50"] = percentile(values, 0.50);
+            metrics[sPrefix + ".p90"] = percentile(values, 0.90);
+            metrics[sPrefix + ".p99"] = percentile(values, 0.99);
+            metrics[sPrefix + ".max"] = percentile(values, 1.0);
+        }
+
+        // Reads the "metrics" object of a previous result. Only the flat
+        // "key": number layout written by Benchmark::Finish is supported.
+        std::map<std::string, double> readMetrics(const std::string& sPath)
+        {
+            std::ifstream in(sPath);
+            if (!in)
+            {
+                throw BenchmarkException("ERROR::BENCHMARK::BASELINE_NOT_FOUND: " + sPath);
+            }
+            std::stringstream ss;
+            ss << in.rdbuf();
+            std::string sJson = ss.str();
+
+            std::map<std::string, double> metrics;
+            size_t pos = sJson.find("\"metrics\"");
+            if (pos == std::string::npos)
+            {
+                return metrics;
+            }
+            pos = sJson.find('{', pos);
+            size_t end = sJson.find('}', pos);
+            while (pos != std::string::npos && pos < end)
+            {
+                size_t keyBegin = sJson.find('"', pos);
+                if (keyBegin == std::string::npos || keyBegin > end)
+                {
+                    break;
+                }
+                size_t keyEnd = sJson.find('"', keyBegin + 1);
+                size_t colon = sJson.find(':', keyEnd);
+                std::string sKey = sJson.substr(keyBegin + 1, keyEnd - keyBegin - 1);
+                metrics[sKey] = std::strtod(sJson.c_str() + colon + 1, nullptr);
+                pos = sJson.find(',', colon);
+            }
+            return metrics;
+        }
+    }
+
+    BenchmarkScript BenchmarkScript::Load(const std::string& sPath)
+    {
+        std::ifstream in(sPath);
+        if (!in)
+        {
+            throw BenchmarkException("ERROR::BENCHMARK::SCRIPT_NOT_FOUND: " + sPath);
+        }
+
+        BenchmarkScript script;
+        std::string sLine;
+        int lineNumber = 0;
+        while (std::getline(in, sLine))
+        {
+            ++lineNumber;
+            size_t comment = sLine.find('#');
+            if (comment != std::string::npos)
+            {
+                sLine.erase(comment);
+            }
+            std::istringstream ls(sLine);
+            std::string sDirective;
+            if (!(ls >> sDirective))
+            {
+                continue;
+            }
+
+            bool ok = true;
+            if (sDirective == "scene")
+            {
+                ok = static_cast<bool>(ls >> script.sModelPath);
+            }
+            else if (sDirective == "size")
+            {
+                ok = static_cast<bool>(ls >> script.iWidth >> script.iHeight);
+            }
+            else if (sDirective == "context")
+            {
+                std::string sApi;
+                ls >> sApi;
+                if (sApi == "native")
+                {
+                    script.eContextApi = ContextApi::NATIVE;
+                }
+                else if (sApi == "egl")
+                {
+                    script.eContextApi = ContextApi::EGL;
+                }
+                else if (sApi == "osmesa")
+                {
+                    script.eContextApi = ContextApi::OSMESA;
+                }
+                else
+                {
+                    ok = false;
+                }
+            }
+            else if (sDirective == "warmup")
+            {
+                ok = static_cast<bool>(ls >> script.iWarmupFrames);
+            }
+            else if (sDirective == "frames")
+            {
+                ok = static_cast<bool>(ls >> script.iMeasuredFrames) && script.iMeasuredFrames > 0;
+            }
+            else if (sDirective == "timestep")
+            {
+                ok = static_cast<bool>(ls >> script.fTimestep);
+            }
+            else if (sDirective == "option")
+            {
+                std::string sName;
+                float value = 0.0f;
+                ok = static_cast<bool>(ls >> sName >> value) && getOptionSetters().count(sName);
+                script.vecOptions.emplace_back(sName, value);
+            }
+            else if (sDirective == "camera")
+            {
+                CameraKeyframe key;
+                ok = static_cast<bool>(ls >> key.time
+                    >> key.position.x >> key.position.y >> key.position.z
+                    >> key.target.x >> key.target.y >> key.target.z);
+                ok = ok && (script.vecCameraPath.empty() || key.time > script.vecCameraPath.back().time);
+                script.vecCameraPath.push_back(key);
+            }
+            else if (sDirective == "output")
+            {
+                ok = static_cast<bool>(ls >> script.sOutputPath);
+            }
+            else if (sDirective == "baseline")
+            {
+                ok = static_cast<bool>(ls >> script.sBaselinePath);
+            }
+            else if (sDirective == "threshold")
+            {
+                ok = static_cast<bool>(ls >> script.fThreshold);
+            }
+            else if (sDirective == "slack")
+            {
+                ok = static_cast<bool>(ls >> script.fSlack);
+            }
+            else
+            {
+                ok = false;
+            }
+
+            if (!ok)
+            {
+                throw BenchmarkException("ERROR::BENCHMARK::INVALID_SCRIPT_LINE: " + sPath + ":" +
+                    std::to_string(lineNumber));
+            }
+        }
+        return script;
+    }
+
+    Benchmark::Benchmark(const std::string& sScriptPath)
+        : m_Script(BenchmarkScript::Load(sScriptPath)), m_sScriptPath(sScriptPath)
+    {
+        m_vecFrameMs.reserve(m_Script.iMeasuredFrames);
+    }
+
+    bool Benchmark::Advance(float realDeltaTime)
+    {
+        Profiler& profiler = Profiler::GetInstance();
+        switch (m_ePhase)
+        {
+        case Phase::WARMUP:
+            if (m_iFrame >= m_Script.iWarmupFrames)
+            {
+                profiler.SetEnabled(true);
+                profiler.StartCapture();
+                m_ui64FirstMeasuredFrame = profiler.GetFrameIndex();
+                m_ePhase = Phase::MEASURE;
+            }
+            break;
+        case Phase::MEASURE:
+            // Wall time of the previous, measured, frame. The scripted timestep
+            // only drives the animation, it would make every frame equal.
+            m_vecFrameMs.push_back(realDeltaTime * 1000.0f);
+            if ((int)m_vecFrameMs.size() >= m_Script.iMeasuredFrames)
+            {
+                m_ePhase = Phase::DRAIN;
+            }
+            break;
+        case Phase::DRAIN:
+        {
+            ++m_iDrainFrames;
+            const auto& captured = profiler.GetCapturedFrames();
+            uint64_t lastFrame = m_ui64FirstMeasuredFrame + m_Script.iMeasuredFrames - 1;
+            if ((!captured.empty() && captured.back().frameIndex >= lastFrame) ||
+                m_iDrainFrames >= MAX_DRAIN_FRAMES)
+            {
+                profiler.StopCapture();
+                return true;
+            }
+            break;
+        }
+        }
+        ++m_iFrame;
+        return false;
+    }
+
+    void Benchmark::ApplyFrame(Camera& camera, ModelRenderOptions& opts) const
+    {
+        const auto& setters = getOptionSetters();
+        for (const auto& option : m_Script.vecOptions)
+        {
+            setters.at(option.first)(opts, option.second);
+        }
+        // Vsync would only measure the display refresh rate.
+        opts.enableVsync = false;
+
+        const auto& path = m_Script.vecCameraPath;
+        if (path.empty())
+        {
+            return;
+        }
+        // The path loops over its duration.
+        float t = GetTime();
+        float duration = path.back().time - path.front().time;
+        if (duration > 0.0f)
+        {
+            t = path.front().time + std::fmod(t, duration);
+        }
+        size_t next = 0;
+        while (next < path.size() && path[next].time < t)
+        {
+            ++next;
+        }
+        glm::vec3 position = path.front().position;
+        glm::vec3 target = path.front().target;
+        if (next >= path.size())
+        {
+            position = path.back().position;
+            target = path.back().target;
+        }
+        else if (next > 0)
+        {
+            const CameraKeyframe& a = path[next - 1];
+            const CameraKeyframe& b = path[next];
+            float s = (t - a.time) / (b.time - a.time);
+            position = glm::mix(a.position, b.position, s);
+            target = glm::mix(a.target, b.target, s);
+        }
+        camera.setPosition(position);
+        camera.lookAt(target);
+    }
+
+    std::map<std::string, double> Benchmark::ComputeMetrics() const
+    {
+        std::map<std::string, double> metrics;
+
+        std::vector<double> frameMs(m_vecFrameMs.begin(), m_vecFrameMs.end());
+        addDistribution(metrics, "frame_ms", frameMs);
+
+        // Profiler frames inside the measured range only; frames that were
+        // already in flight when the capture started are skipped.
+        std::vector<double> cpuMs;
+        std::vector<double> gpuMs;
+        std::vector<double> drawCalls;
+        std::vector<double> primitives;
+        std::map<std::string, std::vector<double>> passCpuMs;
+        std::map<std::string, std::vector<double>> passGpuMs;
+        uint64_t lastFrame = m_ui64FirstMeasuredFrame + m_Script.iMeasuredFrames;
+        for (const ProfileFrame& frame : Profiler::GetInstance().GetCapturedFrames())
+        {
+            if (frame.frameIndex < m_ui64FirstMeasuredFrame || frame.frameIndex >= lastFrame)
+            {
+                continue;
+            }
+            drawCalls.push_back(frame.drawCalls);
+            primitives.push_back((double)frame.primitives);
+
+            // A pass can run more than once per frame; its times are summed.
+            std::map<std::string, std::pair<double, double>> passTimes;
+            for (const ProfileRecord& record : frame.records)
+            {
+                if (record.depth == 0)
+                {
+                    cpuMs.push_back(record.GetCpuMs());
+                    gpuMs.push_back(record.GetGpuMs());
+                    continue;
+                }
+                auto& times = passTimes[record.name];
+                times.first += record.GetCpuMs();
+                times.second += record.GetGpuMs();
+            }
+            for (const auto& pass : passTimes)
+            {
+                passCpuMs[pass.first].push_back(pass.second.first);
+                passGpuMs[pass.first].push_back(pass.second.second);
+            }
+        }
+
+        addDistribution(metrics, "cpu_ms", cpuMs);
+        addDistribution(metrics, "gpu_ms", gpuMs);
+        metrics["draw_calls.mean"] = mean(drawCalls);
+        metrics["primitives.mean"] = mean(primitives);
+        for (const auto& pass : passCpuMs)
+        {
+            metrics["pass." + pass.first + ".cpu_ms.mean"] = mean(pass.second);
+            metrics["pass." + pass.first + ".cpu_ms.p90"] = percentile(pass.second, 0.90);
+        }
+        for (const auto& pass : passGpuMs)
+        {
+            metrics["pass." + pass.first + ".gpu_ms.mean"] = mean(pass.second);
+            metrics["pass." + pass.first + ".gpu_ms.p90"] = percentile(pass.second, 0.90);
+        }
+        return metrics;
+    }
+
+    std::vector<std::string> Benchmark::CompareToBaseline(const std::map<std::string, double>& metrics) const
+    {
+        std::vector<std::string> regressions;
+        if (m_Script.sBaselinePath.empty())
+        {
+            return regressions;
+        }
+        for (const auto& baseline : readMetrics(m_Script.sBaselinePath))
+        {
+            auto iter = metrics.find(baseline.first);
+            if (iter == metrics.end())
+            {
+                continue;
+            }
+            double limit = baseline.second * (1.0 + m_Script.fThreshold);
+            if (iter->second > limit && iter->second - baseline.second > m_Script.fSlack)
+            {
+                std::ostringstream ss;
+                ss << baseline.first << ": " << iter->second << " > " << baseline.second;
+                regressions.push_back(ss.str());
+            }
+        }
+        return regressions;
+    }
+
+    bool Benchmark::Finish()
+    {
+        std::map<std::string, double> metrics = ComputeMetrics();
+        std::vector<std::string> regressions = CompareToBaseline(metrics);
+        for (const auto& failure : m_mapFailures)
+        {
+            regressions.push_back(failure.first + ": failed in " + std::to_string(failure.second) + " frames");
+        }
+
+        std::ofstream out(m_Script.sOutputPath);
+        if (!out)
+        {
+            std::cerr << "ERROR::BENCHMARK::OUTPUT_FAILED: " << m_Script.sOutputPath << std::endl;
+            return false;
+        }
+        const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        out << "{\n";
+        out << "  \"script\": " << jsonString(m_sScriptPath) << ",\n";
+        out << "  \"renderer\": " << jsonString(renderer ? renderer : "") << ",\n";
+        out << "  \"width\": " << m_Script.iWidth << ",\n";
+        out << "  \"height\": " << m_Script.iHeight << ",\n";
+        out << "  \"warmup_frames\": " << m_Script.iWarmupFrames << ",\n";
+        out << "  \"measured_frames\": " << m_vecFrameMs.size() << ",\n";
+        out << "  \"metrics\": {";
+        bool bFirst = true;
+        for (const auto& metric : metrics)
+        {
+            out << (bFirst ? "\n" : ",\n") << "    " << jsonString(metric.first) << ": " << metric.second;
+            bFirst = false;
+        }
+        out << "\n  },\n";
+        out << "  \"regressions\": [";
+        for (size_t i = 0; i < regressions.size(); ++i)
+        {
+            out << (i == 0 ? "\n" : ",\n") << "    " << jsonString(regressions[i]);
+        }
+        out << (regressions.empty() ? "" : "\n  ") << "],\n";
+        out << "  \"passed\": " << (regressions.empty() ? "true" : "false") << "\n";
+        out << "}\n";
+
+        std::cout << "Benchmark: " << m_vecFrameMs.size() << " frames, frame_ms p50 "
+                  << metrics["frame_ms.p50"] << ", p99 " << metrics["frame_ms.p99"]
+                  << ", written to " << m_Script.sOutputPath << std::endl;
+        for (const std::string& sRegression : regressions)
+        {
+            std::cerr << "REGRESSION: " << sRegression << std::endl;
+        }
+        return regressions.empty();
+    }
+}  // namespace Cme
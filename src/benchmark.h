@@ -0,0 +1,111 @@
+#pragma once
+
+#include "camera.h"
+#include "cme_defs.h"
+#include "exceptions.h"
+#include "window.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Cme
+{
+	class BenchmarkException : public QuarkException
+	{
+		using QuarkException::QuarkException;
+	};
+
+	struct CameraKeyframe
+	{
+		float time = 0.0f;
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::vec3 target = glm::vec3(0.0f);
+	};
+
+	// Benchmark description, loaded from a line based text file. Each line is a
+	// directive followed by its arguments; '#' starts a comment.
+	//
+	//   scene    <model path>               model loaded instead of the default
+	//   size     <width> <height>
+	//   context  native|egl|osmesa          API of the hidden GLFW window,
+	//                                       which still needs a display
+	//                                       server, see Window::setHeadless()
+	//   warmup   <frames>
+	//   frames   <frames>                   measured frames
+	//   timestep <seconds>                  scripted time advanced per frame
+	//   option   <name> <value>             ModelRenderOptions override
+	//   camera   <time> <px py pz> <tx ty tz>  camera path keyframe
+	//   output   <path>                     result JSON
+	//   baseline <path>                     result JSON to compare against
+	//   threshold <fraction>                allowed relative regression
+	//   slack    <value>                    ignored absolute regression
+	struct BenchmarkScript
+	{
+		std::string sModelPath;
+		int iWidth = 1920;
+		int iHeight = 1080;
+		ContextApi eContextApi = ContextApi::NATIVE;
+		int iWarmupFrames = 60;
+		int iMeasuredFrames = 600;
+		float fTimestep = 1.0f / 60.0f;
+		std::vector<std::pair<std::string, float>> vecOptions;
+		std::vector<CameraKeyframe> vecCameraPath;
+		std::string sOutputPath = "benchmark_result.json";
+		std::string sBaselinePath;
+		float fThreshold = 0.1f;
+		float fSlack = 0.05f;
+
+		static BenchmarkScript Load(const std::string& sPath);
+	};
+
+	// Drives the app through a scripted run: warmup frames, then measured
+	// frames whose timings are collected from the Profiler. The result is
+	// written as JSON with every metric in a flat "metrics" object, which is
+	// also the format read back as a baseline. All metrics are lower-is-better.
+	class Benchmark
+	{
+	public:
+		explicit Benchmark(const std::string& sScriptPath);
+
+		const BenchmarkScript& GetScript() const { return m_Script; }
+
+		// Called at the start of every frame with the wall time of the previous
+		// one, not the scripted timestep. Returns true once the run is complete.
+		bool Advance(float realDeltaTime);
+		// Applies the camera path and option overrides for the current frame.
+		void ApplyFrame(Camera& camera, ModelRenderOptions& opts) const;
+		// Scripted time of the current frame in seconds.
+		float GetTime() const { return m_iFrame * m_Script.fTimestep; }
+		// Records a failed correctness check of the current frame, such as
+		// option validateLightClusters. Failures fail the run like regressions.
+		void AddFailure(const std::string& sCheck) { ++m_mapFailures[sCheck]; }
+
+		// Writes the result JSON and compares it to the baseline, if any.
+		// Returns false if a metric regressed or a check failed.
+		bool Finish();
+
+	private:
+		enum class Phase
+		{
+			WARMUP,
+			MEASURE,
+			// Waiting for the Profiler to read back the last measured frames.
+			DRAIN,
+		};
+
+		std::map<std::string, double> ComputeMetrics() const;
+		std::vector<std::string> CompareToBaseline(const std::map<std::string, double>& metrics) const;
+
+		BenchmarkScript m_Script;
+		std::string m_sScriptPath;
+		Phase m_ePhase = Phase::WARMUP;
+		int m_iFrame = 0;
+		int m_iDrainFrames = 0;
+		uint64_t m_ui64FirstMeasuredFrame = 0;
+		std::vector<float> m_vecFrameMs;
+		// Frames failed per check.
+		std::map<std::string, int> m_mapFailures;
+	};
+}  // namespace Cme
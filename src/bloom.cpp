@@ -0,0 +1,89 @@
+#include "bloom.h"
+#include "common_helper.h"
+
+#include <algorithm>
+
+namespace Cme
+{
+    BloomPass::BloomPass(ImageSize screenSize, int maxMips)
+        : Framebuffer(std::max(screenSize.width / 2, 1), std::max(screenSize.height / 2, 1)),
+        m_DownsampleShaderObj(ShaderPath("assets//shaders//builtin//bloom_downsample.frag")),
+        m_UpsampleShaderObj(ShaderPath("assets//shaders//builtin//bloom_upsample.frag"))
+    {
+        TextureParams params;
+        params.filtering = TextureFiltering::BILINEAR;
+        params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+        params.generateMips = MipGeneration::ALWAYS;
+        params.maxNumMips = maxMips;
+        m_ColorAttachmentObj = AttachTexture2FB_i(BufferType::COLOR_HDR_PACKED, params);
+
+        // Views need immutable storage, which Texture::Create() allocates.
+        m_vecMipViews.resize(m_ColorAttachmentObj.m_iNumMips);
+        glGenTextures((GLsizei)m_vecMipViews.size(), m_vecMipViews.data());
+        for (int mip = 0; mip < (int)m_vecMipViews.size(); ++mip)
+        {
+            GLuint view = m_vecMipViews[mip];
+            glTextureView(view, GL_TEXTURE_2D, m_ColorAttachmentObj.m_uiID,
+                          bufferTypeToGlInternalFormat(BufferType::COLOR_HDR_PACKED), mip, 1, 0, 1);
+            glTextureParameteri(view, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(view, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(view, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(view, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+    }
+
+    BloomPass::~BloomPass()
+    {
+        // The color attachment itself is released by Framebuffer.
+        glDeleteTextures((GLsizei)m_vecMipViews.size(), m_vecMipViews.data());
+    }
+
+    void BloomPass::Render(Texture& source, ScreenQuadMesh& quad, unsigned int textureUnit)
+    {
+        int numMips = getNumMips();
+        quad.unsetTexture();
+
+        // Downsample. The first step reads the full resolution source and
+        // applies the Karis average, the others read the previous mip.
+        m_DownsampleShaderObj.setInt("qrk_bloomMipChain", textureUnit);
+        for (int mip = 0; mip < numMips; ++mip)
+        {
+            if (mip == 0)
+            {
+                source.BindToUnit(textureUnit);
+            }
+            else
+            {
+                glBindTextureUnit(textureUnit, m_vecMipViews[mip - 1]);
+            }
+            m_DownsampleShaderObj.setBool("qrk_karisAverage", mip == 0);
+            activate(mip);
+            quad.draw(m_DownsampleShaderObj);
+        }
+
+        // Upsample, adding each level onto the one above it. The first mip
+        // ends up with the sum of all levels.
+        enableAdditiveBlending();
+        m_UpsampleShaderObj.setInt("qrk_bloomMipChain", textureUnit);
+        m_UpsampleShaderObj.setFloat("qrk_filterRadius", m_fFilterRadius);
+        for (int mip = numMips - 1; mip > 0; --mip)
+        {
+            glBindTextureUnit(textureUnit, m_vecMipViews[mip]);
+            activate(mip - 1);
+            quad.draw(m_UpsampleShaderObj);
+        }
+        disableAdditiveBlending();
+
+        deactivate();
+    }
+
+    unsigned int BloomPass::bindTexture(unsigned int nextTextureUnit, Shader& shader)
+    {
+        glBindTextureUnit(nextTextureUnit, m_vecMipViews[0]);
+        // Bind sampler uniforms.
+        shader.setInt("qrk_bloom", nextTextureUnit);
+
+        return nextTextureUnit + 1;
+    }
+
+}  // namespace Cme
@@ -0,0 +1,58 @@
+#ifndef QUARKGL_BLOOM_H_
+#define QUARKGL_BLOOM_H_
+
+#include "framebuffer.h"
+#include "screen.h"
+#include "shader/shader.h"
+#include "shader/shader_primitives.h"
+#include "shape/screenquad_mesh.h"
+
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+
+namespace Cme
+{
+    // Physically based bloom over a mip chain, after the Call of Duty technique
+    // presented at Siggraph 2014. The HDR image is downsampled into the mips of
+    // one half resolution texture, the first step with a Karis average to keep
+    // single bright texels from flickering. The chain is then upsampled back to
+    // its first mip with a tent filter, adding each level to the one above it.
+    // Every mip is sampled through its own single level texture view, so one
+    // framebuffer renders the whole chain. Since each level has a quarter of the
+    // texels of the previous one, the pass costs a small constant fraction of a
+    // full screen pass, independent of the bloom radius.
+    class BloomPass : public Framebuffer
+    {
+    public:
+        // The chain starts at half of `screenSize` and is at most `maxMips`
+        // levels deep.
+        explicit BloomPass(ImageSize screenSize, int maxMips = 6);
+        virtual ~BloomPass();
+
+        // Builds the bloom of `source`, sampling it from `textureUnit`.
+        void Render(Texture& source, ScreenQuadMesh& quad, unsigned int textureUnit);
+
+        // Radius of the upsampling tent, in texture coordinates.
+        float getFilterRadius() const { return m_fFilterRadius; }
+        void setFilterRadius(float radius) { m_fFilterRadius = radius; }
+
+        int getNumMips() const { return (int)m_vecMipViews.size(); }
+        std::shared_ptr<Texture> getBloomTexture() { return m_ColorAttachmentObj.Transform2Texture(); }
+
+        // Binds the first mip, which holds the result, as qrk_bloom.
+        unsigned int bindTexture(unsigned int nextTextureUnit, Shader& shader);
+
+    private:
+        Attachment m_ColorAttachmentObj;
+        // Single level views of each mip of the color attachment.
+        std::vector<GLuint> m_vecMipViews;
+        float m_fFilterRadius = 0.005f;
+
+        ScreenShader m_DownsampleShaderObj;
+        ScreenShader m_UpsampleShaderObj;
+    };
+
+}  // namespace Cme
+
+#endif
@@ -49,6 +49,17 @@ namespace Cme
     }
 
     glm::mat4 Camera::getProjectionTransform() const 
+    {
+        glm::mat4 projection = getUnjitteredProjectionTransform();
+        // Shifts clip space x and y by jitter * w, i.e. the image by the jitter
+        // in NDC after the perspective divide. The third column multiplies the
+        // view z, which is -w.
+        projection[2][0] -= m_vec2Jitter.x;
+        projection[2][1] -= m_vec2Jitter.y;
+        return projection;
+    }
+
+    glm::mat4 Camera::getUnjitteredProjectionTransform() const
     {
         return glm::perspective(glm::radians(getFov()), m_fAspectRatio, m_fNear, m_fFar);
     }
@@ -77,7 +77,14 @@ namespace Cme
         void setFarPlane(float far) { m_fFar = far; }
 
         glm::mat4 getViewTransform() const;
+        // The projection, offset by the current jitter.
         glm::mat4 getProjectionTransform() const;
+        glm::mat4 getUnjitteredProjectionTransform() const;
+
+        // Sub-pixel offset of the projection, in normalized device coordinates.
+        // Set per frame by temporal passes such as TaaPass.
+        glm::vec2 getJitter() const { return m_vec2Jitter; }
+        void setJitter(glm::vec2 jitter) { m_vec2Jitter = jitter; }
 
         // Moves the camera in the given direction by the given amount.
         void move(CameraDirection direction, float velocity);
@@ -106,6 +113,7 @@ namespace Cme
         float m_fAspectRatio;
         float m_fNear;
         float m_fFar;
+        glm::vec2 m_vec2Jitter = glm::vec2(0.0f);
     };
 
     struct MouseDelta 
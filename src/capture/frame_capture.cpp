@@ -0,0 +1,152 @@
+#include "frame_capture.h"
+#include "image_writer.h"
+
+#include <iostream>
+
+namespace Cme
+{
+    FrameCapture::FrameCapture(int numBuffers, unsigned int numWorkers)
+        : m_ThreadPool(numWorkers)
+    {
+        if (numBuffers <= 0)
+        {
+            throw FrameCaptureException("ERROR::FRAME_CAPTURE::INVALID_BUFFER_COUNT");
+        }
+        for (int i = 0; i < numBuffers; ++i)
+        {
+            m_vecSlots.push_back(std::make_unique<Slot>());
+        }
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        Flush();
+        for (auto& upSlot : m_vecSlots)
+        {
+            Release(*upSlot);
+        }
+    }
+
+    void FrameCapture::Reserve(Slot& slot, GLsizeiptr size)
+    {
+        if (slot.capacity >= size)
+        {
+            return;
+        }
+        Release(slot);
+
+        const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &slot.pbo);
+        glNamedBufferStorage(slot.pbo, size, nullptr, flags);
+        slot.pMapped = glMapNamedBufferRange(slot.pbo, 0, size, flags);
+        if (slot.pMapped == nullptr)
+        {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+            throw FrameCaptureException("ERROR::FRAME_CAPTURE::MAP_FAILED");
+        }
+        slot.capacity = size;
+    }
+
+    void FrameCapture::Release(Slot& slot)
+    {
+        if (slot.fence != nullptr)
+        {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        if (slot.pbo != 0)
+        {
+            glUnmapNamedBuffer(slot.pbo);
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+        slot.pMapped = nullptr;
+        slot.capacity = 0;
+    }
+
+    bool FrameCapture::Capture(const Texture& texture, const std::string& sPath, CaptureFormat eFormat)
+    {
+        Slot* pSlot = nullptr;
+        for (auto& upSlot : m_vecSlots)
+        {
+            if (upSlot->state.load(std::memory_order_acquire) == SLOT_FREE)
+            {
+                pSlot = upSlot.get();
+                break;
+            }
+        }
+        if (pSlot == nullptr)
+        {
+            ++m_uiDropped;
+            return false;
+        }
+
+        const int width = texture.getWidth();
+        const int height = texture.getHeight();
+        const GLenum type = eFormat == CaptureFormat::EXR ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE;
+        const GLsizeiptr size = (GLsizeiptr)width * height * 4 * (eFormat == CaptureFormat::EXR ? 2 : 1);
+        Reserve(*pSlot, size);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pSlot->pbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTextureImage(texture.getId(), 0, GL_RGBA, type, (GLsizei)size, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        pSlot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        pSlot->width = width;
+        pSlot->height = height;
+        pSlot->eFormat = eFormat;
+        pSlot->sPath = sPath;
+        pSlot->state.store(SLOT_IN_FLIGHT, std::memory_order_relaxed);
+        return true;
+    }
+
+    void FrameCapture::Update()
+    {
+        for (auto& upSlot : m_vecSlots)
+        {
+            Slot& slot = *upSlot;
+            if (slot.state.load(std::memory_order_relaxed) != SLOT_IN_FLIGHT)
+            {
+                continue;
+            }
+            // Zero timeout: only poll. The flush bit makes sure the fence gets
+            // submitted even if nothing else flushes this frame.
+            GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            {
+                continue;
+            }
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            slot.state.store(SLOT_ENCODING, std::memory_order_relaxed);
+
+            Slot* pSlot = &slot;
+            m_ThreadPool.Submit([pSlot]()
+            {
+                bool ok = pSlot->eFormat == CaptureFormat::EXR
+                    ? WriteExr(pSlot->sPath, pSlot->width, pSlot->height, static_cast<const uint16_t*>(pSlot->pMapped))
+                    : WritePng(pSlot->sPath, pSlot->width, pSlot->height, static_cast<const uint8_t*>(pSlot->pMapped));
+                if (!ok)
+                {
+                    std::cerr << "ERROR::FRAME_CAPTURE::WRITE_FAILED: " << pSlot->sPath << std::endl;
+                }
+                pSlot->state.store(SLOT_FREE, std::memory_order_release);
+            });
+        }
+    }
+
+    void FrameCapture::Flush()
+    {
+        for (auto& upSlot : m_vecSlots)
+        {
+            if (upSlot->state.load(std::memory_order_relaxed) == SLOT_IN_FLIGHT)
+            {
+                glClientWaitSync(upSlot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            }
+        }
+        Update();
+        m_ThreadPool.WaitIdle();
+    }
+}  // namespace Cme
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "../core/texture.h"
+#include "../core/thread_pool.h"
+#include "../exceptions.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Cme
+{
+    class FrameCaptureException : public QuarkException
+    {
+        using QuarkException::QuarkException;
+    };
+
+    enum class CaptureFormat
+    {
+        // 8-bit, values are clamped to [0, 1].
+        PNG = 0,
+        // Half float, keeps HDR values.
+        EXR,
+    };
+
+    // Asynchronous texture readback into files.
+    //
+    // Capture() only records a glGetTextureImage into one of a set of
+    // persistently mapped pixel-pack buffers and fences it. Update(), called
+    // once per frame, polls the fences without waiting; finished buffers are
+    // handed to a worker pool that encodes straight from the mapped memory, and
+    // become free again when the file is written. If every buffer is busy the
+    // capture is dropped instead of stalling the render thread.
+    class FrameCapture
+    {
+    public:
+        explicit FrameCapture(int numBuffers = 4, unsigned int numWorkers = 2);
+        ~FrameCapture();
+
+        FrameCapture(const FrameCapture&) = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+
+        // Queues a readback of mip level 0 of `texture`. Returns false if the
+        // capture was dropped.
+        bool Capture(const Texture& texture, const std::string& sPath, CaptureFormat eFormat);
+        // Hands finished readbacks to the workers. Never blocks.
+        void Update();
+        // Waits until every queued capture has been written.
+        void Flush();
+
+        unsigned int GetDroppedCount() const { return m_uiDropped; }
+
+    private:
+        enum SlotState
+        {
+            SLOT_FREE = 0,
+            SLOT_IN_FLIGHT,
+            SLOT_ENCODING,
+        };
+
+        struct Slot
+        {
+            GLuint pbo = 0;
+            GLsizeiptr capacity = 0;
+            void* pMapped = nullptr;
+            GLsync fence = nullptr;
+            std::atomic<int> state{ SLOT_FREE };
+
+            int width = 0;
+            int height = 0;
+            CaptureFormat eFormat = CaptureFormat::PNG;
+            std::string sPath;
+        };
+
+        void Reserve(Slot& slot, GLsizeiptr size);
+        void Release(Slot& slot);
+
+        std::vector<std::unique_ptr<Slot>> m_vecSlots;
+        ThreadPool m_ThreadPool;
+        unsigned int m_uiDropped = 0;
+    };
+}  // namespace Cme
@@ -0,0 +1,212 @@
+#include "image_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace Cme
+{
+    namespace
+    {
+        const std::array<uint32_t, 256>& crcTable()
+        {
+            static const std::array<uint32_t, 256> table = []()
+            {
+                std::array<uint32_t, 256> t = {};
+                for (uint32_t n = 0; n < 256; ++n)
+                {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k)
+                    {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    t[n] = c;
+                }
+                return t;
+            }();
+            return table;
+        }
+
+        uint32_t updateCrc(uint32_t crc, const uint8_t* pData, size_t size)
+        {
+            const auto& table = crcTable();
+            for (size_t i = 0; i < size; ++i)
+            {
+                crc = table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+        void putBigEndian32(std::vector<uint8_t>& out, uint32_t value)
+        {
+            out.push_back((uint8_t)(value >> 24));
+            out.push_back((uint8_t)(value >> 16));
+            out.push_back((uint8_t)(value >> 8));
+            out.push_back((uint8_t)value);
+        }
+
+        void writePngChunk(std::ofstream& out, const char* type, const std::vector<uint8_t>& data)
+        {
+            std::vector<uint8_t> chunk;
+            chunk.reserve(data.size() + 12);
+            putBigEndian32(chunk, (uint32_t)data.size());
+            chunk.insert(chunk.end(), type, type + 4);
+            chunk.insert(chunk.end(), data.begin(), data.end());
+            uint32_t crc = updateCrc(0xFFFFFFFFu, chunk.data() + 4, data.size() + 4) ^ 0xFFFFFFFFu;
+            putBigEndian32(chunk, crc);
+            out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+        }
+
+        template <typename T>
+        void putLittleEndian(std::vector<uint8_t>& out, T value)
+        {
+            const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&value);
+            out.insert(out.end(), pBytes, pBytes + sizeof(T));
+        }
+
+        void putExrAttribute(std::vector<uint8_t>& out, const char* name, const char* type,
+                             const std::vector<uint8_t>& value)
+        {
+            out.insert(out.end(), name, name + std::char_traits<char>::length(name) + 1);
+            out.insert(out.end(), type, type + std::char_traits<char>::length(type) + 1);
+            putLittleEndian<int32_t>(out, (int32_t)value.size());
+            out.insert(out.end(), value.begin(), value.end());
+        }
+    }
+
+    bool WritePng(const std::string& sPath, int width, int height, const uint8_t* pRgba)
+    {
+        std::ofstream out(sPath, std::ios::binary);
+        if (!out)
+        {
+            return false;
+        }
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+        std::vector<uint8_t> header;
+        putBigEndian32(header, (uint32_t)width);
+        putBigEndian32(header, (uint32_t)height);
+        // 8 bits per channel, RGBA, deflate, adaptive filtering, no interlace.
+        header.insert(header.end(), { 8, 6, 0, 0, 0 });
+        writePngChunk(out, "IHDR", header);
+
+        // Scanlines, each prefixed with filter type 0, flipped to top-down.
+        const size_t rowSize = (size_t)width * 4;
+        std::vector<uint8_t> raw;
+        raw.reserve((rowSize + 1) * height);
+        for (int y = height - 1; y >= 0; --y)
+        {
+            raw.push_back(0);
+            const uint8_t* pRow = pRgba + rowSize * y;
+            raw.insert(raw.end(), pRow, pRow + rowSize);
+        }
+
+        // zlib stream made of stored deflate blocks.
+        std::vector<uint8_t> zlib;
+        const size_t maxBlock = 65535;
+        zlib.reserve(raw.size() + raw.size() / maxBlock * 5 + 16);
+        zlib.push_back(0x78);
+        zlib.push_back(0x01);
+        uint32_t adlerA = 1;
+        uint32_t adlerB = 0;
+        for (size_t offset = 0; offset < raw.size(); offset += maxBlock)
+        {
+            uint16_t size = (uint16_t)std::min(maxBlock, raw.size() - offset);
+            zlib.push_back(offset + size >= raw.size() ? 1 : 0);
+            zlib.push_back((uint8_t)size);
+            zlib.push_back((uint8_t)(size >> 8));
+            zlib.push_back((uint8_t)~size);
+            zlib.push_back((uint8_t)(~size >> 8));
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+            for (size_t i = offset; i < offset + size; ++i)
+            {
+                adlerA = (adlerA + raw[i]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+        }
+        putBigEndian32(zlib, (adlerB << 16) | adlerA);
+        writePngChunk(out, "IDAT", zlib);
+        writePngChunk(out, "IEND", {});
+        return out.good();
+    }
+
+    bool WriteExr(const std::string& sPath, int width, int height, const uint16_t* pRgbaHalf)
+    {
+        std::ofstream out(sPath, std::ios::binary);
+        if (!out)
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> header;
+        putLittleEndian<uint32_t>(header, 20000630);
+        // Version 2, single part scanline file.
+        putLittleEndian<uint32_t>(header, 2);
+
+        // Channels must be listed in alphabetical order.
+        const char channelNames[4] = { 'A', 'B', 'G', 'R' };
+        const int channelSource[4] = { 3, 2, 1, 0 };
+        std::vector<uint8_t> channels;
+        for (char name : channelNames)
+        {
+            channels.push_back((uint8_t)name);
+            channels.push_back(0);
+            putLittleEndian<int32_t>(channels, 1);  // HALF
+            channels.insert(channels.end(), { 0, 0, 0, 0 });  // pLinear, reserved
+            putLittleEndian<int32_t>(channels, 1);  // x sampling
+            putLittleEndian<int32_t>(channels, 1);  // y sampling
+        }
+        channels.push_back(0);
+        putExrAttribute(header, "channels", "chlist", channels);
+        putExrAttribute(header, "compression", "compression", { 0 });
+
+        std::vector<uint8_t> window;
+        putLittleEndian<int32_t>(window, 0);
+        putLittleEndian<int32_t>(window, 0);
+        putLittleEndian<int32_t>(window, width - 1);
+        putLittleEndian<int32_t>(window, height - 1);
+        putExrAttribute(header, "dataWindow", "box2i", window);
+        putExrAttribute(header, "displayWindow", "box2i", window);
+        putExrAttribute(header, "lineOrder", "lineOrder", { 0 });
+
+        std::vector<uint8_t> one;
+        putLittleEndian<float>(one, 1.0f);
+        putExrAttribute(header, "pixelAspectRatio", "float", one);
+        std::vector<uint8_t> center;
+        putLittleEndian<float>(center, 0.0f);
+        putLittleEndian<float>(center, 0.0f);
+        putExrAttribute(header, "screenWindowCenter", "v2f", center);
+        putExrAttribute(header, "screenWindowWidth", "float", one);
+        header.push_back(0);
+
+        // One scanline per block without compression.
+        const size_t blockDataSize = (size_t)width * 4 * sizeof(uint16_t);
+        const uint64_t firstBlock = header.size() + (uint64_t)height * sizeof(uint64_t);
+        for (int y = 0; y < height; ++y)
+        {
+            putLittleEndian<uint64_t>(header, firstBlock + (uint64_t)y * (8 + blockDataSize));
+        }
+        out.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+        std::vector<uint8_t> block;
+        block.reserve(8 + blockDataSize);
+        for (int y = 0; y < height; ++y)
+        {
+            block.clear();
+            putLittleEndian<int32_t>(block, y);
+            putLittleEndian<int32_t>(block, (int32_t)blockDataSize);
+            const uint16_t* pRow = pRgbaHalf + (size_t)(height - 1 - y) * width * 4;
+            for (int channel : channelSource)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    putLittleEndian<uint16_t>(block, pRow[x * 4 + channel]);
+                }
+            }
+            out.write(reinterpret_cast<const char*>(block.data()), block.size());
+        }
+        return out.good();
+    }
+}  // namespace Cme
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Cme
+{
+    // Minimal image encoders for frame capture, free of GL calls so that they
+    // can run on worker threads. Pixels are tightly packed RGBA with the first
+    // row at the bottom, as returned by OpenGL; the files are written top-down.
+
+    // 8-bit RGBA PNG. Without a compression library in the tree the image data
+    // is stored in uncompressed deflate blocks, so files are about as large as
+    // the raw pixels, but any PNG reader accepts them.
+    bool WritePng(const std::string& sPath, int width, int height, const uint8_t* pRgba);
+
+    // Half float RGBA OpenEXR, scanline layout without compression.
+    bool WriteExr(const std::string& sPath, int width, int height, const uint16_t* pRgbaHalf);
+}  // namespace Cme
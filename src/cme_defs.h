@@ -11,6 +11,10 @@
 #define WATER_FOUNTAIN_MAX_PARTICLES 100000
 #endif
 
+#ifndef CPU_PARTICLE_MAX_PARTICLES
+#define CPU_PARTICLE_MAX_PARTICLES 20000
+#endif
+
 namespace Cme
 {
     enum class CameraControlType
@@ -70,6 +74,22 @@ namespace Cme
         Fire
     };
 
+    enum class ParticleRendering
+    {
+        // Points, expanded to sprites by a geometry shader.
+        GEOMETRY_SHADER = 0,
+        // Instanced quads, expanded in the vertex shader.
+        INSTANCED_QUADS,
+    };
+
+    enum class ParticleBlending
+    {
+        // Order independent, but only for glowing effects.
+        ADDITIVE = 0,
+        // Over blending, after a depth sort of the particles on the GPU.
+        ALPHA_SORTED,
+    };
+
     // Options for the model render UI. The defaults here are used at startup.
     struct ModelRenderOptions
     {
@@ -85,11 +105,29 @@ namespace Cme
         float directionalIntensity = 10.0f;
         glm::vec3 directionalDirection = glm::normalize(glm::vec3(-0.2f, -1.0f, -0.3f));
 
+        // Animated point lights around the model, to load clustered shading.
+        int numPointLights = 0;
+        float pointLightIntensity = 1.0f;
+        float pointLightRange = 0.75f;
+        // Point and spot light shadows from the shadow atlas. The first
+        // numShadowedPointLights point lights cast shadows.
+        bool localShadows = true;
+        int numShadowedPointLights = 4;
+        // Atlas tile texels per pixel a light covers on screen.
+        float shadowAtlasCoverageScale = 1.0f;
+        int shadowAtlasLights = 0;
+        int shadowAtlasTiles = 0;
+
         bool shadowMapping = false;
-        float shadowCameraCuboidExtents = 2.0f;
-        float shadowCameraNear = 0.1f;
-        float shadowCameraFar = 15.0f;
-        float shadowCameraDistance = 5.0f;
+        int shadowCascades = 4;
+        // 0: uniform splits, 1: logarithmic splits.
+        float shadowSplitLambda = 0.75f;
+        float shadowDistance = 30.0f;
+        bool shadowStableFit = true;
+        // Caches static caster depth and spreads far cascade refreshes over frames.
+        bool shadowCaching = true;
+        float shadowRefreshBudgetMs = 0.5f;
+        bool shadowCascadeVis = false;
         float shadowBiasMin = 0.0001;
         float shadowBiasMax = 0.001;
 
@@ -100,17 +138,35 @@ namespace Cme
         bool ssao = false;
         float ssaoRadius = 0.5f;
         float ssaoBias = 0.025f;
+        int ssaoSamples = 16;
+        // Computes AO at a quarter instead of half of the screen resolution.
+        bool ssaoQuarterResolution = false;
+        // Accumulates AO over frames, with the kernel rotated every frame.
+        bool ssaoTemporal = true;
+        float ssaoTemporalBlend = 0.1f;
         float shininess = 32.0f;
         float emissionIntensity = 5.0f;
         glm::vec3 emissionAttenuation = glm::vec3(0, 0, 1.0f);
 
         bool bloom = true;
         float bloomMix = 0.004;
+        // Radius of the bloom upsampling filter, in texture coordinates.
+        float bloomFilterRadius = 0.005f;
+        // Linear scale of the HDR image before tone mapping. Compensation on
+        // top of the measured exposure when auto exposure is on.
+        float exposure = 1.0f;
+        bool autoExposure = true;
+        // Rate at which auto exposure adapts, in 1 / seconds.
+        float exposureAdaptationSpeed = 1.5f;
         ToneMapping toneMapping = ToneMapping::ACES_APPROX;
         bool gammaCorrect = true;
         float gamma = 2.2f;
 
         bool fxaa = true;
+        // Temporal anti-aliasing with a jittered projection.
+        bool taa = true;
+        // Weight of the current frame in the TAA history.
+        float taaBlend = 0.1f;
 
         // Camera.
         CameraControlType cameraControlType = CameraControlType::FLY;
@@ -125,6 +181,12 @@ namespace Cme
         GBufferVis gBufferVis = GBufferVis::DISABLED;
         bool wireframe = false;
         bool drawNormals = false;
+        bool validateLightClusters = false;
+
+        // ͼ
+        bool captureScreenshot = false;
+        bool captureSequence = false;
+        bool captureExr = false;
 
         // 
         const float* frameDeltas = nullptr;
@@ -132,8 +194,24 @@ namespace Cme
         int frameDeltasOffset = 0;
         float avgFPS = 0;
         bool enableVsync = true;
+        // Lowers the render resolution to hold the target frame rate, and
+        // upscales to the window size.
+        bool dynamicResolution = false;
+        float targetFrameRate = 60.0f;
+        float minRenderScale = 0.5f;
+        float upscaleSharpness = 0.5f;
+        float renderScale = 1.0f;
 
         // 
+        // Size of the fountain's particle pool.
+        int particleCount = WATER_FOUNTAIN_MAX_PARTICLES;
+        ParticleRendering particleRendering = ParticleRendering::INSTANCED_QUADS;
+        // Stretches the sprites along their movement.
+        bool particleStretch = true;
+        ParticleBlending particleBlending = ParticleBlending::ADDITIVE;
+        // Sparks simulated on the CPU, besides the fountain.
+        bool cpuParticles = false;
+        int cpuParticleCount = CPU_PARTICLE_MAX_PARTICLES;
         bool bChangeParticleColorByTime = true;
         glm::vec3 vec3ParticleLocation = glm::vec3(0.0f, 0.0f, 0.0f);
         glm::vec3 vec3ParticleColor = glm::vec3(1.0f, 0.0f, 0.0f);
@@ -0,0 +1,29 @@
+#include "frame_clock.h"
+
+namespace Cme
+{
+    FrameClock& FrameClock::GetInstance()
+    {
+        static FrameClock clock;
+        return clock;
+    }
+
+    float FrameClock::Tick(float realDelta)
+    {
+        float delta = realDelta;
+        bool bFromSource = m_DeltaSource && m_DeltaSource(delta);
+        if (!bFromSource)
+        {
+            delta = m_fFixedTimestep > 0.0f ? m_fFixedTimestep : realDelta;
+        }
+        m_fDeltaTime = delta;
+        m_dTime += delta;
+        return delta;
+    }
+
+    void FrameClock::Reset()
+    {
+        m_dTime = 0.0;
+        m_fDeltaTime = 0.0f;
+    }
+}  // namespace Cme
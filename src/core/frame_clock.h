@@ -0,0 +1,50 @@
+#ifndef QUARKGL_FRAME_CLOCK_H_
+#define QUARKGL_FRAME_CLOCK_H_
+
+#include <functional>
+
+namespace Cme
+{
+    // Virtual time seen by everything that animates. Window::loop ticks it once
+    // per frame with the measured wall time; depending on the mode the clock
+    // either follows wall time, advances by a fixed timestep, or takes its
+    // deltas from an external source such as a replayed session. Code that
+    // animates should read GetTime() instead of glfwGetTime() so that a
+    // session can be reproduced frame for frame.
+    class FrameClock
+    {
+    public:
+        static FrameClock& GetInstance();
+
+        // Advances the clock by one frame and returns the frame delta.
+        float Tick(float realDelta);
+
+        // Seconds of virtual time since the first frame.
+        double GetTime() const { return m_dTime; }
+        float GetDeltaTime() const { return m_fDeltaTime; }
+
+        // A positive step makes every frame advance by exactly `step` seconds;
+        // zero returns to wall time.
+        void SetFixedTimestep(float step) { m_fFixedTimestep = step; }
+        float GetFixedTimestep() const { return m_fFixedTimestep; }
+
+        // Takes precedence over the fixed timestep while set. The source writes
+        // the next delta and returns false once it has none left, in which case
+        // the clock falls back to the other modes.
+        void SetDeltaSource(std::function<bool(float&)> source) { m_DeltaSource = std::move(source); }
+
+        void Reset();
+
+    private:
+        FrameClock() {};
+        FrameClock(const FrameClock&) = delete;
+        void operator=(const FrameClock&) = delete;
+
+        double m_dTime = 0.0;
+        float m_fDeltaTime = 0.0f;
+        float m_fFixedTimestep = 0.0f;
+        std::function<bool(float&)> m_DeltaSource;
+    };
+}  // namespace Cme
+
+#endif
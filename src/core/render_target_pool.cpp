@@ -0,0 +1,159 @@
+#include "render_target_pool.h"
+#include "../common_helper.h"
+
+#include <algorithm>
+
+namespace Cme
+{
+    namespace
+    {
+        // Frames a released target is kept for reuse before it is deleted.
+        // Long enough to survive a pass being torn down and rebuilt within a
+        // frame or two, short enough that a resize doesn't hold both sizes.
+        constexpr unsigned long long RENDER_TARGET_RETENTION_FRAMES = 3;
+
+        // Mirrors the mip count chosen by Texture::Create().
+        int calculateNumMips(int width, int height, const TextureParams& params)
+        {
+            if (params.generateMips != MipGeneration::ALWAYS)
+            {
+                return 1;
+            }
+            int numMips = CommonHelper::calculateNumMips(width, height);
+            if (params.maxNumMips >= 0)
+            {
+                numMips = std::min(numMips, params.maxNumMips);
+            }
+            return numMips;
+        }
+
+        GLenum textureBindingQuery(TextureType type)
+        {
+            switch (type)
+            {
+            case TextureType::CUBEMAP:
+                return GL_TEXTURE_BINDING_CUBE_MAP;
+            case TextureType::TEXTURE_2D_ARRAY:
+                return GL_TEXTURE_BINDING_2D_ARRAY;
+            default:
+                return GL_TEXTURE_BINDING_2D;
+            }
+        }
+    }
+
+    bool RenderTargetPool::Key::operator==(const Key& other) const
+    {
+        return width == other.width && height == other.height && internalFormat == other.internalFormat &&
+               type == other.type && numMips == other.numMips && layers == other.layers && samples == other.samples;
+    }
+
+    RenderTargetPool& RenderTargetPool::GetInstance()
+    {
+        static RenderTargetPool pool;
+        return pool;
+    }
+
+    Texture RenderTargetPool::Acquire(int width, int height, GLenum internalFormat, const TextureParams& params,
+                                      BufferType type, int layers, int samples)
+    {
+        Key key;
+        key.width = width;
+        key.height = height;
+        key.internalFormat = internalFormat;
+        key.type = layers > 1 ? TextureType::TEXTURE_2D_ARRAY
+                 : (type == BufferType::COLOR_CUBEMAP_HDR || type == BufferType::COLOR_CUBEMAP_HDR_ALPHA)
+                     ? TextureType::CUBEMAP : TextureType::TEXTURE_2D;
+        key.numMips = calculateNumMips(width, height, params);
+        key.layers = layers;
+        key.samples = samples;
+
+        for (Target& target : m_vecTargets)
+        {
+            if (target.inUse || !(target.key == key))
+            {
+                continue;
+            }
+            target.inUse = true;
+
+            // Undo what the previous user may have changed. SetTextureParams()
+            // works on the bound texture, so the binding of the active unit,
+            // which may be one the TextureManager reserved, is restored after.
+            GLuint id = target.texture.getId();
+            GLenum glTarget = textureTypeToGlTarget(key.type);
+            GLint previous = 0;
+            glGetIntegerv(textureBindingQuery(key.type), &previous);
+            glBindTexture(glTarget, id);
+            target.texture.SetTextureParams(params, key.type);
+            glBindTexture(glTarget, static_cast<GLuint>(previous));
+            glTextureParameteri(id, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+            glTextureParameteri(id, GL_TEXTURE_BASE_LEVEL, 0);
+            glTextureParameteri(id, GL_TEXTURE_MAX_LEVEL, 1000);
+            return target.texture;
+        }
+
+        Target target;
+        target.key = key;
+        if (layers > 1)
+        {
+            target.texture.CreateArray(width, height, layers, internalFormat, params);
+        }
+        else
+        {
+            target.texture.Create(width, height, internalFormat, params, type);
+            target.texture.SetTextureType(key.type);
+        }
+        target.inUse = true;
+        target.releasedFrame = m_ullFrame;
+        m_vecTargets.push_back(target);
+        return target.texture;
+    }
+
+    void RenderTargetPool::Release(const Texture& texture)
+    {
+        for (Target& target : m_vecTargets)
+        {
+            if (target.inUse && target.texture.getId() == texture.getId())
+            {
+                target.inUse = false;
+                target.releasedFrame = m_ullFrame;
+                return;
+            }
+        }
+    }
+
+    void RenderTargetPool::NextFrame()
+    {
+        ++m_ullFrame;
+        auto expired = [this](Target& target)
+        {
+            if (target.inUse || m_ullFrame - target.releasedFrame <= RENDER_TARGET_RETENTION_FRAMES)
+            {
+                return false;
+            }
+            target.texture.free();
+            return true;
+        };
+        m_vecTargets.erase(std::remove_if(m_vecTargets.begin(), m_vecTargets.end(), expired), m_vecTargets.end());
+    }
+
+    void RenderTargetPool::Trim()
+    {
+        auto released = [](Target& target)
+        {
+            if (target.inUse)
+            {
+                return false;
+            }
+            target.texture.free();
+            return true;
+        };
+        m_vecTargets.erase(std::remove_if(m_vecTargets.begin(), m_vecTargets.end(), released), m_vecTargets.end());
+    }
+
+    int RenderTargetPool::GetNumFreeTargets() const
+    {
+        return (int)std::count_if(m_vecTargets.begin(), m_vecTargets.end(),
+                                  [](const Target& target) { return !target.inUse; });
+    }
+
+}  // namespace Cme
@@ -0,0 +1,76 @@
+#ifndef QUARKGL_RENDER_TARGET_POOL_H_
+#define QUARKGL_RENDER_TARGET_POOL_H_
+
+#include "texture.h"
+
+#include <glad/glad.h>
+#include <vector>
+
+namespace Cme
+{
+    // Owns the textures that render passes draw into. Targets are keyed by
+    // size, format, texture type, mip and layer count and sample count. A
+    // released target goes back to the pool, where the next request with the
+    // same key picks it up instead of allocating. Released targets that stay
+    // unused for a few frames are deleted, so a resize or an environment
+    // switch frees the old targets a fixed number of frames later instead of
+    // leaking them.
+    //
+    // Framebuffer acquires its texture attachments here and releases them
+    // when destroyed, so passes built on it get pooling without changes.
+    class RenderTargetPool
+    {
+    public:
+        static RenderTargetPool& GetInstance();
+
+        // Hands out a target like Texture::Create() or, for `layers` above 1,
+        // Texture::CreateArray(). A reused target has `params` applied again
+        // and per-use state such as depth comparison reset.
+        Texture Acquire(int width, int height, GLenum internalFormat, const TextureParams& params, BufferType type,
+                        int layers = 1, int samples = 0);
+        // Returns a target handed out by Acquire(). Other textures are ignored.
+        void Release(const Texture& texture);
+
+        // Advances the frame counter and deletes the targets that have been
+        // released for more than the retention period. Call once per frame.
+        void NextFrame();
+        // Deletes all released targets immediately.
+        void Trim();
+
+        int GetNumTargets() const { return (int)m_vecTargets.size(); }
+        int GetNumFreeTargets() const;
+
+    private:
+        RenderTargetPool() {}
+        RenderTargetPool(const RenderTargetPool&) = delete;
+        void operator=(const RenderTargetPool&) = delete;
+
+        struct Key
+        {
+            int width;
+            int height;
+            GLenum internalFormat;
+            TextureType type;
+            int numMips;
+            int layers;
+            int samples;
+
+            bool operator==(const Key& other) const;
+        };
+
+        struct Target
+        {
+            Key key;
+            Texture texture;
+            bool inUse;
+            // Frame of the last release.
+            unsigned long long releasedFrame;
+        };
+
+        std::vector<Target> m_vecTargets;
+        unsigned long long m_ullFrame = 0;
+    };
+
+}  // namespace Cme
+
+#endif
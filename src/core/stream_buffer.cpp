@@ -0,0 +1,133 @@
+#include "stream_buffer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace Cme
+{
+    namespace
+    {
+        // Live buffers, for EndFrame(). Only touched on the render thread.
+        std::vector<StreamBuffer*>& streamBuffers()
+        {
+            static std::vector<StreamBuffer*> buffers;
+            return buffers;
+        }
+    }
+
+    StreamBuffer::StreamBuffer(GLsizeiptr regionSize, GLsizeiptr alignment)
+    {
+        if (regionSize <= 0 || alignment <= 0)
+        {
+            throw StreamBufferException("ERROR::STREAM_BUFFER::INVALID_SIZE");
+        }
+        m_iAlignment = alignment;
+        // Keep every region start aligned so that offsets can be bound directly.
+        m_iRegionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &m_uiBuffer);
+        glNamedBufferStorage(m_uiBuffer, m_iRegionSize * NUM_REGIONS, nullptr, flags);
+        m_pMapped = static_cast<unsigned char*>(
+            glMapNamedBufferRange(m_uiBuffer, 0, m_iRegionSize * NUM_REGIONS, flags));
+        if (m_pMapped == nullptr)
+        {
+            glDeleteBuffers(1, &m_uiBuffer);
+            throw StreamBufferException("ERROR::STREAM_BUFFER::MAP_FAILED");
+        }
+        streamBuffers().push_back(this);
+    }
+
+    StreamBuffer::~StreamBuffer()
+    {
+        auto& buffers = streamBuffers();
+        buffers.erase(std::remove(buffers.begin(), buffers.end(), this), buffers.end());
+        for (auto& fence : m_arrFences)
+        {
+            if (fence != nullptr)
+            {
+                glDeleteSync(fence);
+            }
+        }
+        glUnmapNamedBuffer(m_uiBuffer);
+        glDeleteBuffers(1, &m_uiBuffer);
+    }
+
+    void* StreamBuffer::BeginRegion()
+    {
+        m_iRegion = (m_iRegion + 1) % NUM_REGIONS;
+        m_iCursor = 0;
+        m_bRegionOpen = true;
+        WaitForRegion(m_iRegion);
+        return m_pMapped + GetRegionOffset();
+    }
+
+    void StreamBuffer::EndRegion()
+    {
+        GLsync& fence = m_arrFences[m_iRegion];
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+        }
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_bRegionOpen = false;
+    }
+
+    void StreamBuffer::EndFrame()
+    {
+        for (StreamBuffer* pBuffer : streamBuffers())
+        {
+            if (pBuffer->m_bRegionOpen)
+            {
+                pBuffer->EndRegion();
+            }
+        }
+    }
+
+    void* StreamBuffer::Allocate(GLsizeiptr size, GLintptr& offset)
+    {
+        if (!m_bRegionOpen)
+        {
+            BeginRegion();
+        }
+        GLsizeiptr start = (m_iCursor + m_iAlignment - 1) / m_iAlignment * m_iAlignment;
+        if (start + size > m_iRegionSize)
+        {
+            return nullptr;
+        }
+        m_iCursor = start + size;
+        offset = GetRegionOffset() + start;
+        return m_pMapped + offset;
+    }
+
+    void StreamBuffer::WaitForRegion(int region)
+    {
+        GLsync& fence = m_arrFences[region];
+        if (fence == nullptr)
+        {
+            return;
+        }
+
+        // Flush on the first wait so the fence is guaranteed to be submitted,
+        // then keep polling. With three regions this almost never blocks.
+        GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        const GLuint64 timeoutNs = 1000000;
+        while (true)
+        {
+            GLenum result = glClientWaitSync(fence, waitFlags, timeoutNs);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
+            if (result == GL_WAIT_FAILED)
+            {
+                std::cerr << "ERROR::STREAM_BUFFER::WAIT_FAILED" << std::endl;
+                break;
+            }
+            waitFlags = 0;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}  // namespace Cme
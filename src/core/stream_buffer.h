@@ -0,0 +1,82 @@
+#ifndef QUARKGL_STREAM_BUFFER_H_
+#define QUARKGL_STREAM_BUFFER_H_
+
+#include <glad/glad.h>
+
+#include "../exceptions.h"
+
+#include <array>
+
+namespace Cme
+{
+    class StreamBufferException : public QuarkException
+    {
+        using QuarkException::QuarkException;
+    };
+
+    // A persistently mapped ring buffer for data that is re-specified every
+    // frame. The storage is split into NUM_REGIONS equally sized regions; the
+    // CPU writes into one region while the GPU may still be reading from the
+    // others. A fence guards each region so that it is never overwritten before
+    // the draws that sourced it have completed. This replaces the
+    // glBufferData/glBufferSubData orphaning pattern, which forces the driver to
+    // either allocate or implicitly synchronize.
+    //
+    // Usage per frame:
+    //   void* ptr = buffer.BeginRegion();     // waits on the region's fence
+    //   ... write up to GetRegionSize() bytes, or use Allocate() ...
+    //   ... issue draws sourcing GetRegionOffset() ...
+    //   buffer.EndRegion();                   // fences the region
+    //
+    // Buffers drawn from several times per frame sub-allocate each draw with
+    // Allocate(), which opens a region on first use, and leave the fence to
+    // EndFrame(). A region per draw would wrap the ring within a frame and
+    // wait on the GPU.
+    class StreamBuffer
+    {
+    public:
+        static constexpr int NUM_REGIONS = 3;
+
+        StreamBuffer(GLsizeiptr regionSize, GLsizeiptr alignment = 16);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        // Advances to the next region and blocks until the GPU is done with it.
+        // Returns the mapped pointer to the start of the region.
+        void* BeginRegion();
+        // Places a fence after the commands that read the current region.
+        void EndRegion();
+        // Fences the open region of every stream buffer. Called once per frame
+        // after the last draw, so regions whose readers were skipped are
+        // fenced too.
+        static void EndFrame();
+
+        // Sub-allocates `size` bytes from the current region, opening the
+        // next region if none is open. Writes the absolute byte offset into
+        // the buffer to `offset`. Returns nullptr if the region is exhausted.
+        void* Allocate(GLsizeiptr size, GLintptr& offset);
+
+        GLuint GetBufferID() const { return m_uiBuffer; }
+        GLsizeiptr GetRegionSize() const { return m_iRegionSize; }
+        // Absolute byte offset of the current region within the buffer.
+        GLintptr GetRegionOffset() const { return m_iRegionSize * m_iRegion; }
+
+    private:
+        void WaitForRegion(int region);
+
+        GLuint m_uiBuffer = 0;
+        GLsizeiptr m_iRegionSize = 0;
+        GLsizeiptr m_iAlignment = 0;
+        unsigned char* m_pMapped = nullptr;
+
+        int m_iRegion = NUM_REGIONS - 1;
+        // Written since the last fence.
+        bool m_bRegionOpen = false;
+        GLsizeiptr m_iCursor = 0;
+        std::array<GLsync, NUM_REGIONS> m_arrFences = {};
+    };
+}  // namespace Cme
+
+#endif
@@ -9,6 +9,33 @@
 
 namespace Cme 
 {
+    namespace
+    {
+        // ڲʽͨ ֻcreateFromDataõĸʽ
+        int channelsOfFormat(GLenum internalFormat)
+        {
+            switch (internalFormat)
+            {
+            case GL_R16F:
+            case GL_R32F:
+                return 1;
+            case GL_RG16F:
+            case GL_RG32F:
+                return 2;
+            case GL_RGB16F:
+            case GL_RGB32F:
+            case GL_R11F_G11F_B10F:
+                return 3;
+            case GL_RGBA16F:
+            case GL_RGBA32F:
+                return 4;
+            default:
+                throw TextureException("ERROR::TEXTURE::UNSUPPORTED_TEXTURE_FORMAT\n"
+                    "Internal format " + std::to_string(internalFormat) + " is not supported by createFromData");
+            }
+        }
+    }
+
     // C++ ̬޷ʹ÷Ǿ̬
     void Texture::LoadTexture(const char* path, bool isSRGB)
     {
@@ -242,6 +269,33 @@ namespace Cme
         SetTextureParams(params, textureType);
     }
 
+    void Texture::CreateArray(int width, int height, int layers, GLenum internalFormat, const TextureParams& params)
+    {
+        m_eType = TextureType::TEXTURE_2D_ARRAY;
+        m_iWidth = width;
+        m_iHeight = height;
+        m_iNumLayers = layers;
+        m_iNumChannels = 0;  // Default.
+        m_iNumMips = 1;
+        if (params.generateMips == MipGeneration::ALWAYS)
+        {
+            m_iNumMips = CommonHelper::calculateNumMips(m_iWidth, m_iHeight);
+            if (params.maxNumMips >= 0)
+            {
+                m_iNumMips = std::min(m_iNumMips, params.maxNumMips);
+            }
+        }
+        m_uiInternalFormat = internalFormat;
+
+        glGenTextures(1, &m_uiID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_uiID);
+
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_iNumMips, m_uiInternalFormat, m_iWidth, m_iHeight, m_iNumLayers);
+
+        // Set texture-wrapping/filtering options.
+        SetTextureParams(params, m_eType);
+    }
+
     void Texture::createCubemap(int size, GLenum internalFormat)
     {
         TextureParams params;
@@ -279,26 +333,35 @@ namespace Cme
             throw TextureException("ERROR::TEXTURE::INVALID_DATA_SIZE");
         }
 
-        int iNumMips = 1;
+        m_eType = TextureType::TEXTURE_2D;
+        m_iWidth = width;
+        m_iHeight = height;
+        m_iNumChannels = channelsOfFormat(internalFormat);
+        m_iNumMips = 1;
         if (params.generateMips == MipGeneration::ALWAYS)
         {
-            iNumMips = CommonHelper::calculateNumMips(width, height);
+            m_iNumMips = CommonHelper::calculateNumMips(width, height);
             if (params.maxNumMips >= 0)
             {
-                iNumMips = std::min(iNumMips, params.maxNumMips);
+                m_iNumMips = std::min(m_iNumMips, params.maxNumMips);
             }
         }
+        m_uiInternalFormat = internalFormat;
 
         glGenTextures(1, &m_uiID);
         glBindTexture(GL_TEXTURE_2D, m_uiID);
 
-        glTexStorage2D(GL_TEXTURE_2D, iNumMips, internalFormat, width, height);
+        glTexStorage2D(GL_TEXTURE_2D, m_iNumMips, internalFormat, width, height);
 
         // Set texture-wrapping/filtering options.
         SetTextureParams(params, TextureType::TEXTURE_2D);
 
         // Upload the data. ssaoר
-        //glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_iWidth, m_iHeight, GL_RGB, GL_FLOAT, data.data());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_iWidth, m_iHeight, GL_RGB, GL_FLOAT, data.data());
+        if (m_iNumMips > 1)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
         return true;
     }
 
@@ -320,6 +383,9 @@ namespace Cme
         case TextureBindType::CUBEMAP:
             glBindTexture(GL_TEXTURE_CUBE_MAP, m_uiID);
             break;
+        case TextureBindType::TEXTURE_2D_ARRAY:
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_uiID);
+            break;
         case TextureBindType::IMAGE_TEXTURE:
             // Bind image unit.
             glBindImageTexture(textureUnit, m_uiID, 0, GL_FALSE, 0, GL_READ_WRITE, m_uiInternalFormat);
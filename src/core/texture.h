@@ -22,6 +22,8 @@ namespace Cme
     {
         TEXTURE_2D = 0,
         CUBEMAP,
+        // A stack of equally sized 2D layers, e.g. shadow cascades.
+        TEXTURE_2D_ARRAY,
     };
 
     enum class BufferType
@@ -35,6 +37,13 @@ namespace Cme
         COLOR_ALPHA,
         COLOR_HDR_ALPHA,
         COLOR_SNORM_ALPHA,
+        // Two channel attachments, e.g. for octahedral normals or packed
+        // material parameters.
+        COLOR_RG,
+        COLOR_SNORM_RG,
+        // Packed R11G11B10F attachment. Unsigned HDR color at half the size of
+        // COLOR_HDR_ALPHA.
+        COLOR_HDR_PACKED,
         COLOR_CUBEMAP_HDR,
         COLOR_CUBEMAP_HDR_ALPHA,
         GRAYSCALE,
@@ -51,6 +60,8 @@ namespace Cme
             return GL_TEXTURE_2D;
         case TextureType::CUBEMAP:
             return GL_TEXTURE_CUBE_MAP;
+        case TextureType::TEXTURE_2D_ARRAY:
+            return GL_TEXTURE_2D_ARRAY;
         }
         throw TextureException("ERROR::TEXTURE::INVALID_TEXTURE_TYPE\n" +
                                 std::to_string(static_cast<int>(type)));
@@ -65,6 +76,8 @@ namespace Cme
         TEXTURE_2D,
         // A cubemap.
         CUBEMAP,
+        // A TEXTURE_2D_ARRAY.
+        TEXTURE_2D_ARRAY,
         // An image texture that is directly indexed, rather than sampled.
         IMAGE_TEXTURE,
     };
@@ -77,6 +90,8 @@ namespace Cme
             return TextureBindType::TEXTURE_2D;
         case TextureType::CUBEMAP:
             return TextureBindType::CUBEMAP;
+        case TextureType::TEXTURE_2D_ARRAY:
+            return TextureBindType::TEXTURE_2D_ARRAY;
         }
         throw TextureException("ERROR::TEXTURE::INVALID_TEXTURE_TYPE\n" +
                                 std::to_string(static_cast<int>(type)));
@@ -146,6 +161,8 @@ namespace Cme
         bool createFromData(int width, int height, GLenum internalFormat, const std::vector<glm::vec3>& data, const TextureParams& params);
         // Creates a custom texture of the given size and format.
         void Create(int width, int height, GLenum internalFormat, const TextureParams& params, Cme::BufferType type);
+        // Creates a 2D array texture with the given number of layers.
+        void CreateArray(int width, int height, int layers, GLenum internalFormat, const TextureParams& params);
 
         // TODO: Replace this with proper RAII.
         void free();
@@ -176,6 +193,8 @@ namespace Cme
         int getHeight() const { return m_iHeight; }
         int getNumChannels() const { return m_iNumChannels; }
         int getNumMips() const { return m_iNumMips; }
+        // Number of layers of an array texture, 1 otherwise.
+        int getNumLayers() const { return m_iNumLayers; }
         // TODO: Remove GLenum from this API (use a custom enum).
         GLenum getInternalFormat() const { return m_uiInternalFormat; }
 
@@ -192,6 +211,7 @@ namespace Cme
         int m_iHeight;
         int m_iNumChannels;
         int m_iNumMips;
+        int m_iNumLayers = 1;
         GLenum m_uiInternalFormat;
 
         friend class Framebuffer;
@@ -17,6 +17,11 @@ namespace Cme
 		m_mapTextureCache[sKey] = std::move(vecTextures);
 	}
 
+	void TextureManager::ReplaceTexture(const std::string& sKey, std::vector<std::shared_ptr<Texture>> vecTextures)
+	{
+		m_mapTextureCache[sKey] = std::move(vecTextures);
+	}
+
 	std::vector<std::shared_ptr<Texture>> TextureManager::GetTexture(const std::string& sKey) const
 	{
 		if (!ContainTexture(sKey))
@@ -16,6 +16,9 @@ namespace Cme
 		static TextureManager& GetInstance();
 
 		void AddTexture(const std::string& sKey, std::vector<std::shared_ptr<Texture>> vecTextures);
+		// 滻м ʱͬAddTexture
+		// λò ʱԪֲ
+		void ReplaceTexture(const std::string& sKey, std::vector<std::shared_ptr<Texture>> vecTextures);
 		std::vector<std::shared_ptr<Texture>> GetTexture(const std::string& sKey) const;
 		bool ContainTexture(const std::string& sKey) const;
 		int GetTextureUnit(std::string sKey) const;
@@ -0,0 +1,79 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace Cme
+{
+    ThreadPool::ThreadPool(unsigned int numThreads)
+    {
+        if (numThreads == 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            numThreads = std::max(1u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+        }
+        m_vecThreads.reserve(numThreads);
+        for (unsigned int i = 0; i < numThreads; ++i)
+        {
+            m_vecThreads.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_bStopping = true;
+        }
+        m_JobAvailable.notify_all();
+        for (auto& thread : m_vecThreads)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::Submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_queJobs.push_back(std::move(job));
+        }
+        m_JobAvailable.notify_one();
+    }
+
+    void ThreadPool::WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Idle.wait(lock, [this]() { return m_queJobs.empty() && m_uiRunning == 0; });
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_JobAvailable.wait(lock, [this]() { return m_bStopping || !m_queJobs.empty(); });
+                // Remaining jobs are still run on shutdown.
+                if (m_queJobs.empty())
+                {
+                    return;
+                }
+                job = std::move(m_queJobs.front());
+                m_queJobs.pop_front();
+                ++m_uiRunning;
+            }
+
+            job();
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                --m_uiRunning;
+                if (m_queJobs.empty() && m_uiRunning == 0)
+                {
+                    m_Idle.notify_all();
+                }
+            }
+        }
+    }
+}  // namespace Cme
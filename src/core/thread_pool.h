@@ -0,0 +1,44 @@
+#ifndef QUARKGL_THREAD_POOL_H_
+#define QUARKGL_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Cme
+{
+    // Fixed set of worker threads executing submitted jobs in FIFO order. Jobs
+    // must not touch the GL context, which stays on the render thread.
+    class ThreadPool
+    {
+    public:
+        // Zero picks one worker per hardware thread, minus the render thread.
+        explicit ThreadPool(unsigned int numThreads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void Submit(std::function<void()> job);
+        // Blocks until the queue is empty and no job is running.
+        void WaitIdle();
+
+        unsigned int GetThreadCount() const { return (unsigned int)m_vecThreads.size(); }
+
+    private:
+        void WorkerLoop();
+
+        std::vector<std::thread> m_vecThreads;
+        std::deque<std::function<void()>> m_queJobs;
+        std::mutex m_Mutex;
+        std::condition_variable m_JobAvailable;
+        std::condition_variable m_Idle;
+        unsigned int m_uiRunning = 0;
+        bool m_bStopping = false;
+    };
+}  // namespace Cme
+
+#endif
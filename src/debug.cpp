@@ -1,12 +1,18 @@
 #include "debug.h"
+#include "profiler.h"
 
 namespace Cme
 {
 	Cme::DebugGroup::DebugGroup(const char* name)
 	{
 		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+		Profiler::GetInstance().BeginScope(name);
 	}
 
-	DebugGroup::~DebugGroup() { glPopDebugGroup(); }
+	DebugGroup::~DebugGroup()
+	{
+		Profiler::GetInstance().EndScope();
+		glPopDebugGroup();
+	}
 
 }  // namespace Cme
\ No newline at end of file
@@ -6,7 +6,8 @@
 
 namespace Cme 
 {
-	// RAII debugging group marker.
+	// RAII debugging group marker. The group is also timed on the CPU and GPU
+	// by the Profiler, so `name` must be a string literal.
 	class DebugGroup 
 	{
 	public:
@@ -12,35 +12,41 @@ namespace Cme
     {
         // Need to use a zero clear color, or else the G-Buffer won't work properly.
         setClearColor(glm::vec4(0.0f));
-        // Create and attach all components of the G-Buffer.
-        // Don't need to read from depth, so we attach as a renderbuffer.
-        attachRenderbuffer(Cme::BufferType::DEPTH_AND_STENCIL);                     // Ⱦ󸽼
-        // Position and normal are stored as "HDR" colors for higher precision.
-        // TODO: Positions can be un-projected from depth without storing them.
+        // Create and attach all components of the G-Buffer. 18 bytes per pixel
+        // in total, down from 28 when positions and full normals were stored.
+        // Depth is sampled by the lighting pass to un-project view space
+        // positions, so it has to be a texture rather than a renderbuffer.
+        TextureParams depthParams;
+        depthParams.filtering = TextureFiltering::NEAREST;
+        depthParams.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+        AttachTexture2FB_i(Cme::BufferType::DEPTH_AND_STENCIL, depthParams);
 
-        // RGB used for position, alpha used for AO. 
-        AttachTexture2FB(Cme::BufferType::COLOR_HDR_ALPHA);     
-        // RGB used for normal, alpha used for roughness.
-        AttachTexture2FB(Cme::BufferType::COLOR_SNORM_ALPHA); 
+        // Octahedral encoded view space normal.
+        AttachTexture2FB(Cme::BufferType::COLOR_SNORM_RG);
         // RGB used for albedo, alpha used for metallic.
-        AttachTexture2FB(Cme::BufferType::COLOR_ALPHA); 
-        // RGB used for emission color, alpha channel unused.
-        AttachTexture2FB(Cme::BufferType::COLOR_ALPHA); 
+        AttachTexture2FB(Cme::BufferType::COLOR_ALPHA);
+        // R used for roughness, G used for AO.
+        AttachTexture2FB(Cme::BufferType::COLOR_RG);
+        // Emission color. Emission is HDR but never negative, so it fits in the
+        // packed float format.
+        AttachTexture2FB(Cme::BufferType::COLOR_HDR_PACKED);
     }
 
     unsigned int GBuffer::bindTexture(unsigned int nextTextureUnit, Shader& shader) 
     {
-        GetTexture(1)->BindToUnit(nextTextureUnit + 0);
-        GetTexture(2)->BindToUnit(nextTextureUnit + 1);
-        GetTexture(3)->BindToUnit(nextTextureUnit + 2);
-        GetTexture(4)->BindToUnit(nextTextureUnit + 3);
+        GetTexture(0)->BindToUnit(nextTextureUnit + 0);
+        GetTexture(1)->BindToUnit(nextTextureUnit + 1);
+        GetTexture(2)->BindToUnit(nextTextureUnit + 2);
+        GetTexture(3)->BindToUnit(nextTextureUnit + 3);
+        GetTexture(4)->BindToUnit(nextTextureUnit + 4);
         // Bind sampler uniforms.
-        shader.setInt("gPositionAO", nextTextureUnit + 0);
-        shader.setInt("gNormalRoughness", nextTextureUnit + 1);
+        shader.setInt("gDepth", nextTextureUnit + 0);
+        shader.setInt("gNormal", nextTextureUnit + 1);
         shader.setInt("gAlbedoMetallic", nextTextureUnit + 2);
-        shader.setInt("gEmission", nextTextureUnit + 3);
+        shader.setInt("gRoughnessAO", nextTextureUnit + 3);
+        shader.setInt("gEmission", nextTextureUnit + 4);
 
-        return nextTextureUnit + 4;
+        return nextTextureUnit + 5;
     }
 
 }  // namespace Cme
@@ -28,11 +28,15 @@ namespace Cme
         explicit GBuffer(ImageSize size) : GBuffer(size.width, size.height) {}
         virtual ~GBuffer() = default;
 
-        std::shared_ptr<Texture> getPositionAOTexture() { return GetTexture(1); }
-        std::shared_ptr<Texture> getNormalRoughnessTexture() { return GetTexture(2); }
-        std::shared_ptr<Texture> getAlbedoMetallicTexture() { return GetTexture(3); }
+        std::shared_ptr<Texture> getDepthTexture() { return GetTexture(0); }
+        std::shared_ptr<Texture> getNormalTexture() { return GetTexture(1); }
+        std::shared_ptr<Texture> getAlbedoMetallicTexture() { return GetTexture(2); }
+        std::shared_ptr<Texture> getRoughnessAOTexture() { return GetTexture(3); }
         std::shared_ptr<Texture> getEmissionTexture() { return GetTexture(4); }
 
+        // Binds all G-Buffer samplers. Shaders that reconstruct positions from
+        // gDepth also need the `inverseProjection` uniform, which they pass to
+        // qrk_viewPosFromDepth().
         unsigned int bindTexture(unsigned int nextTextureUnit, Shader& shader);
     };
 
@@ -0,0 +1,126 @@
+#include "dynamic_resolution.h"
+#include "core/render_target_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Cme
+{
+    namespace
+    {
+        constexpr int UPSCALE_LOCAL_SIZE = 8;
+        // Number of recent frames averaged, and waited for after a change.
+        constexpr int DYNAMIC_RESOLUTION_WINDOW = 8;
+        // Relative frame time error that is tolerated without a change.
+        constexpr float DYNAMIC_RESOLUTION_DEADBAND = 0.05f;
+        // Fraction of the correction applied per adjustment.
+        constexpr float DYNAMIC_RESOLUTION_DAMPING = 0.5f;
+        // Scales are rounded to this step, which keeps frame time noise from
+        // nudging the render size on every adjustment.
+        constexpr float DYNAMIC_RESOLUTION_STEP = 1.0f / 32.0f;
+
+        void dispatch(Shader& shader, ImageSize size)
+        {
+            shader.activate();
+            glDispatchCompute((size.width + UPSCALE_LOCAL_SIZE - 1) / UPSCALE_LOCAL_SIZE,
+                              (size.height + UPSCALE_LOCAL_SIZE - 1) / UPSCALE_LOCAL_SIZE, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                            GL_FRAMEBUFFER_BARRIER_BIT);
+            shader.deactivate();
+        }
+    }
+
+    DynamicResolution::DynamicResolution(ImageSize maxSize)
+        : m_MaxSize(maxSize), m_RenderSize(maxSize)
+    {
+    }
+
+    void DynamicResolution::setScale(float scale)
+    {
+        m_fScale = glm::clamp(scale, m_fMinScale, m_fMaxScale);
+        m_RenderSize.width = std::max(static_cast<int>(std::round(m_MaxSize.width * m_fScale)), 1);
+        m_RenderSize.height = std::max(static_cast<int>(std::round(m_MaxSize.height * m_fScale)), 1);
+    }
+
+    bool DynamicResolution::Update(const Window& window)
+    {
+        if (m_iCooldown > 0)
+        {
+            --m_iCooldown;
+            return false;
+        }
+
+        // The newest delta is at the offset, since the frame count is only
+        // advanced at the end of the frame.
+        const float* deltas = window.getFrameDeltas();
+        int numDeltas = window.getNumFrameDeltas();
+        int newest = window.getFrameDeltasOffset();
+        int count = std::min<int>(DYNAMIC_RESOLUTION_WINDOW, window.getFrameCount());
+        if (count == 0)
+        {
+            return false;
+        }
+        float frameTime = 0.0f;
+        for (int i = 0; i < count; ++i)
+        {
+            frameTime += deltas[(newest - i + numDeltas) % numDeltas];
+        }
+        frameTime /= count;
+
+        float error = frameTime / m_fTargetFrameTime - 1.0f;
+        if (std::abs(error) < DYNAMIC_RESOLUTION_DEADBAND || frameTime <= 0.0f)
+        {
+            return false;
+        }
+
+        // GPU cost is roughly proportional to the pixel count, the square of
+        // the scale.
+        float idealScale = m_fScale * std::sqrt(m_fTargetFrameTime / frameTime);
+        float scale = m_fScale + (idealScale - m_fScale) * DYNAMIC_RESOLUTION_DAMPING;
+        scale = std::round(scale / DYNAMIC_RESOLUTION_STEP) * DYNAMIC_RESOLUTION_STEP;
+
+        ImageSize prevSize = m_RenderSize;
+        setScale(scale);
+        if (m_RenderSize == prevSize)
+        {
+            return false;
+        }
+        m_iCooldown = DYNAMIC_RESOLUTION_WINDOW;
+        return true;
+    }
+
+    UpscalePass::UpscalePass(ImageSize size)
+        : m_Size(size),
+        m_UpscaleShaderObj(ShaderPath("assets//shaders//builtin//upscale.comp")),
+        m_SharpenShaderObj(ShaderPath("assets//shaders//builtin//sharpen.comp"))
+    {
+        TextureParams params;
+        params.filtering = TextureFiltering::NEAREST;
+        params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+        params.generateMips = MipGeneration::NEVER;
+        m_spUpscaled = std::make_shared<Texture>(
+            RenderTargetPool::GetInstance().Acquire(size.width, size.height, GL_RGBA16F, params, BufferType::COLOR_HDR_ALPHA));
+    }
+
+    UpscalePass::~UpscalePass()
+    {
+        RenderTargetPool::GetInstance().Release(*m_spUpscaled);
+    }
+
+    void UpscalePass::Render(Texture& color, ImageSize renderSize, unsigned int textureUnit)
+    {
+        color.BindToUnit(textureUnit);
+        m_UpscaleShaderObj.setInt("qrk_upscaleSource", textureUnit);
+        m_UpscaleShaderObj.setVec2("qrk_upscaleSourceSize", glm::vec2(renderSize.width, renderSize.height));
+        glBindImageTexture(0, m_spUpscaled->getId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        dispatch(m_UpscaleShaderObj, m_Size);
+
+        // Sharpening writes the final image back into the source.
+        m_spUpscaled->BindToUnit(textureUnit);
+        m_SharpenShaderObj.setInt("qrk_sharpenSource", textureUnit);
+        m_SharpenShaderObj.setFloat("qrk_sharpness", m_fSharpness);
+        glBindImageTexture(0, color.getId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        dispatch(m_SharpenShaderObj, m_Size);
+    }
+
+}  // namespace Cme
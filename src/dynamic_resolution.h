@@ -0,0 +1,96 @@
+#ifndef QUARKGL_DYNAMIC_RESOLUTION_H_
+#define QUARKGL_DYNAMIC_RESOLUTION_H_
+
+#include "screen.h"
+#include "shader/shader.h"
+#include "core/texture.h"
+#include "window.h"
+
+#include <memory>
+
+namespace Cme
+{
+    // Picks the resolution the scene is rendered at to hold a target frame
+    // time. The render size is a fraction of a fixed maximum size, so targets
+    // are allocated once at the maximum and only their viewport shrinks, see
+    // Framebuffer::setViewportSize().
+    //
+    // The frame time is taken from the window's frame delta history, which
+    // includes waiting for vsync: with vsync on, the scale can only recover up
+    // to where frames fit in one refresh interval.
+    class DynamicResolution
+    {
+    public:
+        explicit DynamicResolution(ImageSize maxSize);
+
+        // Adjusts the scale from the recent frame times of `window`. Returns
+        // whether the render size changed.
+        bool Update(const Window& window);
+
+        float getTargetFrameTime() const { return m_fTargetFrameTime; }
+        void setTargetFrameTime(float seconds) { m_fTargetFrameTime = seconds; }
+        float getMinScale() const { return m_fMinScale; }
+        void setMinScale(float scale) { m_fMinScale = scale; }
+        float getMaxScale() const { return m_fMaxScale; }
+        void setMaxScale(float scale) { m_fMaxScale = scale; }
+
+        // Fraction of the maximum size along each axis.
+        float getScale() const { return m_fScale; }
+        // Sets the scale directly, e.g. to pin it while the controller is off.
+        void setScale(float scale);
+        ImageSize getRenderSize() const { return m_RenderSize; }
+        ImageSize getMaxSize() const { return m_MaxSize; }
+
+    private:
+        ImageSize m_MaxSize;
+        ImageSize m_RenderSize;
+        float m_fScale = 1.0f;
+        float m_fTargetFrameTime = 1.0f / 60.0f;
+        float m_fMinScale = 0.5f;
+        float m_fMaxScale = 1.0f;
+        // Frames left before the next adjustment, so that the frame times
+        // measured at the previous scale have left the averaging window.
+        int m_iCooldown = 0;
+    };
+
+    // Reconstructs the full resolution image from the render size part of a
+    // target, in two compute passes:
+    //  1. An edge adaptive upscale. Each output pixel filters the 12 nearest
+    //     source texels with a Lanczos-like kernel that is stretched along the
+    //     local edge direction and narrowed across it, then clamped to the
+    //     nearest texels to avoid ringing.
+    //  2. Contrast adaptive sharpening, limited per pixel so that it never
+    //     pushes a color outside its neighborhood.
+    class UpscalePass
+    {
+    public:
+        explicit UpscalePass(ImageSize size);
+        ~UpscalePass();
+
+        UpscalePass(const UpscalePass&) = delete;
+        UpscalePass& operator=(const UpscalePass&) = delete;
+
+        // Upscales the bottom left `renderSize` pixels of `color` to its full
+        // size, in place. `color` must be RGBA16F. Samples from `textureUnit`.
+        void Render(Texture& color, ImageSize renderSize, unsigned int textureUnit);
+
+        // Sharpening amount in [0, 1], 0 to disable.
+        float getSharpness() const { return m_fSharpness; }
+        void setSharpness(float sharpness) { m_fSharpness = sharpness; }
+
+        std::shared_ptr<Texture> getTexture() const { return m_spUpscaled; }
+
+    private:
+        ImageSize m_Size;
+        float m_fSharpness = 0.5f;
+
+        Shader m_UpscaleShaderObj;
+        Shader m_SharpenShaderObj;
+
+        // Upscaled, unsharpened image.
+        std::shared_ptr<Texture> m_spUpscaled;
+    };
+
+}  // namespace Cme
+
+#endif
@@ -1,20 +1,27 @@
 #include "text.h"
 #include <glm/gtc/matrix_transform.hpp>
+#include <cstring>
 #include <iostream>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 #include "../common_helper.h"
+#include "../profiler.h"
+#include "../core/frame_clock.h"
 
 //const std::size_t Text::FONT_HEIGHT = 40;
 
 namespace Cme
 {
+    // Glyphs the stream buffer holds at first, it grows for longer strings.
+    const std::size_t INITIAL_GLYPH_CAPACITY = 256;
+    // Floats of a glyph quad, two triangles of position and uv.
+    const std::size_t GLYPH_FLOATS = 24;
+
     Text::Text()
     {
         m_VAO = 0;
-        m_VBO = 0;
         current_font = 0;
         m_iFontHeight = 40;
 
@@ -25,14 +32,15 @@ namespace Cme
 
         m_pDrawShader->output("color");
 
-        glGenVertexArrays(1, &m_VAO);
-        glGenBuffers(1, &m_VBO);
+        // Every glyph quad of a string is written into one streamed region.
+        ReserveGlyphs(INITIAL_GLYPH_CAPACITY);
 
+        glGenVertexArrays(1, &m_VAO);
         glBindVertexArray(m_VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-        glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glVertexAttribFormat(0, 4, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(0, 0);
         glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
     }
 
     std::size_t Text::addFont(const std::string& filePath, std::size_t data_size)
@@ -104,7 +112,21 @@ namespace Cme
         }
             
         glDeleteVertexArrays(1, &m_VAO);
-        glDeleteBuffers(1, &m_VBO);
+    }
+
+    void Text::ReserveGlyphs(std::size_t count)
+    {
+        if (count <= m_uiGlyphCapacity)
+        {
+            return;
+        }
+        std::size_t capacity = m_uiGlyphCapacity ? m_uiGlyphCapacity : INITIAL_GLYPH_CAPACITY;
+        while (capacity < count)
+        {
+            capacity *= 2;
+        }
+        m_upStreamBuffer = std::make_unique<StreamBuffer>(capacity * GLYPH_FLOATS * sizeof(float));
+        m_uiGlyphCapacity = capacity;
     }
 
     void Text::Render(std::string const& text, Anchor anchor, std::shared_ptr<Cme::Camera> spCamera)
@@ -147,11 +169,13 @@ namespace Cme
 
         float xoff, yoff = h - iY;
         auto width = 0.0f, height = 0.0f;
+        std::size_t numGlyphs = 0;
         for (const auto& c : text)
         {
             auto i = c - 32;
             if (i < 0 || i > 94)
                 continue;
+            ++numGlyphs;
             width += chars[i].advance * m_iScale;
             if (chars[i].size_y > height)
             {
@@ -197,11 +221,15 @@ namespace Cme
         // ת
         model = glm::rotate(model, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         // Zת
-        model = glm::rotate(model, (float)glfwGetTime() * glm::radians(30.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::rotate(model, (float)FrameClock::GetInstance().GetTime() * glm::radians(30.0f), glm::vec3(0.0f, 0.0f, 1.0f));
         m_pDrawShader->setMat4("model", model);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(m_VAO);
+        // Fill the quads of the whole string first, then issue the draws from
+        // the same region.
+        ReserveGlyphs(numGlyphs);
+        float* pVertices = static_cast<float*>(m_upStreamBuffer->BeginRegion());
+        std::vector<int>& glyphs = m_vecGlyphs;
+        glyphs.clear();
         for (const auto& c : text)
         {
             auto i = c - 32;
@@ -222,17 +250,23 @@ namespace Cme
                     xpos + w, ypos,   1.0f, 1.0f,
                     xpos + w, ypos + h, 1.0f, 0.0f
             };
-
-            glBindTexture(GL_TEXTURE_2D, textures[current_font][i]);
-            glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            std::memcpy(pVertices + glyphs.size() * GLYPH_FLOATS, vertices, sizeof(vertices));
+            glyphs.push_back(i);
 
             iX += chars[i].advance * m_iScale;
         }
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(m_VAO);
+        glBindVertexBuffer(0, m_upStreamBuffer->GetBufferID(), m_upStreamBuffer->GetRegionOffset(), 4 * sizeof(float));
+        for (std::size_t g = 0; g < glyphs.size(); ++g)
+        {
+            glBindTexture(GL_TEXTURE_2D, textures[current_font][glyphs[g]]);
+            glDrawArrays(GL_TRIANGLES, static_cast<GLint>(g * 6), 6);
+            Profiler::GetInstance().CountDrawCall();
+        }
+        m_upStreamBuffer->EndRegion();
+
         glBindVertexArray(0);
         m_pDrawShader->deactivate();
 
@@ -4,9 +4,11 @@
 #include <GLFW/glfw3.h>
 #include "../shader/shader.h"
 #include "../camera.h"
+#include "../core/stream_buffer.h"
 
 #include <vector>
 #include <array>
+#include <memory>
 
 namespace Cme
 {
@@ -61,12 +63,18 @@ namespace Cme
         std::vector<std::array<unsigned, 200>> textures;
         std::vector<Character> chars;
         GLuint m_VAO;
-        GLuint m_VBO;
+        std::unique_ptr<StreamBuffer> m_upStreamBuffer;
+        // Glyph indices of the quads written this frame, reused across calls.
+        std::vector<int> m_vecGlyphs;
         Shader* m_pDrawShader = nullptr;
 
         std::size_t current_font;
 
     private:
+        // Grows the stream buffer to hold the quads of `count` glyphs.
+        void ReserveGlyphs(std::size_t count);
+
+        std::size_t m_uiGlyphCapacity = 0;
         int m_iFontHeight;
         int m_iFontX = 0;
         int m_iFontY = 0;
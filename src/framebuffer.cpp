@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 #include "framebuffer.h"
 #include "common_helper.h"
+#include "core/render_target_pool.h"
 
 namespace Cme 
 {
@@ -23,11 +24,12 @@ namespace Cme
         spTexture->m_iWidth = m_iWidth;
         spTexture->m_iHeight = m_iHeight;
         spTexture->m_iNumMips = m_iNumMips;
+        spTexture->m_iNumLayers = m_iNumLayers;
         return spTexture;
     }
 
     Framebuffer::Framebuffer(int width, int height, int samples)
-        : m_iWidth(width), m_iHeight(height), m_iSamples(samples)
+        : m_iWidth(width), m_iHeight(height), m_iSamples(samples), m_ViewportSize{ width, height }
     {
         glGenFramebuffers(1, &fbo_);
     }
@@ -37,6 +39,7 @@ namespace Cme
         m_iWidth = size.width;
         m_iHeight = size.height;
         m_iSamples = samples;
+        m_ViewportSize = size;
 
         glGenFramebuffers(1, &fbo_);
 
@@ -53,8 +56,9 @@ namespace Cme
         }
 
         GLenum internalFormat = bufferTypeToGlInternalFormat(type);
-        auto spTexture = std::make_shared<Texture>();
-        spTexture->Create(m_iWidth, m_iHeight, internalFormat, params, type);
+        auto spTexture = std::make_shared<Texture>(
+            RenderTargetPool::GetInstance().Acquire(m_iWidth, m_iHeight, internalFormat, params, type, 1, m_iSamples));
+        m_vecTextures.push_back(*spTexture);
         spTexture->SetTextureType(textureType);
 
         // Attach the texture to the framebuffer.
@@ -81,7 +85,20 @@ namespace Cme
     Framebuffer::~Framebuffer() 
     {
         glDeleteFramebuffers(1, &fbo_);
-        // TODO: Delete attachments.
+
+        // Owned textures go back to the pool. Shared ones belong to another
+        // framebuffer and aren't in m_vecTextures.
+        for (const Texture& texture : m_vecTextures)
+        {
+            RenderTargetPool::GetInstance().Release(texture);
+        }
+        for (const Attachment& attachment : m_vecAttachments)
+        {
+            if (attachment.m_eTarget == AttachmentTarget::RENDERBUFFER)
+            {
+                glDeleteRenderbuffers(1, &attachment.m_uiID);
+            }
+        }
     }
 
     void Framebuffer::activate(int mipLevel, int cubemapFace) 
@@ -98,6 +115,12 @@ namespace Cme
             {
                 case AttachmentTarget::TEXTURE:
                 {
+                    if (attachment.m_eTextureType == TextureType::TEXTURE_2D_ARRAY)
+                    {
+                        // Layered attachment, all layers stay bound.
+                        glFramebufferTexture(GL_FRAMEBUFFER, attachmentType, attachment.m_uiID, mipLevel);
+                        break;
+                    }
                     GLenum target = GL_TEXTURE_2D;
                     if (cubemapFace >= 0) 
                     {
@@ -128,7 +151,7 @@ namespace Cme
             }
         }
 
-        ImageSize mipSize = CommonHelper::calculateMipLevel(m_iWidth, m_iHeight, mipLevel);
+        ImageSize mipSize = CommonHelper::calculateMipLevel(m_ViewportSize.width, m_ViewportSize.height, mipLevel);
         glViewport(0, 0, mipSize.width, mipSize.height);
     }
 
@@ -177,8 +200,9 @@ namespace Cme
         }
 
         GLenum internalFormat = bufferTypeToGlInternalFormat(type);
-        auto spTexture = std::make_shared<Texture>();
-        spTexture->Create(m_iWidth, m_iHeight, internalFormat, params, type);
+        auto spTexture = std::make_shared<Texture>(
+            RenderTargetPool::GetInstance().Acquire(m_iWidth, m_iHeight, internalFormat, params, type, 1, m_iSamples));
+        m_vecTextures.push_back(*spTexture);
 
         // Attach the texture to the framebuffer.
         int colorAttachmentIndex = m_iNumColorAttachments;
@@ -201,6 +225,39 @@ namespace Cme
         return saveAttachment(spTexture->getId(), spTexture->getNumMips(), AttachmentTarget::TEXTURE, type, colorAttachmentIndex, textureType);
     }
 
+    Attachment Framebuffer::AttachTextureArray2FB(BufferType type, int layers, const TextureParams& params)
+    {
+        if (m_iSamples)
+        {
+            throw FramebufferException("ERROR::FRAMEBUFFER::MULTISAMPLED_TEXTURE_ARRAY");
+        }
+        checkFlags(type);
+        activate();
+
+        GLenum internalFormat = bufferTypeToGlInternalFormat(type);
+        auto spTexture = std::make_shared<Texture>(
+            RenderTargetPool::GetInstance().Acquire(m_iWidth, m_iHeight, internalFormat, params, type, layers));
+        m_vecTextures.push_back(*spTexture);
+
+        int colorAttachmentIndex = m_iNumColorAttachments;
+        GLenum attachmentType = bufferTypeToGlAttachmentType(type, colorAttachmentIndex);
+        glFramebufferTexture(GL_FRAMEBUFFER, attachmentType, spTexture->getId(), 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            throw FramebufferException("ERROR::FRAMEBUFFER::TEXTURE::INCOMPLETE");
+        }
+
+        updateFlags(type);
+        updateBufferSources();
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        deactivate();
+
+        return saveAttachment(spTexture->getId(), spTexture->getNumMips(), AttachmentTarget::TEXTURE, type,
+                              colorAttachmentIndex, TextureType::TEXTURE_2D_ARRAY, layers);
+    }
+
     Attachment Framebuffer::attachRenderbuffer(BufferType type)
     {
         checkFlags(type);
@@ -245,6 +302,33 @@ namespace Cme
         return saveAttachment(rbo, 1, AttachmentTarget::RENDERBUFFER, type, colorAttachmentIndex, TextureType::TEXTURE_2D);
     }
 
+    Attachment Framebuffer::attachSharedTexture(const Attachment& attachment)
+    {
+        if (attachment.m_eTarget != AttachmentTarget::TEXTURE || attachment.m_iWidth != m_iWidth ||
+            attachment.m_iHeight != m_iHeight)
+        {
+            throw FramebufferException("ERROR::FRAMEBUFFER::SHARED_TEXTURE_MISMATCH");
+        }
+        checkFlags(attachment.m_eType);
+        activate();
+
+        int colorAttachmentIndex = m_iNumColorAttachments;
+        GLenum attachmentType = bufferTypeToGlAttachmentType(attachment.m_eType, colorAttachmentIndex);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachmentType, GL_TEXTURE_2D, attachment.m_uiID, 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            throw FramebufferException("ERROR::FRAMEBUFFER::SHARED_TEXTURE::INCOMPLETE");
+        }
+
+        updateFlags(attachment.m_eType);
+        updateBufferSources();
+        deactivate();
+
+        return saveAttachment(attachment.m_uiID, attachment.m_iNumMips, AttachmentTarget::TEXTURE, attachment.m_eType,
+                              colorAttachmentIndex, attachment.m_eTextureType);
+    }
+
     Attachment Framebuffer::getTexture(BufferType type)
     {
         return getAttachment(AttachmentTarget::TEXTURE, type);
@@ -283,7 +367,8 @@ namespace Cme
                                            AttachmentTarget target, 
                                            BufferType type,
                                            int colorAttachmentIndex,
-                                           TextureType textureType)
+                                           TextureType textureType,
+                                           int numLayers)
     {
         Attachment attachment;
         attachment.m_uiID = id;
@@ -294,6 +379,7 @@ namespace Cme
         attachment.m_eType = type;
         attachment.m_iColorAttachmentIndex = colorAttachmentIndex;
         attachment.m_eTextureType = textureType;
+        attachment.m_iNumLayers = numLayers;
 
         m_vecAttachments.push_back(attachment);
         return attachment;
@@ -323,6 +409,9 @@ namespace Cme
             case BufferType::COLOR_ALPHA:
             case BufferType::COLOR_HDR_ALPHA:
             case BufferType::COLOR_SNORM_ALPHA:
+            case BufferType::COLOR_RG:
+            case BufferType::COLOR_SNORM_RG:
+            case BufferType::COLOR_HDR_PACKED:
             case BufferType::COLOR_CUBEMAP_HDR_ALPHA:
             case BufferType::GRAYSCALE:
                 // Multiple color attachments OK.
@@ -365,6 +454,9 @@ namespace Cme
             case BufferType::COLOR_ALPHA:
             case BufferType::COLOR_HDR_ALPHA:
             case BufferType::COLOR_SNORM_ALPHA:
+            case BufferType::COLOR_RG:
+            case BufferType::COLOR_SNORM_RG:
+            case BufferType::COLOR_HDR_PACKED:
             case BufferType::COLOR_CUBEMAP_HDR_ALPHA:
             case BufferType::GRAYSCALE:
                 m_hasColorAttachment = true;
@@ -432,6 +524,12 @@ namespace Cme
         glClear(clearBits);
     }
 
+    void Framebuffer::clear(GLbitfield bits)
+    {
+        glClearColor(m_vec4ClearColor.r, m_vec4ClearColor.g, m_vec4ClearColor.b, m_vec4ClearColor.a);
+        glClear(bits);
+    }
+
     std::shared_ptr<Texture> Framebuffer::GetTexture(int iIndex)
     {
         if (!m_vecAttachments.empty())
@@ -31,6 +31,8 @@ namespace Cme
         int m_iWidth;
         int m_iHeight;
         int m_iNumMips;
+        // Number of layers. Only above 1 for array textures.
+        int m_iNumLayers = 1;
         AttachmentTarget m_eTarget;
         BufferType m_eType;
         // Attachment index. Only applies for color buffers.
@@ -52,6 +54,9 @@ namespace Cme
         case BufferType::COLOR_ALPHA:
         case BufferType::COLOR_HDR_ALPHA:
         case BufferType::COLOR_SNORM_ALPHA:
+        case BufferType::COLOR_RG:
+        case BufferType::COLOR_SNORM_RG:
+        case BufferType::COLOR_HDR_PACKED:
         case BufferType::COLOR_CUBEMAP_HDR:
         case BufferType::COLOR_CUBEMAP_HDR_ALPHA:
         case BufferType::GRAYSCALE:
@@ -85,6 +90,12 @@ namespace Cme
             return GL_RGBA16F;
         case BufferType::COLOR_SNORM_ALPHA:
             return GL_RGBA16_SNORM;
+        case BufferType::COLOR_RG:
+            return GL_RG8;
+        case BufferType::COLOR_SNORM_RG:
+            return GL_RG16_SNORM;
+        case BufferType::COLOR_HDR_PACKED:
+            return GL_R11F_G11F_B10F;
         case BufferType::GRAYSCALE:
             return GL_R8;
         case BufferType::DEPTH:
@@ -105,6 +116,7 @@ namespace Cme
         case BufferType::COLOR:
         case BufferType::COLOR_HDR:
         case BufferType::COLOR_SNORM:
+        case BufferType::COLOR_HDR_PACKED:
         case BufferType::COLOR_CUBEMAP_HDR:
             return GL_RGB;
         case BufferType::COLOR_ALPHA:
@@ -112,6 +124,9 @@ namespace Cme
         case BufferType::COLOR_SNORM_ALPHA:
         case BufferType::COLOR_CUBEMAP_HDR_ALPHA:
             return GL_RGBA;
+        case BufferType::COLOR_RG:
+        case BufferType::COLOR_SNORM_RG:
+            return GL_RG;
         case BufferType::GRAYSCALE:
             return GL_RED;
         case BufferType::DEPTH:
@@ -131,11 +146,14 @@ namespace Cme
         {
         case BufferType::COLOR:
         case BufferType::COLOR_ALPHA:
+        case BufferType::COLOR_RG:
             return GL_UNSIGNED_BYTE;
         case BufferType::COLOR_HDR:
         case BufferType::COLOR_HDR_ALPHA:
         case BufferType::COLOR_SNORM:
         case BufferType::COLOR_SNORM_ALPHA:
+        case BufferType::COLOR_SNORM_RG:
+        case BufferType::COLOR_HDR_PACKED:
         case BufferType::COLOR_CUBEMAP_HDR:
         case BufferType::COLOR_CUBEMAP_HDR_ALPHA:
             return GL_FLOAT;
@@ -173,12 +191,24 @@ namespace Cme
         glm::vec4 getClearColor() { return m_vec4ClearColor; }
         void setClearColor(glm::vec4 color) { m_vec4ClearColor = color; }
         void clear();
+        // Clears only the given buffers, e.g. to keep a shared depth buffer.
+        void clear(GLbitfield bits);
 
         ImageSize getSize();
+        // Restricts drawing to the bottom left `size` pixels, e.g. to render at
+        // a lower resolution without reallocating. Mips are scaled to match.
+        void setViewportSize(ImageSize size) { m_ViewportSize = size; }
+        ImageSize getViewportSize() const { return m_ViewportSize; }
 
         Attachment AttachTexture2FB(BufferType type);
         Attachment AttachTexture2FB_i(BufferType type, const TextureParams& params);
+        // Attaches all layers of a 2D array texture. Draws select the layer with
+        // gl_Layer, e.g. from a geometry shader.
+        Attachment AttachTextureArray2FB(BufferType type, int layers, const TextureParams& params);
         Attachment attachRenderbuffer(BufferType type);
+        // Attaches a texture owned by another framebuffer of the same size, so
+        // both render to it without copies. The owner frees it.
+        Attachment attachSharedTexture(const Attachment& attachment);
 
         // Returns the first texture attachment of the given type.
         Attachment getTexture(BufferType type);
@@ -214,8 +244,9 @@ namespace Cme
         int m_iWidth;
         int m_iHeight;
         int m_iSamples;
+        ImageSize m_ViewportSize;
         std::vector<Attachment> m_vecAttachments;         //  ñ֡ Ӧֵ
-        std::vector<Texture> m_vecTextures;               // 
+        std::vector<Texture> m_vecTextures;               // Լ ʱ黹RenderTargetPool
 
         bool m_hasColorAttachment = false;
         int m_iNumColorAttachments = 0;
@@ -225,7 +256,7 @@ namespace Cme
 
         Attachment saveAttachment(unsigned int id, int numMips,
                                 AttachmentTarget target, BufferType type,
-                                int colorAttachmentIndex, TextureType textureType);
+                                int colorAttachmentIndex, TextureType textureType, int numLayers = 1);
         Attachment getAttachment(AttachmentTarget target, BufferType type);
         void checkFlags(BufferType type);
         void updateFlags(BufferType type);
@@ -1,36 +1,38 @@
 #include "light.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace Cme
 {
-    DirectionalLight::DirectionalLight(glm::vec3 direction, glm::vec3 diffuse,
-                                       glm::vec3 specular)
-        : direction_(glm::normalize(direction)),
-          diffuse_(diffuse),
-          specular_(specular) {}
-
-    void DirectionalLight::updateUniforms(Shader& shader) 
+    float calculateLightRange(const Attenuation& attenuation, const glm::vec3& color)
     {
-        checkState();
-
-        if (m_hasViewBeenApplied) 
+        // Solve quadratic * d^2 + linear * d + constant = intensity / cutoff.
+        float intensity = std::max(color.r, std::max(color.g, color.b));
+        float c = attenuation.constant - intensity / LIGHT_CUTOFF_INTENSITY;
+        if (c >= 0.0f)
         {
-            shader.setVec3(m_sUniformName + ".direction", m_bUseViewTransform ? viewDirection_ : direction_);
+            return 0.0f;
         }
-        if (m_hasLightChanged) 
+        if (attenuation.quadratic > 0.0f)
         {
-            shader.setVec3(m_sUniformName + ".diffuse", diffuse_);
-            shader.setVec3(m_sUniformName + ".specular", specular_);
+            float discriminant = attenuation.linear * attenuation.linear - 4.0f * attenuation.quadratic * c;
+            return (-attenuation.linear + std::sqrt(discriminant)) / (2.0f * attenuation.quadratic);
         }
-
-        // TODO: Fix change detection to work with >1 shaders.
-        // resetChangeDetection();
+        if (attenuation.linear > 0.0f)
+        {
+            return -c / attenuation.linear;
+        }
+        // No falloff, the light reaches everything.
+        return std::numeric_limits<float>::infinity();
     }
 
-    void DirectionalLight::applyViewTransform(const glm::mat4& view) 
-    {
-        viewDirection_ = glm::vec3(view * glm::vec4(direction_, 0.0f));
-        m_hasViewBeenApplied = true;
-    }
+    DirectionalLight::DirectionalLight(glm::vec3 direction, glm::vec3 diffuse,
+                                       glm::vec3 specular)
+        : direction_(glm::normalize(direction)),
+          diffuse_(diffuse),
+          specular_(specular) {}
 
     PointLight::PointLight(glm::vec3 position, glm::vec3 diffuse,
                            glm::vec3 specular, Attenuation attenuation)
@@ -39,34 +41,6 @@ namespace Cme
         m_vec3Specular(specular),
         m_stAttenuation(attenuation) {}
 
-    void PointLight::updateUniforms(Shader& shader)
-    {
-        checkState();
-
-        if (m_hasViewBeenApplied)
-        {
-            shader.setVec3(m_sUniformName + ".position", m_bUseViewTransform ? m_vec3ViewPosition : m_vec3Position);
-        }
-        if (m_hasLightChanged)
-        {
-            shader.setVec3(m_sUniformName + ".diffuse", m_vec3Diffuse);
-            shader.setVec3(m_sUniformName + ".specular", m_vec3Specular);
-            shader.setFloat(m_sUniformName + ".attenuation.constant",
-                m_stAttenuation.constant);
-            shader.setFloat(m_sUniformName + ".attenuation.linear", m_stAttenuation.linear);
-            shader.setFloat(m_sUniformName + ".attenuation.quadratic",
-                m_stAttenuation.quadratic);
-        }
-
-        // resetChangeDetection();
-    }
-
-    void PointLight::applyViewTransform(const glm::mat4& view)
-    {
-        m_vec3ViewPosition = glm::vec3(view * glm::vec4(m_vec3Position, 1.0f));
-        m_hasViewBeenApplied = true;
-    }
-
     SpotLight::SpotLight(glm::vec3 position, glm::vec3 direction, float innerAngle,
                          float outerAngle, glm::vec3 diffuse, glm::vec3 specular,
                          Attenuation attenuation)
@@ -78,36 +52,4 @@ namespace Cme
         m_vec3Specular(specular),
         m_stAttenuation(attenuation) {}
 
-    void SpotLight::updateUniforms(Shader& shader)
-    {
-        checkState();
-
-        if (m_hasViewBeenApplied)
-        {
-            shader.setVec3(m_sUniformName + ".position", m_bUseViewTransform ? m_vec3ViewPosition : m_vec3Position);
-            shader.setVec3(m_sUniformName + ".direction", m_bUseViewTransform ? m_vec3ViewDirection : m_vec3Direction);
-        }
-        if (m_hasLightChanged)
-        {
-            shader.setFloat(m_sUniformName + ".innerAngle", m_fInnerAngle);
-            shader.setFloat(m_sUniformName + ".outerAngle", m_fOuterAngle);
-            shader.setVec3(m_sUniformName + ".diffuse", m_vec3Diffuse);
-            shader.setVec3(m_sUniformName + ".specular", m_vec3Specular);
-            shader.setFloat(m_sUniformName + ".attenuation.constant",
-                m_stAttenuation.constant);
-            shader.setFloat(m_sUniformName + ".attenuation.linear", m_stAttenuation.linear);
-            shader.setFloat(m_sUniformName + ".attenuation.quadratic",
-                m_stAttenuation.quadratic);
-        }
-
-        // resetChangeDetection();
-    }
-
-    void SpotLight::applyViewTransform(const glm::mat4& view) 
-    {
-        m_vec3ViewPosition = glm::vec3(view * glm::vec4(m_vec3Position, 1.0f));
-        m_vec3ViewDirection = glm::vec3(view * glm::vec4(m_vec3Direction, 0.0f));
-        m_hasViewBeenApplied = true;
-    }
-
 }  // namespace Cme
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "../exceptions.h"
-#include "../shader/shader.h"
 
 #include <glm/glm.hpp>
 #include <string>
@@ -30,6 +29,14 @@ namespace Cme
     constexpr float DEFAULT_INNER_ANGLE = glm::radians(10.5f);
     constexpr float DEFAULT_OUTER_ANGLE = glm::radians(19.5f);
 
+    // Attenuated intensity below which a light no longer contributes. Used to
+    // bound point and spot lights for clustered shading.
+    constexpr float LIGHT_CUTOFF_INTENSITY = 1.0f / 256.0f;
+
+    // Returns the distance at which a light of the given color falls below
+    // LIGHT_CUTOFF_INTENSITY.
+    float calculateLightRange(const Attenuation& attenuation, const glm::vec3& color);
+
     enum class LightType
     {
         DIRECTIONAL_LIGHT,
@@ -37,6 +44,17 @@ namespace Cme
         SPOT_LIGHT,
     };
 
+    inline bool operator==(const Attenuation& lhs, const Attenuation& rhs)
+    {
+        return lhs.constant == rhs.constant && lhs.linear == rhs.linear && lhs.quadratic == rhs.quadratic;
+    }
+    inline bool operator!=(const Attenuation& lhs, const Attenuation& rhs)
+    {
+        return !operator==(lhs, rhs);
+    }
+
+    // Lights only hold their state. LightControl packs them into GPU buffers,
+    // re-uploading a light only when one of the change flags below is set.
     class Light 
     {
     public:
@@ -45,47 +63,49 @@ namespace Cme
 
         void setUseViewTransform(bool useViewTransform)
         {
-            m_bUseViewTransform = useViewTransform;
+            if (m_bUseViewTransform != useViewTransform)
+            {
+                m_bUseViewTransform = useViewTransform;
+                m_hasViewDependentChanged = true;
+            }
         }
 
+        // Sets the slot of the light in the buffer of its light type.
         void setLightIdx(unsigned int lightIdx) 
         {
-            m_uiLightIdx = lightIdx;
-            m_sUniformName = getUniformName(lightIdx);
-        }
-
-        void checkState()
-        {
-            if (m_hasViewDependentChanged && !m_hasViewBeenApplied)
+            if (m_uiLightIdx != lightIdx)
             {
-                throw LightException(
-                    "ERROR::LIGHT::VIEW_CHANGED\n"
-                    "Light state changed without re-applying view transform.");
+                m_uiLightIdx = lightIdx;
+                // Moved to a new slot, which has to be filled in.
+                m_hasViewDependentChanged = true;
+                m_hasLightChanged = true;
             }
         }
 
+        // Point and spot lights with shadows get tiles in the ShadowAtlas. The
+        // directional light uses the CascadedShadowMap instead.
+        bool getCastShadows() const { return m_bCastShadows; }
+        void setCastShadows(bool castShadows) { m_bCastShadows = castShadows; }
+
+        bool hasChanged() const { return m_hasViewDependentChanged || m_hasLightChanged; }
+
         void resetChangeDetection()
         {
             m_hasViewDependentChanged = false;
             m_hasLightChanged = false;
-            m_hasViewBeenApplied = false;
         }
 
-        virtual std::string getUniformName(unsigned int lightIdx) const = 0;
-        virtual void updateUniforms(Shader& shader) = 0;
-        virtual void applyViewTransform(const glm::mat4& view) = 0;
-
-        unsigned int m_uiLightIdx;
-        std::string m_sUniformName;
+        unsigned int m_uiLightIdx = 0;
+        bool m_bCastShadows = false;
 
         // Whether the light's position uniforms should be in view space. If false,
         // the positions are instead in world space.
         bool m_bUseViewTransform = true;
-        // Start as `true` so that initial uniform values get set.
+        // Set when a position or direction changes, which are transformed by
+        // the view. Start as `true` so that initial values get uploaded.
         bool m_hasViewDependentChanged = true;
+        // Set when any other property changes.
         bool m_hasLightChanged = true;
-
-        bool m_hasViewBeenApplied = false;
     };
 
     class DirectionalLight : public Light
@@ -101,33 +121,39 @@ namespace Cme
         glm::vec3 getDirection() const { return direction_; }
         void setDirection(glm::vec3 direction)
         {
-            direction_ = direction;
-            m_hasViewDependentChanged = true;
+            // A zero vector has no direction, normalizing it gives NaNs.
+            if (glm::dot(direction, direction) == 0.0f)
+            {
+                return;
+            }
+            direction = glm::normalize(direction);
+            if (direction_ != direction)
+            {
+                direction_ = direction;
+                m_hasViewDependentChanged = true;
+            }
         }
         glm::vec3 getDiffuse() const { return diffuse_; }
         void setDiffuse(glm::vec3 diffuse)
         {
-            diffuse_ = diffuse;
-            m_hasLightChanged = true;
+            if (diffuse_ != diffuse)
+            {
+                diffuse_ = diffuse;
+                m_hasLightChanged = true;
+            }
         }
         glm::vec3 getSpecular() const { return specular_; }
         void setSpecular(glm::vec3 specular) 
         {
-            specular_ = specular;
-            m_hasLightChanged = true;
-        }
-
-    protected:
-        std::string getUniformName(unsigned int lightIdx) const 
-        {
-            return "qrk_directionalLights[" + std::to_string(lightIdx) + "]";
+            if (specular_ != specular)
+            {
+                specular_ = specular;
+                m_hasLightChanged = true;
+            }
         }
-        void updateUniforms(Shader& shader);
-        void applyViewTransform(const glm::mat4& view);
 
-        private:
+    private:
         glm::vec3 direction_;
-        glm::vec3 viewDirection_;
 
         glm::vec3 diffuse_;
         glm::vec3 specular_;
@@ -146,40 +172,44 @@ namespace Cme
         glm::vec3 getPosition() const { return m_vec3Position; }
         void setPosition(glm::vec3 position)
         {
-            m_vec3Position = position;
-            m_hasViewDependentChanged = true;
+            if (m_vec3Position != position)
+            {
+                m_vec3Position = position;
+                m_hasViewDependentChanged = true;
+            }
         }
         glm::vec3 getDiffuse() const { return m_vec3Diffuse; }
         void setDiffuse(glm::vec3 diffuse)
         {
-            m_vec3Diffuse = diffuse;
-            m_hasLightChanged = true;
+            if (m_vec3Diffuse != diffuse)
+            {
+                m_vec3Diffuse = diffuse;
+                m_hasLightChanged = true;
+            }
         }
 
         glm::vec3 getSpecular() const { return m_vec3Specular; }
         void setSpecular(glm::vec3 specular)
         {
-            m_vec3Specular = specular;
-            m_hasLightChanged = true;
+            if (m_vec3Specular != specular)
+            {
+                m_vec3Specular = specular;
+                m_hasLightChanged = true;
+            }
         }
         Attenuation getAttenuation() const { return m_stAttenuation; }
         void setAttenuation(Attenuation attenuation) 
         {
-            m_stAttenuation = attenuation;
-            m_hasLightChanged = true;
-        }
-
-    protected:
-        std::string getUniformName(unsigned int lightIdx) const 
-        {
-            return "qrk_pointLights[" + std::to_string(lightIdx) + "]";
+            if (m_stAttenuation != attenuation)
+            {
+                m_stAttenuation = attenuation;
+                m_hasLightChanged = true;
+            }
         }
-        void updateUniforms(Shader& shader);
-        void applyViewTransform(const glm::mat4& view);
+        float getRange() const { return calculateLightRange(m_stAttenuation, m_vec3Diffuse); }
 
     private:
         glm::vec3 m_vec3Position;
-        glm::vec3 m_vec3ViewPosition;
 
         glm::vec3 m_vec3Diffuse;
         glm::vec3 m_vec3Specular;
@@ -203,48 +233,64 @@ namespace Cme
         glm::vec3 getPosition() const { return m_vec3Position; }
         void setPosition(glm::vec3 position)
         {
-            m_vec3Position = position;
-            m_hasViewDependentChanged = true;
+            if (m_vec3Position != position)
+            {
+                m_vec3Position = position;
+                m_hasViewDependentChanged = true;
+            }
         }
         glm::vec3 getDirection() const { return m_vec3Direction; }
         void setDirection(glm::vec3 direction)
         {
-            m_vec3Direction = direction;
-            m_hasViewDependentChanged = true;
+            if (m_vec3Direction != direction)
+            {
+                m_vec3Direction = direction;
+                m_hasViewDependentChanged = true;
+            }
+        }
+        float getInnerAngle() const { return m_fInnerAngle; }
+        float getOuterAngle() const { return m_fOuterAngle; }
+        void setAngles(float innerAngle, float outerAngle)
+        {
+            if (m_fInnerAngle != innerAngle || m_fOuterAngle != outerAngle)
+            {
+                m_fInnerAngle = innerAngle;
+                m_fOuterAngle = outerAngle;
+                m_hasLightChanged = true;
+            }
         }
         glm::vec3 getDiffuse() const { return m_vec3Diffuse; }
         void setDiffuse(glm::vec3 diffuse) 
         {
-            m_vec3Diffuse = diffuse;
-            m_hasViewBeenApplied = true;
+            if (m_vec3Diffuse != diffuse)
+            {
+                m_vec3Diffuse = diffuse;
+                m_hasLightChanged = true;
+            }
         }
         glm::vec3 getSpecular() const { return m_vec3Specular; }
         void setSpecular(glm::vec3 specular)
         {
-            m_vec3Specular = specular;
-            m_hasViewBeenApplied = true;
+            if (m_vec3Specular != specular)
+            {
+                m_vec3Specular = specular;
+                m_hasLightChanged = true;
+            }
         }
         Attenuation getAttenuation() const { return m_stAttenuation; }
         void setAttenuation(Attenuation attenuation)
         {
-            m_stAttenuation = attenuation;
-            m_hasViewBeenApplied = true;
-        }
-
-    protected:
-        std::string getUniformName(unsigned int lightIdx) const
-        {
-            return "qrk_spotLights[" + std::to_string(lightIdx) + "]";
+            if (m_stAttenuation != attenuation)
+            {
+                m_stAttenuation = attenuation;
+                m_hasLightChanged = true;
+            }
         }
-        void updateUniforms(Shader& shader);
-        void applyViewTransform(const glm::mat4& view);
+        float getRange() const { return calculateLightRange(m_stAttenuation, m_vec3Diffuse); }
 
     private:
         glm::vec3 m_vec3Position;
-        glm::vec3 m_vec3ViewPosition;
-
         glm::vec3 m_vec3Direction;
-        glm::vec3 m_vec3ViewDirection;
 
         float m_fInnerAngle;
         float m_fOuterAngle;
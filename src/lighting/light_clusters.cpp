@@ -0,0 +1,185 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Cme
+{
+    namespace
+    {
+        constexpr int BIN_LOCAL_SIZE = 64;
+
+        // Mirrors qrk_clusterBounds() in light_clusters.glsl.
+        void clusterBounds(const ClusterGrid& grid, const glm::mat4& inverseProjection, float near, float far,
+                           const glm::ivec3& cluster, glm::vec3& minBounds, glm::vec3& maxBounds)
+        {
+            float sliceNear = near * std::pow(far / near, float(cluster.z) / float(grid.size.z));
+            float sliceFar = near * std::pow(far / near, float(cluster.z + 1) / float(grid.size.z));
+            glm::vec2 ndcMin = glm::vec2(cluster.x, cluster.y) / glm::vec2(grid.size.x, grid.size.y) * 2.0f - 1.0f;
+            glm::vec2 ndcMax = glm::vec2(cluster.x + 1, cluster.y + 1) / glm::vec2(grid.size.x, grid.size.y) * 2.0f - 1.0f;
+
+            minBounds = glm::vec3(std::numeric_limits<float>::max());
+            maxBounds = glm::vec3(-std::numeric_limits<float>::max());
+            for (int i = 0; i < 4; ++i)
+            {
+                glm::vec2 ndc = glm::vec2((i & 1) ? ndcMax.x : ndcMin.x, (i & 2) ? ndcMax.y : ndcMin.y);
+                // A point on the near plane, which is the direction of the ray
+                // through the corner.
+                glm::vec4 corner = inverseProjection * glm::vec4(ndc, -1.0f, 1.0f);
+                glm::vec3 ray = glm::vec3(corner) / corner.w;
+                for (float depth : { sliceNear, sliceFar })
+                {
+                    glm::vec3 point = ray * (depth / -ray.z);
+                    minBounds = glm::min(minBounds, point);
+                    maxBounds = glm::max(maxBounds, point);
+                }
+            }
+        }
+
+        bool sphereIntersectsAabb(const glm::vec4& sphere, const glm::vec3& minBounds, const glm::vec3& maxBounds)
+        {
+            glm::vec3 center = glm::vec3(sphere);
+            glm::vec3 offset = glm::clamp(center, minBounds, maxBounds) - center;
+            return glm::dot(offset, offset) <= sphere.w * sphere.w;
+        }
+    }
+
+    LightClusters::LightClusters(ClusterGrid grid) : m_Grid(grid)
+    {
+        if (m_Grid.GetClusterCount() <= 0 || m_Grid.maxLightsPerCluster <= 0)
+        {
+            throw LightClusterException("ERROR::LIGHT_CLUSTERS::INVALID_GRID");
+        }
+        m_upBinShader = std::make_unique<Shader>(ShaderPath("assets//shaders//builtin//light_clusters.comp"));
+
+        glCreateBuffers(1, &m_uiClusterBuffer);
+        glNamedBufferStorage(m_uiClusterBuffer, m_Grid.GetClusterCount() * sizeof(glm::uvec2), nullptr, 0);
+        glCreateBuffers(1, &m_uiIndexBuffer);
+        glNamedBufferStorage(m_uiIndexBuffer,
+                             GLsizeiptr(m_Grid.GetClusterCount()) * m_Grid.maxLightsPerCluster * sizeof(uint32_t),
+                             nullptr, 0);
+    }
+
+    LightClusters::~LightClusters()
+    {
+        glDeleteBuffers(1, &m_uiClusterBuffer);
+        glDeleteBuffers(1, &m_uiIndexBuffer);
+    }
+
+    void LightClusters::Build(const LightControl& lights, const glm::mat4& projection, float near, float far)
+    {
+        m_fNear = near;
+        m_fFar = far;
+
+        lights.bindLightBuffers();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_BUFFER_BINDING, m_uiClusterBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING, m_uiIndexBuffer);
+
+        m_upBinShader->activate();
+        m_upBinShader->setMat4("inverseProjection", glm::inverse(projection));
+        m_upBinShader->setIVec3("qrk_clusterGridSize", m_Grid.size);
+        m_upBinShader->setInt("qrk_maxLightsPerCluster", m_Grid.maxLightsPerCluster);
+        m_upBinShader->setFloat("qrk_clusterNear", near);
+        m_upBinShader->setFloat("qrk_clusterFar", far);
+
+        int numGroups = (m_Grid.GetClusterCount() + BIN_LOCAL_SIZE - 1) / BIN_LOCAL_SIZE;
+        glDispatchCompute(numGroups, 1, 1);
+        m_upBinShader->deactivate();
+
+        // The lighting pass reads the lists from its fragment shader.
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void LightClusters::updateUniforms(Shader& shader, ImageSize screenSize)
+    {
+        shader.setIVec3("qrk_clusterGridSize", m_Grid.size);
+        shader.setInt("qrk_maxLightsPerCluster", m_Grid.maxLightsPerCluster);
+        shader.setFloat("qrk_clusterNear", m_fNear);
+        shader.setFloat("qrk_clusterFar", m_fFar);
+        shader.setVec2("qrk_clusterScreenSize", glm::vec2(screenSize.width, screenSize.height));
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_BUFFER_BINDING, m_uiClusterBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING, m_uiIndexBuffer);
+    }
+
+    LightClusterData LightClusters::ReadBack() const
+    {
+        LightClusterData data;
+        data.counts.resize(m_Grid.GetClusterCount());
+        data.indices.resize(size_t(m_Grid.GetClusterCount()) * m_Grid.maxLightsPerCluster);
+
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glGetNamedBufferSubData(m_uiClusterBuffer, 0, data.counts.size() * sizeof(glm::uvec2), data.counts.data());
+        glGetNamedBufferSubData(m_uiIndexBuffer, 0, data.indices.size() * sizeof(uint32_t), data.indices.data());
+        return data;
+    }
+
+    LightClusterData LightClusters::BinCpu(const ClusterGrid& grid, const glm::mat4& projection, float near, float far,
+                                           const std::vector<GpuPointLight>& pointLights,
+                                           const std::vector<GpuSpotLight>& spotLights)
+    {
+        LightClusterData data;
+        data.counts.resize(grid.GetClusterCount(), glm::uvec2(0));
+        data.indices.resize(size_t(grid.GetClusterCount()) * grid.maxLightsPerCluster, 0);
+
+        glm::mat4 inverseProjection = glm::inverse(projection);
+        for (int z = 0; z < grid.size.z; ++z)
+        {
+            for (int y = 0; y < grid.size.y; ++y)
+            {
+                for (int x = 0; x < grid.size.x; ++x)
+                {
+                    int clusterIndex = x + grid.size.x * (y + grid.size.y * z);
+                    glm::vec3 minBounds, maxBounds;
+                    clusterBounds(grid, inverseProjection, near, far, glm::ivec3(x, y, z), minBounds, maxBounds);
+
+                    uint32_t* list = &data.indices[size_t(clusterIndex) * grid.maxLightsPerCluster];
+                    uint32_t count = 0;
+                    glm::uvec2& counts = data.counts[clusterIndex];
+                    for (uint32_t i = 0; i < pointLights.size() && count < (uint32_t)grid.maxLightsPerCluster; ++i)
+                    {
+                        if (sphereIntersectsAabb(pointLights[i].positionRange, minBounds, maxBounds))
+                        {
+                            list[count++] = i;
+                            counts.x++;
+                        }
+                    }
+                    for (uint32_t i = 0; i < spotLights.size() && count < (uint32_t)grid.maxLightsPerCluster; ++i)
+                    {
+                        if (sphereIntersectsAabb(spotLights[i].positionRange, minBounds, maxBounds))
+                        {
+                            list[count++] = i;
+                            counts.y++;
+                        }
+                    }
+                }
+            }
+        }
+        return data;
+    }
+
+    int LightClusters::Validate(const LightControl& lights, const glm::mat4& projection, float near, float far) const
+    {
+        LightClusterData gpu = ReadBack();
+        LightClusterData cpu = BinCpu(m_Grid, projection, near, far, lights.getPointLightData(), lights.getSpotLightData());
+
+        int mismatches = 0;
+        for (int i = 0; i < m_Grid.GetClusterCount(); ++i)
+        {
+            if (gpu.counts[i] != cpu.counts[i])
+            {
+                ++mismatches;
+                continue;
+            }
+            size_t offset = size_t(i) * m_Grid.maxLightsPerCluster;
+            size_t count = cpu.counts[i].x + cpu.counts[i].y;
+            if (!std::equal(cpu.indices.begin() + offset, cpu.indices.begin() + offset + count,
+                            gpu.indices.begin() + offset))
+            {
+                ++mismatches;
+            }
+        }
+        return mismatches;
+    }
+}  // namespace Cme
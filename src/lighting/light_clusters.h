@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../exceptions.h"
+#include "../screen.h"
+#include "../shader/shader.h"
+#include "light_control.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Cme
+{
+	// SSBO binding points of the cluster lists, see standard_lights.frag.
+	constexpr GLuint LIGHT_CLUSTER_BUFFER_BINDING = 3;
+	constexpr GLuint LIGHT_INDEX_BUFFER_BINDING = 4;
+
+	class LightClusterException : public QuarkException
+	{
+		using QuarkException::QuarkException;
+	};
+
+	// Froxel grid the view frustum is divided into. X and Y split the screen
+	// evenly, Z splits view depth exponentially between the near and far planes
+	// so that clusters stay roughly cubic.
+	struct ClusterGrid
+	{
+		glm::ivec3 size = glm::ivec3(16, 9, 24);
+		// Lights beyond this count in a single cluster are dropped.
+		int maxLightsPerCluster = 128;
+
+		int GetClusterCount() const { return size.x * size.y * size.z; }
+	};
+
+	// Per cluster light lists, in the layout of the GPU buffers. Cluster i owns
+	// indices [i * maxLightsPerCluster, i * maxLightsPerCluster + count), point
+	// lights first, followed by spot lights.
+	struct LightClusterData
+	{
+		// x: point light count, y: spot light count.
+		std::vector<glm::uvec2> counts;
+		std::vector<uint32_t> indices;
+	};
+
+	// Bins point and spot lights into clusters with a compute pass, so that the
+	// lighting pass only shades the lights whose range overlaps the cluster of
+	// each pixel. Lights are bounded by a sphere of their range and tested
+	// against the view space AABB of each cluster.
+	class LightClusters
+	{
+	public:
+		explicit LightClusters(ClusterGrid grid = ClusterGrid());
+		~LightClusters();
+
+		LightClusters(const LightClusters&) = delete;
+		LightClusters& operator=(const LightClusters&) = delete;
+
+		// Rebuilds the light lists for the current frame. Expects the light
+		// buffers of `lights` to be up to date.
+		void Build(const LightControl& lights, const glm::mat4& projection, float near, float far);
+
+		// Sets the uniforms and binds the buffers the lighting pass needs to find
+		// the light list of a pixel. `screenSize` is the size of the target the
+		// lighting pass renders to.
+		void updateUniforms(Shader& shader, ImageSize screenSize);
+
+		// Reads the light lists of the last Build() back from the GPU.
+		LightClusterData ReadBack() const;
+
+		// CPU reference of the compute pass, producing the same lists given the
+		// same inputs.
+		static LightClusterData BinCpu(const ClusterGrid& grid, const glm::mat4& projection, float near, float far,
+									   const std::vector<GpuPointLight>& pointLights,
+									   const std::vector<GpuSpotLight>& spotLights);
+
+		// Compares the last Build() against BinCpu() and returns the number of
+		// clusters whose lists differ. Stalls on the GPU, debugging only.
+		int Validate(const LightControl& lights, const glm::mat4& projection, float near, float far) const;
+
+		const ClusterGrid& GetGrid() const { return m_Grid; }
+
+	private:
+		ClusterGrid m_Grid;
+		std::unique_ptr<Shader> m_upBinShader;
+		GLuint m_uiClusterBuffer = 0;
+		GLuint m_uiIndexBuffer = 0;
+		float m_fNear = 0.1f;
+		float m_fFar = 100.0f;
+	};
+}  // namespace Cme
@@ -1,16 +1,29 @@
 #include "light_control.h"
 
+#include <algorithm>
+
 namespace Cme
 {
     LightControl::LightControl(glm::mat4 mat4View)
     {
         m_mat4View = mat4View;
+        glCreateBuffers(1, &m_uiLightBlockBuffer);
+        glNamedBufferStorage(m_uiLightBlockBuffer, sizeof(GpuLightBlock), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    LightControl::~LightControl()
+    {
+        glDeleteBuffers(1, &m_uiLightBlockBuffer);
     }
 
     void LightControl::AddLight(std::shared_ptr<Light> light)
     {
-        // TODO: Throw an error if this exceeds the max light count supported in the
-        // shader.
+        // Point and spot lights live in storage buffers, so only directional
+        // lights are limited by QRK_MAX_DIRECTIONAL_LIGHTS.
+        if (light->getLightType() == LightType::DIRECTIONAL_LIGHT && m_uiDirectionalCount >= MAX_DIRECTIONAL_LIGHTS)
+        {
+            throw LightException("ERROR::LIGHT_CONTROL::TOO_MANY_DIRECTIONAL_LIGHTS");
+        }
         m_vecLights.push_back(light);
 
         switch (light->getLightType())
@@ -24,27 +37,43 @@ namespace Cme
             m_uiPointCount++;
             break;
         case LightType::SPOT_LIGHT:
-            light->setLightIdx(m_uiPointCount);
+            light->setLightIdx(m_uiSpotCount);
             m_uiSpotCount++;
             break;
         }
+        // A new light always has its change flags set, so only the counts
+        // need to be marked here.
+        m_bLightBlockChanged = true;
     }
 
-    void LightControl::updateUniforms(Shader& shader)
+    void LightControl::RemoveLight(const std::shared_ptr<Light>& light)
     {
-        for (auto item : m_vecLights)
+        auto iter = std::find(m_vecLights.begin(), m_vecLights.end(), light);
+        if (iter == m_vecLights.end())
         {
-            item->applyViewTransform(m_mat4View);
+            return;
         }
+        m_vecLights.erase(iter);
 
-        shader.setInt("qrk_directionalLightCount", m_uiDirectionalCount);
-        shader.setInt("qrk_pointLightCount", m_uiPointCount);
-        shader.setInt("qrk_spotLightCount", m_uiSpotCount);
+        // Re-index the remaining lights so the buffers stay dense. Only the
+        // lights whose index moves are marked as changed.
+        std::vector<std::shared_ptr<Light>> vecLights;
+        vecLights.swap(m_vecLights);
+        m_uiDirectionalCount = 0;
+        m_uiPointCount = 0;
+        m_uiSpotCount = 0;
+        for (auto& item : vecLights)
+        {
+            AddLight(item);
+        }
+    }
 
-        // ڿòͬĹԴ ĿǰԴĸʱŵlight_control
-        for (auto light : m_vecLights)
+    void LightControl::setViewTransform(const glm::mat4& mat4View)
+    {
+        if (m_mat4View != mat4View)
         {
-            light->updateUniforms(shader);
+            m_mat4View = mat4View;
+            m_bViewChanged = true;
         }
     }
 
@@ -55,4 +84,101 @@ namespace Cme
             light->setUseViewTransform(useViewTransform);
         }
     }
+
+    void LightControl::updateLightBuffers()
+    {
+        m_PointLights.Resize(m_uiPointCount);
+        m_SpotLights.Resize(m_uiSpotCount);
+
+        // ֻ´仯ĹԴ ƶʱӿռµĹԴȫҪ
+        for (auto& item : m_vecLights)
+        {
+            if (!item->hasChanged() && !(m_bViewChanged && item->m_bUseViewTransform))
+            {
+                continue;
+            }
+
+            switch (item->getLightType())
+            {
+            case LightType::DIRECTIONAL_LIGHT:
+            {
+                auto light = std::static_pointer_cast<DirectionalLight>(item);
+                glm::vec3 direction = light->getDirection();
+                if (light->m_bUseViewTransform)
+                {
+                    direction = glm::vec3(m_mat4View * glm::vec4(direction, 0.0f));
+                }
+
+                GpuDirectionalLight& data = m_LightBlock.directionalLights[light->m_uiLightIdx];
+                data.direction = glm::vec4(direction, 0.0f);
+                data.diffuse = glm::vec4(light->getDiffuse(), 0.0f);
+                data.specular = glm::vec4(light->getSpecular(), 0.0f);
+                m_bLightBlockChanged = true;
+            } break;
+            case LightType::POINT_LIGHT:
+            {
+                auto light = std::static_pointer_cast<PointLight>(item);
+                glm::vec3 position = light->getPosition();
+                if (light->m_bUseViewTransform)
+                {
+                    position = glm::vec3(m_mat4View * glm::vec4(position, 1.0f));
+                }
+                Attenuation attenuation = light->getAttenuation();
+
+                GpuPointLight data;
+                data.positionRange = glm::vec4(position, light->getRange());
+                data.diffuse = glm::vec4(light->getDiffuse(), 0.0f);
+                data.specular = glm::vec4(light->getSpecular(), 0.0f);
+                data.attenuation = glm::vec4(attenuation.constant, attenuation.linear, attenuation.quadratic, 0.0f);
+                m_PointLights.Set(light->m_uiLightIdx, data);
+            } break;
+            case LightType::SPOT_LIGHT:
+            {
+                auto light = std::static_pointer_cast<SpotLight>(item);
+                glm::vec3 position = light->getPosition();
+                glm::vec3 direction = light->getDirection();
+                if (light->m_bUseViewTransform)
+                {
+                    position = glm::vec3(m_mat4View * glm::vec4(position, 1.0f));
+                    direction = glm::vec3(m_mat4View * glm::vec4(direction, 0.0f));
+                }
+                Attenuation attenuation = light->getAttenuation();
+
+                GpuSpotLight data;
+                data.positionRange = glm::vec4(position, light->getRange());
+                data.direction = glm::vec4(direction, 0.0f);
+                data.diffuse = glm::vec4(light->getDiffuse(), 0.0f);
+                data.specular = glm::vec4(light->getSpecular(), 0.0f);
+                data.attenuation = glm::vec4(attenuation.constant, attenuation.linear, attenuation.quadratic, 0.0f);
+                data.angles = glm::vec4(light->getInnerAngle(), light->getOuterAngle(), 0.0f, 0.0f);
+                m_SpotLights.Set(light->m_uiLightIdx, data);
+            } break;
+            }
+            item->resetChangeDetection();
+        }
+        m_bViewChanged = false;
+
+        if (m_LightBlock.directionalLightCount != (int)m_uiDirectionalCount ||
+            m_LightBlock.pointLightCount != (int)m_uiPointCount || m_LightBlock.spotLightCount != (int)m_uiSpotCount)
+        {
+            m_LightBlock.directionalLightCount = m_uiDirectionalCount;
+            m_LightBlock.pointLightCount = m_uiPointCount;
+            m_LightBlock.spotLightCount = m_uiSpotCount;
+            m_bLightBlockChanged = true;
+        }
+        if (m_bLightBlockChanged)
+        {
+            glNamedBufferSubData(m_uiLightBlockBuffer, 0, sizeof(GpuLightBlock), &m_LightBlock);
+            m_bLightBlockChanged = false;
+        }
+        m_PointLights.Upload();
+        m_SpotLights.Upload();
+    }
+
+    void LightControl::bindLightBuffers() const
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, m_uiLightBlockBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_BUFFER_BINDING, m_PointLights.GetBufferID());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SPOT_LIGHT_BUFFER_BINDING, m_SpotLights.GetBufferID());
+    }
 }
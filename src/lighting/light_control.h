@@ -3,31 +3,174 @@
 #include "../shader/shader.h"
 #include "light.h"
 
+#include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
+
 namespace Cme
 {
+    // Binding points of the light storage, see light_buffers.glsl.
+    constexpr GLuint LIGHT_BLOCK_BINDING = 0;
+    constexpr GLuint POINT_LIGHT_BUFFER_BINDING = 1;
+    constexpr GLuint SPOT_LIGHT_BUFFER_BINDING = 2;
+
+    // Must match QRK_MAX_DIRECTIONAL_LIGHTS.
+    constexpr int MAX_DIRECTIONAL_LIGHTS = 10;
+
+    // std140 layout of a directional light in the light block.
+    struct GpuDirectionalLight
+    {
+        glm::vec4 direction;
+        glm::vec4 diffuse;
+        glm::vec4 specular;
+    };
+
+    // std140 layout of the light uniform block.
+    struct GpuLightBlock
+    {
+        GpuDirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
+        int directionalLightCount;
+        int pointLightCount;
+        int spotLightCount;
+        int padding;
+    };
+
+    // std430 layout of a point light in the light buffer. Positions are in the
+    // same space as the shading (view space by default).
+    struct GpuPointLight
+    {
+        // xyz: position, w: range of influence.
+        glm::vec4 positionRange;
+        glm::vec4 diffuse;
+        glm::vec4 specular;
+        // xyz: constant, linear, quadratic.
+        glm::vec4 attenuation;
+    };
+
+    // std430 layout of a spot light in the light buffer.
+    struct GpuSpotLight
+    {
+        glm::vec4 positionRange;
+        glm::vec4 direction;
+        glm::vec4 diffuse;
+        glm::vec4 specular;
+        glm::vec4 attenuation;
+        // x: inner angle, y: outer angle.
+        glm::vec4 angles;
+    };
+
+    // A storage buffer mirroring an array of light entries. Tracks the range
+    // of entries written since the last upload, so that only those are sent.
+    template <typename T>
+    class LightBuffer
+    {
+    public:
+        LightBuffer() { glCreateBuffers(1, &m_uiBuffer); }
+        ~LightBuffer() { glDeleteBuffers(1, &m_uiBuffer); }
+
+        LightBuffer(const LightBuffer&) = delete;
+        LightBuffer& operator=(const LightBuffer&) = delete;
+
+        void Resize(size_t count)
+        {
+            m_vecData.resize(count);
+            m_iDirtyEnd = std::min(m_iDirtyEnd, count);
+            m_iDirtyBegin = std::min(m_iDirtyBegin, m_iDirtyEnd);
+        }
+
+        void Set(size_t idx, const T& value)
+        {
+            m_vecData[idx] = value;
+            m_iDirtyBegin = std::min(m_iDirtyBegin, idx);
+            m_iDirtyEnd = std::max(m_iDirtyEnd, idx + 1);
+        }
+
+        void Upload()
+        {
+            if (m_vecData.size() > m_iCapacity || m_iCapacity == 0)
+            {
+                // Grow geometrically, keeping at least one element since an
+                // empty buffer can't be bound. Reallocating drops the contents,
+                // so everything is sent again.
+                m_iCapacity = std::max({ m_vecData.size(), m_iCapacity * 2, size_t(1) });
+                glNamedBufferData(m_uiBuffer, m_iCapacity * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+                m_iDirtyBegin = 0;
+                m_iDirtyEnd = m_vecData.size();
+            }
+            if (m_iDirtyBegin < m_iDirtyEnd)
+            {
+                glNamedBufferSubData(m_uiBuffer, m_iDirtyBegin * sizeof(T),
+                                     (m_iDirtyEnd - m_iDirtyBegin) * sizeof(T), &m_vecData[m_iDirtyBegin]);
+            }
+            m_iDirtyBegin = SIZE_MAX;
+            m_iDirtyEnd = 0;
+        }
+
+        GLuint GetBufferID() const { return m_uiBuffer; }
+        const std::vector<T>& GetData() const { return m_vecData; }
+
+    private:
+        GLuint m_uiBuffer = 0;
+        size_t m_iCapacity = 0;
+        std::vector<T> m_vecData;
+        size_t m_iDirtyBegin = SIZE_MAX;
+        size_t m_iDirtyEnd = 0;
+    };
+
+    // Owns the scene lights and their GPU copies: directional lights and the
+    // light counts in a std140 uniform block, point and spot lights in std430
+    // storage buffers. Entries are re-packed only for lights whose change
+    // flags are set, or for all view space lights when the view changes.
     class LightControl
     {
     public:
         LightControl(glm::mat4 mat4View);
-        virtual ~LightControl() = default;
+        virtual ~LightControl();
         void AddLight(std::shared_ptr<Light> light);
-        void updateUniforms(Shader& shader);
+        void RemoveLight(const std::shared_ptr<Light>& light);
+
+        // Sets the view transform used to move lights into view space. Needs to
+        // be called whenever the camera moves.
+        void setViewTransform(const glm::mat4& mat4View);
 
         // Sets whether the registered lights should transform their positions to view
         // space. If false, positions remain in world space when passed to the shader.
         void setUseViewTransform(bool useViewTransform);
 
+        // Uploads the lights that changed since the last call. Call once per
+        // frame after the lights and view are updated, before binning and
+        // bindLightBuffers().
+        void updateLightBuffers();
+        // Binds the light block and buffers for the lighting shaders.
+        void bindLightBuffers() const;
+
+        const std::vector<std::shared_ptr<Light>>& getLights() const { return m_vecLights; }
+        unsigned int getPointLightCount() const { return m_uiPointCount; }
+        unsigned int getSpotLightCount() const { return m_uiSpotCount; }
+
+        GLuint getPointLightBuffer() const { return m_PointLights.GetBufferID(); }
+        GLuint getSpotLightBuffer() const { return m_SpotLights.GetBufferID(); }
+        const std::vector<GpuPointLight>& getPointLightData() const { return m_PointLights.GetData(); }
+        const std::vector<GpuSpotLight>& getSpotLightData() const { return m_SpotLights.GetData(); }
+
     private:
         unsigned int m_uiDirectionalCount = 0;
         unsigned int m_uiPointCount = 0;
         unsigned int m_uiSpotCount = 0;
         glm::mat4 m_mat4View = glm::mat4(1.0f);
+        bool m_bViewChanged = true;
 
         // std::shared_ptr<ViewSource> m_spViewSource;
         std::vector<std::shared_ptr<Light>> m_vecLights;
+
+        GpuLightBlock m_LightBlock = {};
+        bool m_bLightBlockChanged = true;
+        GLuint m_uiLightBlockBuffer = 0;
+        LightBuffer<GpuPointLight> m_PointLights;
+        LightBuffer<GpuSpotLight> m_SpotLights;
     };
 }
-
@@ -1,40 +1,196 @@
 #include "ssao.h"
 #include "../common_helper.h"
+#include "../core/render_target_pool.h"
 #include "ssao_kernel.h"
 
-#include <glm/gtx/norm.hpp>
-#include <random>
+#include <algorithm>
 
-namespace Cme 
+namespace Cme
 {
-    SsaoShader::SsaoShader()
-        : Shader(ShaderPath("assets//shaders//builtin//screen_quad.vert"),
-                 ShaderPath("assets//shaders//builtin//ssao.frag")) {}
+    namespace
+    {
+        constexpr int SSAO_LOCAL_SIZE = 8;
+        // Relative view depth difference beyond which history is rejected.
+        constexpr float SSAO_DEPTH_REJECTION = 0.05f;
+        // Relative view depth difference at which the upsample weight of a
+        // low resolution texel falls to ~37%.
+        constexpr float SSAO_UPSAMPLE_DEPTH_SIGMA = 0.02f;
+        // Advances the kernel rotation by the golden angle each frame, which
+        // spreads consecutive rotations evenly.
+        constexpr float SSAO_ROTATION_STEP = 2.39996323f;
+
+        void createTarget(Texture& texture, ImageSize size, GLenum internalFormat, TextureFiltering filtering,
+                          MipGeneration mips = MipGeneration::NEVER)
+        {
+            TextureParams params;
+            params.filtering = filtering;
+            params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+            params.generateMips = mips;
+            texture = RenderTargetPool::GetInstance().Acquire(size.width, size.height, internalFormat, params,
+                                                              BufferType::GRAYSCALE);
+        }
+
+        void bindImage(const Texture& texture, int level = 0)
+        {
+            glBindImageTexture(0, texture.getId(), level, GL_FALSE, 0, GL_WRITE_ONLY, texture.getInternalFormat());
+        }
+    }
+
+    SsaoPass::SsaoPass(ImageSize screenSize, SsaoResolution resolution)
+        : m_ScreenSize(screenSize),
+        m_eResolution(resolution),
+        m_DepthShaderObj(ShaderPath("assets//shaders//builtin//ssao_depth.comp")),
+        m_AoShaderObj(ShaderPath("assets//shaders//builtin//ssao.comp")),
+        m_TemporalShaderObj(ShaderPath("assets//shaders//builtin//ssao_temporal.comp")),
+        m_UpsampleShaderObj(ShaderPath("assets//shaders//builtin//ssao_upsample.comp"))
+    {
+        m_spDepthPyramid = std::make_shared<Texture>();
+        m_spRawAo = std::make_shared<Texture>();
+        m_spHistory[0] = std::make_shared<Texture>();
+        m_spHistory[1] = std::make_shared<Texture>();
+        allocateLowResTargets();
+        m_spAo = std::make_shared<Texture>();
+        createTarget(*m_spAo, screenSize, GL_R8, TextureFiltering::BILINEAR);
+    }
 
-    SsaoBlurShader::SsaoBlurShader()
-        : Shader(ShaderPath("assets/shaders/builtin/screen_quad.vert"),
-            ShaderPath("assets/shaders/builtin/ssao_blur.frag")) {}
+    SsaoPass::~SsaoPass()
+    {
+        RenderTargetPool& pool = RenderTargetPool::GetInstance();
+        pool.Release(*m_spDepthPyramid);
+        pool.Release(*m_spRawAo);
+        pool.Release(*m_spHistory[0]);
+        pool.Release(*m_spHistory[1]);
+        pool.Release(*m_spAo);
+    }
 
-    SsaoBuffer::SsaoBuffer(int width, int height) : Framebuffer(width, height)
+    void SsaoPass::allocateLowResTargets()
     {
-        // Make sure we're clearing properly.
-        setClearColor(glm::vec4(0.0f));
-        // Create and attach the SSAO buffer. Don't need a depth buffer.
-        m_SsaoBufferAttachmentObj = AttachTexture2FB(Cme::BufferType::GRAYSCALE);
+        int divisor = static_cast<int>(m_eResolution);
+        ImageSize size = { std::max(m_ScreenSize.width / divisor, 1), std::max(m_ScreenSize.height / divisor, 1) };
+
+        // Re-created in place, so that registered pointers stay valid.
+        createTarget(*m_spDepthPyramid, size, GL_R32F, TextureFiltering::NEAREST, MipGeneration::ALWAYS);
+        // Levels are read with texelFetch(), which needs a mipmapped filter to
+        // reach past the base level.
+        glTextureParameteri(m_spDepthPyramid->getId(), GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        createTarget(*m_spRawAo, size, GL_R8, TextureFiltering::NEAREST);
+        createTarget(*m_spHistory[0], size, GL_RG16F, TextureFiltering::BILINEAR);
+        createTarget(*m_spHistory[1], size, GL_RG16F, TextureFiltering::BILINEAR);
+        m_bHistoryValid = false;
     }
 
-    void SsaoBlurShader::configureWith(SsaoKernel& kernel, SsaoBuffer& buffer)
+    void SsaoPass::setResolution(SsaoResolution resolution)
     {
-        setInt("qrk_ssaoNoiseTextureSideLength", kernel.getNoiseTextureSideLength());
+        if (m_eResolution == resolution)
+        {
+            return;
+        }
+        m_eResolution = resolution;
+        // Switching back and forth reuses the targets of the other resolution
+        // while the pool still holds them.
+        RenderTargetPool& pool = RenderTargetPool::GetInstance();
+        pool.Release(*m_spDepthPyramid);
+        pool.Release(*m_spRawAo);
+        pool.Release(*m_spHistory[0]);
+        pool.Release(*m_spHistory[1]);
+        allocateLowResTargets();
+    }
+
+    std::vector<std::shared_ptr<Texture>> SsaoPass::getTextures() const
+    {
+        return { m_spAo, m_spDepthPyramid, m_spRawAo, m_spHistory[0], m_spHistory[1] };
+    }
+
+    void SsaoPass::dispatch(Shader& shader, ImageSize size)
+    {
+        shader.activate();
+        glDispatchCompute((size.width + SSAO_LOCAL_SIZE - 1) / SSAO_LOCAL_SIZE,
+                          (size.height + SSAO_LOCAL_SIZE - 1) / SSAO_LOCAL_SIZE, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    void SsaoPass::Render(GBuffer& gBuffer, const Camera& camera, unsigned int textureUnit)
+    {
+        glm::mat4 view = camera.getViewTransform();
+        glm::mat4 projection = camera.getProjectionTransform();
+        glm::mat4 inverseProjection = glm::inverse(projection);
+        ImageSize lowSize = { m_spRawAo->getWidth(), m_spRawAo->getHeight() };
+        // The G-Buffer may only be partly rendered to, see DynamicResolution.
+        ImageSize gBufferSize = gBuffer.getSize();
+        ImageSize renderSize = gBuffer.getViewportSize();
+        glm::vec2 renderScale = glm::vec2(renderSize.width, renderSize.height) /
+            glm::vec2(gBufferSize.width, gBufferSize.height);
+
+        // Depth pyramid.
+        gBuffer.getDepthTexture()->BindToUnit(textureUnit);
+        m_DepthShaderObj.setInt("gDepth", textureUnit);
+        m_spDepthPyramid->BindToUnit(textureUnit + 1);
+        m_DepthShaderObj.setInt("qrk_depthPyramid", textureUnit + 1);
+        m_DepthShaderObj.setMat4("inverseProjection", inverseProjection);
+        m_DepthShaderObj.setVec2("qrk_renderScale", renderScale);
+        for (int level = 0; level < m_spDepthPyramid->getNumMips(); ++level)
+        {
+            // Each level reads the one before it, which the barrier in
+            // dispatch() made visible.
+            m_DepthShaderObj.setInt("sourceLevel", level - 1);
+            bindImage(*m_spDepthPyramid, level);
+            dispatch(m_DepthShaderObj, { std::max(lowSize.width >> level, 1), std::max(lowSize.height >> level, 1) });
+        }
+
+        // Occlusion.
+        m_spDepthPyramid->BindToUnit(textureUnit);
+        m_AoShaderObj.setInt("qrk_depthPyramid", textureUnit);
+        m_AoShaderObj.setInt("qrk_depthPyramidLevels", m_spDepthPyramid->getNumMips());
+        gBuffer.getNormalTexture()->BindToUnit(textureUnit + 1);
+        m_AoShaderObj.setInt("gNormal", textureUnit + 1);
+        m_AoShaderObj.setVec2("qrk_renderScale", renderScale);
+        m_KernelObj.bindTexture(textureUnit + 2, m_AoShaderObj);
+        m_KernelObj.updateUniforms(m_AoShaderObj);
+        m_AoShaderObj.setFloat("qrk_ssaoRotation", m_bTemporal ? SSAO_ROTATION_STEP * (m_uiFrame % 1024) : 0.0f);
+        m_AoShaderObj.setMat4("projection", projection);
+        m_AoShaderObj.setMat4("inverseProjection", inverseProjection);
+        bindImage(*m_spRawAo);
+        dispatch(m_AoShaderObj, lowSize);
+
+        // Accumulation. Without it the raw AO is passed through, so the
+        // upsample always reads the history.
+        Texture& history = *m_spHistory[m_iHistoryIndex];
+        Texture& nextHistory = *m_spHistory[1 - m_iHistoryIndex];
+        m_spRawAo->BindToUnit(textureUnit);
+        m_TemporalShaderObj.setInt("qrk_ssaoRaw", textureUnit);
+        m_spDepthPyramid->BindToUnit(textureUnit + 1);
+        m_TemporalShaderObj.setInt("qrk_depthPyramid", textureUnit + 1);
+        history.BindToUnit(textureUnit + 2);
+        m_TemporalShaderObj.setInt("qrk_ssaoHistory", textureUnit + 2);
+        m_TemporalShaderObj.setBool("qrk_ssaoHistoryValid", m_bHistoryValid && m_bTemporal);
+        m_TemporalShaderObj.setFloat("qrk_ssaoTemporalBlend", m_fTemporalBlend);
+        m_TemporalShaderObj.setFloat("qrk_ssaoDepthRejection", SSAO_DEPTH_REJECTION);
+        m_TemporalShaderObj.setMat4("inverseProjection", inverseProjection);
+        m_TemporalShaderObj.setMat4("reprojection", m_mat4PrevViewProjection * glm::inverse(view));
+        bindImage(nextHistory);
+        dispatch(m_TemporalShaderObj, lowSize);
+
+        // Upsample.
+        nextHistory.BindToUnit(textureUnit);
+        m_UpsampleShaderObj.setInt("qrk_ssaoHistory", textureUnit);
+        gBuffer.getDepthTexture()->BindToUnit(textureUnit + 1);
+        m_UpsampleShaderObj.setInt("gDepth", textureUnit + 1);
+        m_UpsampleShaderObj.setVec2("qrk_renderScale", renderScale);
+        m_UpsampleShaderObj.setMat4("inverseProjection", inverseProjection);
+        m_UpsampleShaderObj.setFloat("qrk_ssaoUpsampleDepthSigma", SSAO_UPSAMPLE_DEPTH_SIGMA);
+        bindImage(*m_spAo);
+        dispatch(m_UpsampleShaderObj, m_ScreenSize);
+        m_UpsampleShaderObj.deactivate();
 
-        // The blur shader only needs a single texture, so we just bind it directly.
-        buffer.getSsaoTexture()->BindToUnit(0);
-        setInt("qrk_ssao", 0);
+        m_iHistoryIndex = 1 - m_iHistoryIndex;
+        m_bHistoryValid = true;
+        m_mat4PrevViewProjection = projection * view;
+        ++m_uiFrame;
     }
 
-    unsigned int SsaoBuffer::bindTexture(unsigned int nextTextureUnit, Shader& shader) 
+    unsigned int SsaoPass::bindTexture(unsigned int nextTextureUnit, Shader& shader)
     {
-        m_SsaoBufferAttachmentObj.Transform2Texture()->BindToUnit(nextTextureUnit);
+        m_spAo->BindToUnit(nextTextureUnit);
         // Bind sampler uniforms.
         shader.setInt("qrk_ssao", nextTextureUnit);
 
@@ -1,13 +1,15 @@
 #pragma once
 
+#include "../camera.h"
+#include "../deferred.h"
 #include "../exceptions.h"
-#include "../framebuffer.h"
-#include "../random.h"
+#include "../screen.h"
 #include "../shader/shader.h"
 #include "../core/texture.h"
 #include "ssao_kernel.h"
 
 #include <glm/glm.hpp>
+#include <memory>
 #include <vector>
 
 namespace Cme
@@ -17,42 +19,86 @@ namespace Cme
         using QuarkException::QuarkException;
     };
 
-    // A shader that calculates SSAO based on a G-Buffer and SSAO kernel.
-    class SsaoShader : public Shader 
+    // Screen fraction the occlusion is computed at.
+    enum class SsaoResolution
     {
-    public:
-        SsaoShader();
+        HALF = 2,
+        QUARTER = 4,
     };
 
-    // SsaoBufferıFBO
-    class SsaoBuffer : public Framebuffer 
+    // Screen space ambient occlusion from the G-Buffer, in four compute passes:
+    //  1. A pyramid of linear view depth, starting at the AO resolution. Each
+    //     level keeps the nearest depth, so distant samples read coarse levels
+    //     without losing occluders.
+    //  2. Hemisphere sampling at the AO resolution, with a kernel rotated each
+    //     frame.
+    //  3. Temporal accumulation into a history reprojected from the previous
+    //     frame, dropping history that fails a depth test.
+    //  4. A depth aware bilateral upsample to the full resolution.
+    // The rotating kernel and the history let a small kernel (8-16 samples)
+    // converge to the quality of a much larger one.
+    class SsaoPass
     {
     public:
-        SsaoBuffer(int width, int height);
-        explicit SsaoBuffer(ImageSize size) : SsaoBuffer(size.width, size.height) {}
-        virtual ~SsaoBuffer() = default;
+        explicit SsaoPass(ImageSize screenSize, SsaoResolution resolution = SsaoResolution::HALF);
+        ~SsaoPass();
+
+        SsaoPass(const SsaoPass&) = delete;
+        SsaoPass& operator=(const SsaoPass&) = delete;
+
+        // Computes this frame's AO. Call after the geometry pass. Samples from
+        // the `textureUnit` units reserved with getTextures().
+        void Render(GBuffer& gBuffer, const Camera& camera, unsigned int textureUnit);
+
+        SsaoResolution getResolution() const { return m_eResolution; }
+        // Reallocates the low resolution targets and drops the history.
+        void setResolution(SsaoResolution resolution);
+
+        SsaoKernel& getKernel() { return m_KernelObj; }
+
+        bool getTemporal() const { return m_bTemporal; }
+        void setTemporal(bool temporal) { m_bTemporal = temporal; }
+        // Weight of the current frame when accumulating.
+        float getTemporalBlend() const { return m_fTemporalBlend; }
+        void setTemporalBlend(float blend) { m_fTemporalBlend = blend; }
+        // Drops the accumulated history, e.g. after a camera cut.
+        void ResetHistory() { m_bHistoryValid = false; }
 
-        std::shared_ptr<Texture> getSsaoTexture()
-        { 
-            return m_SsaoBufferAttachmentObj.Transform2Texture(); 
-        }
+        // All textures of the pass, the full resolution AO first. Registering
+        // them reserves enough texture units for Render().
+        std::vector<std::shared_ptr<Texture>> getTextures() const;
 
+        // Binds the full resolution AO as qrk_ssao.
         unsigned int bindTexture(unsigned int nextTextureUnit, Shader& shader);
 
     private:
-        Attachment m_SsaoBufferAttachmentObj;
-    };
+        ImageSize m_ScreenSize;
+        SsaoResolution m_eResolution;
+        SsaoKernel m_KernelObj;
+        bool m_bTemporal = true;
+        float m_fTemporalBlend = 0.1f;
 
-    // A simple shader that blurs a precomputed SSAO buffer.
-    class SsaoBlurShader : public Shader
-    {
-    public:
-        SsaoBlurShader();
+        Shader m_DepthShaderObj;
+        Shader m_AoShaderObj;
+        Shader m_TemporalShaderObj;
+        Shader m_UpsampleShaderObj;
+
+        // Linear view depth with mips, at the AO resolution.
+        std::shared_ptr<Texture> m_spDepthPyramid;
+        // This frame's AO, at the AO resolution.
+        std::shared_ptr<Texture> m_spRawAo;
+        // Ping-ponged (AO, view depth), at the AO resolution.
+        std::shared_ptr<Texture> m_spHistory[2];
+        // Upsampled AO, at the screen resolution.
+        std::shared_ptr<Texture> m_spAo;
+
+        int m_iHistoryIndex = 0;
+        bool m_bHistoryValid = false;
+        glm::mat4 m_mat4PrevViewProjection = glm::mat4(1.0f);
+        unsigned int m_uiFrame = 0;
 
-        // Configures uniforms for the blur to run correctly for the given kernel,
-        // using the given buffer as the source image. After this, you can draw onto
-        // another separate SsaoBuffer to get the blurred result.
-        void configureWith(SsaoKernel& kernel, SsaoBuffer& buffer);
+        void allocateLowResTargets();
+        void dispatch(Shader& shader, ImageSize size);
     };
 
 }  // namespace Cme
@@ -1,16 +1,29 @@
 #include "ssao_kernel.h"
 #include "../common_helper.h"
 
+#include <algorithm>
+#include <string>
+
 namespace Cme
 {
     SsaoKernel::SsaoKernel(float radius, float bias, int kernelSize, int noiseTextureSideLength)
     {
         m_fRadius = radius;
         m_fBias = bias;
-        GenerateNoiseTexture(kernelSize, noiseTextureSideLength);
+        GenerateKernel(kernelSize);
+        GenerateNoiseTexture(noiseTextureSideLength);
     }
 
-    void SsaoKernel::GenerateNoiseTexture(int kernelSize, int noiseTextureSideLength)
+    void SsaoKernel::setSize(int kernelSize)
+    {
+        kernelSize = std::clamp(kernelSize, 1, MAX_SSAO_KERNEL_SIZE);
+        if (kernelSize != getSize())
+        {
+            GenerateKernel(kernelSize);
+        }
+    }
+
+    void SsaoKernel::GenerateKernel(int kernelSize)
     {
         m_vecKernel.resize(kernelSize);
         //  ȡһӵ64ֵĲ
@@ -34,6 +47,10 @@ namespace Cme
 
             m_vecKernel[i] = sample;
         }
+    }
+
+    void SsaoKernel::GenerateNoiseTexture(int noiseTextureSideLength)
+    {
 
         // ת һСתƽĻ
         std::vector<glm::vec3> vecNoiseData;
@@ -53,7 +70,8 @@ namespace Cme
         params.filtering = TextureFiltering::NEAREST;
         params.wrapMode = TextureWrapMode::REPEAT;
 
-        //m_NoiseTextureObj = Texture::createFromData(noiseTextureSideLength, noiseTextureSideLength, GL_RGB16F, vecNoiseData, params);
+        params.generateMips = MipGeneration::NEVER;
+        m_NoiseTextureObj.createFromData(noiseTextureSideLength, noiseTextureSideLength, GL_RGB16F, vecNoiseData, params);
     }
 
     unsigned int SsaoKernel::bindTexture(unsigned int nextTextureUnit, Shader& shader)
@@ -64,5 +82,16 @@ namespace Cme
 
         return nextTextureUnit + 1;
     }
+
+    void SsaoKernel::updateUniforms(Shader& shader)
+    {
+        shader.setFloat("qrk_ssaoSampleRadius", m_fRadius);
+        shader.setFloat("qrk_ssaoSampleBias", m_fBias);
+        shader.setInt("qrk_ssaoKernelSize", getSize());
+        for (int i = 0; i < getSize(); ++i)
+        {
+            shader.setVec3("qrk_ssaoKernel[" + std::to_string(i) + "]", m_vecKernel[i]);
+        }
+    }
 }
 
@@ -6,14 +6,20 @@
 
 namespace Cme
 {
+    // Must match QRK_MAX_SSAO_KERNEL_SIZE in ssao.comp.
+    constexpr int MAX_SSAO_KERNEL_SIZE = 64;
+
     // SsaoKernel
     // A sample kernel for use in screen space ambient occlusion. Uses a hemisphere
     // sampling method and a noise texture.
     class SsaoKernel
     {
     public:
-        SsaoKernel(float radius = 0.5, float bias = 0.025, int kernelSize = 64, int noiseTextureSideLength = 4);
+        SsaoKernel(float radius = 0.5, float bias = 0.025, int kernelSize = 16, int noiseTextureSideLength = 4);
         int getSize() { return m_vecKernel.size(); }
+        // Regenerates the kernel with the given number of samples, at most
+        // MAX_SSAO_KERNEL_SIZE.
+        void setSize(int kernelSize);
         int getNoiseTextureSideLength() { return m_NoiseTextureObj.getWidth(); }
         float getRadius() { return m_fRadius; }
         void setRadius(float radius) { m_fRadius = radius; }
@@ -22,11 +28,14 @@ namespace Cme
 
         // Binds the noise texture.
         unsigned int bindTexture(unsigned int nextTextureUnit, Shader& shader);
+        // Sets the kernel, radius and bias uniforms.
+        void updateUniforms(Shader& shader);
 
     private:
+        void GenerateKernel(int kernelSize);
         // TODO: Expose this after texture lifecycle is handled (currently
         // regenerating would cause orphaned textures).
-        void GenerateNoiseTexture(int kernelSize, int noiseTextureSideLength);
+        void GenerateNoiseTexture(int noiseTextureSideLength);
 
         float m_fRadius;
         float m_fBias;
@@ -1,13 +1,59 @@
 #include "App.h"
+#include "core/frame_clock.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <cstdlib>
+#include <cstring>
+
 int main(int argc, char** argv)
 {
     //auto app = Cme::App::Instance();
     Cme::App app;
-    app.Init(false);
-    app.Run();
 
-    return 0;
+    // Command line:
+    //   --benchmark <script>  run the scripted benchmark in a hidden window.
+    //                         The exit code is non-zero when a metric
+    //                         regressed. Needs a display server, such as
+    //                         Xvfb on CI machines.
+    //   --record <log>        record deltas, camera and options of the session.
+    //   --replay <log>        replay a recorded session and exit at its end.
+    //   --fixed-step <sec>    advance the clock by a fixed step every frame.
+    try
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char* option = argv[i];
+            const char* value = argv[i + 1];
+            if (std::strcmp(option, "--benchmark") == 0)
+            {
+                app.SetBenchmark(std::make_shared<Cme::Benchmark>(value));
+            }
+            else if (std::strcmp(option, "--record") == 0)
+            {
+                app.SetRecorder(std::make_shared<Cme::SessionRecorder>(value));
+            }
+            else if (std::strcmp(option, "--replay") == 0)
+            {
+                app.SetReplayer(std::make_shared<Cme::SessionReplayer>(value));
+            }
+            else if (std::strcmp(option, "--fixed-step") == 0)
+            {
+                Cme::FrameClock::GetInstance().SetFixedTimestep(static_cast<float>(std::atof(value)));
+            }
+            else
+            {
+                std::cerr << "Unknown option " << option << std::endl;
+                return 2;
+            }
+        }
+    }
+    catch (const Cme::QuarkException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    app.Init(false);
+    return app.Run() ? 0 : 1;
 }
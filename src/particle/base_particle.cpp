@@ -0,0 +1,15 @@
+#include "base_particle.h"
+
+namespace Cme
+{
+    ParticleProperty::ParticleProperty()
+        : position(0.0f), velocity(0.0f), color(1.0f), size(1.0f), rotation(0.0f),
+        u_offset(0.0f), v_offset(0.0f), texture_scale(1.0f)
+    {
+    }
+
+    void BaseParticle::err(std::string const& msg)
+    {
+        std::cerr << "ERROR::PARTICLE::" << msg << std::endl;
+    }
+}
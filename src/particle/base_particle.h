@@ -11,6 +11,7 @@ namespace Cme
     struct ParticleProperty
     {
         glm::vec3 position;
+        glm::vec3 velocity;
         glm::vec4 color;
         float size, rotation;
         float u_offset, v_offset, texture_scale;
@@ -18,6 +19,9 @@ namespace Cme
         ParticleProperty();
     };
 
+    // Called with the particle, its remaining life in seconds and its id.
+    // Returning false discards a new particle, or kills an updated one. The
+    // update also gets the time step.
     using ParticleSpawnFn_t = std::function<bool(ParticleProperty&, float&, int id)>;
     using ParticleUpdateFn_t = std::function<bool(ParticleProperty&, float&, float, int id)>;
 
@@ -0,0 +1,378 @@
+#include "cpu_particle_system.h"
+#include "../profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace Cme
+{
+    namespace
+    {
+        // Particles per job. Chunks are independent of the thread count, so
+        // the results are too.
+        constexpr size_t PARTICLE_CHUNK_SIZE = 4096;
+        // Births are capped to this frame time, so a stall doesn't release a
+        // burst of particles at once.
+        constexpr float MAX_BIRTH_DELTA = 0.05f;
+        constexpr float TWO_PI = 6.28318531f;
+
+        // Layout of a particle instance in the stream buffer.
+        struct ParticleInstance
+        {
+            glm::vec4 positionSize;
+            glm::vec4 color;
+        };
+    }
+
+    void ParticleStreams::Resize(size_t count)
+    {
+        for (auto* stream : { &posX, &posY, &posZ, &velX, &velY, &velZ,
+                              &colorR, &colorG, &colorB, &colorA, &size, &life })
+        {
+            stream->assign(count, 0.0f);
+        }
+        id.assign(count, 0);
+    }
+
+    void ParticleStreams::Move(size_t from, size_t to)
+    {
+        posX[to] = posX[from];
+        posY[to] = posY[from];
+        posZ[to] = posZ[from];
+        velX[to] = velX[from];
+        velY[to] = velY[from];
+        velZ[to] = velZ[from];
+        colorR[to] = colorR[from];
+        colorG[to] = colorG[from];
+        colorB[to] = colorB[from];
+        colorA[to] = colorA[from];
+        size[to] = size[from];
+        life[to] = life[from];
+        id[to] = id[from];
+    }
+
+    ParticleProperty ParticleStreams::Get(size_t i) const
+    {
+        ParticleProperty property;
+        property.position = glm::vec3(posX[i], posY[i], posZ[i]);
+        property.velocity = glm::vec3(velX[i], velY[i], velZ[i]);
+        property.color = glm::vec4(colorR[i], colorG[i], colorB[i], colorA[i]);
+        property.size = size[i];
+        return property;
+    }
+
+    void ParticleStreams::Set(size_t i, const ParticleProperty& property)
+    {
+        posX[i] = property.position.x;
+        posY[i] = property.position.y;
+        posZ[i] = property.position.z;
+        velX[i] = property.velocity.x;
+        velY[i] = property.velocity.y;
+        velZ[i] = property.velocity.z;
+        colorR[i] = property.color.r;
+        colorG[i] = property.color.g;
+        colorB[i] = property.color.b;
+        colorA[i] = property.color.a;
+        size[i] = property.size;
+    }
+
+    CpuParticleSystem::CpuParticleSystem(unsigned int numThreads, uint32_t seed)
+        : m_ThreadPoolObj(numThreads), m_RandomObj(seed)
+    {
+        max_particles = 0;
+        birth_rate = 0.0f;
+        m_uiParticleCount = 0;
+        m_spCamera = std::make_shared<Camera>();
+    }
+
+    CpuParticleSystem::~CpuParticleSystem()
+    {
+        glDeleteVertexArrays(1, &m_uiVao);
+        delete m_pShader;
+    }
+
+    void CpuParticleSystem::InitPS(float*, unsigned int, unsigned int tex, float*, bool)
+    {
+        if (m_pShader == nullptr)
+        {
+            m_pShader = new Shader(Cme::ShaderPath("assets//shaders//cpu_particle.vert"),
+                                   Cme::ShaderPath("assets//shaders//cpu_particle.frag"));
+        }
+        m_pShader->setInt("sprite", 0);
+        m_pShader->deactivate();
+        m_uiSprite = tex;
+
+        m_Streams.Resize(max_particles);
+        m_uiParticleCount = 0;
+        m_upStreamBuffer = std::make_unique<StreamBuffer>(
+            std::max<GLsizeiptr>(max_particles, 1) * sizeof(ParticleInstance));
+
+        // One instance per particle, the quad corners come from gl_VertexID.
+        if (m_uiVao == 0)
+        {
+            glGenVertexArrays(1, &m_uiVao);
+            glBindVertexArray(m_uiVao);
+            glVertexAttribFormat(0, 4, GL_FLOAT, GL_FALSE, offsetof(ParticleInstance, positionSize));
+            glVertexAttribBinding(0, 0);
+            glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, offsetof(ParticleInstance, color));
+            glVertexAttribBinding(1, 0);
+            glVertexBindingDivisor(0, 1);
+            glEnableVertexAttribArray(0);
+            glEnableVertexAttribArray(1);
+            glBindVertexArray(0);
+        }
+    }
+
+    void CpuParticleSystem::ActivateTexture(unsigned int tex, float*, bool)
+    {
+        m_uiSprite = tex;
+    }
+
+    void CpuParticleSystem::Restart()
+    {
+        m_uiParticleCount = 0;
+        m_fBirthDebt = 0.0f;
+    }
+
+    void CpuParticleSystem::ParallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& fn)
+    {
+        if (end - begin <= PARTICLE_CHUNK_SIZE)
+        {
+            if (end > begin)
+            {
+                fn(begin, end);
+            }
+            return;
+        }
+        // The calling thread takes the last chunk instead of idling.
+        size_t chunkBegin = begin;
+        for (; chunkBegin + PARTICLE_CHUNK_SIZE < end; chunkBegin += PARTICLE_CHUNK_SIZE)
+        {
+            size_t chunkEnd = chunkBegin + PARTICLE_CHUNK_SIZE;
+            m_ThreadPoolObj.Submit([&fn, chunkBegin, chunkEnd]() { fn(chunkBegin, chunkEnd); });
+        }
+        fn(chunkBegin, end);
+        m_ThreadPoolObj.WaitIdle();
+    }
+
+    void CpuParticleSystem::DefaultSpawn(size_t begin, size_t end)
+    {
+        ParticleStreams& s = m_Streams;
+        const ParticleRandom& random = m_RandomObj;
+        float* px = s.posX.data();
+        float* py = s.posY.data();
+        float* pz = s.posZ.data();
+        float* vx = s.velX.data();
+        float* vy = s.velY.data();
+        float* vz = s.velZ.data();
+        float* life = s.life.data();
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t id = s.id[i];
+            // Uniform over the cone's cap.
+            float theta = spread * std::sqrt(random.Uniform(id, 0));
+            float phi = TWO_PI * random.Uniform(id, 1);
+            float v = speed * random.Range(id, 2, 0.75f, 1.0f);
+            px[i] = emitter_position.x;
+            py[i] = emitter_position.y;
+            pz[i] = emitter_position.z;
+            vx[i] = v * std::sin(theta) * std::cos(phi);
+            vy[i] = v * std::cos(theta);
+            vz[i] = v * std::sin(theta) * std::sin(phi);
+            life[i] = lifetime + random.Range(id, 3, -lifetime_variance, lifetime_variance);
+        }
+        std::fill(s.colorR.begin() + begin, s.colorR.begin() + end, color.r);
+        std::fill(s.colorG.begin() + begin, s.colorG.begin() + end, color.g);
+        std::fill(s.colorB.begin() + begin, s.colorB.begin() + end, color.b);
+        std::fill(s.colorA.begin() + begin, s.colorA.begin() + end, color.a);
+        std::fill(s.size.begin() + begin, s.size.begin() + end, size);
+    }
+
+    void CpuParticleSystem::DefaultUpdate(size_t begin, size_t end, float deltaTime)
+    {
+        ParticleStreams& s = m_Streams;
+        float* px = s.posX.data();
+        float* py = s.posY.data();
+        float* pz = s.posZ.data();
+        float* vx = s.velX.data();
+        float* vy = s.velY.data();
+        float* vz = s.velZ.data();
+        float* alpha = s.colorA.data();
+        float* life = s.life.data();
+        const glm::vec3 dv = acceleration * deltaTime;
+        const float fadeRate = 1.0f / std::max(lifetime * 0.25f, 1e-3f);
+        // One stream per statement and no branches, so each loop vectorizes.
+        for (size_t i = begin; i < end; ++i)
+        {
+            vx[i] += dv.x;
+            vy[i] += dv.y;
+            vz[i] += dv.z;
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            px[i] += vx[i] * deltaTime;
+            py[i] += vy[i] * deltaTime;
+            pz[i] += vz[i] * deltaTime;
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            life[i] -= deltaTime;
+            // Fades out over the last quarter of the lifetime.
+            alpha[i] = std::min(alpha[i], std::max(life[i] * fadeRate, 0.0f));
+        }
+    }
+
+    void CpuParticleSystem::SpawnCallbacks(size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            ParticleProperty property = m_Streams.Get(i);
+            float& life = m_Streams.life[i];
+            if (spawn_fn(property, life, static_cast<int>(m_Streams.id[i])))
+            {
+                m_Streams.Set(i, property);
+            }
+            else
+            {
+                life = 0.0f;
+            }
+        }
+    }
+
+    void CpuParticleSystem::UpdateCallbacks(size_t begin, size_t end, float deltaTime)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            ParticleProperty property = m_Streams.Get(i);
+            float& life = m_Streams.life[i];
+            if (life > 0.0f && update_fn(property, life, deltaTime, static_cast<int>(m_Streams.id[i])))
+            {
+                m_Streams.Set(i, property);
+            }
+            else
+            {
+                life = 0.0f;
+            }
+        }
+    }
+
+    void CpuParticleSystem::Compact(size_t begin)
+    {
+        // Keeps the order of the survivors, so the results don't depend on
+        // how the chunks were scheduled.
+        size_t alive = begin;
+        for (size_t i = begin; i < m_uiParticleCount; ++i)
+        {
+            if (m_Streams.life[i] > 0.0f)
+            {
+                if (i != alive)
+                {
+                    m_Streams.Move(i, alive);
+                }
+                ++alive;
+            }
+        }
+        m_uiParticleCount = static_cast<unsigned int>(alive);
+    }
+
+    void CpuParticleSystem::Update(float fDelta, float)
+    {
+        if (m_Streams.life.size() != max_particles)
+        {
+            m_Streams.Resize(max_particles);
+            m_uiParticleCount = 0;
+        }
+
+        ParallelFor(0, m_uiParticleCount, [this, fDelta](size_t begin, size_t end)
+        {
+            if (update_kernel)
+            {
+                update_kernel(m_Streams, begin, end, fDelta, m_RandomObj);
+            }
+            else
+            {
+                DefaultUpdate(begin, end, fDelta);
+            }
+            if (update_fn)
+            {
+                UpdateCallbacks(begin, end, fDelta);
+            }
+        });
+        Compact(0);
+
+        m_fBirthDebt += std::min(MAX_BIRTH_DELTA, fDelta) * birth_rate;
+        unsigned int births = static_cast<unsigned int>(m_fBirthDebt);
+        m_fBirthDebt -= static_cast<float>(births);
+        births = std::min(births, max_particles - m_uiParticleCount);
+
+        size_t first = m_uiParticleCount;
+        for (size_t i = first; i < first + births; ++i)
+        {
+            m_Streams.id[i] = m_uiNextId++;
+        }
+        ParallelFor(first, first + births, [this](size_t begin, size_t end)
+        {
+            if (spawn_kernel)
+            {
+                spawn_kernel(m_Streams, begin, end, 0.0f, m_RandomObj);
+            }
+            else
+            {
+                DefaultSpawn(begin, end);
+            }
+            if (spawn_fn)
+            {
+                SpawnCallbacks(begin, end);
+            }
+        });
+        m_uiParticleCount += births;
+        // Births that spawn_fn rejected, or a spawn kernel gave no life.
+        Compact(first);
+    }
+
+    void CpuParticleSystem::Render(GLenum)
+    {
+        if (m_uiParticleCount == 0 || !m_upStreamBuffer)
+        {
+            return;
+        }
+
+        // Interleaved for the vertex format, and written in sequential chunks,
+        // which is what write-combined mapped memory wants.
+        ParticleInstance* pInstances = static_cast<ParticleInstance*>(m_upStreamBuffer->BeginRegion());
+        ParallelFor(0, m_uiParticleCount, [this, pInstances](size_t begin, size_t end)
+        {
+            const ParticleStreams& s = m_Streams;
+            for (size_t i = begin; i < end; ++i)
+            {
+                pInstances[i].positionSize = glm::vec4(s.posX[i], s.posY[i], s.posZ[i], s.size[i]);
+                pInstances[i].color = glm::vec4(s.colorR[i], s.colorG[i], s.colorB[i], s.colorA[i]);
+            }
+        });
+
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+        m_pShader->activate();
+        m_pShader->setMat4("view", m_spCamera->getViewTransform());
+        m_pShader->setMat4("proj", m_spCamera->getProjectionTransform());
+        m_pShader->setBool("useSprite", m_uiSprite != 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_uiSprite);
+
+        glBindVertexArray(m_uiVao);
+        glBindVertexBuffer(0, m_upStreamBuffer->GetBufferID(), m_upStreamBuffer->GetRegionOffset(),
+                           sizeof(ParticleInstance));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_uiParticleCount);
+        Profiler::GetInstance().CountDrawCall();
+        glBindVertexArray(0);
+        m_upStreamBuffer->EndRegion();
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_pShader->deactivate();
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+}
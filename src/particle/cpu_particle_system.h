@@ -0,0 +1,153 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "base_particle.h"
+#include "../camera.h"
+#include "../shader/shader.h"
+#include "../core/stream_buffer.h"
+#include "../core/thread_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace Cme
+{
+    // Counter based random numbers. A value is a hash of the seed, a particle
+    // id and a counter, so a particle draws the same numbers no matter which
+    // thread runs it or in what order.
+    class ParticleRandom
+    {
+    public:
+        explicit ParticleRandom(uint32_t seed = 0) : m_uiSeed(seed) {}
+
+        uint32_t Next(uint32_t id, uint32_t counter) const
+        {
+            return Mix(id + Mix(counter + Mix(m_uiSeed)));
+        }
+        // Uniform in [0, 1).
+        float Uniform(uint32_t id, uint32_t counter) const
+        {
+            return static_cast<float>(Next(id, counter) >> 8) * (1.0f / 16777216.0f);
+        }
+        float Range(uint32_t id, uint32_t counter, float min, float max) const
+        {
+            return min + (max - min) * Uniform(id, counter);
+        }
+
+    private:
+        static uint32_t Mix(uint32_t x)
+        {
+            x ^= x >> 16;
+            x *= 0x7feb352du;
+            x ^= x >> 15;
+            x *= 0x846ca68bu;
+            x ^= x >> 16;
+            return x;
+        }
+
+        uint32_t m_uiSeed;
+    };
+
+    // Particle attributes as structure of arrays, so kernels run plain loops
+    // over contiguous floats that the compiler can vectorize.
+    struct ParticleStreams
+    {
+        std::vector<float> posX, posY, posZ;
+        std::vector<float> velX, velY, velZ;
+        std::vector<float> colorR, colorG, colorB, colorA;
+        std::vector<float> size;
+        // Remaining life in seconds, the particle dies at 0.
+        std::vector<float> life;
+        // Serial number of the particle's birth, the key of its random numbers.
+        std::vector<uint32_t> id;
+
+        void Resize(size_t count);
+        // Copies particle `from` over particle `to`.
+        void Move(size_t from, size_t to);
+        ParticleProperty Get(size_t i) const;
+        void Set(size_t i, const ParticleProperty& property);
+    };
+
+    // Runs over particles [begin, end). Chunks run concurrently, so a kernel
+    // may only write the particles of its range.
+    using ParticleKernel_t = std::function<void(ParticleStreams&, size_t begin, size_t end,
+                                                float deltaTime, const ParticleRandom& random)>;
+
+    // Particles simulated on the CPU, for machines without compute shaders and
+    // effects that gameplay code reads or drives.
+    //
+    // Each Update() runs in fixed size chunks on a thread pool:
+    //  1. The update kernel, by default gravity and aging, followed by
+    //     update_fn for every particle if it is set.
+    //  2. Dead particles are compacted away.
+    //  3. Births of birth_rate, placed by the spawn kernel, by default a cone
+    //     around emitter_position, followed by spawn_fn if it is set.
+    //     Births without life are compacted away again.
+    // Chunks don't depend on the thread count, and random numbers on the
+    // particle ids, so a simulation is deterministic. Update() makes no GL
+    // calls. Render() streams the particles into a persistently mapped buffer
+    // and draws them as instanced quads.
+    class CpuParticleSystem : public BaseParticle
+    {
+    public:
+        // Zero threads picks one per hardware thread, minus the calling thread,
+        // which also takes a chunk.
+        explicit CpuParticleSystem(unsigned int numThreads = 0, uint32_t seed = 0);
+        ~CpuParticleSystem();
+
+        glm::vec3 emitter_position = glm::vec3(0.0f);
+        glm::vec3 acceleration = glm::vec3(0.0f, -1.0f, 0.0f);
+        // Initial speed, within a cone of spread radians around +Y.
+        float speed = 1.5f;
+        float spread = 0.4f;
+        // Lifetime in seconds, randomized by +-variance.
+        float lifetime = 2.0f;
+        float lifetime_variance = 0.5f;
+        float size = 0.02f;
+        glm::vec4 color = glm::vec4(1.0f, 0.5f, 0.1f, 1.0f);
+
+        // Replace the built in kernels. An empty kernel restores the default.
+        // A spawn kernel has to set the life of its particles, those without
+        // any are dropped right away.
+        ParticleKernel_t spawn_kernel;
+        ParticleKernel_t update_kernel;
+
+        // Allocates `max_particles`. `tex` is the sprite, 0 draws soft discs.
+        void InitPS(float* vertex, unsigned int v_count,
+                    unsigned int tex = 0, float* uv = nullptr, bool atlas = false) override;
+        void ActivateTexture(unsigned int tex = 0, float* uv = nullptr, bool atlas = false) override;
+        void Restart() override;
+        void Update(float fDelta, float fTime) override;
+        void Render(GLenum gl_draw_mode = GL_POINT) override;
+
+        unsigned int total() const noexcept override { return max_particles; }
+        // The first count() particles are alive.
+        const ParticleStreams& getStreams() const { return m_Streams; }
+        void SetCamera(std::shared_ptr<Camera> spCamera) { m_spCamera = spCamera; }
+
+    private:
+        // Runs `fn` over [begin, end) in chunks of PARTICLE_CHUNK_SIZE.
+        void ParallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& fn);
+        void DefaultSpawn(size_t begin, size_t end);
+        void DefaultUpdate(size_t begin, size_t end, float deltaTime);
+        // Runs spawn_fn or update_fn on each particle of the range.
+        void SpawnCallbacks(size_t begin, size_t end);
+        void UpdateCallbacks(size_t begin, size_t end, float deltaTime);
+        // Removes dead particles from [begin, count()).
+        void Compact(size_t begin);
+
+        ThreadPool m_ThreadPoolObj;
+        ParticleRandom m_RandomObj;
+        ParticleStreams m_Streams;
+        uint32_t m_uiNextId = 0;
+        // Fraction of a particle carried over to the next frame's births.
+        float m_fBirthDebt = 0.0f;
+
+        // Per instance position and size, then color.
+        std::unique_ptr<StreamBuffer> m_upStreamBuffer;
+        GLuint m_uiVao = 0;
+        Shader* m_pShader = nullptr;
+        unsigned int m_uiSprite = 0;
+        std::shared_ptr<Camera> m_spCamera;
+    };
+}
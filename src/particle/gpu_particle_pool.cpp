@@ -0,0 +1,316 @@
+#include "gpu_particle_pool.h"
+#include "../profiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+
+namespace Cme
+{
+    namespace
+    {
+        // Births are capped to this frame time, so a stall doesn't release a
+        // burst of particles at once.
+        constexpr float MAX_BIRTH_DELTA = 0.05f;
+
+        // Stages of particle_args.comp.
+        constexpr int PARTICLE_ARGS_EMIT = 0;
+        constexpr int PARTICLE_ARGS_SIMULATE = 1;
+        constexpr int PARTICLE_ARGS_DRAW = 2;
+
+        // Stages of particle_sort.comp.
+        constexpr int PARTICLE_SORT_KEYS = 0;
+        constexpr int PARTICLE_SORT_LOCAL = 1;
+        constexpr int PARTICLE_SORT_GLOBAL = 2;
+        constexpr int PARTICLE_SORT_MERGE = 3;
+        constexpr int PARTICLE_SORT_WRITE = 4;
+        // Threads per work group, and the entries a group sorts in shared
+        // memory, as in particle_sort.comp.
+        constexpr unsigned int PARTICLE_SORT_LOCAL_SIZE = 256;
+        constexpr unsigned int PARTICLE_SORT_BLOCK = 2 * PARTICLE_SORT_LOCAL_SIZE;
+
+        // Layout of QrkParticleSortEntry in particle_sort.comp.
+        struct GpuParticleSortEntry
+        {
+            GLfloat depth;
+            GLuint particle;
+        };
+
+        // Group counts are powers of two, so halving x until it fits the limit
+        // splits them evenly into x and y.
+        void dispatchSort(Shader& shader, int stage, GLuint groups, GLuint maxGroupsX)
+        {
+            GLuint groupsX = groups;
+            while (groupsX > maxGroupsX)
+            {
+                groupsX /= 2;
+            }
+            shader.setInt("qrk_particleSortStage", stage);
+            shader.activate();
+            glDispatchCompute(groupsX, groups / groupsX, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        // Layout of QrkParticleEmitter in particle_pool.glsl.
+        struct GpuParticleEmitter
+        {
+            glm::vec4 positionSpeed;
+            glm::vec4 lifetime;
+            glm::uvec4 births;
+        };
+
+        // Layout of QrkParticleCounters in particle_pool.glsl.
+        struct GpuParticleCounters
+        {
+            GLuint emitArgs[3];
+            GLuint simulateArgs[3];
+            GLuint drawArgs[4];
+            GLint deadCount;
+            GLuint aliveCount[2];
+            GLuint emitCount;
+            GLuint quadDrawArgs[4];
+        };
+        constexpr GLintptr EMIT_ARGS_OFFSET = offsetof(GpuParticleCounters, emitArgs);
+        constexpr GLintptr SIMULATE_ARGS_OFFSET = offsetof(GpuParticleCounters, simulateArgs);
+        constexpr GLintptr DRAW_ARGS_OFFSET = offsetof(GpuParticleCounters, drawArgs);
+        constexpr GLintptr QUAD_DRAW_ARGS_OFFSET = offsetof(GpuParticleCounters, quadDrawArgs);
+    }
+
+    GpuParticlePool::GpuParticlePool(unsigned int capacity)
+        : m_uiCapacity(capacity),
+        m_ArgsShaderObj(ShaderPath("assets//shaders//builtin//particle_args.comp")),
+        m_SortShaderObj(ShaderPath("assets//shaders//builtin//particle_sort.comp"))
+    {
+        glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &m_iMaxGroupsX);
+
+        const GLsizeiptr attributeSize = static_cast<GLsizeiptr>(capacity) * sizeof(glm::vec4);
+        glCreateBuffers(1, &m_uiPositionBuffer);
+        glNamedBufferStorage(m_uiPositionBuffer, attributeSize, nullptr, 0);
+        glCreateBuffers(1, &m_uiVelocityBuffer);
+        glNamedBufferStorage(m_uiVelocityBuffer, attributeSize, nullptr, 0);
+        glCreateBuffers(1, &m_uiDeltaBuffer);
+        glNamedBufferStorage(m_uiDeltaBuffer, attributeSize, nullptr, 0);
+        glCreateBuffers(1, &m_uiEmitterBuffer);
+        glNamedBufferStorage(m_uiEmitterBuffer, MAX_PARTICLE_EMITTERS * sizeof(GpuParticleEmitter),
+                             nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        const GLsizeiptr listSize = static_cast<GLsizeiptr>(capacity) * sizeof(GLuint);
+        glCreateBuffers(1, &m_uiCounterBuffer);
+        glNamedBufferStorage(m_uiCounterBuffer, sizeof(GpuParticleCounters), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glCreateBuffers(1, &m_uiAliveListBuffer);
+        glNamedBufferStorage(m_uiAliveListBuffer, 2 * listSize, nullptr, 0);
+        glCreateBuffers(1, &m_uiDeadListBuffer);
+        glNamedBufferStorage(m_uiDeadListBuffer, listSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        ResetLists();
+
+        // Whole blocks, and a power of two for the bitonic network.
+        m_uiSortSize = PARTICLE_SORT_BLOCK;
+        while (m_uiSortSize < capacity)
+        {
+            m_uiSortSize *= 2;
+        }
+        glCreateBuffers(1, &m_uiSortBuffer);
+        glNamedBufferStorage(m_uiSortBuffer, static_cast<GLsizeiptr>(m_uiSortSize) * sizeof(GpuParticleSortEntry),
+                             nullptr, 0);
+
+        // The draw fetches the particles from the buffers, but core profile
+        // still needs a vertex array bound.
+        glGenVertexArrays(1, &m_uiVao);
+    }
+
+    GpuParticlePool::~GpuParticlePool()
+    {
+        glDeleteVertexArrays(1, &m_uiVao);
+        glDeleteBuffers(1, &m_uiPositionBuffer);
+        glDeleteBuffers(1, &m_uiVelocityBuffer);
+        glDeleteBuffers(1, &m_uiDeltaBuffer);
+        glDeleteBuffers(1, &m_uiEmitterBuffer);
+        glDeleteBuffers(1, &m_uiCounterBuffer);
+        glDeleteBuffers(1, &m_uiAliveListBuffer);
+        glDeleteBuffers(1, &m_uiDeadListBuffer);
+        glDeleteBuffers(1, &m_uiSortBuffer);
+    }
+
+    int GpuParticlePool::AddEmitter(const ParticleEmitter& emitter)
+    {
+        if (m_vecEmitters.size() >= MAX_PARTICLE_EMITTERS)
+        {
+            return -1;
+        }
+        EmitterState state;
+        state.params = emitter;
+        m_vecEmitters.push_back(state);
+        return static_cast<int>(m_vecEmitters.size()) - 1;
+    }
+
+    void GpuParticlePool::Restart()
+    {
+        for (EmitterState& emitter : m_vecEmitters)
+        {
+            emitter.debt = 0.0f;
+        }
+        ResetLists();
+    }
+
+    void GpuParticlePool::ResetLists()
+    {
+        std::vector<GLuint> deadList(m_uiCapacity);
+        std::iota(deadList.begin(), deadList.end(), 0u);
+        glNamedBufferSubData(m_uiDeadListBuffer, 0, deadList.size() * sizeof(GLuint), deadList.data());
+
+        GpuParticleCounters counters = {};
+        counters.deadCount = static_cast<GLint>(m_uiCapacity);
+        glNamedBufferSubData(m_uiCounterBuffer, 0, sizeof(counters), &counters);
+        m_uiAliveList = 0;
+    }
+
+    void GpuParticlePool::BindBuffers() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_POSITION_BUFFER_BINDING, m_uiPositionBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_VELOCITY_BUFFER_BINDING, m_uiVelocityBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_DELTA_BUFFER_BINDING, m_uiDeltaBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_EMITTER_BUFFER_BINDING, m_uiEmitterBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_COUNTER_BUFFER_BINDING, m_uiCounterBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_ALIVE_LIST_BUFFER_BINDING, m_uiAliveListBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_DEAD_LIST_BUFFER_BINDING, m_uiDeadListBuffer);
+    }
+
+    unsigned int GpuParticlePool::UploadEmitters(float deltaTime)
+    {
+        std::vector<GpuParticleEmitter> gpuEmitters;
+        gpuEmitters.reserve(m_vecEmitters.size());
+        unsigned int totalBirths = 0;
+        for (EmitterState& emitter : m_vecEmitters)
+        {
+            // More births than the pool holds can never be served.
+            emitter.debt += std::min(MAX_BIRTH_DELTA, deltaTime) * emitter.params.birthRate;
+            emitter.debt = std::min(emitter.debt, static_cast<float>(m_uiCapacity));
+            unsigned int births = static_cast<unsigned int>(emitter.debt);
+            emitter.debt -= static_cast<float>(births);
+            births = std::min(births, m_uiCapacity - std::min(totalBirths, m_uiCapacity));
+
+            GpuParticleEmitter gpuEmitter;
+            gpuEmitter.positionSpeed = glm::vec4(emitter.params.position, emitter.params.speed);
+            gpuEmitter.lifetime = glm::vec4(emitter.params.lifetime, emitter.params.lifetimeVariance, 0.0f, 0.0f);
+            gpuEmitter.births = glm::uvec4(births, totalBirths, 0, 0);
+            gpuEmitters.push_back(gpuEmitter);
+            totalBirths += births;
+        }
+        if (!gpuEmitters.empty())
+        {
+            glNamedBufferSubData(m_uiEmitterBuffer, 0, gpuEmitters.size() * sizeof(GpuParticleEmitter),
+                                 gpuEmitters.data());
+        }
+        return totalBirths;
+    }
+
+    void GpuParticlePool::WriteArgs(int stage)
+    {
+        m_ArgsShaderObj.setInt("qrk_particleArgsStage", stage);
+        m_ArgsShaderObj.setUInt("qrk_particleCurrentList", m_uiAliveList);
+        m_ArgsShaderObj.activate();
+        glDispatchCompute(1, 1, 1);
+        // The next stage reads the sizes as indirect arguments, and the counts
+        // from the shader.
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void GpuParticlePool::Simulate(Shader& simulation, float deltaTime)
+    {
+        const unsigned int births = UploadEmitters(deltaTime);
+
+        BindBuffers();
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_uiCounterBuffer);
+        m_ArgsShaderObj.setUInt("qrk_maxParticleGroupsX", static_cast<unsigned int>(m_iMaxGroupsX));
+        simulation.setUInt("qrk_particleCapacity", m_uiCapacity);
+        simulation.setUInt("qrk_numParticleEmitters", static_cast<unsigned int>(m_vecEmitters.size()));
+        simulation.setUInt("qrk_particleCurrentList", m_uiAliveList);
+        simulation.setFloat("dt", deltaTime);
+
+        // Emission, as many threads as there are births and dead particles.
+        if (births > 0)
+        {
+            m_ArgsShaderObj.setUInt("qrk_particleBirths", births);
+            WriteArgs(PARTICLE_ARGS_EMIT);
+            simulation.setBool("qrk_particleEmit", true);
+            glDispatchComputeIndirect(EMIT_ARGS_OFFSET);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        // Simulation over the alive list, which also holds the new births.
+        WriteArgs(PARTICLE_ARGS_SIMULATE);
+        simulation.setBool("qrk_particleEmit", false);
+        glDispatchComputeIndirect(SIMULATE_ARGS_OFFSET);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        simulation.deactivate();
+
+        // The survivors are the current particles from here on.
+        m_uiAliveList = 1 - m_uiAliveList;
+        WriteArgs(PARTICLE_ARGS_DRAW);
+        m_ArgsShaderObj.deactivate();
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    }
+
+    void GpuParticlePool::Draw(Shader& shader)
+    {
+        BindBuffers();
+        shader.setUInt("qrk_particleCapacity", m_uiCapacity);
+        shader.setUInt("qrk_particleCurrentList", m_uiAliveList);
+
+        glBindVertexArray(m_uiVao);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_uiCounterBuffer);
+        glDrawArraysIndirect(GL_POINTS, reinterpret_cast<const void*>(DRAW_ARGS_OFFSET));
+        Profiler::GetInstance().CountDrawCall();
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void GpuParticlePool::DrawQuads(Shader& shader)
+    {
+        BindBuffers();
+        shader.setUInt("qrk_particleCapacity", m_uiCapacity);
+        shader.setUInt("qrk_particleCurrentList", m_uiAliveList);
+
+        glBindVertexArray(m_uiVao);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_uiCounterBuffer);
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, reinterpret_cast<const void*>(QUAD_DRAW_ARGS_OFFSET));
+        Profiler::GetInstance().CountDrawCall();
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void GpuParticlePool::Sort(const glm::mat4& modelView)
+    {
+        BindBuffers();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_SORT_BUFFER_BINDING, m_uiSortBuffer);
+        m_SortShaderObj.setUInt("qrk_particleCapacity", m_uiCapacity);
+        m_SortShaderObj.setUInt("qrk_particleCurrentList", m_uiAliveList);
+        m_SortShaderObj.setUInt("qrk_particleSortSize", m_uiSortSize);
+        m_SortShaderObj.setMat4("qrk_particleSortTransform", modelView);
+
+        // One thread per entry for the keys and the write back, one per pair
+        // for the compare and exchange steps.
+        const GLuint entryGroups = m_uiSortSize / PARTICLE_SORT_LOCAL_SIZE;
+        const GLuint pairGroups = m_uiSortSize / PARTICLE_SORT_BLOCK;
+        const GLuint maxGroupsX = static_cast<GLuint>(m_iMaxGroupsX);
+        dispatchSort(m_SortShaderObj, PARTICLE_SORT_KEYS, entryGroups, maxGroupsX);
+        // Blocks are sorted in shared memory. Each later merge needs a pass
+        // per partner distance across blocks, and then finishes the steps
+        // within blocks in shared memory again.
+        dispatchSort(m_SortShaderObj, PARTICLE_SORT_LOCAL, pairGroups, maxGroupsX);
+        for (unsigned int k = 2 * PARTICLE_SORT_BLOCK; k <= m_uiSortSize; k *= 2)
+        {
+            m_SortShaderObj.setUInt("qrk_particleSortK", k);
+            for (unsigned int j = k / 2; j >= PARTICLE_SORT_BLOCK; j /= 2)
+            {
+                m_SortShaderObj.setUInt("qrk_particleSortJ", j);
+                dispatchSort(m_SortShaderObj, PARTICLE_SORT_GLOBAL, pairGroups, maxGroupsX);
+            }
+            dispatchSort(m_SortShaderObj, PARTICLE_SORT_MERGE, pairGroups, maxGroupsX);
+        }
+        // The sorted particles replace the current alive list, which the
+        // draws read.
+        dispatchSort(m_SortShaderObj, PARTICLE_SORT_WRITE, entryGroups, maxGroupsX);
+        m_SortShaderObj.deactivate();
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef QUARKGL_GPU_PARTICLE_POOL_H_
+#define QUARKGL_GPU_PARTICLE_POOL_H_
+
+#include "../shader/shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Cme
+{
+    // SSBO binding points of the particle pool, see particle_pool.glsl.
+    constexpr GLuint PARTICLE_POSITION_BUFFER_BINDING = 9;
+    constexpr GLuint PARTICLE_VELOCITY_BUFFER_BINDING = 10;
+    constexpr GLuint PARTICLE_DELTA_BUFFER_BINDING = 11;
+    constexpr GLuint PARTICLE_EMITTER_BUFFER_BINDING = 12;
+    constexpr GLuint PARTICLE_COUNTER_BUFFER_BINDING = 13;
+    constexpr GLuint PARTICLE_ALIVE_LIST_BUFFER_BINDING = 14;
+    constexpr GLuint PARTICLE_DEAD_LIST_BUFFER_BINDING = 15;
+    // Depth keys of Sort(), see particle_sort.comp.
+    constexpr GLuint PARTICLE_SORT_BUFFER_BINDING = 16;
+
+    constexpr int MAX_PARTICLE_EMITTERS = 64;
+
+    struct ParticleEmitter
+    {
+        glm::vec3 position = glm::vec3(0.0f);
+        // Particles born per second, as long as the pool has dead particles.
+        float birthRate = 0.0f;
+        // Initial speed, and lifetime in seconds, randomized by +-variance.
+        float speed = 5.0f;
+        float lifetime = 3.0f;
+        float lifetimeVariance = 1.0f;
+    };
+
+    // Particle storage on the GPU, shared by any number of emitters.
+    //
+    // Attributes are stored as structure of arrays in std430 buffers, so that
+    // a pass only touches the attributes it needs. Which particles are in use
+    // is tracked on the GPU with a dead list of free indices and an alive list
+    // of live ones, so the work of a frame follows the live count, which the
+    // CPU never reads back:
+    //  1. Emission pops indices from the dead list, with one thread per birth,
+    //     capped to the dead count, and appends them to the alive list.
+    //  2. Simulation runs over the alive list. Survivors are compacted into the
+    //     other alive list, and the dead are pushed back on the dead list.
+    //  3. The draw covers the compacted alive list.
+    // Dispatch and draw sizes are written by a single thread pass between the
+    // stages and consumed with glDispatchComputeIndirect() and
+    // glDrawArraysIndirect().
+    class GpuParticlePool
+    {
+    public:
+        explicit GpuParticlePool(unsigned int capacity);
+        ~GpuParticlePool();
+
+        GpuParticlePool(const GpuParticlePool&) = delete;
+        GpuParticlePool& operator=(const GpuParticlePool&) = delete;
+
+        // Adds an emitter. Returns its index, or -1 if there are too many.
+        int AddEmitter(const ParticleEmitter& emitter);
+        // Parameters of an emitter. Changes apply from the next Simulate().
+        ParticleEmitter& getEmitter(int index) { return m_vecEmitters[index].params; }
+        int getNumEmitters() const { return static_cast<int>(m_vecEmitters.size()); }
+        // Kills all particles, which are born again at the emitters' rates.
+        void Restart();
+
+        // Emits the births of `deltaTime` seconds and advances the particles.
+        // `simulation` is dispatched twice: with `qrk_particleEmit` set it
+        // spawns the particle of qrk_particleEmitIndex(), otherwise it updates
+        // the particle of qrk_particleSimulateIndex() and reports whether it
+        // survives with qrk_particleSurvive() or qrk_particleDie().
+        void Simulate(Shader& simulation, float deltaTime);
+        // Draws the live particles as points, where vertex i draws particle
+        // qrk_particleAlive(i), see particle_pool.glsl.
+        void Draw(Shader& shader);
+        // Draws the live particles as instanced 4 vertex triangle strips,
+        // where instance i draws particle qrk_particleAlive(i). Saves the
+        // geometry shader that expands points.
+        void DrawQuads(Shader& shader);
+        // Orders the live particles back to front by their view space depth
+        // under `modelView`, so alpha blended draws composite correctly. A
+        // bitonic sort over the capacity rounded up to a power of two, so the
+        // cost follows the capacity rather than the live count.
+        void Sort(const glm::mat4& modelView);
+
+        unsigned int getCapacity() const { return m_uiCapacity; }
+
+    private:
+        struct EmitterState
+        {
+            ParticleEmitter params;
+            // Fraction of a particle carried over to the next frame's births.
+            float debt = 0.0f;
+        };
+
+        void BindBuffers() const;
+        // Fills the dead list with every particle and empties the alive lists.
+        void ResetLists();
+        // Uploads the emitters with this frame's births. Returns the total.
+        unsigned int UploadEmitters(float deltaTime);
+        // Runs a stage of particle_args.comp, see PARTICLE_ARGS_*.
+        void WriteArgs(int stage);
+
+        unsigned int m_uiCapacity;
+        std::vector<EmitterState> m_vecEmitters;
+        GLint m_iMaxGroupsX = 65535;
+        // Alive list holding the current particles, the other one receives
+        // the survivors.
+        unsigned int m_uiAliveList = 0;
+
+        Shader m_ArgsShaderObj;
+        Shader m_SortShaderObj;
+        unsigned int m_uiSortSize = 0;
+
+        GLuint m_uiPositionBuffer = 0;
+        GLuint m_uiVelocityBuffer = 0;
+        GLuint m_uiDeltaBuffer = 0;
+        GLuint m_uiEmitterBuffer = 0;
+        // Dispatch sizes and the draw command, followed by the list counts.
+        GLuint m_uiCounterBuffer = 0;
+        GLuint m_uiAliveListBuffer = 0;
+        GLuint m_uiDeadListBuffer = 0;
+        GLuint m_uiSortBuffer = 0;
+        GLuint m_uiVao = 0;
+    };
+}
+
+#endif
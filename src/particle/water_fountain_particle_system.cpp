@@ -3,6 +3,8 @@
 #include "../stb_image.h"
 #include "../core/texture_manager.h"
 #include "../common_helper.h"
+#include "../profiler.h"
+#include "../debug.h"
 
 namespace Cme
 {
@@ -10,18 +12,15 @@ namespace Cme
 
 	WaterFountainParticleSystem::WaterFountainParticleSystem()
 	{
-		m_uiVao = 0;
-		m_uiVbo = 0;
+		m_uiParticleCount = 0;
 		m_spCamera = std::make_shared<Camera>();
 	}
 
 	WaterFountainParticleSystem::~WaterFountainParticleSystem()
 	{
-		glDeleteVertexArrays(1, &m_uiVao);
-		glDeleteBuffers(1, &m_uiVbo);
-
-		m_uiVao = 0;
-		m_uiVbo = 0;
+		delete m_pComputeShader;
+		delete m_pDrawShader;
+		delete m_pQuadShader;
 	}
 
 	void WaterFountainParticleSystem::InitPS(float*, unsigned int v_count,
@@ -37,25 +36,21 @@ namespace Cme
 									 Cme::ShaderPath("assets//shaders//water_fountain_scene.frag"),
 									 Cme::ShaderPath("assets//shaders//water_fountain_scene.geom"));
 		}
+		if (m_pQuadShader == nullptr)
+		{
+			m_pQuadShader = new Shader(Cme::ShaderPath("assets//shaders//water_fountain_scene.vert"),
+									 Cme::ShaderPath("assets//shaders//water_fountain_scene.frag"));
+		}
 
-		glGenVertexArrays(1, &m_uiVao);
-		glGenBuffers(1, &m_uiVbo);
+		// Ȫһӳ ԰SoAstd430
+		m_upPool = std::make_unique<GpuParticlePool>(max_particles);
 
-		m_pDrawShader->activate();
-		// draw_shader->bind("GlobalAttributes", 0);
 		m_pDrawShader->setInt("sprite", 0);
-		glBindVertexArray(m_uiVao);
-		glBindBuffer(GL_ARRAY_BUFFER, m_uiVbo);
-		glEnableVertexAttribArray(0);   // position
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(0));
-		glEnableVertexAttribArray(1);   // color alpha
-		glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);   // delta position
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(8 * sizeof(float)));
+		m_pDrawShader->setBool("quads", false);
 		m_pDrawShader->deactivate();
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		m_pQuadShader->setInt("sprite", 0);
+		m_pQuadShader->setBool("quads", true);
+		m_pQuadShader->deactivate();
 
 		auto& tm = TextureManager::GetInstance();
 		{
@@ -63,98 +58,110 @@ namespace Cme
 			spTexture->LoadTexture("assets//texture//particle3.png", true);
 			tm.AddTexture(WATERFOUNTAIN_KEY, std::vector<std::shared_ptr<Texture>>{spTexture});
 		}
-
-		tot = max_particles;
-		debt = 0.f;
-		upload = true;
 	}
 
-	void WaterFountainParticleSystem::Restart()
+	int WaterFountainParticleSystem::AddEmitter(const ParticleEmitter& emitter)
 	{
-		//tot = max_particles;
-		//debt = 0.f;
-		//upload = true;
+		int index = m_upPool->AddEmitter(emitter);
+		if (index < 0)
+		{
+			std::cout << "Particle pool is full, emitter not added!" << std::endl;
+		}
+		return index;
 	}
 
-	void WaterFountainParticleSystem::Upload()
+	void WaterFountainParticleSystem::SetMaxParticles(unsigned int maxParticles)
 	{
-		if (!upload)
+		if (maxParticles == max_particles)
 		{
 			return;
 		}
+		auto upPool = std::make_unique<GpuParticlePool>(maxParticles);
+		for (int i = 0; i < m_upPool->getNumEmitters(); ++i)
+		{
+			upPool->AddEmitter(m_upPool->getEmitter(i));
+		}
+		m_upPool = std::move(upPool);
+		max_particles = maxParticles;
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_uiVbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 12 * max_particles, nullptr, GL_STATIC_DRAW);
-
-		m_uiParticleCount = max_particles;
-		Update(-1.f, 0.0f);
-		m_uiParticleCount = 0;
-
-		upload = false;
+	void WaterFountainParticleSystem::Restart()
+	{
+		m_upPool->Restart();
 	}
 
 	void WaterFountainParticleSystem::Update(float fDelta, float fTime)
 	{
 		m_fTime = fTime;
-		if (m_uiParticleCount != total())
-		{
-			debt += std::min(0.05f, fDelta) * birth_rate;
-			auto new_particles = static_cast<int>(debt);
-			debt -= new_particles;
-			m_uiParticleCount += new_particles;
-			if (m_uiParticleCount > total())
-			{
-				m_uiParticleCount = total();
-			}
-		}
 
-		// std::cout << "dt count(): " << dt  << " "  << count() << std::endl;
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_uiVbo);
-		m_pComputeShader->activate();
-		m_pComputeShader->setFloat("dt", fDelta);
+		// ɫ߳GPUϵĴ ٹ̶Ϊ256
 		m_pComputeShader->setVec3("acceleration", acceleration);
-		m_pComputeShader->setInt("n_particles", static_cast<int>(count()));
-		// ˴
-		glDispatchCompute(256, 1, 1);
-		m_pComputeShader->deactivate();
+		// ֻGPU count()ٸ
+		m_upPool->Simulate(*m_pComputeShader, fDelta);
 	}
 
 	void WaterFountainParticleSystem::Render(GLenum gl_draw_mode)
 	{
-		glDisable(GL_DEPTH_TEST);
+		auto modelMatrix = glm::mat4(1.0f);
+		modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, -2.5f, 0.0f));
+
+		// ӻ˳޹ ͨalphaҪȰȴԶ
+		if (m_eBlending == ParticleBlending::ALPHA_SORTED)
+		{
+			Cme::DebugGroup debugGroup("Particle sort");
+			m_upPool->Sort(m_spCamera->getViewTransform() * modelMatrix);
+		}
+
 		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+		if (m_eBlending == ParticleBlending::ALPHA_SORTED)
+		{
+			// ڵϵҪȲ ֮ź д
+			glEnable(GL_DEPTH_TEST);
+			glDepthMask(GL_FALSE);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		}
+		else
+		{
+			glDisable(GL_DEPTH_TEST);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+		}
 
-		m_pDrawShader->activate();
-		m_pDrawShader->setMat4("view", m_spCamera->getViewTransform());
-		m_pDrawShader->setMat4("proj", m_spCamera->getProjectionTransform());
-		m_pDrawShader->setVec3("cam_pos", m_spCamera->getPosition());
-		m_pDrawShader->setVec3("particleColor", m_vec3ParticleColor);
-		m_pDrawShader->setFloat("time", m_fTime);
+		// ɫѵչı ʵıڶɫֱӼĸ
+		Shader& shader = m_eRendering == ParticleRendering::GEOMETRY_SHADER ? *m_pDrawShader : *m_pQuadShader;
+		shader.activate();
+		shader.setMat4("view", m_spCamera->getViewTransform());
+		shader.setMat4("proj", m_spCamera->getProjectionTransform());
+		shader.setVec3("particleColor", m_vec3ParticleColor);
+		shader.setFloat("time", m_fTime);
+		shader.setBool("stretch", m_bStretch);
 
-		auto modelMatrix = glm::mat4(1.0f);
-		modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, -2.5f, 0.0f));
-		m_pDrawShader->setMat4("modelMatrix", modelMatrix);
+		shader.setMat4("modelMatrix", modelMatrix);
 
 		auto& tm = TextureManager::GetInstance();
 
-		glBindVertexArray(m_uiVao);
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, tm.GetTexture(WATERFOUNTAIN_KEY)[0]->getId());
-		glDrawArrays(GL_POINTS, 0, count());
+		if (m_eRendering == ParticleRendering::GEOMETRY_SHADER)
+		{
+			m_upPool->Draw(shader);
+		}
+		else
+		{
+			m_upPool->DrawQuads(shader);
+		}
 
 		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindVertexArray(0);
-		m_pDrawShader->deactivate();
+		shader.deactivate();
 
 		glDisable(GL_BLEND);
+		glDepthMask(GL_TRUE);
 		// ȲԺ ʱһҪȲ ͷ(ģ)Ⱦ
 		glEnable(GL_DEPTH_TEST);     
 	}
 
 	unsigned int WaterFountainParticleSystem::total() const noexcept
 	{
-		return tot;
+		return m_upPool->getCapacity();
 	}
 
 	void WaterFountainParticleSystem::SetCamera(std::shared_ptr<Camera> spCamera)
@@ -3,8 +3,10 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "base_particle.h"
+#include "gpu_particle_pool.h"
 #include "../shader/shader.h"
 #include "../camera.h"
+#include "../cme_defs.h"
 
 namespace Cme
 {
@@ -21,7 +23,6 @@ namespace Cme
         void InitPS(float* vertex, unsigned int v_count,
                     unsigned int tex = 0, float* uv = nullptr, bool atlas = false) override;
         void Restart() override;
-        void Upload() override;
         void Update(float fDelta, float fTime) override;
         void Render(GLenum gl_draw_mode = GL_POINT) override;
 
@@ -30,21 +31,37 @@ namespace Cme
             m_vec3ParticleColor = Color;
         };
 
+        // Adds a fountain to the particle pool of `max_particles`, which all
+        // fountains share. Returns the emitter index, or -1 if there are too
+        // many emitters.
+        int AddEmitter(const ParticleEmitter& emitter);
+        ParticleEmitter& GetEmitter(int index) { return m_upPool->getEmitter(index); }
+        // Reallocates the pool for `maxParticles` and restarts the emitters.
+        void SetMaxParticles(unsigned int maxParticles);
+
+        void SetRendering(ParticleRendering rendering) { m_eRendering = rendering; }
+        // Stretches the sprites along their movement, otherwise they face the
+        // camera.
+        void SetStretch(bool stretch) { m_bStretch = stretch; }
+        // Alpha blending sorts the particles back to front before the draw.
+        void SetBlending(ParticleBlending blending) { m_eBlending = blending; }
+
+        // Pool capacity. count() stays 0, the live count is only kept on the
+        // GPU.
         unsigned int total() const noexcept override;
         void SetCamera(std::shared_ptr<Camera> spCamera);
 
 
     private:
-        //std::unique_ptr<WaterFountainPSImpl> m_upImpl;
-        unsigned int m_uiVao;
-        unsigned int m_uiVbo;
-
-        float debt;
-        unsigned int tot;
-        bool upload;
+        std::unique_ptr<GpuParticlePool> m_upPool;
 
         Shader* m_pComputeShader = nullptr;
         Shader* m_pDrawShader = nullptr;
+        // Same vertex shader, without the geometry shader.
+        Shader* m_pQuadShader = nullptr;
+        ParticleRendering m_eRendering = ParticleRendering::INSTANCED_QUADS;
+        bool m_bStretch = true;
+        ParticleBlending m_eBlending = ParticleBlending::ADDITIVE;
 
         glm::vec3 m_vec3ParticleColor = glm::vec3(0.0f, 1.0f, 0.0f);
         std::shared_ptr<Camera> m_spCamera;
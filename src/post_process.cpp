@@ -0,0 +1,47 @@
+#include "post_process.h"
+
+namespace Cme
+{
+    namespace
+    {
+        // Matches the work group size of post_process.comp.
+        constexpr int POST_PROCESS_LOCAL_SIZE = 16;
+    }
+
+    PostProcessPass::PostProcessPass(ImageSize screenSize)
+        : Framebuffer(screenSize),
+        m_Size(screenSize),
+        m_PostProcessShaderObj(ShaderPath("assets//shaders//builtin//post_process.comp"))
+    {
+        TextureParams params;
+        params.filtering = TextureFiltering::NEAREST;
+        params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+        params.generateMips = MipGeneration::NEVER;
+        m_ColorAttachmentObj = AttachTexture2FB_i(BufferType::COLOR_ALPHA, params);
+    }
+
+    void PostProcessPass::Render(Texture& source, Texture& bloom, unsigned int textureUnit)
+    {
+        source.BindToUnit(textureUnit);
+        m_PostProcessShaderObj.setInt("qrk_postSource", textureUnit);
+        bloom.BindToUnit(textureUnit + 1);
+        m_PostProcessShaderObj.setInt("qrk_bloom", textureUnit + 1);
+        m_PostProcessShaderObj.setBool("qrk_bloomEnabled", m_bBloom);
+        m_PostProcessShaderObj.setFloat("qrk_bloomMix", m_fBloomMix);
+        m_PostProcessShaderObj.setFloat("qrk_exposure", m_fExposure);
+        m_PostProcessShaderObj.setBool("qrk_autoExposure", m_bAutoExposure);
+        m_PostProcessShaderObj.setInt("qrk_toneMapping", m_iToneMapping);
+        m_PostProcessShaderObj.setBool("qrk_gammaCorrect", m_bGammaCorrect);
+        m_PostProcessShaderObj.setFloat("qrk_gamma", m_fGamma);
+        m_PostProcessShaderObj.setBool("qrk_fxaa", m_bFxaa);
+        glBindImageTexture(0, m_ColorAttachmentObj.m_uiID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+        m_PostProcessShaderObj.activate();
+        glDispatchCompute((m_Size.width + POST_PROCESS_LOCAL_SIZE - 1) / POST_PROCESS_LOCAL_SIZE,
+                          (m_Size.height + POST_PROCESS_LOCAL_SIZE - 1) / POST_PROCESS_LOCAL_SIZE, 1);
+        // The result is read by the blit to the screen and by captures.
+        glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+        m_PostProcessShaderObj.deactivate();
+    }
+
+}  // namespace Cme
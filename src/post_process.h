@@ -0,0 +1,74 @@
+#ifndef QUARKGL_POST_PROCESS_H_
+#define QUARKGL_POST_PROCESS_H_
+
+#include "framebuffer.h"
+#include "screen.h"
+#include "shader/shader.h"
+#include "core/texture.h"
+
+#include <memory>
+
+namespace Cme
+{
+    // Turns the HDR image into the displayable one in a single compute pass:
+    // bloom composite, exposure, tone mapping, gamma correction and optionally
+    // FXAA. The HDR image is read once and the 8 bit result written once, so
+    // no full screen intermediate goes through memory between the steps.
+    //
+    // The result is the color attachment of this framebuffer. Compute shaders
+    // can't write the window surface, so it reaches the screen with one blit,
+    // see Present().
+    class PostProcessPass : public Framebuffer
+    {
+    public:
+        explicit PostProcessPass(ImageSize screenSize);
+
+        // Post-processes `source`, compositing `bloom` if enabled. Samples from
+        // `textureUnit` and the unit after it.
+        void Render(Texture& source, Texture& bloom, unsigned int textureUnit);
+        // Copies the result to the default framebuffer.
+        void Present() { blitToDefault(GL_COLOR_BUFFER_BIT); }
+
+        bool getBloom() const { return m_bBloom; }
+        void setBloom(bool bloom) { m_bBloom = bloom; }
+        float getBloomMix() const { return m_fBloomMix; }
+        void setBloomMix(float bloomMix) { m_fBloomMix = bloomMix; }
+        // Linear scale of the HDR color before tone mapping. With auto
+        // exposure, applied on top of the measured exposure.
+        float getExposure() const { return m_fExposure; }
+        void setExposure(float exposure) { m_fExposure = exposure; }
+        // Reads the exposure from the buffer bound by
+        // AutoExposure::bindExposureBuffer().
+        bool getAutoExposure() const { return m_bAutoExposure; }
+        void setAutoExposure(bool autoExposure) { m_bAutoExposure = autoExposure; }
+        // One of the ToneMapping values.
+        int getToneMapping() const { return m_iToneMapping; }
+        void setToneMapping(int toneMapping) { m_iToneMapping = toneMapping; }
+        bool getGammaCorrect() const { return m_bGammaCorrect; }
+        void setGammaCorrect(bool gammaCorrect) { m_bGammaCorrect = gammaCorrect; }
+        float getGamma() const { return m_fGamma; }
+        void setGamma(float gamma) { m_fGamma = gamma; }
+        bool getFxaa() const { return m_bFxaa; }
+        void setFxaa(bool fxaa) { m_bFxaa = fxaa; }
+
+        std::shared_ptr<Texture> getTexture() { return m_ColorAttachmentObj.Transform2Texture(); }
+
+    private:
+        ImageSize m_Size;
+        Attachment m_ColorAttachmentObj;
+
+        bool m_bBloom = true;
+        float m_fBloomMix = 0.004f;
+        float m_fExposure = 1.0f;
+        bool m_bAutoExposure = false;
+        int m_iToneMapping = 0;
+        bool m_bGammaCorrect = true;
+        float m_fGamma = 2.2f;
+        bool m_bFxaa = true;
+
+        Shader m_PostProcessShaderObj;
+    };
+
+}  // namespace Cme
+
+#endif
@@ -0,0 +1,372 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace Cme
+{
+    // Query objects are created in batches when a frame needs more of them.
+    const int QUERY_BATCH_SIZE = 64;
+    // The GPU and CPU clocks drift apart slowly; resynchronize periodically.
+    const uint64_t CLOCK_SYNC_INTERVAL = 256;
+    // Upper bound on captured frames so that a forgotten capture cannot grow
+    // without limit.
+    const size_t MAX_CAPTURED_FRAMES = 3600;
+    // Weight of the newest frame in the running frame time averages.
+    const double AVERAGE_WEIGHT = 0.05;
+    // Thread id used for GPU events in the exported trace.
+    const uint32_t GPU_TRACE_TID = 1000;
+
+    Profiler& Profiler::GetInstance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler::Profiler() : m_Epoch(std::chrono::steady_clock::now()) {}
+
+    int64_t Profiler::NowNs() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_Epoch).count();
+    }
+
+    Profiler::ThreadRing& Profiler::GetThreadRing()
+    {
+        // Registration happens once per thread; recording itself never locks.
+        thread_local ThreadRing* t_pRing = nullptr;
+        if (t_pRing == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(m_RingsMutex);
+            m_vecRings.push_back(std::make_unique<ThreadRing>());
+            t_pRing = m_vecRings.back().get();
+            t_pRing->threadIndex = (uint32_t)m_vecRings.size() - 1;
+        }
+        return *t_pRing;
+    }
+
+    int Profiler::AllocateQuery()
+    {
+        FrameSlot& slot = m_arrSlots[m_ui64FrameIndex % NUM_FRAMES_IN_FLIGHT];
+        if (slot.queryCount == (int)slot.queries.size())
+        {
+            slot.queries.resize(slot.queries.size() + QUERY_BATCH_SIZE);
+            glCreateQueries(GL_TIMESTAMP, QUERY_BATCH_SIZE, &slot.queries[slot.queryCount]);
+        }
+        int index = slot.queryCount++;
+        glQueryCounter(slot.queries[index], GL_TIMESTAMP);
+        return index;
+    }
+
+    void Profiler::BeginFrame()
+    {
+        if (!m_bEnabled)
+        {
+            return;
+        }
+        m_RenderThread = std::this_thread::get_id();
+
+        ResolveFrames();
+        if (!m_bClocksSynced || m_ui64FrameIndex % CLOCK_SYNC_INTERVAL == 0)
+        {
+            SyncClocks();
+        }
+
+        // A slot that is still pending here has not completed on the GPU after
+        // NUM_FRAMES_IN_FLIGHT frames. Rather than wait, its timings are dropped.
+        FrameSlot& slot = m_arrSlots[m_ui64FrameIndex % NUM_FRAMES_IN_FLIGHT];
+        slot.bPending = false;
+        slot.queryCount = 0;
+        slot.events.clear();
+
+        if (slot.statsQuery == 0)
+        {
+            glCreateQueries(GL_PRIMITIVES_SUBMITTED, 1, &slot.statsQuery);
+        }
+        glBeginQuery(GL_PRIMITIVES_SUBMITTED, slot.statsQuery);
+        m_uiDrawCalls = 0;
+
+        m_bInFrame = true;
+        BeginScope("Frame");
+    }
+
+    void Profiler::EndFrame()
+    {
+        if (!m_bInFrame)
+        {
+            return;
+        }
+        EndScope();
+        m_bInFrame = false;
+        glEndQuery(GL_PRIMITIVES_SUBMITTED);
+
+        FrameSlot& slot = m_arrSlots[m_ui64FrameIndex % NUM_FRAMES_IN_FLIGHT];
+        slot.drawCalls = m_uiDrawCalls.load(std::memory_order_relaxed);
+        DrainRings(slot);
+        slot.frameIndex = m_ui64FrameIndex;
+        slot.bPending = true;
+        ++m_ui64FrameIndex;
+    }
+
+    void Profiler::BeginScope(const char* name)
+    {
+        ThreadRing& ring = GetThreadRing();
+        ScopeEvent event = { nullptr, ring.threadIndex, (int)ring.stack.size(), 0, 0, -1, -1 };
+        // Scopes outside of a frame still go on the stack to keep it balanced,
+        // but are not recorded.
+        if (m_bInFrame)
+        {
+            event.name = name;
+            if (std::this_thread::get_id() == m_RenderThread)
+            {
+                event.queryBegin = AllocateQuery();
+            }
+            event.beginNs = NowNs();
+        }
+        ring.stack.push_back(event);
+    }
+
+    void Profiler::EndScope()
+    {
+        ThreadRing& ring = GetThreadRing();
+        if (ring.stack.empty())
+        {
+            return;
+        }
+        ScopeEvent event = ring.stack.back();
+        ring.stack.pop_back();
+        if (event.name == nullptr)
+        {
+            return;
+        }
+        event.endNs = NowNs();
+        if (event.queryBegin >= 0)
+        {
+            event.queryEnd = AllocateQuery();
+        }
+
+        uint32_t head = ring.head.load(std::memory_order_relaxed);
+        uint32_t tail = ring.tail.load(std::memory_order_acquire);
+        if (head - tail >= RING_CAPACITY)
+        {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring.events[head % RING_CAPACITY] = event;
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::DrainRings(FrameSlot& slot)
+    {
+        std::lock_guard<std::mutex> lock(m_RingsMutex);
+        for (auto& upRing : m_vecRings)
+        {
+            ThreadRing& ring = *upRing;
+            uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+            uint32_t head = ring.head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail)
+            {
+                slot.events.push_back(ring.events[tail % RING_CAPACITY]);
+            }
+            ring.tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    void Profiler::ResolveFrames()
+    {
+        // Oldest pending frame first. Timestamp queries complete in submission
+        // order, so once a frame is not ready the newer ones are not either.
+        uint64_t first = m_ui64FrameIndex >= NUM_FRAMES_IN_FLIGHT ? m_ui64FrameIndex - NUM_FRAMES_IN_FLIGHT : 0;
+        for (uint64_t frame = first; frame < m_ui64FrameIndex; ++frame)
+        {
+            FrameSlot& slot = m_arrSlots[frame % NUM_FRAMES_IN_FLIGHT];
+            if (!slot.bPending || slot.frameIndex != frame)
+            {
+                continue;
+            }
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(slot.statsQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available && slot.queryCount > 0)
+            {
+                glGetQueryObjectiv(slot.queries[slot.queryCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            }
+            if (!available)
+            {
+                break;
+            }
+            ResolveSlot(slot);
+        }
+    }
+
+    void Profiler::ResolveSlot(FrameSlot& slot)
+    {
+        slot.bPending = false;
+
+        ProfileFrame frame;
+        frame.frameIndex = slot.frameIndex;
+        frame.drawCalls = slot.drawCalls;
+        GLuint64 primitives = 0;
+        glGetQueryObjectui64v(slot.statsQuery, GL_QUERY_RESULT, &primitives);
+        frame.primitives = primitives;
+        frame.records.reserve(slot.events.size());
+        for (const ScopeEvent& event : slot.events)
+        {
+            ProfileRecord record;
+            record.name = event.name;
+            record.threadIndex = event.threadIndex;
+            record.depth = event.depth;
+            record.cpuBeginNs = event.beginNs;
+            record.cpuEndNs = event.endNs;
+            if (event.queryBegin >= 0 && event.queryEnd >= 0)
+            {
+                GLuint64 gpuBegin = 0;
+                GLuint64 gpuEnd = 0;
+                glGetQueryObjectui64v(slot.queries[event.queryBegin], GL_QUERY_RESULT, &gpuBegin);
+                glGetQueryObjectui64v(slot.queries[event.queryEnd], GL_QUERY_RESULT, &gpuEnd);
+                record.gpuBeginNs = (int64_t)gpuBegin - m_i64GpuToCpuOffsetNs;
+                record.gpuEndNs = (int64_t)gpuEnd - m_i64GpuToCpuOffsetNs;
+            }
+            frame.records.push_back(record);
+        }
+
+        // Events arrive in the order their scopes closed. Sorting by start time
+        // (parents before children on ties) restores the pre-order hierarchy.
+        std::sort(frame.records.begin(), frame.records.end(),
+            [](const ProfileRecord& a, const ProfileRecord& b)
+            {
+                if (a.threadIndex != b.threadIndex)
+                {
+                    return a.threadIndex < b.threadIndex;
+                }
+                if (a.cpuBeginNs != b.cpuBeginNs)
+                {
+                    return a.cpuBeginNs < b.cpuBeginNs;
+                }
+                return a.depth < b.depth;
+            });
+
+        for (const ProfileRecord& record : frame.records)
+        {
+            if (record.depth == 0 && record.gpuBeginNs >= 0)
+            {
+                m_dAvgCpuFrameMs += (record.GetCpuMs() - m_dAvgCpuFrameMs) * AVERAGE_WEIGHT;
+                m_dAvgGpuFrameMs += (record.GetGpuMs() - m_dAvgGpuFrameMs) * AVERAGE_WEIGHT;
+                break;
+            }
+        }
+
+        if (m_bCapturing)
+        {
+            m_vecCapturedFrames.push_back(frame);
+            if (m_vecCapturedFrames.size() >= MAX_CAPTURED_FRAMES)
+            {
+                m_bCapturing = false;
+            }
+        }
+        m_LastFrame = std::move(frame);
+    }
+
+    void Profiler::SyncClocks()
+    {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        m_i64GpuToCpuOffsetNs = gpuNow - NowNs();
+        m_bClocksSynced = true;
+    }
+
+    void Profiler::StartCapture()
+    {
+        m_vecCapturedFrames.clear();
+        m_bCapturing = true;
+    }
+
+    void Profiler::StopCapture()
+    {
+        m_bCapturing = false;
+    }
+
+    namespace
+    {
+        void writeJsonString(std::ofstream& out, const char* str)
+        {
+            out << '"';
+            for (const char* c = str; *c != '\0'; ++c)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    out << '\\';
+                }
+                out << *c;
+            }
+            out << '"';
+        }
+
+        void writeTraceEvent(std::ofstream& out, bool& bFirst, const char* name,
+            uint32_t tid, int64_t beginNs, int64_t endNs)
+        {
+            out << (bFirst ? "\n" : ",\n");
+            bFirst = false;
+            out << "{\"name\":";
+            writeJsonString(out, name);
+            out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+                << ",\"ts\":" << beginNs / 1000.0
+                << ",\"dur\":" << (endNs - beginNs) / 1000.0 << "}";
+        }
+
+        void writeThreadName(std::ofstream& out, bool& bFirst, uint32_t tid, const std::string& sName)
+        {
+            out << (bFirst ? "\n" : ",\n");
+            bFirst = false;
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+                << ",\"args\":{\"name\":";
+            writeJsonString(out, sName.c_str());
+            out << "}}";
+        }
+    }
+
+    bool Profiler::ExportChromeTrace(const std::string& sPath) const
+    {
+        std::ofstream out(sPath);
+        if (!out)
+        {
+            return false;
+        }
+        out.precision(3);
+        out << std::fixed;
+
+        std::vector<const ProfileFrame*> frames;
+        for (const ProfileFrame& frame : m_vecCapturedFrames)
+        {
+            frames.push_back(&frame);
+        }
+        if (frames.empty())
+        {
+            frames.push_back(&m_LastFrame);
+        }
+
+        out << "{\"traceEvents\":[";
+        bool bFirst = true;
+        uint32_t maxThread = 0;
+        for (const ProfileFrame* pFrame : frames)
+        {
+            for (const ProfileRecord& record : pFrame->records)
+            {
+                maxThread = std::max(maxThread, record.threadIndex);
+                writeTraceEvent(out, bFirst, record.name, record.threadIndex,
+                    record.cpuBeginNs, record.cpuEndNs);
+                if (record.gpuBeginNs >= 0)
+                {
+                    writeTraceEvent(out, bFirst, record.name, GPU_TRACE_TID,
+                        record.gpuBeginNs, record.gpuEndNs);
+                }
+            }
+        }
+        for (uint32_t tid = 0; tid <= maxThread; ++tid)
+        {
+            writeThreadName(out, bFirst, tid, "CPU " + std::to_string(tid));
+        }
+        writeThreadName(out, bFirst, GPU_TRACE_TID, "GPU");
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return out.good();
+    }
+}  // namespace Cme
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Cme
+{
+	// One timed scope of a resolved frame. Times are nanoseconds relative to the
+	// profiler epoch; GPU times have been mapped onto the CPU timeline and are
+	// negative when the scope issued no GPU queries.
+	struct ProfileRecord
+	{
+		const char* name = nullptr;
+		uint32_t threadIndex = 0;
+		int depth = 0;
+		int64_t cpuBeginNs = 0;
+		int64_t cpuEndNs = 0;
+		int64_t gpuBeginNs = -1;
+		int64_t gpuEndNs = -1;
+
+		double GetCpuMs() const { return (cpuEndNs - cpuBeginNs) * 1e-6; }
+		double GetGpuMs() const { return gpuBeginNs < 0 ? 0.0 : (gpuEndNs - gpuBeginNs) * 1e-6; }
+	};
+
+	struct ProfileFrame
+	{
+		uint64_t frameIndex = 0;
+		uint32_t drawCalls = 0;
+		// GL_PRIMITIVES_SUBMITTED over the frame: triangles, lines and points
+		// sent to the pipeline before clipping.
+		uint64_t primitives = 0;
+		// Pre-order: every record is followed by its children, with `depth` one
+		// greater than the parent's.
+		std::vector<ProfileRecord> records;
+	};
+
+	// Frame profiler combining CPU timestamps and GL timestamp queries.
+	//
+	// Scopes are recorded into a fixed size ring owned by the recording thread,
+	// so any thread may open scopes without taking a lock. The render thread
+	// (the one calling BeginFrame) additionally brackets its scopes with
+	// glQueryCounter. Query objects are pooled per frame in flight and read back
+	// NUM_FRAMES_IN_FLIGHT - 1 frames later, once GL_QUERY_RESULT_AVAILABLE is
+	// set, so the readback never stalls the pipeline.
+	//
+	// Scope names must be string literals or otherwise outlive the profiler.
+	class Profiler
+	{
+	public:
+		static constexpr int NUM_FRAMES_IN_FLIGHT = 4;
+		static constexpr uint32_t RING_CAPACITY = 4096;
+
+		static Profiler& GetInstance();
+
+		// Called by the render thread around every frame.
+		void BeginFrame();
+		void EndFrame();
+
+		void BeginScope(const char* name);
+		void EndScope();
+
+		// Called next to every draw call issued by the renderer.
+		void CountDrawCall() { m_uiDrawCalls.fetch_add(1, std::memory_order_relaxed); }
+
+		// Index of the frame currently being recorded.
+		uint64_t GetFrameIndex() const { return m_ui64FrameIndex; }
+
+		bool IsEnabled() const { return m_bEnabled; }
+		void SetEnabled(bool bEnabled) { m_bEnabled = bEnabled; }
+
+		// The most recent frame whose GPU timings have been read back.
+		const ProfileFrame& GetLastFrame() const { return m_LastFrame; }
+		// Average over recent resolved frames of the root "Frame" scope.
+		double GetAvgCpuFrameMs() const { return m_dAvgCpuFrameMs; }
+		double GetAvgGpuFrameMs() const { return m_dAvgGpuFrameMs; }
+
+		// While capturing, every resolved frame is kept for trace export.
+		void StartCapture();
+		void StopCapture();
+		bool IsCapturing() const { return m_bCapturing; }
+		size_t GetCapturedFrameCount() const { return m_vecCapturedFrames.size(); }
+		const std::vector<ProfileFrame>& GetCapturedFrames() const { return m_vecCapturedFrames; }
+		// Writes the captured frames (or the last frame if nothing was captured)
+		// in the Chrome trace event format, readable by chrome://tracing and
+		// Perfetto. Returns false if the file cannot be written.
+		bool ExportChromeTrace(const std::string& sPath) const;
+
+	private:
+		Profiler();
+		Profiler(const Profiler&) = delete;
+		void operator=(const Profiler&) = delete;
+
+		struct ScopeEvent
+		{
+			const char* name;
+			uint32_t threadIndex;
+			int depth;
+			int64_t beginNs;
+			int64_t endNs;
+			// Indices into the frame's query pool, or -1 without GPU timing.
+			int queryBegin;
+			int queryEnd;
+		};
+
+		// Single-producer single-consumer ring: the owning thread pushes closed
+		// scopes, the render thread drains them in EndFrame.
+		struct ThreadRing
+		{
+			uint32_t threadIndex = 0;
+			std::array<ScopeEvent, RING_CAPACITY> events;
+			std::atomic<uint32_t> head{ 0 };
+			std::atomic<uint32_t> tail{ 0 };
+			std::atomic<uint32_t> dropped{ 0 };
+
+			// Open scopes of the owning thread, only touched by that thread.
+			std::vector<ScopeEvent> stack;
+		};
+
+		struct FrameSlot
+		{
+			uint64_t frameIndex = 0;
+			bool bPending = false;
+			uint32_t drawCalls = 0;
+			GLuint statsQuery = 0;
+			std::vector<GLuint> queries;
+			int queryCount = 0;
+			std::vector<ScopeEvent> events;
+		};
+
+		ThreadRing& GetThreadRing();
+		int AllocateQuery();
+		void DrainRings(FrameSlot& slot);
+		void ResolveFrames();
+		void ResolveSlot(FrameSlot& slot);
+		void SyncClocks();
+		int64_t NowNs() const;
+
+		std::chrono::steady_clock::time_point m_Epoch;
+		bool m_bEnabled = true;
+		// Read by every recording thread to decide whether a scope is kept.
+		std::atomic<bool> m_bInFrame{ false };
+		std::thread::id m_RenderThread;
+		uint64_t m_ui64FrameIndex = 0;
+		std::atomic<uint32_t> m_uiDrawCalls{ 0 };
+
+		std::mutex m_RingsMutex;
+		std::vector<std::unique_ptr<ThreadRing>> m_vecRings;
+
+		std::array<FrameSlot, NUM_FRAMES_IN_FLIGHT> m_arrSlots;
+		// GPU timestamp minus CPU time, both in nanoseconds.
+		int64_t m_i64GpuToCpuOffsetNs = 0;
+		bool m_bClocksSynced = false;
+
+		ProfileFrame m_LastFrame;
+		double m_dAvgCpuFrameMs = 0.0;
+		double m_dAvgGpuFrameMs = 0.0;
+
+		bool m_bCapturing = false;
+		std::vector<ProfileFrame> m_vecCapturedFrames;
+	};
+
+	// RAII profiling scope. Use DebugGroup instead when the scope should also
+	// show up as a debug marker in graphics debuggers.
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name) { Profiler::GetInstance().BeginScope(name); }
+		~ProfileScope() { Profiler::GetInstance().EndScope(); }
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+}  // namespace Cme
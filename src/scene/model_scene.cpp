@@ -59,6 +59,12 @@ namespace Cme
         }
 	}
 
+    void ModelScene::RenderDepth(const ModelRenderOptions& stModelRenderOptions, Cme::Shader& shader)
+    {
+        m_upModel->setModelTransform(glm::scale(glm::mat4_cast(stModelRenderOptions.modelRotation), glm::vec3(stModelRenderOptions.modelScale)));
+        m_upModel->draw(shader);
+    }
+
 	void ModelScene::Update()
 	{
 
@@ -66,6 +72,11 @@ namespace Cme
 
     std::unique_ptr<Cme::Model> ModelScene::LoadModelOrDefault()
     {
+        if (!m_sModelPath.empty())
+        {
+            return std::make_unique<Cme::Model>(m_sModelPath.c_str());
+        }
+
         // Default to the gltf DamagedHelmet.
         auto helmet = std::make_unique<Cme::Model>("assets//models//DamagedHelmet/DamagedHelmet.gltf");
         return helmet;
@@ -14,12 +14,17 @@ namespace Cme
 
         void Init(ImageSize windowSize);
         void Render(ModelRenderOptions stModelRenderOptions, std::shared_ptr<Cme::Camera> spCamera, std::shared_ptr<Cme::DeferredGeometryPassShader> spGeometryPassShader = nullptr, bool bShowNormal = false);
+        // Draws only the geometry, e.g. into a shadow map.
+        void RenderDepth(const ModelRenderOptions& stModelRenderOptions, Cme::Shader& shader);
         void Update();
 
         std::unique_ptr<Cme::Model> LoadModelOrDefault();
+        // Model loaded by Init instead of the default one. Empty for the default.
+        void SetModelPath(const std::string& sPath) { m_sModelPath = sPath; }
 
     private:
         ImageSize m_Size;
+        std::string m_sModelPath;
 
     private:
         // Model
@@ -0,0 +1,215 @@
+#include "session_log.h"
+#include "core/frame_clock.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace Cme
+{
+    static_assert(std::is_trivially_copyable<ModelRenderOptions>::value,
+                  "ModelRenderOptions is diffed as raw memory");
+
+    const char SESSION_LOG_MAGIC[4] = { 'C', 'M', 'E', 'S' };
+    const uint32_t SESSION_LOG_VERSION = 1;
+    const size_t OPTIONS_WORDS = (sizeof(ModelRenderOptions) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    namespace
+    {
+        // Copies the options that aren't user state from `src`: outputs of the
+        // renderer, which it writes back every frame, and one-shot triggers,
+        // which must not fire again on replay.
+        void copyNonUserOptions(ModelRenderOptions& dst, const ModelRenderOptions& src)
+        {
+            dst.frameDeltas = src.frameDeltas;
+            dst.numFrameDeltas = src.numFrameDeltas;
+            dst.frameDeltasOffset = src.frameDeltasOffset;
+            dst.avgFPS = src.avgFPS;
+            dst.shadowAtlasLights = src.shadowAtlasLights;
+            dst.shadowAtlasTiles = src.shadowAtlasTiles;
+            dst.renderScale = src.renderScale;
+            dst.speed = src.speed;
+            dst.fov = src.fov;
+            dst.near = src.near;
+            dst.far = src.far;
+            dst.captureScreenshot = src.captureScreenshot;
+            dst.validateLightClusters = src.validateLightClusters;
+        }
+
+        // Raw words of the options, with the fields that aren't user state at
+        // their defaults.
+        std::vector<uint32_t> optionsToWords(const ModelRenderOptions& opts)
+        {
+            ModelRenderOptions sanitized = opts;
+            copyNonUserOptions(sanitized, ModelRenderOptions());
+
+            std::vector<uint32_t> words(OPTIONS_WORDS, 0);
+            std::copy_n(reinterpret_cast<const unsigned char*>(&sanitized), sizeof(ModelRenderOptions),
+                        reinterpret_cast<unsigned char*>(words.data()));
+            return words;
+        }
+
+        template <typename T>
+        void writeValue(std::ofstream& out, const T& value)
+        {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool readValue(std::ifstream& in, T& value)
+        {
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+    }
+
+    CameraState CameraState::Capture(const Camera& camera)
+    {
+        CameraState state;
+        state.position = camera.getPosition();
+        state.yaw = camera.getYaw();
+        state.pitch = camera.getPitch();
+        state.fov = camera.getFov();
+        state.aspectRatio = camera.getAspectRatio();
+        state.nearPlane = camera.getNearPlane();
+        state.farPlane = camera.getFarPlane();
+        return state;
+    }
+
+    void CameraState::Apply(Camera& camera) const
+    {
+        camera.setPosition(position);
+        camera.setYaw(yaw);
+        camera.setPitch(pitch);
+        camera.setFov(fov);
+        camera.setAspectRatio(aspectRatio);
+        camera.setNearPlane(nearPlane);
+        camera.setFarPlane(farPlane);
+    }
+
+    SessionRecorder::SessionRecorder(const std::string& sPath)
+        : m_Out(sPath, std::ios::binary), m_vecPrevOptions(OPTIONS_WORDS, 0)
+    {
+        if (!m_Out)
+        {
+            throw SessionLogException("ERROR::SESSION_LOG::OPEN_FAILED: " + sPath);
+        }
+        m_Out.write(SESSION_LOG_MAGIC, sizeof(SESSION_LOG_MAGIC));
+        writeValue(m_Out, SESSION_LOG_VERSION);
+        writeValue(m_Out, static_cast<uint32_t>(sizeof(ModelRenderOptions)));
+    }
+
+    void SessionRecorder::RecordFrame(float delta, const Camera& camera, const ModelRenderOptions& opts)
+    {
+        writeValue(m_Out, delta);
+        writeValue(m_Out, CameraState::Capture(camera));
+
+        // Collect runs of changed words.
+        std::vector<uint32_t> words = optionsToWords(opts);
+        std::vector<std::pair<uint16_t, uint16_t>> runs;
+        for (size_t i = 0; i < OPTIONS_WORDS; ++i)
+        {
+            if (words[i] == m_vecPrevOptions[i])
+            {
+                continue;
+            }
+            if (!runs.empty() && runs.back().first + runs.back().second == i)
+            {
+                ++runs.back().second;
+            }
+            else
+            {
+                runs.emplace_back(static_cast<uint16_t>(i), 1);
+            }
+        }
+
+        writeValue(m_Out, static_cast<uint16_t>(runs.size()));
+        for (const auto& run : runs)
+        {
+            writeValue(m_Out, run.first);
+            writeValue(m_Out, run.second);
+            m_Out.write(reinterpret_cast<const char*>(&words[run.first]), run.second * sizeof(uint32_t));
+        }
+        m_vecPrevOptions = std::move(words);
+    }
+
+    SessionReplayer::SessionReplayer(const std::string& sPath)
+    {
+        std::ifstream in(sPath, std::ios::binary);
+        if (!in)
+        {
+            throw SessionLogException("ERROR::SESSION_LOG::OPEN_FAILED: " + sPath);
+        }
+
+        char magic[4] = {};
+        uint32_t version = 0;
+        uint32_t optionsSize = 0;
+        in.read(magic, sizeof(magic));
+        if (!in || std::memcmp(magic, SESSION_LOG_MAGIC, sizeof(magic)) != 0 ||
+            !readValue(in, version) || version != SESSION_LOG_VERSION)
+        {
+            throw SessionLogException("ERROR::SESSION_LOG::INVALID_HEADER: " + sPath);
+        }
+        if (!readValue(in, optionsSize) || optionsSize != sizeof(ModelRenderOptions))
+        {
+            throw SessionLogException("ERROR::SESSION_LOG::OPTIONS_LAYOUT_MISMATCH: " + sPath);
+        }
+
+        std::vector<uint32_t> options(OPTIONS_WORDS, 0);
+        while (true)
+        {
+            Frame frame;
+            if (!readValue(in, frame.delta))
+            {
+                break;
+            }
+            uint16_t runCount = 0;
+            if (!readValue(in, frame.camera) || !readValue(in, runCount))
+            {
+                throw SessionLogException("ERROR::SESSION_LOG::TRUNCATED: " + sPath);
+            }
+            for (uint16_t r = 0; r < runCount; ++r)
+            {
+                uint16_t offset = 0;
+                uint16_t count = 0;
+                if (!readValue(in, offset) || !readValue(in, count) || offset + count > OPTIONS_WORDS ||
+                    !in.read(reinterpret_cast<char*>(&options[offset]), count * sizeof(uint32_t)))
+                {
+                    throw SessionLogException("ERROR::SESSION_LOG::TRUNCATED: " + sPath);
+                }
+            }
+            frame.options = options;
+            m_vecFrames.push_back(std::move(frame));
+        }
+    }
+
+    void SessionReplayer::Attach()
+    {
+        FrameClock::GetInstance().SetDeltaSource([this](float& delta)
+        {
+            ++m_iFrame;
+            if (IsFinished())
+            {
+                return false;
+            }
+            delta = m_vecFrames[m_iFrame].delta;
+            return true;
+        });
+    }
+
+    void SessionReplayer::Apply(Camera& camera, ModelRenderOptions& opts) const
+    {
+        if (m_iFrame < 0 || IsFinished())
+        {
+            return;
+        }
+        const Frame& frame = m_vecFrames[m_iFrame];
+        frame.camera.Apply(camera);
+
+        // The fields that aren't user state keep their live values.
+        ModelRenderOptions replayed = opts;
+        std::copy_n(reinterpret_cast<const unsigned char*>(frame.options.data()), sizeof(ModelRenderOptions),
+                    reinterpret_cast<unsigned char*>(&replayed));
+        copyNonUserOptions(replayed, opts);
+        opts = replayed;
+    }
+}  // namespace Cme
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "camera.h"
+#include "cme_defs.h"
+#include "exceptions.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Cme
+{
+	class SessionLogException : public QuarkException
+	{
+		using QuarkException::QuarkException;
+	};
+
+	// Camera state needed to reproduce the view and projection.
+	struct CameraState
+	{
+		glm::vec3 position = glm::vec3(0.0f);
+		float yaw = 0.0f;
+		float pitch = 0.0f;
+		float fov = 0.0f;
+		float aspectRatio = 0.0f;
+		float nearPlane = 0.0f;
+		float farPlane = 0.0f;
+
+		static CameraState Capture(const Camera& camera);
+		void Apply(Camera& camera) const;
+	};
+
+	// Binary session log layout (little endian, as written by the host):
+	//
+	//   header: "CMES", uint32 version, uint32 sizeof(ModelRenderOptions)
+	//   frame:  float delta, CameraState,
+	//           uint16 run count, runs of { uint16 word offset, uint16 word
+	//           count, uint32 words[] } patching the previous frame's options
+	//
+	// The options are diffed as raw 32-bit words against the previous frame
+	// (zeroes before the first), so a frame without UI changes costs a few
+	// bytes and any new option field is covered without touching the format.
+	// Logs only replay on a build with the same options layout.
+	class SessionRecorder
+	{
+	public:
+		explicit SessionRecorder(const std::string& sPath);
+
+		void RecordFrame(float delta, const Camera& camera, const ModelRenderOptions& opts);
+
+	private:
+		std::ofstream m_Out;
+		std::vector<uint32_t> m_vecPrevOptions;
+	};
+
+	// Reads a whole session log and plays it back: the deltas through the
+	// FrameClock, camera and options through Apply().
+	class SessionReplayer
+	{
+	public:
+		explicit SessionReplayer(const std::string& sPath);
+
+		// Installs the recorded deltas as the FrameClock source.
+		void Attach();
+		// Overwrites camera and options with the state of the current frame.
+		// Per-frame statistics in `opts` are left untouched.
+		void Apply(Camera& camera, ModelRenderOptions& opts) const;
+
+		bool IsFinished() const { return m_iFrame >= (int)m_vecFrames.size(); }
+		int GetFrameCount() const { return (int)m_vecFrames.size(); }
+
+	private:
+		struct Frame
+		{
+			float delta;
+			CameraState camera;
+			std::vector<uint32_t> options;
+		};
+
+		std::vector<Frame> m_vecFrames;
+		// Frame whose delta was handed out last.
+		int m_iFrame = -1;
+	};
+}  // namespace Cme
@@ -175,6 +175,18 @@ namespace Cme
         glUniform4f(safeGetUniformLocation(name), v0, v1, v2, w);
     }
 
+    void Shader::setVec2(const char* name, const glm::vec2& vector)
+    {
+        activate();
+        glUniform2fv(safeGetUniformLocation(name), 1, glm::value_ptr(vector));
+    }
+
+    void Shader::setIVec3(const char* name, const glm::ivec3& vector)
+    {
+        activate();
+        glUniform3iv(safeGetUniformLocation(name), 1, glm::value_ptr(vector));
+    }
+
     void Shader::setMat4(const char* name, const glm::mat4& matrix) 
     {
         activate();
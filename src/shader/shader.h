@@ -70,6 +70,10 @@ namespace Cme
 
         void setVec4(const char* name, float v0, float v1, float v2, float w);
 
+        void setVec2(const char* name, const glm::vec2& vector);
+
+        void setIVec3(const char* name, const glm::ivec3& vector);
+
         virtual void setMat4(const char* name, const glm::mat4& matrix);
         void setMat4(std::string name, const glm::mat4& matrix) 
         {
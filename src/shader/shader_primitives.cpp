@@ -50,7 +50,13 @@ namespace Cme
 
     ShadowMapShader::ShadowMapShader()
         : Shader(ShaderPath("assets//shaders//builtin//shadow_map.vert"),
-                 ShaderPath("assets//shaders//builtin//shadow_map.frag")) {}
+                 ShaderPath("assets//shaders//builtin//shadow_map.frag"),
+                 ShaderPath("assets//shaders//builtin//shadow_map.geom")) {}
+
+    ShadowAtlasShader::ShadowAtlasShader()
+        : Shader(ShaderPath("assets//shaders//builtin//shadow_map.vert"),
+                 ShaderPath("assets//shaders//builtin//shadow_map.frag"),
+                 ShaderPath("assets//shaders//builtin//shadow_atlas.geom")) {}
 
 
     CubemapIrradianceShader::CubemapIrradianceShader()
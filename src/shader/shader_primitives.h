@@ -43,6 +43,13 @@ namespace Cme
         ShadowMapShader();
     };
 
+    // Renders the faces of a ShadowAtlas light into their tiles.
+    class ShadowAtlasShader : public Shader
+    {
+    public:
+        ShadowAtlasShader();
+    };
+
     // HDR---ͼShader
     class EquirectCubemapShader : public Shader
     {
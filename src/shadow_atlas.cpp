@@ -0,0 +1,404 @@
+#include "shadow_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm/gtc/matrix_transform.hpp>
+#include <string>
+
+namespace Cme
+{
+    namespace
+    {
+        // Look directions and up vectors of the cube faces, in the order of
+        // qrk_cubeFace() in shadow_atlas.glsl.
+        const glm::vec3 CUBE_FACE_DIRECTIONS[6] = {
+            glm::vec3(1.0f, 0.0f, 0.0f),  glm::vec3(-1.0f, 0.0f, 0.0f),
+            glm::vec3(0.0f, 1.0f, 0.0f),  glm::vec3(0.0f, -1.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec3(0.0f, 0.0f, -1.0f),
+        };
+        const glm::vec3 CUBE_FACE_UPS[6] = {
+            glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec3(0.0f, 0.0f, -1.0f),
+            glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        };
+
+        // Widest spot light cone that still gets a usable perspective.
+        constexpr float MAX_SPOT_SHADOW_FOV = glm::radians(170.0f);
+
+        constexpr float SHADOW_SLOPE_BIAS = 2.0f;
+        constexpr float SHADOW_CONSTANT_BIAS = 4.0f;
+
+        // World space frustum planes of the given view projection, as
+        // (normal, distance) with normals pointing inside.
+        void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+        {
+            glm::vec4 rows[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i],
+                                    viewProjection[3][i]);
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                planes[i * 2] = rows[3] + rows[i];
+                planes[i * 2 + 1] = rows[3] - rows[i];
+            }
+            for (int i = 0; i < 6; ++i)
+            {
+                planes[i] /= glm::length(glm::vec3(planes[i]));
+            }
+        }
+
+        bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius)
+        {
+            for (int i = 0; i < 6; ++i)
+            {
+                if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Conservative: only rejects when all corners of the other frustum are
+        // outside one plane.
+        bool frustumInFrustum(const glm::vec4 planes[6], const glm::mat4& viewProjection)
+        {
+            glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+            glm::vec3 corners[8];
+            for (int i = 0; i < 8; ++i)
+            {
+                glm::vec4 corner = inverseViewProjection * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f,
+                                                                     (i & 4) ? 1.0f : -1.0f, 1.0f);
+                corners[i] = glm::vec3(corner) / corner.w;
+            }
+            for (int i = 0; i < 6; ++i)
+            {
+                bool allOutside = true;
+                for (const glm::vec3& corner : corners)
+                {
+                    if (glm::dot(glm::vec3(planes[i]), corner) + planes[i].w >= 0.0f)
+                    {
+                        allOutside = false;
+                        break;
+                    }
+                }
+                if (allOutside)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int nextPowerOfTwo(int value)
+        {
+            int result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        int faceCount(unsigned int faceMask)
+        {
+            int count = 0;
+            for (; faceMask; faceMask &= faceMask - 1)
+            {
+                ++count;
+            }
+            return count;
+        }
+
+        // Splits the bits of a Morton code into x (even bits) and y (odd bits).
+        glm::ivec2 decodeMorton(uint64_t code)
+        {
+            glm::ivec2 result(0);
+            for (int bit = 0; bit < 32; ++bit)
+            {
+                result.x |= int((code >> (2 * bit)) & 1) << bit;
+                result.y |= int((code >> (2 * bit + 1)) & 1) << bit;
+            }
+            return result;
+        }
+    }
+
+    ShadowAtlas::ShadowAtlas(int size) : Framebuffer(size, size), m_iSize(size)
+    {
+        if (size <= 0 || (size & (size - 1)) != 0)
+        {
+            throw ShadowException("ERROR::SHADOW_ATLAS::SIZE_NOT_POWER_OF_TWO\n" + std::to_string(size));
+        }
+
+        // Tiles are sampled with hardware depth comparison and clamped to their
+        // rect in the shader, so the wrap mode doesn't matter.
+        TextureParams params;
+        params.filtering = TextureFiltering::BILINEAR;
+        params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+        m_DepthAttachmentObj = AttachTexture2FB_i(BufferType::DEPTH, params);
+        glTextureParameteri(m_DepthAttachmentObj.m_uiID, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTextureParameteri(m_DepthAttachmentObj.m_uiID, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        glCreateBuffers(1, &m_uiTileBuffer);
+        glCreateBuffers(1, &m_uiLightTileBuffer);
+        // Bindable before the first Update(), with no light shadowed.
+        GpuShadowTile emptyTile = {};
+        int noTile = -1;
+        glNamedBufferData(m_uiTileBuffer, sizeof(GpuShadowTile), &emptyTile, GL_STREAM_DRAW);
+        glNamedBufferData(m_uiLightTileBuffer, sizeof(int), &noTile, GL_STREAM_DRAW);
+    }
+
+    ShadowAtlas::~ShadowAtlas()
+    {
+        glDeleteBuffers(1, &m_uiTileBuffer);
+        glDeleteBuffers(1, &m_uiLightTileBuffer);
+    }
+
+    void ShadowAtlas::AddCaster(ShadowCasterDraw draw)
+    {
+        m_vecCasters.push_back(std::move(draw));
+    }
+
+    void ShadowAtlas::Update(const LightControl& lights, const Camera& camera, ImageSize screenSize)
+    {
+        m_vecRequests.clear();
+        m_vecTiles.clear();
+        unsigned int pointCount = lights.getPointLightCount();
+        m_vecLightTiles.assign(std::max(pointCount + lights.getSpotLightCount(), 1u), -1);
+
+        // Tiles map from view space, which is where the lighting pass shades.
+        glm::mat4 view = camera.getViewTransform();
+        glm::mat4 inverseView = glm::inverse(view);
+        m_mat4ViewToWorld = inverseView;
+        glm::vec4 planes[6];
+        extractFrustumPlanes(camera.getProjectionTransform() * view, planes);
+        glm::vec3 cameraPosition = glm::vec3(inverseView[3]);
+        float tanHalfFov = std::tan(glm::radians(camera.getFov()) * 0.5f);
+
+        for (const auto& light : lights.getLights())
+        {
+            if (!light->getCastShadows())
+            {
+                continue;
+            }
+
+            TileRequest request = {};
+            glm::vec3 position;
+            float range;
+            float near;
+            if (light->getLightType() == LightType::POINT_LIGHT)
+            {
+                auto pointLight = std::static_pointer_cast<PointLight>(light);
+                position = pointLight->getPosition();
+                range = pointLight->getRange();
+                near = std::max(0.01f, range * 0.01f);
+
+                glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, near, range);
+                for (int face = 0; face < 6; ++face)
+                {
+                    glm::mat4 faceView =
+                        glm::lookAt(position, position + CUBE_FACE_DIRECTIONS[face], CUBE_FACE_UPS[face]);
+                    request.faceViewProjections[face] = projection * faceView;
+                }
+                request.numFaces = 6;
+                request.lightSlot = light->m_uiLightIdx;
+            }
+            else if (light->getLightType() == LightType::SPOT_LIGHT)
+            {
+                auto spotLight = std::static_pointer_cast<SpotLight>(light);
+                position = spotLight->getPosition();
+                range = spotLight->getRange();
+                near = std::max(0.01f, range * 0.01f);
+
+                glm::vec3 direction = glm::normalize(spotLight->getDirection());
+                glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                float fov = std::min(2.0f * spotLight->getOuterAngle(), MAX_SPOT_SHADOW_FOV);
+                request.faceViewProjections[0] = glm::perspective(fov, 1.0f, near, range) *
+                                                 glm::lookAt(position, position + direction, up);
+                request.numFaces = 1;
+                request.lightSlot = pointCount + light->m_uiLightIdx;
+            }
+            else
+            {
+                continue;
+            }
+
+            if (!sphereInFrustum(planes, position, range))
+            {
+                continue;
+            }
+            for (int face = 0; face < request.numFaces; ++face)
+            {
+                if (frustumInFrustum(planes, request.faceViewProjections[face]))
+                {
+                    request.faceMask |= 1u << face;
+                }
+            }
+            if (request.faceMask == 0)
+            {
+                continue;
+            }
+
+            // Screen height covered by the light's sphere of influence. From
+            // inside the sphere it covers the whole screen.
+            float distance = glm::length(position - cameraPosition);
+            request.coverage = float(screenSize.height);
+            if (distance > range)
+            {
+                float projectedRadius = range / (std::sqrt(distance * distance - range * range) * tanHalfFov);
+                request.coverage = std::min(request.coverage, projectedRadius * screenSize.height);
+            }
+            int size = int(std::ceil(request.coverage * m_fCoverageScale));
+            request.size = std::clamp(nextPowerOfTwo(size), m_iMinTileSize, std::min(m_iMaxTileSize, m_iSize));
+
+            request.firstTile = (int)m_vecTiles.size();
+            for (int face = 0; face < request.numFaces; ++face)
+            {
+                GpuShadowTile tile;
+                tile.viewProjection = request.faceViewProjections[face] * inverseView;
+                tile.atlasRect = glm::vec4(0.0f);
+                m_vecTiles.push_back(tile);
+            }
+            m_vecRequests.push_back(request);
+        }
+
+        packTiles();
+
+        for (const TileRequest& request : m_vecRequests)
+        {
+            m_vecLightTiles[request.lightSlot] = request.firstTile;
+        }
+
+        // Keep at least one element, since an empty buffer can't be bound.
+        GpuShadowTile emptyTile = {};
+        const GpuShadowTile* tiles = m_vecTiles.empty() ? &emptyTile : m_vecTiles.data();
+        glNamedBufferData(m_uiTileBuffer, std::max<size_t>(m_vecTiles.size(), 1) * sizeof(GpuShadowTile), tiles,
+                          GL_STREAM_DRAW);
+        glNamedBufferData(m_uiLightTileBuffer, m_vecLightTiles.size() * sizeof(int), m_vecLightTiles.data(),
+                          GL_STREAM_DRAW);
+    }
+
+    void ShadowAtlas::packTiles()
+    {
+        // Most important lights first, so that the ones dropped are the least
+        // visible.
+        std::stable_sort(m_vecRequests.begin(), m_vecRequests.end(),
+                         [](const TileRequest& a, const TileRequest& b) { return a.coverage > b.coverage; });
+
+        auto totalArea = [this]() {
+            uint64_t area = 0;
+            for (const TileRequest& request : m_vecRequests)
+            {
+                area += uint64_t(faceCount(request.faceMask)) * request.size * request.size;
+            }
+            return area;
+        };
+        uint64_t capacity = uint64_t(m_iSize) * m_iSize;
+        while (totalArea() > capacity)
+        {
+            // Halve the largest tiles first, which evens out the resolution
+            // before anything small gets smaller.
+            int largest = 0;
+            for (const TileRequest& request : m_vecRequests)
+            {
+                largest = std::max(largest, request.size);
+            }
+            if (largest > m_iMinTileSize)
+            {
+                for (TileRequest& request : m_vecRequests)
+                {
+                    if (request.size == largest)
+                    {
+                        request.size /= 2;
+                    }
+                }
+            }
+            else
+            {
+                m_vecRequests.pop_back();
+            }
+        }
+
+        // Power of two tiles placed from the largest down along a Z-order
+        // curve never overlap and leave no gaps.
+        struct Placement
+        {
+            int tile;
+            int size;
+        };
+        std::vector<Placement> placements;
+        for (const TileRequest& request : m_vecRequests)
+        {
+            for (int face = 0; face < request.numFaces; ++face)
+            {
+                if (request.faceMask & (1u << face))
+                {
+                    placements.push_back({ request.firstTile + face, request.size });
+                }
+            }
+        }
+        std::stable_sort(placements.begin(), placements.end(),
+                         [](const Placement& a, const Placement& b) { return a.size > b.size; });
+
+        uint64_t offset = 0;
+        for (const Placement& placement : placements)
+        {
+            uint64_t area = uint64_t(placement.size) * placement.size;
+            glm::ivec2 origin = decodeMorton(offset);
+            m_vecTiles[placement.tile].atlasRect =
+                glm::vec4(origin.x, origin.y, placement.size, placement.size) / float(m_iSize);
+            offset += area;
+        }
+        m_iTileCount = (int)placements.size();
+    }
+
+    void ShadowAtlas::Render(Shader& shader)
+    {
+        activate();
+        clear();
+        if (m_vecRequests.empty() || m_vecCasters.empty())
+        {
+            deactivate();
+            return;
+        }
+
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(SHADOW_SLOPE_BIAS, SHADOW_CONSTANT_BIAS);
+        for (const TileRequest& request : m_vecRequests)
+        {
+            // Geometry shader invocation i draws face i into viewport i.
+            for (int face = 0; face < request.numFaces; ++face)
+            {
+                if ((request.faceMask & (1u << face)) == 0)
+                {
+                    continue;
+                }
+                glm::vec4 rect = m_vecTiles[request.firstTile + face].atlasRect * float(m_iSize);
+                glViewportIndexedf(face, rect.x, rect.y, rect.z, rect.w);
+                shader.setMat4("faceViewProjections[" + std::to_string(face) + "]",
+                               request.faceViewProjections[face]);
+            }
+            shader.setInt("faceMask", request.faceMask);
+            for (const ShadowCasterDraw& draw : m_vecCasters)
+            {
+                draw(shader);
+            }
+        }
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        deactivate();
+    }
+
+    unsigned int ShadowAtlas::bindTexture(unsigned int nextTextureUnit, Shader& shader)
+    {
+        m_DepthAttachmentObj.Transform2Texture()->BindToUnit(nextTextureUnit);
+        shader.setInt("qrk_shadowAtlas", nextTextureUnit);
+        shader.setMat4("qrk_shadowViewToWorld", m_mat4ViewToWorld);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SHADOW_TILE_BUFFER_BINDING, m_uiTileBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_SHADOW_BUFFER_BINDING, m_uiLightTileBuffer);
+        return nextTextureUnit + 1;
+    }
+
+}  // namespace Cme
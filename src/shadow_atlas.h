@@ -0,0 +1,106 @@
+#ifndef QUARKGL_SHADOW_ATLAS_H_
+#define QUARKGL_SHADOW_ATLAS_H_
+
+#include "camera.h"
+#include "framebuffer.h"
+#include "lighting/light_control.h"
+#include "screen.h"
+#include "shader/shader.h"
+#include "shadows.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+namespace Cme
+{
+    // SSBO binding points of the atlas tiles, see shadow_atlas.glsl.
+    constexpr GLuint SHADOW_TILE_BUFFER_BINDING = 5;
+    constexpr GLuint LIGHT_SHADOW_BUFFER_BINDING = 6;
+
+    // std430 layout of an atlas tile.
+    struct GpuShadowTile
+    {
+        // From view space to the tile's clip space.
+        glm::mat4 viewProjection;
+        // xy: offset, zw: size, in atlas texture coordinates. Zero size for
+        // faces that got no tile.
+        glm::vec4 atlasRect;
+    };
+
+    // Shadows of point and spot lights, packed into the tiles of one depth
+    // texture. Each frame the shadow casting lights that touch the camera
+    // frustum get a power of two tile size from their screen coverage; point
+    // lights get one tile per cube face that intersects the camera frustum.
+    // Lights are rendered one draw per caster, with a geometry shader routing
+    // each triangle to the viewport of every visible face.
+    class ShadowAtlas : public Framebuffer
+    {
+    public:
+        // `size` must be a power of two.
+        explicit ShadowAtlas(int size = 4096);
+        virtual ~ShadowAtlas();
+
+        void AddCaster(ShadowCasterDraw draw);
+
+        // Assigns tiles to the shadow casting lights of `lights` and uploads the
+        // tile buffers. `screenSize` is the size of the shaded image.
+        void Update(const LightControl& lights, const Camera& camera, ImageSize screenSize);
+        // Renders the assigned tiles with the given depth shader, see
+        // shadow_atlas.geom.
+        void Render(Shader& shader);
+
+        // Tile texels per pixel of screen coverage.
+        float getCoverageScale() const { return m_fCoverageScale; }
+        void setCoverageScale(float scale) { m_fCoverageScale = scale; }
+        int getMinTileSize() const { return m_iMinTileSize; }
+        void setMinTileSize(int size) { m_iMinTileSize = size; }
+        int getMaxTileSize() const { return m_iMaxTileSize; }
+        void setMaxTileSize(int size) { m_iMaxTileSize = size; }
+
+        std::shared_ptr<Texture> getDepthTexture() { return m_DepthAttachmentObj.Transform2Texture(); }
+        int getShadowedLightCount() const { return (int)m_vecRequests.size(); }
+        int getTileCount() const { return m_iTileCount; }
+
+        // Binds the atlas and tile buffers for shadow_atlas.glsl.
+        unsigned int bindTexture(unsigned int nextTextureUnit, Shader& shader);
+
+    private:
+        struct TileRequest
+        {
+            // Index into the light tile buffer.
+            int lightSlot;
+            // Index into m_vecTiles of the first face.
+            int firstTile;
+            int numFaces;
+            unsigned int faceMask;
+            int size;
+            float coverage;
+            glm::mat4 faceViewProjections[6];
+        };
+
+        int m_iSize;
+        Attachment m_DepthAttachmentObj;
+        float m_fCoverageScale = 1.0f;
+        int m_iMinTileSize = 64;
+        int m_iMaxTileSize = 1024;
+        glm::mat4 m_mat4ViewToWorld = glm::mat4(1.0f);
+
+        std::vector<ShadowCasterDraw> m_vecCasters;
+        std::vector<TileRequest> m_vecRequests;
+        std::vector<GpuShadowTile> m_vecTiles;
+        std::vector<int> m_vecLightTiles;
+        int m_iTileCount = 0;
+
+        GLuint m_uiTileBuffer = 0;
+        GLuint m_uiLightTileBuffer = 0;
+
+        // Places the visible faces of all requests, shrinking tiles until they
+        // fit. Requests that still don't fit at the minimum size are dropped.
+        void packTiles();
+    };
+
+}  // namespace Cme
+
+#endif
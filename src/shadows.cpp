@@ -1,50 +1,336 @@
 #include "shadows.h"
 
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <limits>
+#include <string>
+
 namespace Cme
 {
 
-    ShadowMapCamera::ShadowMapCamera(std::shared_ptr<DirectionalLight> light,
+    CascadedShadowMap::CascadedShadowMap(std::shared_ptr<DirectionalLight> light, int resolution, int numCascades)
+        : Framebuffer(resolution, resolution),
+        m_spLight(light),
+        m_iResolution(resolution),
+        m_iMaxCascades(numCascades),
+        m_iNumCascades(numCascades)
+    {
+        if (numCascades < 1 || numCascades > MAX_SHADOW_CASCADES)
+        {
+            throw ShadowException("ERROR::SHADOW::INVALID_CASCADE_COUNT\n" + std::to_string(numCascades));
+        }
+
+        // One depth layer per cascade. Sampled with hardware depth comparison, so
+        // bilinear filtering gives 2x2 PCF per tap. Outside the map is lit.
+        TextureParams params;
+        params.filtering = TextureFiltering::BILINEAR;
+        params.wrapMode = TextureWrapMode::CLAMP_TO_BORDER;
+        params.borderColor = glm::vec4(1.0f);
+        m_DepthAttachmentObj = AttachTextureArray2FB(BufferType::DEPTH, numCascades, params);
+        glTextureParameteri(m_DepthAttachmentObj.m_uiID, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTextureParameteri(m_DepthAttachmentObj.m_uiID, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        // Static casters only. Copied into the map above, so no comparison here.
+        TextureParams cacheParams;
+        cacheParams.filtering = TextureFiltering::NEAREST;
+        cacheParams.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+        m_upStaticCacheFb = std::make_unique<Framebuffer>(resolution, resolution);
+        m_StaticCacheAttachmentObj = m_upStaticCacheFb->AttachTextureArray2FB(BufferType::DEPTH, numCascades, cacheParams);
 
-                               float cuboidExtents, float near, float far,
-                               float shadowCameraDistanceFromOrigin,
-                               glm::vec3 worldUp)
-        : m_spLight(light),
-        m_fCuboidExtents(cuboidExtents),
-        m_fNear(near),
-        m_fFar(far),
-        m_fShadowCameraDistanceFromOrigin(shadowCameraDistanceFromOrigin),
-        m_vec3WorldUp(worldUp) {}
+        glCreateQueries(GL_TIME_ELAPSED, 1, &m_uiRefreshQuery);
 
-    glm::mat4 ShadowMapCamera::getViewTransform()
+        m_vecFitted.resize(numCascades);
+        m_vecCascades.resize(numCascades);
+        m_vecCacheStates.resize(numCascades);
+    }
+
+    CascadedShadowMap::~CascadedShadowMap()
     {
-        return glm::lookAt(m_fShadowCameraDistanceFromOrigin * -m_spLight->getDirection(),
-                            glm::vec3(0.0f), m_vec3WorldUp);
+        glDeleteQueries(1, &m_uiRefreshQuery);
     }
 
-    glm::mat4 ShadowMapCamera::getProjectionTransform()
+    void CascadedShadowMap::AddCaster(ShadowCasterType type, ShadowCasterDraw draw)
     {
-        // Directional lights cast orthographic shadows.
-        return glm::ortho(-m_fCuboidExtents, m_fCuboidExtents, -m_fCuboidExtents,
-            m_fCuboidExtents, m_fNear, m_fFar);
+        if (type == ShadowCasterType::STATIC)
+        {
+            m_vecStaticCasters.push_back(std::move(draw));
+            InvalidateStaticCasters();
+        }
+        else
+        {
+            m_vecDynamicCasters.push_back(std::move(draw));
+        }
     }
 
-    ShadowMap::ShadowMap(int width, int height) : Framebuffer(width, height)
+    void CascadedShadowMap::InvalidateStaticCasters()
     {
-        // Attach the depth texture used for the shadow map.
-        // TODO: Support omnidirectional shadow maps.
-        TextureParams params;
-        params.filtering = TextureFiltering::NEAREST;
-        params.wrapMode = TextureWrapMode::CLAMP_TO_BORDER;
-        params.borderColor = glm::vec4(1.0f);
-        m_DepthAttachmentObj = AttachTexture2FB_i(BufferType::DEPTH, params);
+        for (CacheState& state : m_vecCacheStates)
+        {
+            state.valid = false;
+        }
+    }
+
+    void CascadedShadowMap::setCaching(bool caching)
+    {
+        if (m_bCaching != caching)
+        {
+            m_bCaching = caching;
+            InvalidateStaticCasters();
+        }
+    }
+
+    void CascadedShadowMap::setNumCascades(int numCascades)
+    {
+        m_iNumCascades = std::clamp(numCascades, 1, m_iMaxCascades);
+    }
+
+    void CascadedShadowMap::Update(const Camera& camera)
+    {
+        float near = camera.getNearPlane();
+        float far = std::min(camera.getFarPlane(), m_fShadowDistance);
+        glm::mat4 view = camera.getViewTransform();
+
+        // All cascades share one light orientation anchored at the world origin,
+        // so snapping to its texel grid is stable under camera translation.
+        glm::vec3 lightDir = glm::normalize(m_spLight->getDirection());
+        if (lightDir != m_vec3CachedLightDir)
+        {
+            m_vec3CachedLightDir = lightDir;
+            InvalidateStaticCasters();
+        }
+        glm::vec3 up = std::abs(lightDir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), lightDir, up);
+
+        float splitNear = near;
+        for (int i = 0; i < m_iNumCascades; ++i)
+        {
+            // Practical split scheme: blend of logarithmic and uniform splits.
+            float p = float(i + 1) / float(m_iNumCascades);
+            float logSplit = near * std::pow(far / near, p);
+            float uniformSplit = near + (far - near) * p;
+            float splitFar = glm::mix(uniformSplit, logSplit, m_fSplitLambda);
+
+            // World space corners of the frustum slice.
+            glm::mat4 sliceProjection = glm::perspective(glm::radians(camera.getFov()), camera.getAspectRatio(),
+                                                         splitNear, splitFar);
+            glm::mat4 inverseSlice = glm::inverse(sliceProjection * view);
+            glm::vec3 corners[8];
+            for (int c = 0; c < 8; ++c)
+            {
+                glm::vec4 ndc((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f, 1.0f);
+                glm::vec4 corner = inverseSlice * ndc;
+                corners[c] = glm::vec3(corner) / corner.w;
+            }
+
+            glm::vec3 minBounds(std::numeric_limits<float>::max());
+            glm::vec3 maxBounds(-std::numeric_limits<float>::max());
+            if (m_bStableFit)
+            {
+                glm::vec3 center(0.0f);
+                for (const glm::vec3& corner : corners)
+                {
+                    center += corner / 8.0f;
+                }
+                float radius = 0.0f;
+                for (const glm::vec3& corner : corners)
+                {
+                    radius = std::max(radius, glm::length(corner - center));
+                }
+                // Quantize so float noise doesn't change the texel size.
+                radius = std::ceil(radius * 16.0f) / 16.0f;
+
+                glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+                minBounds = lightCenter - radius;
+                maxBounds = lightCenter + radius;
+            }
+            else
+            {
+                for (const glm::vec3& corner : corners)
+                {
+                    glm::vec3 lightCorner = glm::vec3(lightView * glm::vec4(corner, 1.0f));
+                    minBounds = glm::min(minBounds, lightCorner);
+                    maxBounds = glm::max(maxBounds, lightCorner);
+                }
+            }
+
+            // Snap to whole texels. One spare texel keeps the slice covered after
+            // the origin moves down to the grid.
+            glm::vec2 texel = glm::vec2(maxBounds - minBounds) / float(m_iResolution - 1);
+            glm::vec2 snappedMin = glm::floor(glm::vec2(minBounds) / texel) * texel;
+            glm::vec2 snappedMax = snappedMin + texel * float(m_iResolution);
+
+            // The light looks down -z. Casters in front of the near plane are
+            // clamped onto it by depth clamping in the shadow pass.
+            glm::mat4 lightProjection = glm::ortho(snappedMin.x, snappedMax.x, snappedMin.y, snappedMax.y,
+                                                   -maxBounds.z, -minBounds.z);
+
+            ShadowCascade& cascade = m_vecFitted[i];
+            cascade.splitFar = splitFar;
+            cascade.viewProjection = lightProjection * lightView;
+            cascade.texelSize = std::max(texel.x, texel.y);
+
+            // Snapping keeps the fit bit-identical while the camera stays within
+            // a texel, so any difference means the cached depth is off.
+            if (cascade.viewProjection != m_vecCascades[i].viewProjection ||
+                cascade.splitFar != m_vecCascades[i].splitFar)
+            {
+                m_vecCacheStates[i].valid = false;
+            }
+
+            splitNear = splitFar;
+        }
+    }
+
+    unsigned int CascadedShadowMap::scheduleRefreshes()
+    {
+        unsigned int activeMask = (1u << m_iNumCascades) - 1;
+        if (!m_bCaching)
+        {
+            return activeMask;
+        }
+
+        // The nearest cascade covers most of the screen, so it never lags.
+        unsigned int mask = m_vecCacheStates[0].valid ? 0u : 1u;
+
+        // Far cascades oldest first, while the estimated cost fits the budget.
+        std::vector<int> vecStale;
+        for (int i = 1; i < m_iNumCascades; ++i)
+        {
+            if (!m_vecCacheStates[i].valid)
+            {
+                vecStale.push_back(i);
+            }
+        }
+        std::stable_sort(vecStale.begin(), vecStale.end(), [this](int a, int b)
+        {
+            return m_vecCacheStates[a].lastRefreshFrame < m_vecCacheStates[b].lastRefreshFrame;
+        });
+
+        float spentMs = 0.0f;
+        for (size_t i = 0; i < vecStale.size(); ++i)
+        {
+            if (i > 0 && spentMs + m_fRefreshMsPerCascade > m_fRefreshBudgetMs)
+            {
+                break;
+            }
+            mask |= 1u << vecStale[i];
+            spentMs += m_fRefreshMsPerCascade;
+        }
+        return mask;
+    }
+
+    void CascadedShadowMap::Render(Shader& shader)
+    {
+        ++m_ui64Frame;
+
+        // Pick up the cost of an earlier refresh without stalling.
+        if (m_bRefreshQueryPending)
+        {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(m_uiRefreshQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                GLuint64 elapsedNs = 0;
+                glGetQueryObjectui64v(m_uiRefreshQuery, GL_QUERY_RESULT, &elapsedNs);
+                float ms = float(elapsedNs * 1e-6) / float(m_iRefreshQueryCascades);
+                m_fRefreshMsPerCascade = m_fRefreshMsPerCascade == 0.0f ? ms : glm::mix(m_fRefreshMsPerCascade, ms, 0.2f);
+                m_bRefreshQueryPending = false;
+            }
+        }
+
+        unsigned int activeMask = (1u << m_iNumCascades) - 1;
+        unsigned int refreshMask = scheduleRefreshes();
+        m_iLastRefreshCount = (int)std::bitset<32>(refreshMask).count();
+
+        // Casters in front of a cascade's near plane are flattened onto it
+        // rather than clipped.
+        glEnable(GL_DEPTH_CLAMP);
+
+        if (refreshMask)
+        {
+            bool timed = !m_bRefreshQueryPending;
+            if (timed)
+            {
+                glBeginQuery(GL_TIME_ELAPSED, m_uiRefreshQuery);
+            }
+
+            const float clearDepth = 1.0f;
+            for (int i = 0; i < m_iNumCascades; ++i)
+            {
+                if (refreshMask & (1u << i))
+                {
+                    m_vecCascades[i] = m_vecFitted[i];
+                    m_vecCacheStates[i].valid = true;
+                    m_vecCacheStates[i].lastRefreshFrame = m_ui64Frame;
+                    glClearTexSubImage(m_StaticCacheAttachmentObj.m_uiID, 0, 0, 0, i, m_iResolution, m_iResolution, 1,
+                                       GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+                }
+            }
+
+            m_upStaticCacheFb->activate();
+            updateShadowPassUniforms(shader, refreshMask);
+            for (auto& draw : m_vecStaticCasters)
+            {
+                draw(shader);
+            }
+            m_upStaticCacheFb->deactivate();
+
+            if (timed)
+            {
+                glEndQuery(GL_TIME_ELAPSED);
+                m_bRefreshQueryPending = true;
+                m_iRefreshQueryCascades = m_iLastRefreshCount;
+            }
+        }
+
+        // Start the touched layers from the static depth, then add the dynamic
+        // casters. Untouched layers keep last frame's contents.
+        unsigned int compositeMask = m_vecDynamicCasters.empty() ? refreshMask : activeMask;
+        for (int i = 0; i < m_iNumCascades; ++i)
+        {
+            if (compositeMask & (1u << i))
+            {
+                glCopyImageSubData(m_StaticCacheAttachmentObj.m_uiID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i,
+                                   m_DepthAttachmentObj.m_uiID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i,
+                                   m_iResolution, m_iResolution, 1);
+            }
+        }
+        if (!m_vecDynamicCasters.empty())
+        {
+            activate();
+            updateShadowPassUniforms(shader, activeMask);
+            for (auto& draw : m_vecDynamicCasters)
+            {
+                draw(shader);
+            }
+            deactivate();
+        }
+
+        glDisable(GL_DEPTH_CLAMP);
+    }
+
+    void CascadedShadowMap::updateShadowPassUniforms(Shader& shader, unsigned int cascadeMask)
+    {
+        for (int i = 0; i < m_iNumCascades; ++i)
+        {
+            shader.setMat4("lightViewProjections[" + std::to_string(i) + "]", m_vecCascades[i].viewProjection);
+        }
+        shader.setInt("cascadeMask", (int)cascadeMask);
     }
 
-    unsigned int ShadowMap::bindTexture(unsigned int nextTextureUnit,
-                                        Shader& shader) 
+    unsigned int CascadedShadowMap::bindTexture(unsigned int nextTextureUnit, Shader& shader)
     {
         m_DepthAttachmentObj.Transform2Texture()->BindToUnit(nextTextureUnit);
-        // TODO: Make this more generic.
-        shader.setInt("shadowMap", nextTextureUnit);
+        shader.setInt("qrk_shadowMap", nextTextureUnit);
+        for (int i = 0; i < m_iNumCascades; ++i)
+        {
+            std::string index = "[" + std::to_string(i) + "]";
+            shader.setMat4("qrk_cascadeViewProjections" + index, m_vecCascades[i].viewProjection);
+            shader.setFloat("qrk_cascadeSplits" + index, m_vecCascades[i].splitFar);
+            shader.setFloat("qrk_cascadeTexelSizes" + index, m_vecCascades[i].texelSize);
+        }
+        shader.setInt("qrk_shadowCascadeCount", m_iNumCascades);
         return nextTextureUnit + 1;
     }
 
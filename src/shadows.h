@@ -1,6 +1,7 @@
 #ifndef QUARKGL_SHADOWS_H_
 #define QUARKGL_SHADOWS_H_
 
+#include "camera.h"
 #include "exceptions.h"
 #include "framebuffer.h"
 #include "lighting/light.h"
@@ -9,69 +10,142 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
 
-namespace Cme 
+namespace Cme
 {
 
-    class ShadowException : public QuarkException 
+    class ShadowException : public QuarkException
     {
         using QuarkException::QuarkException;
     };
 
-    class ShadowMapCamera 
+    // Must match QRK_MAX_SHADOW_CASCADES in cascaded_shadows.glsl.
+    constexpr int MAX_SHADOW_CASCADES = 4;
+
+    struct ShadowCascade
     {
-    public:
-        // TODO: Currently only renders the origin. Make this more dynamic, and have
-        // it automatically determine a best-fit frustum based on the scene.
-        ShadowMapCamera(std::shared_ptr<DirectionalLight> light,
-                    float cuboidExtents = 10.0f, float near = 0.1f,
-                    float far = 15.0f, float shadowCameraDistanceFromOrigin = 7.0f,
-                    glm::vec3 worldUp = glm::vec3(0.0f, 1.0f, 0.0f));
-        virtual ~ShadowMapCamera() = default;
-
-        float getCuboidExtents() const { return m_fCuboidExtents; }
-        void setCuboidExtents(float cuboidExtents) { m_fCuboidExtents = cuboidExtents; }
-        float getNearPlane() const { return m_fNear; }
-        void setNearPlane(float near) { m_fNear = near; }
-        float getFarPlane() const { return m_fFar; }
-        void setFarPlane(float far) { m_fFar = far; }
-        float getDistanceFromOrigin() const 
-        {
-            return m_fShadowCameraDistanceFromOrigin;
-        }
-        void setDistanceFromOrigin(float dist) 
-        {
-            m_fShadowCameraDistanceFromOrigin = dist;
-        }
+        // View space distance at which the cascade ends.
+        float splitFar = 0.0f;
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        // World space size of one shadow map texel.
+        float texelSize = 0.0f;
+    };
 
-        glm::mat4 getViewTransform();
-        glm::mat4 getProjectionTransform();
+    // Draws the geometry of a shadow caster with the given depth shader.
+    using ShadowCasterDraw = std::function<void(Shader&)>;
 
-    private:
-        std::shared_ptr<DirectionalLight> m_spLight;
-        // The extents of the ortho camera's rendering cuboid.
-        float m_fCuboidExtents;
-        // The near plane of the ortho cuboid.
-        float m_fNear;
-        // The far plane of the ortho cuboid.
-        float m_fFar;
-        // The fake distance from the origin that the shadow camera is positioned at.
-        float m_fShadowCameraDistanceFromOrigin;
-        glm::vec3 m_vec3WorldUp;
+    enum class ShadowCasterType
+    {
+        // Cached between frames, only re-rendered when invalidated.
+        STATIC = 0,
+        // Re-rendered on top of the cached static depth every frame.
+        DYNAMIC,
     };
 
-    class ShadowMap : public Framebuffer 
+    // Cascaded shadow maps for a directional light. The camera frustum (up to
+    // the shadow distance) is split into slices and each slice gets its own
+    // orthographic light camera, fitted to it and snapped to whole texels so
+    // that the shadows don't shimmer as the camera moves. All cascades live in
+    // the layers of one depth array texture and are rendered in a single pass.
+    //
+    // Static casters are rendered into a separate cache and only refreshed when
+    // a cascade's fit, the light direction or the casters change. The nearest
+    // cascade refreshes right away; farther stale cascades keep their previous
+    // fit and are refreshed oldest first as the GPU time budget allows. Each
+    // frame the touched layers are copied to the sampled map and the dynamic
+    // casters are drawn on top, so a static scene costs nothing.
+    class CascadedShadowMap : public Framebuffer
     {
     public:
-        explicit ShadowMap(int width = 1024, int height = 1024);
-        explicit ShadowMap(ImageSize size) : ShadowMap(size.width, size.height) {}
-        virtual ~ShadowMap() = default;
+        explicit CascadedShadowMap(std::shared_ptr<DirectionalLight> light, int resolution = 2048,
+                                   int numCascades = MAX_SHADOW_CASCADES);
+        virtual ~CascadedShadowMap();
+
+        void AddCaster(ShadowCasterType type, ShadowCasterDraw draw);
+        // Drops the cached static depth, e.g. after a static caster moved.
+        void InvalidateStaticCasters();
 
+        // Recomputes the splits and fits the cascades to the camera frustum.
+        // Call once per frame before Render().
+        void Update(const Camera& camera);
+        // Renders the shadow pass with the given depth shader, see shadow_map.geom.
+        void Render(Shader& shader);
+
+        // Without caching every cascade is re-rendered every frame.
+        bool getCaching() const { return m_bCaching; }
+        void setCaching(bool caching);
+        // GPU time per frame that refreshing far cascades may take. At least one
+        // stale cascade is refreshed per frame regardless.
+        float getRefreshBudgetMs() const { return m_fRefreshBudgetMs; }
+        void setRefreshBudgetMs(float budgetMs) { m_fRefreshBudgetMs = budgetMs; }
+        // Number of cascades refreshed by the last Render().
+        int getLastRefreshCount() const { return m_iLastRefreshCount; }
+
+        int getNumCascades() const { return m_iNumCascades; }
+        // Only cascades up to the allocated count are used.
+        void setNumCascades(int numCascades);
+        // Blend between uniform (0) and logarithmic (1) split distances.
+        float getSplitLambda() const { return m_fSplitLambda; }
+        void setSplitLambda(float lambda) { m_fSplitLambda = lambda; }
+        // View distance covered by the last cascade, clamped to the camera far
+        // plane. Beyond it nothing is shadowed.
+        float getShadowDistance() const { return m_fShadowDistance; }
+        void setShadowDistance(float distance) { m_fShadowDistance = distance; }
+        // Stable fitting bounds each slice by a sphere, so the cascade size doesn't
+        // change when the camera rotates. Tight fitting bounds the slice itself,
+        // trading rotational shimmering for resolution.
+        bool getStableFit() const { return m_bStableFit; }
+        void setStableFit(bool stableFit) { m_bStableFit = stableFit; }
+
+        const std::vector<ShadowCascade>& getCascades() const { return m_vecCascades; }
         std::shared_ptr<Texture> getDepthTexture() { return m_DepthAttachmentObj.Transform2Texture(); }
+
+        // Binds the depth array and sets the cascade uniforms of
+        // cascaded_shadows.glsl.
         unsigned int bindTexture(unsigned int nextTextureUnit, Shader& shader);
 
     private:
+        std::shared_ptr<DirectionalLight> m_spLight;
         Attachment m_DepthAttachmentObj;
+        int m_iResolution;
+        int m_iMaxCascades;
+        int m_iNumCascades;
+        float m_fSplitLambda = 0.75f;
+        float m_fShadowDistance = 30.0f;
+        bool m_bStableFit = true;
+        // Fit of the current frame. Becomes the cascade once it's refreshed.
+        std::vector<ShadowCascade> m_vecFitted;
+        // Cascades the static cache and the shadow map were rendered with.
+        std::vector<ShadowCascade> m_vecCascades;
+
+        struct CacheState
+        {
+            bool valid = false;
+            uint64_t lastRefreshFrame = 0;
+        };
+        std::vector<CacheState> m_vecCacheStates;
+        std::unique_ptr<Framebuffer> m_upStaticCacheFb;
+        Attachment m_StaticCacheAttachmentObj;
+        std::vector<ShadowCasterDraw> m_vecStaticCasters;
+        std::vector<ShadowCasterDraw> m_vecDynamicCasters;
+        glm::vec3 m_vec3CachedLightDir = glm::vec3(0.0f);
+        bool m_bCaching = true;
+        uint64_t m_ui64Frame = 0;
+        int m_iLastRefreshCount = 0;
+
+        // Timing of the static refreshes, read back a frame or more later.
+        float m_fRefreshBudgetMs = 0.5f;
+        float m_fRefreshMsPerCascade = 0.0f;
+        GLuint m_uiRefreshQuery = 0;
+        bool m_bRefreshQueryPending = false;
+        int m_iRefreshQueryCascades = 0;
+
+        void updateShadowPassUniforms(Shader& shader, unsigned int cascadeMask);
+        unsigned int scheduleRefreshes();
     };
 
 }  // namespace Cme
@@ -1,4 +1,6 @@
 #include "cube_mesh.h"
+#include "shape_cache.h"
+
 namespace Cme
 {
     constexpr float cubeVertices[] =
@@ -73,6 +75,28 @@ namespace Cme
         loadMeshAndTextures(vecTextureMaps);
     }
 
+    const float* CubeMesh::GetVertexData(unsigned int& numVertices)
+    {
+        constexpr unsigned int cubeVertexSizeBytes = 11 * sizeof(float);
+        numVertices = sizeof(cubeVertices) / cubeVertexSizeBytes;
+        return cubeVertices;
+    }
+
+    void CubeMesh::RenderInstanced(std::shared_ptr<Camera> spCamera,
+        const std::vector<glm::mat4>& transforms,
+        const std::vector<glm::vec4>& colors)
+    {
+        auto spShader = ShapeCache::GetInstance().GetShader(ShapeType::CUBE);
+        auto spGeometry = ShapeCache::GetInstance().GetCube();
+        spShader->setMat4("view", spCamera->getViewTransform());
+        spShader->setMat4("projection", spCamera->getProjectionTransform());
+        spShader->activate();
+        spGeometry->DrawInstanced(transforms.data(),
+            colors.size() >= transforms.size() ? colors.data() : nullptr,
+            (unsigned int)transforms.size());
+        spShader->deactivate();
+    }
+
     void CubeMesh::loadMeshAndTextures(const std::vector<std::shared_ptr<TextureMap>>& vecTextureMaps)
     {
         constexpr unsigned int cubeVertexSizeBytes = 11 * sizeof(float);
@@ -1,5 +1,6 @@
 #pragma once
 #include "mesh.h"
+#include "../camera.h"
 
 namespace Cme
 {
@@ -9,6 +10,15 @@ namespace Cme
         explicit CubeMesh(std::string texturePath = "");
         explicit CubeMesh(const std::vector<std::shared_ptr<TextureMap>>& vecTextureMaps);
 
+        // Unindexed cube vertices: position, normal, tangent and texture coordinates.
+        static const float* GetVertexData(unsigned int& numVertices);
+
+        // Draws one cube per transform with the shared geometry and program
+        // from the ShapeCache, in a single draw call.
+        static void RenderInstanced(std::shared_ptr<Camera> spCamera,
+            const std::vector<glm::mat4>& transforms,
+            const std::vector<glm::vec4>& colors);
+
     protected:
         void loadMeshAndTextures(const std::vector<std::shared_ptr<TextureMap>>& vecTextureMaps);
         void initializeVertexAttributes() override;
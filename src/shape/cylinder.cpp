@@ -1,6 +1,7 @@
 #include "cylinder.h"
 #include "../cme_defs.h"
 #include <iostream>
+#include <sstream>
 
 const int MIN_SECTOR_COUNT = 3;
 const int MIN_STACK_COUNT = 1;
@@ -33,6 +34,29 @@ namespace Cme
             upAxis = 3;
         }
             
+        // Geometry is generated once per parameter set and the program once per
+        // shape type.
+        m_spGeometry = ShapeCache::GetInstance().GetGeometry(getCacheKey(), [this]()
+        {
+            return generateGeometry();
+        });
+        m_spShader = ShapeCache::GetInstance().GetShader(ShapeType::CYLINDER);
+    }
+
+    Cylinder::~Cylinder()
+    {
+    }
+
+    std::string Cylinder::getCacheKey() const
+    {
+        std::ostringstream ss;
+        ss << "cylinder:" << baseRadius << "," << topRadius << "," << height << ","
+           << sectorCount << "," << stackCount << "," << smooth << "," << upAxis;
+        return ss.str();
+    }
+
+    std::shared_ptr<ShapeGeometry> Cylinder::generateGeometry()
+    {
         // generate unit circle vertices first
         buildUnitCircleVertices();
 
@@ -41,31 +65,15 @@ namespace Cme
         else
             buildVerticesFlat();
 
-        m_VAO = 0;
-        m_VBO = 0;
-        m_EBO = 0;
+        auto spGeometry = std::make_shared<ShapeGeometry>(getInterleavedVertices(), getInterleavedVertexCount(),
+            std::vector<unsigned int>{ 3, 3, 2 }, indices);
 
-        if (m_pShader == nullptr)
-        {
-            m_pShader = new Shader(Cme::ShaderPath("assets//shaders//cylinder.vert"),
-                                   Cme::ShaderPath("assets//shaders//cylinder.frag"));
-        }
-
-        InitializeData();
-    }
-
-    Cylinder::~Cylinder()
-    {
-        glDeleteVertexArrays(1, &m_VAO);
-        glDeleteBuffers(1, &m_VBO);
-        glDeleteBuffers(1, &m_EBO);
-
-        m_VAO = 0;
-        m_VBO = 0;
-        m_EBO = 0;
+        // The CPU-side arrays are not needed once the geometry lives on the GPU.
+        clearArrays();
+        std::vector<float>().swap(interleavedVertices);
+        return spGeometry;
     }
 
-
     void Cylinder::clearArrays()
     {
         std::vector<float>().swap(vertices);
@@ -198,59 +206,24 @@ namespace Cme
             changeUpAxis(3, this->upAxis);
     }
 
-    void Cylinder::InitializeData()
-    {
-        glGenVertexArrays(1, &m_VAO);
-        glGenBuffers(1, &m_VBO);
-
-        glBindVertexArray(m_VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-        glBufferData(GL_ARRAY_BUFFER, getInterleavedVertexSize(), getInterleavedVertices(), GL_STATIC_DRAW);
-
-        // EBO
-        glGenBuffers(1, &m_EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize(), getIndices(), GL_STATIC_DRAW);
-
-        // enable vertex array attributes for bound VAO
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(1);
-        glEnableVertexAttribArray(2);
-
-        // store vertex array pointers to bound VAO
-        int stride = getInterleavedStride();
-        glVertexAttribPointer(0, 3, GL_FLOAT, false, stride, 0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, false, stride, (void*)(3 * sizeof(float)));
-        glVertexAttribPointer(2, 2, GL_FLOAT, false, stride, (void*)(6 * sizeof(float)));
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-    }
-
     void Cylinder::Render(std::shared_ptr<Cme::Camera> spCamera)
     {
-        glBindVertexArray(m_VAO);
-
         auto modelMatrix = glm::mat4(1.0f);
         modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 0.0f, -10.0f));
-        m_pShader->setMat4("matrixModelViewProjection", spCamera->getProjectionTransform() * spCamera->getViewTransform() * modelMatrix);
-        m_pShader->setMat4("matrixModelView", spCamera->getViewTransform() * modelMatrix);
-        m_pShader->setMat4("matrixNormal", spCamera->getViewTransform() * modelMatrix);
-        m_pShader->setMat4("u_vm", spCamera->getViewTransform());
-
-        m_pShader->setVec4("lightPosition", glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
-        m_pShader->setVec4("lightAmbient", glm::vec4(0.3f, 0.3f, 0.3f, 1.0f));
-        m_pShader->setVec4("lightDiffuse", glm::vec4(0.7f, 0.7f, 0.7f, 1.0f));
-        m_pShader->setVec4("lightSpecular", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-        m_pShader->setVec4("materialAmbient", glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
-        m_pShader->setVec4("materialDiffuse", glm::vec4(0.7f, 0.7f, 0.7f, 1.0f));
-        m_pShader->setVec4("materialSpecular", glm::vec4(0.4f, 0.4f, 0.4f, 1.0f));
-        m_pShader->setFloat("materialShininess", 16.0f);
-
-        glDrawElements(GL_TRIANGLES,                // primitive type
-            getIndexCount(),                        // # of indices
-            GL_UNSIGNED_INT,             // data type
-            (void*)0);                   // ptr to indices
+        RenderInstanced(spCamera, { modelMatrix }, { glm::vec4(1.0f) });
+    }
+
+    void Cylinder::RenderInstanced(std::shared_ptr<Cme::Camera> spCamera,
+        const std::vector<glm::mat4>& transforms,
+        const std::vector<glm::vec4>& colors)
+    {
+        m_spShader->setMat4("view", spCamera->getViewTransform());
+        m_spShader->setMat4("projection", spCamera->getProjectionTransform());
+        m_spShader->activate();
+        m_spGeometry->DrawInstanced(transforms.data(),
+            colors.size() >= transforms.size() ? colors.data() : nullptr,
+            (unsigned int)transforms.size());
+        m_spShader->deactivate();
     }
 
     ///////////////////////////////////////////////////////////////////////////////
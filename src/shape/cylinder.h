@@ -4,6 +4,7 @@
 #include <vector>
 #include "../camera.h"
 #include "../shader/shader.h"
+#include "shape_cache.h"
 
 namespace Cme
 {
@@ -32,7 +33,7 @@ namespace Cme
         void setSmooth(bool smooth);
         void setUpAxis(int up);
 
-        // for vertex data
+        // for vertex data (only populated while generating the shared geometry)
         unsigned int getVertexCount() const { return (unsigned int)vertices.size() / 3; }
         unsigned int getNormalCount() const { return (unsigned int)normals.size() / 3; }
         unsigned int getTexCoordCount() const { return (unsigned int)texCoords.size() / 2; }
@@ -65,11 +66,16 @@ namespace Cme
         unsigned int getSideStartIndex() const { return 0; }   // side starts from the begining
 
     public:
-        void InitializeData();
         void Render(std::shared_ptr<Cme::Camera> spCamera);
+        // Draws one cylinder per transform with a single instanced draw.
+        void RenderInstanced(std::shared_ptr<Cme::Camera> spCamera,
+            const std::vector<glm::mat4>& transforms,
+            const std::vector<glm::vec4>& colors);
 
     private:
         // member functions
+        std::string getCacheKey() const;
+        std::shared_ptr<ShapeGeometry> generateGeometry();
         void clearArrays();
         void buildVerticesSmooth();
         void buildVerticesFlat();
@@ -107,10 +113,9 @@ namespace Cme
         std::vector<float> interleavedVertices;
         int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
 
-        GLuint m_VAO;
-        GLuint m_VBO;
-        GLuint m_EBO;
-        Shader* m_pShader = nullptr;
+        // Shared with every cylinder of the same parameters.
+        std::shared_ptr<ShapeGeometry> m_spGeometry;
+        std::shared_ptr<Shader> m_spShader;
 	};
 }
 
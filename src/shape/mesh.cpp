@@ -1,4 +1,5 @@
 #include "mesh.h"
+#include "../profiler.h"
 
 namespace Cme
 {
@@ -197,6 +198,8 @@ namespace Cme
 
     void Mesh::glDraw() 
     {
+        Profiler::GetInstance().CountDrawCall();
+
         // Handle instancing.
         if (m_uiInstanceCount)
         {
@@ -1,13 +1,17 @@
 #include "pipe.h"
-#include "line.h"
-#include "plane.h"
 #include "../common_helper.h"
+#include "../profiler.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CME_PIPE_SSE 1
+#endif
+
 const int CIRCLE_SECTORS = 100;     // # of vertices per contour
-const int PATH_POINTS = 300;        // # of points on the path
-const float PATH_TURNS = 4.5f;      // # of turns of the spiral
 
 // Variables
 const int POINT_COUNT = 64;
@@ -15,6 +19,9 @@ const float speed = -0.5;
 const float len = 0.015;
 const float radius = 0.5;
 
+// Contours are padded to a multiple of this so rings can be processed in SIMD lanes.
+const int SIMD_WIDTH = 4;
+
 namespace Cme
 {
 	Pipe::Pipe(float fOffset, glm::vec3 vec3RimColor)
@@ -22,14 +29,11 @@ namespace Cme
         m_vecLovePath.clear();
         //BuildSegment(2.0f, 0.0);
         //m_vecPath = m_vecLovePath;
-        m_vecContour = BuildCircle(0.1f, CIRCLE_SECTORS);
-        GenerateContours();
 
         m_fOffset = fOffset;
         m_vec3LoveRimColor = vec3RimColor;
 
         m_VAO = 0;
-        m_VBO = 0;
         m_EBO = 0;
 
         if (m_pShader == nullptr)
@@ -43,95 +47,132 @@ namespace Cme
     void Pipe::InitializeData()
     {
         glGenVertexArrays(1, &m_VAO);
-        glGenBuffers(1, &m_VBO);
-        glGenBuffers(1, &m_EBO);
+        glCreateBuffers(1, &m_EBO);
 
+        // Positions and normals come from separate bindings so that each frame
+        // only has to rebind the buffer offsets of the current ring region.
         glBindVertexArray(m_VAO);
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(0, 0);
+        glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(1, 1);
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
 
         BuildSegment(1.0f, m_fOffset);
-        m_vecContour = BuildCircle(m_fThickness, CIRCLE_SECTORS);
-        GenerateContours();
+        UpdateTopology(CIRCLE_SECTORS, getPathCount());
+    }
+
+    void Pipe::UpdateTopology(int sectors, int pathCount)
+    {
+        if (sectors == m_iSectors && pathCount == m_iContourCount)
+        {
+            return;
+        }
+        m_iSectors = sectors;
+        m_iContourCount = pathCount;
+        m_iVertexCount = sectors + 1;
+        m_iStride = (m_iVertexCount + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
 
-        int contourCount = getContourCount();            // total # of contours
-        int vertexCount = (int)getContour(0).size();     // # of vertices per contour
-        int vertexSize = sizeof(float) * 3 * vertexCount;     // # of bytes per contour
-        int offset = vertexSize * contourCount;               // offset where normals begin
+        // The ring is closed, so the last vertex repeats the first.
+        const float PI2 = acos(-1.0f) * 2.0f;
+        m_vecCircleX.assign(m_iStride, 0.0f);
+        m_vecCircleY.assign(m_iStride, 0.0f);
+        for (int i = 0; i <= sectors; ++i)
+        {
+            float a = PI2 / sectors * i;
+            m_vecCircleX[i] = cosf(a);
+            m_vecCircleY[i] = sinf(a);
+        }
 
+        size_t storage = static_cast<size_t>(pathCount) * m_iStride;
+        m_vecContourX.resize(storage);
+        m_vecContourY.resize(storage);
+        m_vecContourZ.resize(storage);
+        m_vecNormalX.resize(storage);
+        m_vecNormalY.resize(storage);
+        m_vecNormalZ.resize(storage);
+        m_vecContourTransforms.resize(pathCount);
 
-        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-        glVertexAttribPointer(0, 3, GL_FLOAT, false, 0, 0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, false, 0, (void*)offset);
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(1);
+        // build indices for triangle strip
+        std::vector<unsigned int> indices;
+        indices.reserve(2 * std::max(pathCount - 1, 0) * m_iVertexCount);
+        int k1 = 0, k2 = m_iVertexCount;
+        for (int i = 0; i < (pathCount - 1); ++i)
+        {
+            for (int j = 0; j < m_iVertexCount; ++j)
+            {
+                indices.push_back(k2++);
+                indices.push_back(k1++);
+            }
+        }
+        m_iIndexCount = (int)indices.size();
+        glNamedBufferData(m_EBO, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        // One region holds a frame's positions followed by its normals.
+        m_upStreamBuffer = std::make_unique<StreamBuffer>(2 * sizeof(float) * 3 * m_iVertexCount * pathCount);
     }
 
     void Pipe::Update(float dt)
     {
         m_fTime = dt;
         // ¼ǳʱ
-        m_vecContour.clear();
         BuildSegment(dt, m_fOffset);
-        m_vecContour = BuildCircle(m_fThickness, CIRCLE_SECTORS);
+        UpdateTopology(CIRCLE_SECTORS, getPathCount());
+        if (m_iContourCount < 1)
+        {
+            return;
+        }
         GenerateContours();
 
-        int contourCount = getContourCount();            // total # of contours
-        int vertexCount = (int)getContour(0).size();     // # of vertices per contour
-        int vertexSize = sizeof(float) * 3 * vertexCount;     // # of bytes per contour
-        int offset = vertexSize * contourCount;               // offset where normals begin
-        int bufferCount = 2 * 3 * vertexCount * contourCount; // total # of floats (vertex + normal)
-        int bufferSize = sizeof(float) * bufferCount;         // total # of bytes
-        std::vector<float> buffer(bufferCount);
-
-        for (int i = 0; i < contourCount; ++i)
+        // Write straight into the mapped region the GPU is no longer reading.
+        float* pPositions = static_cast<float*>(m_upStreamBuffer->BeginRegion());
+        float* pNormals = pPositions + 3 * m_iVertexCount * m_iContourCount;
+        for (int i = 0; i < m_iContourCount; ++i)
         {
-            std::vector<glm::vec3> contour = m_vecContours[i]; // vertices per contour
-            std::vector<glm::vec3> normal = m_vecNormals[i];   // normals per contours
-            int vIndex = i * 3 * vertexCount;
-            int nIndex = (3 * vertexCount * contourCount) + vIndex;
-            // copy # of bytes per contour
-            std::memcpy(&buffer[vIndex], &contour[0].x, vertexSize);
-            std::memcpy(&buffer[nIndex], &normal[0].x, vertexSize);
+            BuildContour(i);
+            WriteContour(i, pPositions, pNormals);
         }
 
-        // copy to VBO using glBufferData()
-        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-        glBufferData(GL_ARRAY_BUFFER, bufferSize, buffer.data(), GL_DYNAMIC_DRAW);
+        m_iPositionOffset = m_upStreamBuffer->GetRegionOffset();
+        m_iNormalOffset = m_iPositionOffset + sizeof(float) * 3 * m_iVertexCount * m_iContourCount;
+    }
 
-        for (int i = 0; i < contourCount; ++i)
-        {
-            std::vector<glm::vec3> contour = m_vecContours[i]; // vertices per contour
-            std::vector<glm::vec3> normal = m_vecNormals[i];   // normals per contours
-            glBufferSubData(GL_ARRAY_BUFFER, (i * vertexSize), vertexSize, &contour[0].x);
-            glBufferSubData(GL_ARRAY_BUFFER, offset + (i * vertexSize), vertexSize, &normal[0].x);
-        }
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glm::mat4 Pipe::GetModelMatrix() const
+    {
+        return glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -8.0f));
+    }
 
-        // build indices for triangle strip
-        int k1 = 0, k2 = vertexCount;
-        std::vector<unsigned int> indices;
-        for (int i = 0; i < (contourCount - 1); ++i)
+    void Pipe::RenderDepth(Shader& shader)
+    {
+        if (m_iIndexCount == 0)
         {
-            for (int j = 0; j < vertexCount; ++j)
-            {
-                indices.push_back(k2++);
-                indices.push_back(k1++);
-            }
+            return;
         }
 
-        // copy indices to IBO
+        shader.activate();
+        shader.setMat4("model", GetModelMatrix());
+
+        glBindVertexArray(m_VAO);
+        glBindVertexBuffer(0, m_upStreamBuffer->GetBufferID(), m_iPositionOffset, sizeof(glm::vec3));
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glDrawElements(GL_TRIANGLE_STRIP, m_iIndexCount, GL_UNSIGNED_INT, 0);
+        Profiler::GetInstance().CountDrawCall();
+        glBindVertexArray(0);
     }
 
     void Pipe::Render(std::shared_ptr<Cme::Camera> spCamera)
     {
+        if (m_iIndexCount == 0)
+        {
+            return;
+        }
+
         m_pShader->activate();
-        auto modelMatrix = glm::mat4(1.0f);
-        modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 0.0f, -8.0f));
         m_pShader->setMat4("projection", spCamera->getProjectionTransform());
         m_pShader->setMat4("view", spCamera->getViewTransform());
-        m_pShader->setMat4("model", modelMatrix);
+        m_pShader->setMat4("model", GetModelMatrix());
 
         m_pShader->setVec3("viewPos", spCamera->getPosition());
 
@@ -154,101 +195,30 @@ namespace Cme
         m_pShader->setFloat("time", m_fTime);
 
         glBindVertexArray(m_VAO);
-        int indexSize = 2 * (getContourCount() - 1) * getContour(0).size();
+        glBindVertexBuffer(0, m_upStreamBuffer->GetBufferID(), m_iPositionOffset, sizeof(glm::vec3));
+        glBindVertexBuffer(1, m_upStreamBuffer->GetBufferID(), m_iNormalOffset, sizeof(glm::vec3));
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-        glDrawElements(GL_TRIANGLE_STRIP, indexSize, GL_UNSIGNED_INT, 0);
-
-    }
-
-	std::vector<glm::vec3> Pipe::BuildSpiralPath(float r1, float r2, float h1, float h2, float turns, int points)
-	{
-        const float PI = acos(-1.0f);
-        std::vector<glm::vec3> vecResult;
-        glm::vec3 vertex;
-        float r = r1;
-        float rStep = (r2 - r1) / (points - 1);
-        float y = h1;
-        float yStep = (h2 - h1) / (points - 1);
-        float a = 0;
-        float aStep = (turns * 2 * PI) / (points - 1);
-        for (int i = 0; i < points; ++i)
-        {
-            vertex.x = r * cos(a);
-            vertex.z = r * sin(a);
-            vertex.y = y;
-            vecResult.push_back(vertex);
-            // next
-            r += rStep;
-            y += yStep;
-            a += aStep;
-        }
-        return vecResult;
-	}
-
-    std::vector<glm::vec3> Pipe::BuildCircle(float radius, int steps)
-    {
-        std::vector<glm::vec3> vecResult;
-        if (steps < 2) return vecResult;
-
-        const float PI2 = acos(-1.0f) * 2.0f;
-        float x, y, a;
-        for (int i = 0; i <= steps; ++i)
-        {
-            a = PI2 / steps * i;
-            x = radius * cosf(a);
-            y = radius * sinf(a);
-            vecResult.push_back(glm::vec3(x, y, 0));
-        }
-        return vecResult;
+        glDrawElements(GL_TRIANGLE_STRIP, m_iIndexCount, GL_UNSIGNED_INT, 0);
+        Profiler::GetInstance().CountDrawCall();
+        glBindVertexArray(0);
+        // The region written in Update() is fenced by StreamBuffer::EndFrame()
+        // after the frame's last draw, also in frames that skip this one.
     }
 
     void Pipe::GenerateContours()
     {
-        // reset
-        m_vecContours.clear();
-        m_vecNormals.clear();
-
-        // path must have at least a point
-        if (m_vecPath.size() < 1)
-        {
-            return;
-        }
-            
-        // rotate and translate the contour to the first path point
-        TransformFirstContour();
-        m_vecContours.push_back(m_vecContour);
-        m_vecNormals.push_back(ComputeContourNormal(0));
-
-        // project contour to the plane at the next path point
-        int count = (int)m_vecPath.size();
-        for (int i = 1; i < count; ++i)
-        {
-            m_vecContours.push_back(ProjectContour(i - 1, i));
-            m_vecNormals.push_back(ComputeContourNormal(i));
-        }
-    }
-
-    std::vector<glm::vec3> Pipe::ComputeContourNormal(int pathIndex)
-    {
-        // get current contour and center point
-        std::vector<glm::vec3>& contour = m_vecContours[pathIndex];
-        glm::vec3 center = m_vecPath[pathIndex];
-        
-        std::vector<glm::vec3> contourNormal;
-        glm::vec3 normal;
-        for (int i = 0; i < (int)contour.size(); ++i)
+        // The transforms depend on each other, but they are only a matrix per
+        // path point. Building the vertices from them is independent per contour.
+        m_vecContourTransforms[0] = TransformFirstContour();
+        for (int i = 1; i < m_iContourCount; ++i)
         {
-            normal = glm::normalize(contour[i] - center);
-            contourNormal.push_back(normal);
+            m_vecContourTransforms[i] = ProjectContour(i - 1, i) * m_vecContourTransforms[i - 1];
         }
-
-        return contourNormal;
     }
 
-    std::vector<glm::vec3> Pipe::ProjectContour(int fromIndex, int toIndex)
+    glm::mat4 Pipe::ProjectContour(int fromIndex, int toIndex) const
     {
         glm::vec3 dir1, dir2, normal;
-        Line line;
 
         dir1 = m_vecPath[toIndex] - m_vecPath[fromIndex];
         if (toIndex == (int)m_vecPath.size() - 1)
@@ -259,50 +229,126 @@ namespace Cme
         {
             dir2 = m_vecPath[toIndex + 1] - m_vecPath[toIndex];
         }
-            
 
         normal = dir1 + dir2;               // normal vector of plane at toIndex
-        Plane plane(normal, m_vecPath[toIndex]);
 
-        // project each vertex of contour to the plane
-        std::vector<glm::vec3>& fromContour = m_vecContours[fromIndex];
-        std::vector<glm::vec3> toContour;
-        int count = (int)fromContour.size();
-        for (int i = 0; i < count; ++i)
+        // Projecting a point p along dir1 onto the plane (normal, point) is affine:
+        //   p' = p + dir1 * dot(normal, point - p) / dot(normal, dir1)
+        float denom = glm::dot(normal, dir1);
+        if (std::abs(denom) < 1e-8f)
         {
-            line.set(dir1, fromContour[i]);
-            toContour.push_back(plane.intersect(line));
+            return glm::translate(glm::mat4(1.0f), dir1);
         }
-
-        return toContour;
+        glm::mat4 matrix(1.0f);
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                matrix[c][r] -= dir1[r] * normal[c] / denom;
+            }
+        }
+        matrix[3] = glm::vec4(dir1 * (glm::dot(normal, m_vecPath[toIndex]) / denom), 1.0f);
+        return matrix;
     }
 
-    void Pipe::TransformFirstContour()
+    glm::mat4 Pipe::TransformFirstContour() const
     {
         int pathCount = (int)m_vecPath.size();
-        int vertexCount = (int)m_vecContour.size();
-        glm::mat4 matrix;
+        glm::mat4 matrix = glm::translate(glm::mat4(1.0f), m_vecPath[0]);
 
-        if (pathCount > 0)
+        // transform matrix
+        if (pathCount > 1)
         {
-            // transform matrix
-            if (pathCount > 1)
-            {
-                matrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), m_vecPath[0] - m_vecPath[1], glm::vec3(0.0f, 1.0f, 0.0f));
-                matrix = glm::transpose(matrix);
-                matrix[3][0] = m_vecPath[0].x;
-                matrix[3][1] = m_vecPath[0].y;
-                matrix[3][2] = m_vecPath[0].z;
-            }
+            // ߵķȷת
+            matrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), m_vecPath[0] - m_vecPath[1], glm::vec3(0.0f, 1.0f, 0.0f));
+            matrix = glm::transpose(matrix);
+            matrix[3][0] = m_vecPath[0].x;
+            matrix[3][1] = m_vecPath[0].y;
+            matrix[3][2] = m_vecPath[0].z;
+        }
 
-            // multiply matrix to the contour
-            // NOTE: the contour vertices are transformed here
-            // MUST resubmit contour data if the path is resset to 0
-            for (int i = 0; i < vertexCount; ++i)
-            {
-                // ߵķȷת
-                m_vecContour[i] = matrix * glm::vec4(m_vecContour[i], 1.0f);
-            }
+        // The cached circle has unit radius.
+        return glm::scale(matrix, glm::vec3(m_fThickness, m_fThickness, 1.0f));
+    }
+
+    void Pipe::BuildContour(int pathIndex)
+    {
+        const glm::mat4& m = m_vecContourTransforms[pathIndex];
+        const glm::vec3& center = m_vecPath[pathIndex];
+        size_t base = static_cast<size_t>(pathIndex) * m_iStride;
+        float* px = &m_vecContourX[base];
+        float* py = &m_vecContourY[base];
+        float* pz = &m_vecContourZ[base];
+        float* nx = &m_vecNormalX[base];
+        float* ny = &m_vecNormalY[base];
+        float* nz = &m_vecNormalZ[base];
+        const float* cx = m_vecCircleX.data();
+        const float* cy = m_vecCircleY.data();
+
+        // The circle lies in z = 0, so only the first two columns and the
+        // translation contribute.
+#ifdef CME_PIPE_SSE
+        const __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]);
+        const __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]);
+        const __m128 m30 = _mm_set1_ps(m[3][0]), m31 = _mm_set1_ps(m[3][1]), m32 = _mm_set1_ps(m[3][2]);
+        const __m128 centerX = _mm_set1_ps(center.x);
+        const __m128 centerY = _mm_set1_ps(center.y);
+        const __m128 centerZ = _mm_set1_ps(center.z);
+        const __m128 minLength2 = _mm_set1_ps(1e-12f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (int j = 0; j < m_iStride; j += SIMD_WIDTH)
+        {
+            __m128 x = _mm_loadu_ps(cx + j);
+            __m128 y = _mm_loadu_ps(cy + j);
+            __m128 vx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m10, y)), m30);
+            __m128 vy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, x), _mm_mul_ps(m11, y)), m31);
+            __m128 vz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, x), _mm_mul_ps(m12, y)), m32);
+            _mm_storeu_ps(px + j, vx);
+            _mm_storeu_ps(py + j, vy);
+            _mm_storeu_ps(pz + j, vz);
+
+            __m128 dx = _mm_sub_ps(vx, centerX);
+            __m128 dy = _mm_sub_ps(vy, centerY);
+            __m128 dz = _mm_sub_ps(vz, centerZ);
+            __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(length2, minLength2)));
+            _mm_storeu_ps(nx + j, _mm_mul_ps(dx, invLength));
+            _mm_storeu_ps(ny + j, _mm_mul_ps(dy, invLength));
+            _mm_storeu_ps(nz + j, _mm_mul_ps(dz, invLength));
+        }
+#else
+        for (int j = 0; j < m_iStride; ++j)
+        {
+            glm::vec3 v = glm::vec3(m[0]) * cx[j] + glm::vec3(m[1]) * cy[j] + glm::vec3(m[3]);
+            px[j] = v.x;
+            py[j] = v.y;
+            pz[j] = v.z;
+            glm::vec3 normal = glm::normalize(v - center);
+            nx[j] = normal.x;
+            ny[j] = normal.y;
+            nz[j] = normal.z;
+        }
+#endif
+    }
+
+    void Pipe::WriteContour(int pathIndex, float* pPositions, float* pNormals) const
+    {
+        // Interleave into xyz for the vertex format; writes stay sequential,
+        // which is what write-combined mapped memory wants.
+        size_t base = static_cast<size_t>(pathIndex) * m_iStride;
+        float* pos = pPositions + static_cast<size_t>(pathIndex) * 3 * m_iVertexCount;
+        float* nor = pNormals + static_cast<size_t>(pathIndex) * 3 * m_iVertexCount;
+        for (int j = 0; j < m_iVertexCount; ++j)
+        {
+            pos[3 * j + 0] = m_vecContourX[base + j];
+            pos[3 * j + 1] = m_vecContourY[base + j];
+            pos[3 * j + 2] = m_vecContourZ[base + j];
+        }
+        for (int j = 0; j < m_iVertexCount; ++j)
+        {
+            nor[3 * j + 0] = m_vecNormalX[base + j];
+            nor[3 * j + 1] = m_vecNormalY[base + j];
+            nor[3 * j + 2] = m_vecNormalZ[base + j];
         }
     }
 
@@ -315,11 +361,11 @@ namespace Cme
     void Pipe::BuildSegment(float t, float fOffset)
     {
         // ĵλ
-        m_vecPath.clear();
+        m_vecPath.resize(POINT_COUNT);
         for (int i = 0; i < POINT_COUNT; i++)
         {
             vec3 vec3XYZ = vec3(GetHeartPosition(fOffset + float(i) * len + fract(speed * t) * 6.28), 2.0);
-            m_vecPath.push_back(vec3XYZ * glm::vec3(1.0f, -1.0f, 1.0f));      // תY᷽
+            m_vecPath[i] = vec3XYZ * glm::vec3(1.0f, -1.0f, 1.0f);      // תY᷽
         }
     }
 }
\ No newline at end of file
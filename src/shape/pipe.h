@@ -1,9 +1,11 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <memory>
 #include <vector>
 #include "../camera.h"
 #include "../shader/shader.h"
+#include "../core/stream_buffer.h"
 
 namespace Cme
 {
@@ -12,9 +14,6 @@ namespace Cme
 	public:
 		Pipe(float fOffset, glm::vec3 vec3RimColor);
 
-		std::vector<glm::vec3> BuildSpiralPath(float r1, float r2, float h1, float h2, float turns, int points);
-		std::vector<glm::vec3> BuildCircle(float radius, int steps);
-
 		// 
 		glm::vec2 GetHeartPosition(float t);
 		void BuildSegment(float t, float fOffset);
@@ -23,12 +22,14 @@ namespace Cme
 		const std::vector<glm::vec3>& getPathPoints() const { return m_vecPath; }
 		const glm::vec3& getPathPoint(int index) const { return m_vecPath.at(index); }
 
-		int getContourCount() const { return (int)m_vecContours.size(); }
-		const std::vector< std::vector<glm::vec3> >& getContours() const { return m_vecContours; }
-		const std::vector<glm::vec3>& getContour(int index) const { return m_vecContours.at(index); }
-
-		const std::vector< std::vector<glm::vec3> >& getNormals() const { return m_vecNormals; }
-		const std::vector<glm::vec3>& getNormal(int index) const { return m_vecNormals.at(index); }
+		int getContourCount() const { return m_iContourCount; }
+		// # of vertices per contour (the ring is closed, so sectors + 1).
+		int getContourVertexCount() const { return m_iVertexCount; }
+		glm::vec3 getContourVertex(int contour, int index) const
+		{
+			int i = contour * m_iStride + index;
+			return glm::vec3(m_vecContourX[i], m_vecContourY[i], m_vecContourZ[i]);
+		}
 
 		void SetThickness(float fValue)
 		{
@@ -62,25 +63,53 @@ namespace Cme
 	public:
 		void InitializeData();
 		void Render(std::shared_ptr<Cme::Camera> spCamera);
+		// Draws only the positions, e.g. into a shadow map. Must be called
+		// after Update() in the same frame, while the streamed region is open.
+		void RenderDepth(Shader& shader);
 		void Update(float dt);
 
 	private:
+		void UpdateTopology(int sectors, int pathCount);
 		void GenerateContours();
-		void TransformFirstContour();
-		std::vector<glm::vec3> ProjectContour(int fromIndex, int toIndex);
-		std::vector<glm::vec3> ComputeContourNormal(int pathIndex);
+		glm::mat4 GetModelMatrix() const;
+		glm::mat4 TransformFirstContour() const;
+		glm::mat4 ProjectContour(int fromIndex, int toIndex) const;
+		void BuildContour(int pathIndex);
+		void WriteContour(int pathIndex, float* pPositions, float* pNormals) const;
 
-		std::vector<glm::vec3> m_vecSpiralPath;
 		std::vector<glm::vec3> m_vecPath;
-		std::vector<glm::vec3> m_vecContour;
-		std::vector<std::vector<glm::vec3>> m_vecContours;
-		std::vector<std::vector<glm::vec3>> m_vecNormals;
+
+		// Topology. Only changes with the sector or path point count; the index
+		// buffer and the stream buffer are rebuilt when it does.
+		int m_iSectors = 0;
+		int m_iContourCount = 0;
+		int m_iVertexCount = 0;
+		int m_iStride = 0;      // vertices per contour, padded to a SIMD width
+		int m_iIndexCount = 0;
+
+		// Unit circle in the XY plane, padded to m_iStride.
+		std::vector<float> m_vecCircleX;
+		std::vector<float> m_vecCircleY;
+		// Each contour is the unit circle under an affine transform: the first
+		// one is placed at the path start and every later one is the previous
+		// contour projected onto the plane at its path point.
+		std::vector<glm::mat4> m_vecContourTransforms;
+		// SoA contour storage, contour i starts at i * m_iStride.
+		std::vector<float> m_vecContourX;
+		std::vector<float> m_vecContourY;
+		std::vector<float> m_vecContourZ;
+		std::vector<float> m_vecNormalX;
+		std::vector<float> m_vecNormalY;
+		std::vector<float> m_vecNormalZ;
 
 		std::vector<glm::vec3> m_vecLovePath;
 
 		GLuint m_VAO;
-		GLuint m_VBO;
 		GLuint m_EBO;
+		// Positions followed by normals, streamed every frame.
+		std::unique_ptr<StreamBuffer> m_upStreamBuffer;
+		GLintptr m_iPositionOffset = 0;
+		GLintptr m_iNormalOffset = 0;
 		Shader* m_pShader = nullptr;
 		float m_fOffset;
 		
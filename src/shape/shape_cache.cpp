@@ -0,0 +1,211 @@
+#include "shape_cache.h"
+#include "cube_mesh.h"
+#include "sphere_mesh.h"
+#include "../profiler.h"
+
+#include <cstddef>
+#include <sstream>
+
+namespace Cme
+{
+    // Instance capacity of a freshly created geometry, grown on demand.
+    const unsigned int INITIAL_INSTANCE_CAPACITY = 256;
+
+    ShapeGeometry::ShapeGeometry(const float* vertexData, unsigned int numVertices,
+        const std::vector<unsigned int>& attribSizes,
+        const std::vector<unsigned int>& indices)
+        : m_uiNumVertices(numVertices), m_uiIndexCount((unsigned int)indices.size())
+    {
+        unsigned int vertexFloats = 0;
+        for (unsigned int size : attribSizes)
+        {
+            vertexFloats += size;
+        }
+
+        glCreateBuffers(1, &m_uiVbo);
+        glNamedBufferStorage(m_uiVbo, numVertices * vertexFloats * sizeof(float), vertexData, 0);
+        if (!indices.empty())
+        {
+            glCreateBuffers(1, &m_uiEbo);
+            glNamedBufferStorage(m_uiEbo, indices.size() * sizeof(unsigned int), indices.data(), 0);
+        }
+
+        glCreateVertexArrays(1, &m_uiVao);
+        // Binding 0: shape vertices.
+        glVertexArrayVertexBuffer(m_uiVao, 0, m_uiVbo, 0, vertexFloats * sizeof(float));
+        unsigned int offset = 0;
+        for (unsigned int i = 0; i < attribSizes.size(); ++i)
+        {
+            glEnableVertexArrayAttrib(m_uiVao, i);
+            glVertexArrayAttribFormat(m_uiVao, i, attribSizes[i], GL_FLOAT, GL_FALSE, offset * sizeof(float));
+            glVertexArrayAttribBinding(m_uiVao, i, 0);
+            offset += attribSizes[i];
+        }
+        if (m_uiEbo)
+        {
+            glVertexArrayElementBuffer(m_uiVao, m_uiEbo);
+        }
+
+        // Binding 1: per-instance model matrix and color. The buffer is bound at
+        // draw time since it is streamed.
+        glVertexArrayBindingDivisor(m_uiVao, 1, 1);
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            unsigned int location = SHAPE_INSTANCE_MODEL_LOCATION + i;
+            glEnableVertexArrayAttrib(m_uiVao, location);
+            glVertexArrayAttribFormat(m_uiVao, location, 4, GL_FLOAT, GL_FALSE,
+                offsetof(InstanceData, model) + i * sizeof(glm::vec4));
+            glVertexArrayAttribBinding(m_uiVao, location, 1);
+        }
+        glEnableVertexArrayAttrib(m_uiVao, SHAPE_INSTANCE_COLOR_LOCATION);
+        glVertexArrayAttribFormat(m_uiVao, SHAPE_INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE,
+            offsetof(InstanceData, color));
+        glVertexArrayAttribBinding(m_uiVao, SHAPE_INSTANCE_COLOR_LOCATION, 1);
+
+        ReserveInstances(INITIAL_INSTANCE_CAPACITY);
+    }
+
+    ShapeGeometry::~ShapeGeometry()
+    {
+        glDeleteVertexArrays(1, &m_uiVao);
+        glDeleteBuffers(1, &m_uiVbo);
+        if (m_uiEbo)
+        {
+            glDeleteBuffers(1, &m_uiEbo);
+        }
+    }
+
+    void ShapeGeometry::ReserveInstances(unsigned int count)
+    {
+        if (count <= m_uiInstanceCapacity)
+        {
+            return;
+        }
+        unsigned int capacity = m_uiInstanceCapacity ? m_uiInstanceCapacity : INITIAL_INSTANCE_CAPACITY;
+        while (capacity < count)
+        {
+            capacity *= 2;
+        }
+        m_upInstanceBuffer = std::make_unique<StreamBuffer>(capacity * sizeof(InstanceData));
+        m_uiInstanceCapacity = capacity;
+    }
+
+    void ShapeGeometry::DrawInstanced(const glm::mat4* transforms, const glm::vec4* colors, unsigned int count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Every draw of the frame shares one region, fenced by
+        // StreamBuffer::EndFrame().
+        const GLsizeiptr size = count * sizeof(InstanceData);
+        GLintptr offset = 0;
+        void* pData = m_upInstanceBuffer->Allocate(size, offset);
+        if (pData == nullptr)
+        {
+            // Earlier draws of this frame keep sourcing the old buffer, GL
+            // frees it once they are done.
+            ReserveInstances(m_uiInstanceCapacity + count);
+            pData = m_upInstanceBuffer->Allocate(size, offset);
+        }
+        InstanceData* pInstances = static_cast<InstanceData*>(pData);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            pInstances[i].model = transforms[i];
+            pInstances[i].color = colors ? colors[i] : glm::vec4(1.0f);
+        }
+
+        glBindVertexArray(m_uiVao);
+        glBindVertexBuffer(1, m_upInstanceBuffer->GetBufferID(), offset, sizeof(InstanceData));
+        if (m_uiEbo)
+        {
+            glDrawElementsInstanced(GL_TRIANGLES, m_uiIndexCount, GL_UNSIGNED_INT, nullptr, count);
+        }
+        else
+        {
+            glDrawArraysInstanced(GL_TRIANGLES, 0, m_uiNumVertices, count);
+        }
+        Profiler::GetInstance().CountDrawCall();
+        glBindVertexArray(0);
+    }
+
+    ShapeCache& ShapeCache::GetInstance()
+    {
+        static ShapeCache sc;
+        return sc;
+    }
+
+    std::shared_ptr<ShapeGeometry> ShapeCache::GetGeometry(const std::string& sKey,
+        const std::function<std::shared_ptr<ShapeGeometry>()>& generate)
+    {
+        auto iter = m_mapGeometryCache.find(sKey);
+        if (iter != m_mapGeometryCache.end())
+        {
+            return iter->second;
+        }
+        auto spGeometry = generate();
+        m_mapGeometryCache[sKey] = spGeometry;
+        return spGeometry;
+    }
+
+    std::shared_ptr<ShapeGeometry> ShapeCache::GetSphere(int numMeridians, int numParallels)
+    {
+        std::ostringstream ss;
+        ss << "sphere:" << numMeridians << "," << numParallels;
+        return GetGeometry(ss.str(), [numMeridians, numParallels]()
+        {
+            std::vector<float> vertexData;
+            std::vector<unsigned int> indices;
+            SphereMesh::GenerateVertexData(numMeridians, numParallels, vertexData, indices);
+            return std::make_shared<ShapeGeometry>(vertexData.data(),
+                (unsigned int)vertexData.size() / SphereMesh::VERTEX_FLOATS,
+                std::vector<unsigned int>{ 3, 3, 3, 2 }, indices);
+        });
+    }
+
+    std::shared_ptr<ShapeGeometry> ShapeCache::GetCube()
+    {
+        return GetGeometry("cube", []()
+        {
+            unsigned int numVertices = 0;
+            const float* vertexData = CubeMesh::GetVertexData(numVertices);
+            return std::make_shared<ShapeGeometry>(vertexData, numVertices,
+                std::vector<unsigned int>{ 3, 3, 3, 2 }, std::vector<unsigned int>());
+        });
+    }
+
+    std::shared_ptr<Shader> ShapeCache::GetShader(ShapeType eType)
+    {
+        auto iter = m_mapShaders.find(eType);
+        if (iter != m_mapShaders.end())
+        {
+            return iter->second;
+        }
+
+        std::shared_ptr<Shader> spShader;
+        switch (eType)
+        {
+        case ShapeType::CYLINDER:
+            spShader = std::make_shared<Shader>(Cme::ShaderPath("assets//shaders//cylinder.vert"),
+                                                Cme::ShaderPath("assets//shaders//cylinder.frag"));
+            break;
+        case ShapeType::SPHERE:
+            spShader = std::make_shared<Shader>(Cme::ShaderPath("assets//shaders//shape_instanced.vert"),
+                                                Cme::ShaderPath("assets//shaders//shape_instanced.frag"));
+            break;
+        case ShapeType::CUBE:
+            // Same vertex layout as the sphere, so the program is shared.
+            spShader = GetShader(ShapeType::SPHERE);
+            break;
+        }
+        m_mapShaders[eType] = spShader;
+        return spShader;
+    }
+
+    void ShapeCache::ClearCache()
+    {
+        m_mapGeometryCache.clear();
+        m_mapShaders.clear();
+    }
+}
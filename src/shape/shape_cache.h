@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "../shader/shader.h"
+#include "../core/stream_buffer.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Cme
+{
+	enum class ShapeType
+	{
+		CYLINDER = 0,
+		SPHERE,
+		CUBE,
+	};
+
+	// Per-instance attributes follow the vertex attributes of the shape. The
+	// model matrix takes four consecutive locations.
+	constexpr unsigned int SHAPE_INSTANCE_MODEL_LOCATION = 4;
+	constexpr unsigned int SHAPE_INSTANCE_COLOR_LOCATION = 8;
+
+	// GPU geometry of a procedural shape, shared by every object created with
+	// the same parameters. Drawn with per-instance transforms and colors.
+	class ShapeGeometry
+	{
+	public:
+		// `attribSizes` lists the float count of each vertex attribute, starting
+		// at location 0.
+		ShapeGeometry(const float* vertexData, unsigned int numVertices,
+			const std::vector<unsigned int>& attribSizes,
+			const std::vector<unsigned int>& indices);
+		~ShapeGeometry();
+
+		ShapeGeometry(const ShapeGeometry&) = delete;
+		ShapeGeometry& operator=(const ShapeGeometry&) = delete;
+
+		unsigned int GetVertexCount() const { return m_uiNumVertices; }
+		unsigned int GetIndexCount() const { return m_uiIndexCount; }
+
+		// Streams the instance data into this frame's region and issues a
+		// single instanced draw. The shader must already be active. `colors` may be null, in which case
+		// every instance is white.
+		void DrawInstanced(const glm::mat4* transforms, const glm::vec4* colors, unsigned int count);
+
+	private:
+		struct InstanceData
+		{
+			glm::mat4 model;
+			glm::vec4 color;
+		};
+
+		void ReserveInstances(unsigned int count);
+
+		GLuint m_uiVao = 0;
+		GLuint m_uiVbo = 0;
+		GLuint m_uiEbo = 0;
+		unsigned int m_uiNumVertices = 0;
+		unsigned int m_uiIndexCount = 0;
+
+		std::unique_ptr<StreamBuffer> m_upInstanceBuffer;
+		unsigned int m_uiInstanceCapacity = 0;
+	};
+
+	// Parameter-keyed cache of shape geometry plus one program per shape type,
+	// so that creating many primitives neither regenerates vertices nor
+	// recompiles shaders.
+	class ShapeCache
+	{
+	public:
+		static ShapeCache& GetInstance();
+
+		// Returns the geometry cached under `sKey`, calling `generate` on a miss.
+		std::shared_ptr<ShapeGeometry> GetGeometry(const std::string& sKey,
+			const std::function<std::shared_ptr<ShapeGeometry>()>& generate);
+		std::shared_ptr<ShapeGeometry> GetSphere(int numMeridians, int numParallels);
+		std::shared_ptr<ShapeGeometry> GetCube();
+
+		// Program used for instanced drawing of the given shape type. Uniforms:
+		// view, projection.
+		std::shared_ptr<Shader> GetShader(ShapeType eType);
+
+		void ClearCache();
+
+	private:
+		ShapeCache() {};
+		ShapeCache(const ShapeCache&) = delete;
+		void operator=(const ShapeCache&) = delete;
+
+		std::unordered_map<std::string, std::shared_ptr<ShapeGeometry>> m_mapGeometryCache;
+		std::map<ShapeType, std::shared_ptr<Shader>> m_mapShaders;
+	};
+}
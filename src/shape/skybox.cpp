@@ -1,4 +1,5 @@
 #include "skybox.h"
+#include "../profiler.h"
 #include <mutex>
 
 namespace Cme
@@ -58,8 +59,24 @@ namespace Cme
 
     Skybox::~Skybox()
     {
-        glDeleteBuffers(1, &m_VAO);
+        glDeleteVertexArrays(1, &m_VAO);
         //glDeleteBuffers(1, &skyboxVBO);
+        ReleaseEnvironment();
+    }
+
+    void Skybox::ReleaseEnvironment()
+    {
+        // Ⱦ״ͶӰתͼ֡ ֡黹RenderTargetPool
+        // ͼصͼպԼͷ
+        if (m_bOwnsTexture && m_spTexture)
+        {
+            m_spTexture->free();
+        }
+        m_spTexture.reset();
+        m_bOwnsTexture = false;
+        m_spEquirectCubeMap.reset();
+        m_spIrradianceMap.reset();
+        m_spPrefilterMap.reset();
     }
 
     void Skybox::Render(Shader& shader, std::shared_ptr<Cme::Camera> spCamera)
@@ -69,6 +86,10 @@ namespace Cme
         //glEnable(GL_BLEND);
         //glDepthFunc(GL_LEQUAL);
 
+        if (m_spTexture)
+        {
+            m_spTexture->BindToUnit(0, TextureBindType::CUBEMAP);
+        }
         shader.setInt("skybox", 0);
         shader.activate();
         shader.setMat4("view", spCamera->getViewTransform());
@@ -77,6 +98,7 @@ namespace Cme
         glBindVertexArray(m_VAO);
 
         glDrawArrays(GL_TRIANGLES, 0, 36);
+        Profiler::GetInstance().CountDrawCall();
         glBindVertexArray(0);
 
         shader.deactivate();
@@ -155,24 +177,28 @@ namespace Cme
             break;
         }
 
-        // IBL
-        constexpr int CUBEMAP_SIZE = 1024;
-        // Ⱦ״ͶӰͼ
-        m_spEquirectCubeMap = std::make_shared<Cme::EquirectCubemap>(CUBEMAP_SIZE, CUBEMAP_SIZE, true);
-        
-        // ͼ Irradiance map averages radiance uniformly so it doesn't have a lot of high frequency details and can thus be small.
-        m_spIrradianceMap = std::make_shared<Cme::IrradianceMap>(32, 32);
-
-        // Ԥͼ  Create prefiltered envmap for specular IBL. It doesn't have to be super large.
-        m_spPrefilterMap = std::make_shared<Cme::PrefilterMap>(CUBEMAP_SIZE, CUBEMAP_SIZE);
+        // ͷһ ȾĿص ߴͬĿֱӸ лй©Դ
+        ReleaseEnvironment();
 
         int iSkyboxImage = static_cast<int>(eSkyboxImage);
         if (iSkyboxImage <= 6)
         {
-            //Cme::Texture hdr = Cme::Texture::LoadHDR(hdrPath.c_str());
-            auto fuck = std::make_shared<Cme::Texture>();
-            fuck->LoadHDR(hdrPath.c_str());
-            m_spEquirectCubeMap->multipassDraw(fuck);
+            // IBL
+            constexpr int CUBEMAP_SIZE = 1024;
+            // Ⱦ״ͶӰͼ
+            m_spEquirectCubeMap = std::make_shared<Cme::EquirectCubemap>(CUBEMAP_SIZE, CUBEMAP_SIZE, true);
+
+            // ͼ Irradiance map averages radiance uniformly so it doesn't have a lot of high frequency details and can thus be small.
+            m_spIrradianceMap = std::make_shared<Cme::IrradianceMap>(32, 32);
+
+            // Ԥͼ  Create prefiltered envmap for specular IBL. It doesn't have to be super large.
+            m_spPrefilterMap = std::make_shared<Cme::PrefilterMap>(CUBEMAP_SIZE, CUBEMAP_SIZE);
+
+            auto spHdr = std::make_shared<Cme::Texture>();
+            spHdr->LoadHDR(hdrPath.c_str());
+            m_spEquirectCubeMap->multipassDraw(spHdr);
+            // ֻתʱҪȾ״ͶӰͼ
+            spHdr->free();
 
             // m_spIrradianceMapm_spPrefilterMapûʲô(ΪûRendderʱõ ȴȾպ)
             m_spTexture = m_spEquirectCubeMap->GetCubemap();
@@ -190,10 +216,9 @@ namespace Cme
                 "assets//models//skybox//jajsundown1//front.jpg",
                 "assets//models//skybox//jajsundown1//back.jpg",
             };
-            //m_Texture = Cme::Texture::loadCubemap(vecFaces);
-
-            auto texturePtr = std::make_unique<Cme::Texture>();
-            texturePtr->loadCubemap(vecFaces);
+            m_spTexture = std::make_shared<Cme::Texture>();
+            m_spTexture->loadCubemap(vecFaces);
+            m_bOwnsTexture = true;
         }
     }
 
@@ -44,6 +44,7 @@ namespace Cme
 
         void InitializeData();
 
+        // µĻ ֮ǰ֡ȱͷ
         void LoadSkyboxImage(SkyboxImage eSkyboxImage);
 
         bool HasPositions() const;
@@ -56,6 +57,9 @@ namespace Cme
 
         void SetVertexAttributesPointers(int numVertices);
 
+    private:
+        void ReleaseEnvironment();
+
     public:
         std::shared_ptr<Texture> m_spTexture;
 
@@ -65,6 +69,8 @@ namespace Cme
         VertexBufferObject m_VBO;
 
         bool m_bInitialized = false;
+        // m_spTextureͼص κ֡ ҪԼͷ
+        bool m_bOwnsTexture = false;
         bool m_hasPositions = false;
         bool m_hasTextureCoordinates = false; 
         bool m_hasNormals = false; 
@@ -1,4 +1,5 @@
 #include "sphere_mesh.h"
+#include "shape_cache.h"
 
 namespace Cme
 {
@@ -23,18 +24,20 @@ namespace Cme
         loadMeshAndTextures(vecTextureMaps);
     }
 
-    void SphereMesh::loadMeshAndTextures(const std::vector<std::shared_ptr<TextureMap>>& vecTextureMaps)
+    void SphereMesh::GenerateVertexData(int numMeridians, int numParallels,
+        std::vector<float>& vertexData, std::vector<unsigned int>& indices)
     {
         // Generate the sphere vertex components. This uses the common "UV" approach.
 
         const float PI = glm::pi<float>();
 
         // Always use at least 3 meridians.
-        const unsigned int widthSegments = glm::max(m_iNumMeridians, 3);
+        const unsigned int widthSegments = glm::max(numMeridians, 3);
         // Add two segments to account for the poles.
-        const unsigned int heightSegments = glm::max(m_iNumParallels, 2);
+        const unsigned int heightSegments = glm::max(numParallels, 2);
 
-        std::vector<float> vertexData;
+        vertexData.clear();
+        indices.clear();
         // We use <= instead of < because we want to create one more "layer" of
         // vertices in order for UVs to work properly.
         for (unsigned int iy = 0; iy <= heightSegments; ++iy)
@@ -83,7 +86,6 @@ namespace Cme
         }
 
 
-        std::vector<unsigned int> indices;
         // Since we created an extra duplicate "wraparound" vertex for each parallel,
         // we have to adjust the stride.
         const unsigned int widthStride = widthSegments + 1;
@@ -111,13 +113,36 @@ namespace Cme
                 }
             }
         }
+    }
 
-        constexpr unsigned int sphereVertexSizeBytes = 11 * sizeof(float);
+    void SphereMesh::loadMeshAndTextures(const std::vector<std::shared_ptr<TextureMap>>& vecTextureMaps)
+    {
+        std::vector<float> vertexData;
+        std::vector<unsigned int> indices;
+        GenerateVertexData(m_iNumMeridians, m_iNumParallels, vertexData, indices);
+
+        constexpr unsigned int sphereVertexSizeBytes = VERTEX_FLOATS * sizeof(float);
         LoadMeshData(vertexData.data(),
             (sizeof(float) * vertexData.size()) / sphereVertexSizeBytes,
             sphereVertexSizeBytes, indices, vecTextureMaps);
     }
 
+    void SphereMesh::RenderInstanced(std::shared_ptr<Camera> spCamera,
+        const std::vector<glm::mat4>& transforms,
+        const std::vector<glm::vec4>& colors,
+        int numMeridians, int numParallels)
+    {
+        auto spShader = ShapeCache::GetInstance().GetShader(ShapeType::SPHERE);
+        auto spGeometry = ShapeCache::GetInstance().GetSphere(numMeridians, numParallels);
+        spShader->setMat4("view", spCamera->getViewTransform());
+        spShader->setMat4("projection", spCamera->getProjectionTransform());
+        spShader->activate();
+        spGeometry->DrawInstanced(transforms.data(),
+            colors.size() >= transforms.size() ? colors.data() : nullptr,
+            (unsigned int)transforms.size());
+        spShader->deactivate();
+    }
+
     void SphereMesh::initializeVertexAttributes()
     {
         // Positions.
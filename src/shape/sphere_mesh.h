@@ -1,5 +1,6 @@
 #pragma once
 #include "mesh.h"
+#include "../camera.h"
 
 namespace Cme
 {
@@ -8,6 +9,8 @@ namespace Cme
     public:
         static constexpr int DEFAULT_NUM_MERIDIANS = 64;
         static constexpr int DEFAULT_NUM_PARALLELS = 64;
+        // Position, normal, tangent and texture coordinates.
+        static constexpr int VERTEX_FLOATS = 11;
 
         SphereMesh(std::string texturePath = "",
             int numMeridians = DEFAULT_NUM_MERIDIANS,
@@ -17,6 +20,18 @@ namespace Cme
             int numMeridians = DEFAULT_NUM_MERIDIANS,
             int numParallels = DEFAULT_NUM_PARALLELS);
 
+        // Generates the "UV" sphere vertex data and triangle indices.
+        static void GenerateVertexData(int numMeridians, int numParallels,
+            std::vector<float>& vertexData, std::vector<unsigned int>& indices);
+
+        // Draws one sphere per transform with the shared geometry and program
+        // from the ShapeCache, in a single draw call.
+        static void RenderInstanced(std::shared_ptr<Camera> spCamera,
+            const std::vector<glm::mat4>& transforms,
+            const std::vector<glm::vec4>& colors,
+            int numMeridians = DEFAULT_NUM_MERIDIANS,
+            int numParallels = DEFAULT_NUM_PARALLELS);
+
     protected:
         void loadMeshAndTextures(const std::vector<std::shared_ptr<TextureMap>>& vecTextureMaps);
         void initializeVertexAttributes() override;
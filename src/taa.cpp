@@ -0,0 +1,117 @@
+#include "taa.h"
+#include "core/render_target_pool.h"
+
+namespace Cme
+{
+    namespace
+    {
+        constexpr int TAA_LOCAL_SIZE = 8;
+
+        // Radical inverse of `index` in `base`, in [0, 1).
+        float halton(unsigned int index, unsigned int base)
+        {
+            float result = 0.0f;
+            float fraction = 1.0f;
+            while (index > 0)
+            {
+                fraction /= base;
+                result += fraction * (index % base);
+                index /= base;
+            }
+            return result;
+        }
+
+        void createTarget(Texture& texture, ImageSize size, GLenum internalFormat)
+        {
+            TextureParams params;
+            params.filtering = TextureFiltering::BILINEAR;
+            params.wrapMode = TextureWrapMode::CLAMP_TO_EDGE;
+            params.generateMips = MipGeneration::NEVER;
+            texture = RenderTargetPool::GetInstance().Acquire(size.width, size.height, internalFormat, params,
+                                                              BufferType::COLOR_HDR_ALPHA);
+        }
+    }
+
+    TaaPass::TaaPass(ImageSize screenSize)
+        : m_ScreenSize(screenSize),
+        m_ResolveShaderObj(ShaderPath("assets//shaders//builtin//taa.comp"))
+    {
+        for (auto& spHistory : m_spHistory)
+        {
+            spHistory = std::make_shared<Texture>();
+            createTarget(*spHistory, screenSize, GL_RGBA16F);
+        }
+        m_spVelocity = std::make_shared<Texture>();
+        createTarget(*m_spVelocity, screenSize, GL_RG16F);
+    }
+
+    TaaPass::~TaaPass()
+    {
+        RenderTargetPool& pool = RenderTargetPool::GetInstance();
+        pool.Release(*m_spHistory[0]);
+        pool.Release(*m_spHistory[1]);
+        pool.Release(*m_spVelocity);
+    }
+
+    std::vector<std::shared_ptr<Texture>> TaaPass::getTextures() const
+    {
+        return { m_spHistory[0], m_spHistory[1], m_spVelocity };
+    }
+
+    void TaaPass::BeginFrame(Camera& camera, ImageSize renderSize)
+    {
+        // Index 0 of the sequence is the origin, so start at 1.
+        unsigned int index = m_uiFrame % TAA_JITTER_SEQUENCE_LENGTH + 1;
+        m_vec2Jitter = glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+        // A pixel is 2 / size wide in NDC.
+        camera.setJitter(m_vec2Jitter * 2.0f / glm::vec2(renderSize.width, renderSize.height));
+    }
+
+    void TaaPass::Render(Texture& color, GBuffer& gBuffer, Camera& camera, unsigned int textureUnit)
+    {
+        glm::mat4 view = camera.getViewTransform();
+        glm::mat4 viewProjection = camera.getUnjitteredProjectionTransform() * view;
+        glm::mat4 jitteredViewProjection = camera.getProjectionTransform() * view;
+
+        Texture& history = *m_spHistory[m_iHistoryIndex];
+        Texture& nextHistory = *m_spHistory[1 - m_iHistoryIndex];
+
+        color.BindToUnit(textureUnit);
+        m_ResolveShaderObj.setInt("qrk_taaColor", textureUnit);
+        gBuffer.getDepthTexture()->BindToUnit(textureUnit + 1);
+        m_ResolveShaderObj.setInt("gDepth", textureUnit + 1);
+        // The G-Buffer may only be partly rendered to, see DynamicResolution.
+        ImageSize gBufferSize = gBuffer.getSize();
+        ImageSize renderSize = gBuffer.getViewportSize();
+        m_ResolveShaderObj.setVec2("qrk_renderScale", glm::vec2(renderSize.width, renderSize.height) /
+                                   glm::vec2(gBufferSize.width, gBufferSize.height));
+        history.BindToUnit(textureUnit + 2);
+        m_ResolveShaderObj.setInt("qrk_taaHistory", textureUnit + 2);
+        m_ResolveShaderObj.setBool("qrk_taaHistoryValid", m_bHistoryValid);
+        m_ResolveShaderObj.setFloat("qrk_taaBlend", m_fBlend);
+        m_ResolveShaderObj.setMat4("inverseViewProjection", glm::inverse(jitteredViewProjection));
+        m_ResolveShaderObj.setMat4("viewProjection", viewProjection);
+        m_ResolveShaderObj.setMat4("prevViewProjection",
+                                   m_bHistoryValid ? m_mat4PrevViewProjection : viewProjection);
+        glBindImageTexture(0, nextHistory.getId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        glBindImageTexture(1, m_spVelocity->getId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+
+        m_ResolveShaderObj.activate();
+        glDispatchCompute((m_ScreenSize.width + TAA_LOCAL_SIZE - 1) / TAA_LOCAL_SIZE,
+                          (m_ScreenSize.height + TAA_LOCAL_SIZE - 1) / TAA_LOCAL_SIZE, 1);
+        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+        m_ResolveShaderObj.deactivate();
+
+        // The resolved frame is both the next history and this frame's image.
+        glCopyImageSubData(nextHistory.getId(), GL_TEXTURE_2D, 0, 0, 0, 0,
+                           color.getId(), GL_TEXTURE_2D, 0, 0, 0, 0,
+                           m_ScreenSize.width, m_ScreenSize.height, 1);
+
+        m_iHistoryIndex = 1 - m_iHistoryIndex;
+        m_bHistoryValid = true;
+        m_mat4PrevViewProjection = viewProjection;
+        ++m_uiFrame;
+        camera.setJitter(glm::vec2(0.0f));
+    }
+
+}  // namespace Cme
@@ -0,0 +1,86 @@
+#ifndef QUARKGL_TAA_H_
+#define QUARKGL_TAA_H_
+
+#include "camera.h"
+#include "deferred.h"
+#include "screen.h"
+#include "shader/shader.h"
+#include "core/texture.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+namespace Cme
+{
+    // Number of jitter positions before the sequence repeats.
+    constexpr int TAA_JITTER_SEQUENCE_LENGTH = 8;
+
+    // Temporal anti-aliasing. Each frame the camera projection is offset by a
+    // sub-pixel jitter from a Halton (2, 3) sequence, and the HDR image is
+    // blended into a history reprojected from the previous frame. The history
+    // is clipped to the color range of the current neighborhood, which drops
+    // stale colors from disocclusions without a per-object velocity buffer.
+    // Velocity comes from the depth buffer and the previous view projection,
+    // so it follows camera motion only.
+    //
+    // The jitter, frame index, history and velocity are public so that other
+    // passes can spread their samples over frames too.
+    class TaaPass
+    {
+    public:
+        explicit TaaPass(ImageSize screenSize);
+        ~TaaPass();
+
+        TaaPass(const TaaPass&) = delete;
+        TaaPass& operator=(const TaaPass&) = delete;
+
+        // Jitters the projection of `camera` for this frame by a sub-pixel
+        // offset of `renderSize`, the size the scene is rendered at. Call before
+        // the passes whose output is resolved.
+        void BeginFrame(Camera& camera, ImageSize renderSize);
+        // Resolves `color` against the history and writes the result back into
+        // it. `color` must be RGBA16F at the screen size. Clears the camera
+        // jitter, so that later passes draw unjittered. Samples from the
+        // `textureUnit` units reserved with getTextures().
+        void Render(Texture& color, GBuffer& gBuffer, Camera& camera, unsigned int textureUnit);
+
+        // Weight of the current frame when blending.
+        float getBlend() const { return m_fBlend; }
+        void setBlend(float blend) { m_fBlend = blend; }
+        // Drops the history, e.g. after a camera cut.
+        void ResetHistory() { m_bHistoryValid = false; }
+
+        // This frame's jitter in pixels, within [-0.5, 0.5].
+        glm::vec2 getJitter() const { return m_vec2Jitter; }
+        // Increments once per frame. Passes can index their own sequences with
+        // it to stay in step with the jitter.
+        unsigned int getFrameIndex() const { return m_uiFrame; }
+        // The last resolved frame.
+        std::shared_ptr<Texture> getHistoryTexture() const { return m_spHistory[m_iHistoryIndex]; }
+        // Screen space motion of the last resolved frame, in texture
+        // coordinates from the previous frame to this one.
+        std::shared_ptr<Texture> getVelocityTexture() const { return m_spVelocity; }
+
+        // All textures of the pass. Registering them reserves enough texture
+        // units for Render().
+        std::vector<std::shared_ptr<Texture>> getTextures() const;
+
+    private:
+        ImageSize m_ScreenSize;
+        float m_fBlend = 0.1f;
+        Shader m_ResolveShaderObj;
+
+        std::shared_ptr<Texture> m_spHistory[2];
+        std::shared_ptr<Texture> m_spVelocity;
+
+        int m_iHistoryIndex = 0;
+        bool m_bHistoryValid = false;
+        glm::mat4 m_mat4PrevViewProjection = glm::mat4(1.0f);
+        glm::vec2 m_vec2Jitter = glm::vec2(0.0f);
+        unsigned int m_uiFrame = 0;
+    };
+
+}  // namespace Cme
+
+#endif
@@ -1,10 +1,15 @@
 #include "window.h"
+#include "profiler.h"
+#include "core/frame_clock.h"
+#include "core/stream_buffer.h"
 
 
 namespace Cme
 {
     bool Window::m_bGlfwErrorLoggingEnabled = true;
     bool Window::m_bGlErrorLoggingEnabled = true;
+    bool Window::m_bHeadless = false;
+    ContextApi Window::m_eContextApi = ContextApi::NATIVE;
 
     Window::Window(int width, int height, const char* title, bool fullscreen, int samples)
     {
@@ -26,6 +31,25 @@ namespace Cme
             glfwWindowHint(GLFW_SAMPLES, samples);
         }
 
+        if (m_bHeadless)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            switch (m_eContextApi)
+            {
+            case ContextApi::EGL:
+                glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+                break;
+            case ContextApi::OSMESA:
+                glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+                break;
+            case ContextApi::NATIVE:
+                glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API);
+                break;
+            }
+            // Fullscreen makes no sense without a visible window.
+            fullscreen = false;
+        }
+
         // nullptr indicates windowed.
         GLFWmonitor* monitor = nullptr;
         if (fullscreen) 
@@ -433,10 +457,13 @@ namespace Cme
         while (!glfwWindowShouldClose(m_pWindow))
         {
             float currentTime = glfwGetTime();
-            m_fDeltaTime = currentTime - m_fLastTime;
+            float realDeltaTime = currentTime - m_fLastTime;
             m_fLastTime = currentTime;
 
-            updateFrameStats(m_fDeltaTime);
+            // Statistics always show wall time, everything else runs on the
+            // virtual clock.
+            updateFrameStats(realDeltaTime);
+            m_fDeltaTime = FrameClock::GetInstance().Tick(realDeltaTime);
 
             // enableAlphaBlending();
             // Clear the appropriate buffers.
@@ -456,7 +483,11 @@ namespace Cme
             processInput(m_fDeltaTime);
 
             // Call the loop function.
+            Profiler::GetInstance().BeginFrame();
             callback(m_fDeltaTime);
+            // After the frame's last draw.
+            StreamBuffer::EndFrame();
+            Profiler::GetInstance().EndFrame();
 
             qrkCheckForGlError();
 
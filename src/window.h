@@ -40,6 +40,17 @@ namespace Cme
         UNCAPTURE_MOUSE_OR_CLOSE,
     };
 
+    // Context creation API used for windows created after Window::setHeadless().
+    enum class ContextApi
+    {
+        NATIVE,
+        // EGL instead of GLX or WGL. GLFW still creates a hidden window, so
+        // this needs a display server such as X11 or Wayland too.
+        EGL,
+        // Mesa's software renderer, for machines without a GPU.
+        OSMESA,
+    };
+
     // Controls special convenience behavior when the LMB is pressed.
     enum class MouseButtonBehavior
     {
@@ -154,6 +165,9 @@ namespace Cme
         const float* getFrameDeltas() const;
         int getNumFrameDeltas() const;
         int getFrameDeltasOffset() const;
+        // Wall time of the current frame's delta, unlike the delta passed to
+        // the loop callback, which runs on the virtual clock.
+        float getRealFrameDelta() const { return m_fFrameDeltas[getFrameDeltasOffset()]; }
         float getAvgFPS() const;
         glm::vec4 getClearColor() const { return m_vecClearColor; }
         void setClearColor(glm::vec4 color) { m_vecClearColor = color; }
@@ -161,6 +175,20 @@ namespace Cme
         void makeFullscreen();
         void makeWindowed();
 
+        // Ends loop() after the current frame.
+        void requestClose() { glfwSetWindowShouldClose(m_pWindow, true); }
+
+        // Windows created after this call are invisible and use the given
+        // context API, so that rendering can run offscreen. They are still
+        // GLFW windows, which need a display server with every context API;
+        // on CI machines without one, run under Xvfb.
+        static void setHeadless(ContextApi api)
+        {
+            m_bHeadless = true;
+            m_eContextApi = api;
+        }
+        static bool isHeadless() { return m_bHeadless; }
+
         EscBehavior getEscBehavior() const { return e_eEscBehavior; }
         void setEscBehavior(EscBehavior behavior) { e_eEscBehavior = behavior; }
 
@@ -244,6 +272,9 @@ namespace Cme
 
         static bool m_bGlfwErrorLoggingEnabled;
 
+        static bool m_bHeadless;
+        static ContextApi m_eContextApi;
+
         /** Whether or not to automatically print OpenGL debug messages. */
         static bool m_bGlErrorLoggingEnabled;
 